@@ -20,21 +20,293 @@
 
 #include "Configuration.h"
 #include "Logger.h"
+#include "Trace.h"
+#include "Utf8.h"
+#include <Windows.h>
+#include <fstream>
+#include <vector>
 
 using namespace std;
 
+#define REGISTRY_BASE_KEY L"SOFTWARE\\Adamantic\\DasCredentialProvider"
+
+namespace
+{
+	bool ReadRegistryString(const wchar_t* name, SecureWString& value)
+	{
+		DWORD size = 0;
+		if (RegGetValueW(HKEY_LOCAL_MACHINE, REGISTRY_BASE_KEY, name, RRF_RT_REG_SZ, nullptr, nullptr, &size) != ERROR_SUCCESS
+			|| size < sizeof(wchar_t))
+		{
+			return false;
+		}
+
+		SecureWString buffer(size / sizeof(wchar_t), L'\0');
+		if (RegGetValueW(HKEY_LOCAL_MACHINE, REGISTRY_BASE_KEY, name, RRF_RT_REG_SZ, nullptr, &buffer[0], &size) != ERROR_SUCCESS)
+		{
+			return false;
+		}
+
+		buffer.resize(wcsnlen(buffer.c_str(), buffer.size()));
+		value = buffer;
+		return true;
+	}
+
+	DWORD ReadRegistryDword(const wchar_t* name, DWORD defaultValue)
+	{
+		DWORD value = 0;
+		DWORD size = sizeof(value);
+		if (RegGetValueW(HKEY_LOCAL_MACHINE, REGISTRY_BASE_KEY, name, RRF_RT_REG_DWORD, nullptr, &value, &size) != ERROR_SUCCESS)
+		{
+			return defaultValue;
+		}
+		return value;
+	}
+
+	unsigned long long ReadRegistryQword(const wchar_t* name, unsigned long long defaultValue)
+	{
+		unsigned long long value = 0;
+		DWORD size = sizeof(value);
+		if (RegGetValueW(HKEY_LOCAL_MACHINE, REGISTRY_BASE_KEY, name, RRF_RT_REG_QWORD, nullptr, &value, &size) != ERROR_SUCCESS)
+		{
+			return defaultValue;
+		}
+		return value;
+	}
+
+	// Pipe names of daemon_endpoint, separated by ';'
+	vector<string> SplitEndpoints(const wstring& endpoint)
+	{
+		vector<string> endpoints;
+		size_t start = 0;
+		while (start <= endpoint.size())
+		{
+			size_t end = endpoint.find(L';', start);
+			end = end == wstring::npos ? endpoint.size() : end;
+			if (end > start)
+			{
+				endpoints.push_back(DaemonProtocol::Utf8(endpoint.substr(start, end - start)));
+			}
+			start = end + 1;
+		}
+		return endpoints;
+	}
+
+	// Index is the level
+	const wchar_t* const LOG_LEVEL_NAMES[] = { L"off", L"error", L"warning", L"info", L"debug", L"trace" };
+
+	// Index is the LOG_CATEGORY, the registry value is log_level_ and the name
+	const wchar_t* const LOG_CATEGORY_NAMES[LOG_CATEGORIES] = { L"provider", L"credential", L"util", L"filter", L"kerb" };
+
+	int ReadLogLevel(const wstring& name, int defaultLevel)
+	{
+		SecureWString value;
+		if (ReadRegistryString(name.c_str(), value))
+		{
+			for (int level = LOG_LEVEL_OFF; level <= LOG_LEVEL_TRACE; level++)
+			{
+				if (_wcsicmp(value.c_str(), LOG_LEVEL_NAMES[level]) == 0)
+				{
+					return level;
+				}
+			}
+		}
+		return defaultLevel;
+	}
+
+	wstring DescribeLogLevels()
+	{
+		wstring levels = L"Log levels:";
+		for (int category = 0; category < LOG_CATEGORIES; category++)
+		{
+			const int level = Logger::Get().verbosity(static_cast<LOG_CATEGORY>(category));
+			levels += wstring(category == 0 ? L" " : L", ") + LOG_CATEGORY_NAMES[category] + L" "
+				+ LOG_LEVEL_NAMES[level < LOG_LEVEL_OFF ? LOG_LEVEL_OFF : (level > LOG_LEVEL_TRACE ? LOG_LEVEL_TRACE : level)];
+		}
+		return levels + L", compiled in up to " + LOG_LEVEL_NAMES[LOG_COMPILED_LEVEL];
+	}
+}
+
 Configuration::Configuration()
 {
-	// Simple initialization - no registry reading needed for stub
 	loginText = L"Das Credential Provider";
+
+	// Token of this machine. Everything is optional, without a secret every OTP is rejected.
+	SecureWString value;
+	if (ReadRegistryString(L"otp_type", value))
+	{
+		otp.parameters.type = (_wcsicmp(value.c_str(), L"hotp") == 0) ? OTP_TYPE::HOTP : OTP_TYPE::TOTP;
+	}
+	if (ReadRegistryString(L"otp_algorithm", value))
+	{
+		if (_wcsicmp(value.c_str(), L"sha256") == 0)
+		{
+			otp.parameters.algorithm = OTP_ALGORITHM::SHA256;
+		}
+		else if (_wcsicmp(value.c_str(), L"sha512") == 0)
+		{
+			otp.parameters.algorithm = OTP_ALGORITHM::SHA512;
+		}
+		else
+		{
+			otp.parameters.algorithm = OTP_ALGORITHM::SHA1;
+		}
+	}
+	if (ReadRegistryString(L"otp_secret", value))
+	{
+		// base32 is plain ASCII
+		otp.secret.assign(value.size(), '\0');
+		for (size_t i = 0; i < value.size(); i++)
+		{
+			otp.secret[i] = static_cast<char>(value[i]);
+		}
+	}
+
+	otp.parameters.digits = ReadRegistryDword(L"otp_digits", otp.parameters.digits);
+	otp.parameters.period = ReadRegistryDword(L"otp_period", otp.parameters.period);
+	otp.parameters.window = ReadRegistryDword(L"otp_window", otp.parameters.window);
+	otp.parameters.resyncWindow = ReadRegistryDword(L"otp_resync_window", otp.parameters.resyncWindow);
+	otp.parameters.t0 = static_cast<long long>(ReadRegistryQword(L"otp_t0", 0));
+	otp.counter = ReadRegistryQword(L"otp_counter", 0);
+
+	if (ReadRegistryString(L"otp_token_store", value))
+	{
+		otp.storePath = wstring(value.c_str());
+	}
+
+	if (ReadRegistryString(L"daemon_endpoint", value))
+	{
+		daemon.endpoint = wstring(value.c_str());
+	}
+	daemon.timeoutMs = ReadRegistryDword(L"daemon_timeout", daemon.timeoutMs);
+	daemon.deadlineMs = ReadRegistryDword(L"daemon_deadline", daemon.deadlineMs);
+	daemon.prefetchMs = ReadRegistryDword(L"daemon_prefetch_delay", daemon.prefetchMs);
+	daemon.probeMs = ReadRegistryDword(L"daemon_probe_interval", daemon.probeMs);
+	daemon.hedge = ReadRegistryDword(L"daemon_hedge", 0) != 0;
+	daemon.breakerFailures = ReadRegistryDword(L"daemon_breaker_failures", daemon.breakerFailures);
+	daemon.breakerMs = ReadRegistryDword(L"daemon_breaker_open", daemon.breakerMs);
+	daemon.negativeTtlMs = ReadRegistryDword(L"daemon_negative_ttl", daemon.negativeTtlMs);
+	daemon.pushMs = ReadRegistryDword(L"daemon_push_timeout", daemon.pushMs);
+
+	logging.async = ReadRegistryDword(L"log_async", 0) != 0;
+	if (ReadRegistryString(L"log_overflow", value))
+	{
+		logging.overflow = (_wcsicmp(value.c_str(), L"block") == 0) ? LOG_OVERFLOW::BLOCK : LOG_OVERFLOW::DROP;
+	}
+	if (ReadRegistryString(L"log_format", value) && _wcsicmp(value.c_str(), L"binary") == 0)
+	{
+		// The binary log is written by the asynchronous mode only
+		logging.format = LOG_FORMAT::BINARY;
+		logging.async = true;
+	}
+	if (logging.async)
+	{
+		Logger::Get().startAsync(logging.overflow, logging.format);
+	}
+	if (ReadRegistryString(L"trace_file", value))
+	{
+		logging.traceFile = wstring(value.c_str());
+		Tracer::Get().Enable(true);
+	}
+
+	Metrics& registry = Metrics::Get();
+	const string otpHelp = "OTP verification in Connect, per daemon endpoint or offline";
+	metrics.otpOffline = &registry.Register("das_otp_verify_seconds", otpHelp, Metrics::Label("endpoint", "offline"));
+	for (const string& endpoint : SplitEndpoints(daemon.endpoint))
+	{
+		metrics.otpDaemon.push_back(&registry.Register("das_otp_verify_seconds", otpHelp, Metrics::Label("endpoint", endpoint)));
+	}
+	metrics.kerberosPack = &registry.Register("das_kerberos_pack_seconds", "Utilities::KerberosLogon packing", "");
+	metrics.credPack = &registry.Register("das_credpack_seconds", "Utilities::CredPackAuthentication", "");
+	metrics.submitToSerialization = &registry.Register("das_submit_to_serialization_seconds",
+		"Submit in Connect until GetSerialization has packed the credential", "");
+	metrics.intervalMs = ReadRegistryDword(L"metrics_interval", metrics.intervalMs);
+	if (ReadRegistryString(L"metrics_file", value))
+	{
+		metrics.file = wstring(value.c_str());
+		registry.StartDump(Utf8::FromWide(metrics.file), metrics.intervalMs);
+	}
+
+	// log_level sets every category, log_level_kerb and so on one of them.
+	// Levels above LOG_COMPILED_LEVEL are not in the build and stay silent.
+	const int level = ReadLogLevel(L"log_level", LOG_COMPILED_LEVEL);
+	for (int category = 0; category < LOG_CATEGORIES; category++)
+	{
+		Logger::Get().setVerbosity(static_cast<LOG_CATEGORY>(category),
+			ReadLogLevel(wstring(L"log_level_") + LOG_CATEGORY_NAMES[category], level));
+	}
+}
+
+Configuration::~Configuration()
+{
+	// The ring is per process, the file shows the last TRACE_RING_EVENTS calls of every provider
+	if (!logging.traceFile.empty())
+	{
+		ofstream trace(logging.traceFile.c_str(), ios::binary | ios::trunc);
+		trace << Tracer::Get().ChromeJson();
+	}
+
+	// Like the log writer, the dump thread must be gone before LogonUI unloads the DLL
+	if (!metrics.file.empty())
+	{
+		Metrics::Get().StopDump();
+	}
+
+	// The writer thread must be gone before LogonUI unloads the DLL
+	if (logging.async)
+	{
+		Logger::Get().stopAsync();
+	}
+}
+
+unsigned long long Configuration::readOTPCounter()
+{
+	return ReadRegistryQword(L"otp_counter", otp.counter);
+}
+
+bool Configuration::writeOTPCounter(unsigned long long counter)
+{
+	const LSTATUS status = RegSetKeyValueW(HKEY_LOCAL_MACHINE, REGISTRY_BASE_KEY, L"otp_counter", REG_QWORD,
+		&counter, sizeof(counter));
+	return status == ERROR_SUCCESS;
+}
+
+AuthBackends& Configuration::daemonBackends()
+{
+	if (!daemon.backends)
+	{
+		daemon.backends = make_shared<AuthBackends>(SplitEndpoints(daemon.endpoint), daemon.timeoutMs, daemon.probeMs);
+		daemon.backends->SetHedging(daemon.hedge);
+		daemon.backends->SetBreaker(daemon.breakerFailures, daemon.breakerMs);
+		daemon.backends->SetNegativeTtl(daemon.negativeTtlMs);
+	}
+	return *daemon.backends;
 }
 
 void Configuration::printConfiguration()
 {
-	DebugPrint("-----------------------------");
-	DebugPrint("Das Credential Provider");
-	DebugPrint("------- Configuration -------");
-	DebugPrint(L"Login text: " + loginText);
-	DebugPrint(L"Bitmap path: " + bitmapPath);
-	DebugPrint("-----------------------------");
+	LogDebug(PROVIDER, "-----------------------------");
+	LogDebug(PROVIDER, "Das Credential Provider");
+	LogDebug(PROVIDER, "------- Configuration -------");
+	LogDebug(PROVIDER, L"Login text: " + loginText);
+	LogDebug(PROVIDER, L"Bitmap path: " + bitmapPath);
+	LogDebug(PROVIDER, string("OTP type: ") + (otp.parameters.type == OTP_TYPE::HOTP ? "hotp" : "totp"));
+	LogDebug(PROVIDER, "OTP algorithm: " + to_string(static_cast<int>(otp.parameters.algorithm)));
+	LogDebug(PROVIDER, "OTP digits: " + to_string(otp.parameters.digits) + ", period: " + to_string(otp.parameters.period)
+		+ ", window: " + to_string(otp.parameters.window) + ", resync window: " + to_string(otp.parameters.resyncWindow));
+	LogDebug(PROVIDER, string("OTP secret: ") + (otp.secret.empty() ? "not set" : "set"));
+	LogDebug(PROVIDER, L"OTP token store: " + (otp.storePath.empty() ? L"not set" : otp.storePath));
+	LogDebug(PROVIDER, L"Authentication daemon: " + (daemon.endpoint.empty() ? L"not set" : daemon.endpoint)
+		+ L", timeout: " + to_wstring(daemon.timeoutMs) + L" ms, deadline: " + to_wstring(daemon.deadlineMs) + L" ms, prefetch delay: " + to_wstring(daemon.prefetchMs)
+		+ L" ms, probe interval: " + to_wstring(daemon.probeMs) + L" ms, hedging: " + (daemon.hedge ? L"on" : L"off")
+		+ L", breaker: " + to_wstring(daemon.breakerFailures) + L" failures, " + to_wstring(daemon.breakerMs)
+		+ L" ms, not enrolled TTL: " + to_wstring(daemon.negativeTtlMs) + L" ms, push timeout: " + to_wstring(daemon.pushMs) + L" ms");
+	LogDebug(PROVIDER, string("Log writer: ") + (logging.async ? "async" : "direct")
+		+ ", on overflow: " + (logging.overflow == LOG_OVERFLOW::BLOCK ? "block" : "drop")
+		+ ", format: " + (logging.format == LOG_FORMAT::BINARY ? "binary" : "text"));
+	LogDebug(PROVIDER, L"Trace file: " + (logging.traceFile.empty() ? L"not set" : logging.traceFile));
+	LogDebug(PROVIDER, L"Metrics file: " + (metrics.file.empty() ? L"not set" : metrics.file)
+		+ L", interval: " + to_wstring(metrics.intervalMs) + L" ms");
+	LogDebug(PROVIDER, DescribeLogLevels());
+	LogDebug(PROVIDER, "-----------------------------");
 }
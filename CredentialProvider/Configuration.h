@@ -20,16 +20,33 @@
 
 #pragma once
 #include "SecureString.h"
+#include "Logger.h"
+#include "Metrics.h"
+#include "otp/OTPVerifier.h"
+#include "otp/TokenStore.h"
+#include "daemon/AuthBackends.h"
+#include <memory>
 #include <string>
+#include <vector>
 #include <credentialprovider.h>
 
 class Configuration
 {
 public:
 	Configuration();
+	~Configuration();
 
 	void printConfiguration();
 
+	// Next expected HOTP counter as persisted, another session may have advanced it
+	unsigned long long readOTPCounter();
+
+	// Persists the next expected HOTP counter, returns false if the registry is not writable
+	bool writeOTPCounter(unsigned long long counter);
+
+	// Clients of the authentication daemons, created on first use
+	AuthBackends& daemonBackends();
+
 	std::wstring loginText = L"Das Credential Provider";
 	std::wstring bitmapPath = L"";
 
@@ -41,6 +58,7 @@ public:
 	bool doAutoLogon = false;
 	bool userCanceled = false;
 	bool clearFields = true;
+	bool resyncMode = false;			// HOTP resync scenario is shown
 
 	struct PROVIDER
 	{
@@ -68,5 +86,53 @@ public:
 		std::wstring domain = L"";
 		SecureWString password = L"";
 		std::wstring otp = L"";
+		std::wstring otpNext = L"";		// second code, resync only
 	} credential;
+
+	struct OTP
+	{
+		OTP_PARAMETERS parameters;
+		SecureString secret = "";			// base32 as provisioned
+		unsigned long long counter = 0;		// next expected HOTP counter
+
+		// Offline token database, its tokens take precedence over the one above
+		std::wstring storePath = L"";
+		std::shared_ptr<TokenStore> store;
+	} otp;
+
+	struct DAEMON
+	{
+		std::wstring endpoint = L"";		// pipe names separated by ';', empty verifies offline only
+		unsigned int timeoutMs = 5000;		// connect and answer, each
+		unsigned int deadlineMs = 10000;	// everything at submit, then the offline check decides
+		unsigned int prefetchMs = 250;		// quiet time before a typed user name is looked up, 0 disables
+		unsigned int probeMs = 5000;		// health probes of idle or disconnected daemons, 0 disables
+		bool hedge = false;					// ask a second daemon when the first is slower than its p95
+		unsigned int breakerFailures = 3;	// consecutive failures that take a daemon out, 0 disables
+		unsigned int breakerMs = 10000;		// how long it stays out before a trial request
+		unsigned int negativeTtlMs = 30000;	// how long "user not enrolled" is believed, 0 disables
+		unsigned int pushMs = 0;			// wait for a push approval when no OTP is typed, 0 disables push
+		std::shared_ptr<AuthBackends> backends;
+	} daemon;
+
+	struct LOGGING
+	{
+		bool async = false;							// a background thread writes the log file
+		LOG_OVERFLOW overflow = LOG_OVERFLOW::DROP;	// what a full log ring does to the caller
+		LOG_FORMAT format = LOG_FORMAT::TEXT;		// binary implies async
+		std::wstring traceFile;						// Chrome trace of the LogonUI calls, written when the provider goes away
+	} logging;
+
+	// Latency histograms, shared by every provider of the process and registered
+	// here so that recording on the logon path neither locks nor allocates
+	struct METRICS
+	{
+		std::wstring file;							// Prometheus text file for the monitoring agent, empty writes none
+		unsigned int intervalMs = 10000;			// how often the file is rewritten
+		LatencyHistogram* otpOffline = nullptr;		// VerifyOTP, the token of the machine or the store
+		std::vector<LatencyHistogram*> otpDaemon;	// per daemon, in daemon_endpoint order
+		LatencyHistogram* kerberosPack = nullptr;
+		LatencyHistogram* credPack = nullptr;
+		LatencyHistogram* submitToSerialization = nullptr;	// Connect until GetSerialization has packed the credential
+	} metrics;
 };
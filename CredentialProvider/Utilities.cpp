@@ -40,7 +40,8 @@ HRESULT Utilities::KerberosLogon(
 	__in SecureWString password,
 	__in std::wstring domain)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(KERB, __FUNCTION__);
+	LatencyTimer timer(*_config->metrics.kerberosPack);
 
 	HRESULT hr;
 
@@ -57,9 +58,9 @@ HRESULT Utilities::KerberosLogon(
 		domain = wstring(wsz, cch);
 	}
 
-	DebugPrint("Packing Credential:");
-	DebugPrint(username);
-	DebugPrint(domain);
+	LogDebug(KERB, "Packing Credential:");
+	LogDebug(KERB, username);
+	LogDebug(KERB, domain);
 
 	if (!domain.empty() || bGetCompName)
 	{
@@ -118,9 +119,10 @@ HRESULT Utilities::CredPackAuthentication(
 	__in SecureWString password,
 	__in std::wstring domain)
 {
-	DebugPrint(__FUNCTION__);
-	DebugPrint(username);
-	DebugPrint(domain);
+	LogTrace(UTIL, __FUNCTION__);
+	LatencyTimer timer(*_config->metrics.credPack);
+	LogDebug(UTIL, username);
+	LogDebug(UTIL, domain);
 
 	const DWORD credPackFlags = _config->provider.credPackFlags;
 	PWSTR pwzProtectedPassword;
@@ -143,7 +145,7 @@ HRESULT Utilities::CredPackAuthentication(
 	{
 		PWSTR domainUsername = NULL;
 		hr = DomainUsernameStringAlloc(domain.c_str(), username.c_str(), &domainUsername);
-		DebugPrint(domainUsername);
+		LogDebug(UTIL, domainUsername);
 		if (SUCCEEDED(hr))
 		{
 			DWORD size = 0;
@@ -207,19 +209,23 @@ HRESULT Utilities::SetScenario(
 	__in ICredentialProviderCredentialEvents* pCPCE,
 	__in SCENARIO scenario)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(UTIL, __FUNCTION__);
 	HRESULT hr = S_OK;
 
 	switch (scenario)
 	{
 	case SCENARIO::LOGON:
-		DebugPrint("SetScenario: LOGON");
+		LogDebug(UTIL, "SetScenario: LOGON");
 		hr = SetFieldStatePairBatch(pCredential, pCPCE, s_rgScenarioLogon);
 		break;
 	case SCENARIO::UNLOCK_BLOCKED:
-		DebugPrint("SetScenario: UNLOCK_BLOCKED");
+		LogDebug(UTIL, "SetScenario: UNLOCK_BLOCKED");
 		hr = SetFieldStatePairBatch(pCredential, pCPCE, s_rgScenarioUnlockBlocked);
 		break;
+	case SCENARIO::RESYNC:
+		LogDebug(UTIL, "SetScenario: RESYNC");
+		hr = SetFieldStatePairBatch(pCredential, pCPCE, s_rgScenarioResync);
+		break;
 	case SCENARIO::NO_CHANGE:
 	default:
 		break;
@@ -229,6 +235,23 @@ HRESULT Utilities::SetScenario(
 	if (scenario == SCENARIO::UNLOCK_BLOCKED)
 		return hr;
 
+	// Only a counter based token can drift out of its window, the resync scenario keeps the link to cancel
+	if (scenario != SCENARIO::RESYNC)
+	{
+		const wchar_t* typed = _config->provider.field_strings != nullptr ? _config->provider.field_strings[FID_USERNAME] : nullptr;
+		pCPCE->SetFieldState(pCredential, FID_RESYNC_LINK, IsCounterBased(typed) ? CPFS_DISPLAY_IN_SELECTED_TILE : CPFS_HIDDEN);
+	}
+
+	if (scenario == SCENARIO::RESYNC)
+	{
+		pCPCE->SetFieldString(pCredential, FID_RESYNC_LINK, L"Cancel resynchronization");
+		pCPCE->SetFieldString(pCredential, FID_SMALL_TEXT, L"Enter two consecutive codes of your token");
+	}
+	else if (scenario == SCENARIO::LOGON)
+	{
+		pCPCE->SetFieldString(pCredential, FID_RESYNC_LINK, L"Resynchronize token");
+	}
+
 	// Set display text
 	const int hideFullName = _config->hideFullName;
 	const int hideDomain = _config->hideDomainName;
@@ -262,7 +285,7 @@ HRESULT Utilities::Clear(
 	ICredentialProviderCredentialEvents* pcpce,
 	char clear)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(UTIL, __FUNCTION__);
 
 	HRESULT hr = S_OK;
 
@@ -305,7 +328,7 @@ HRESULT Utilities::SetFieldStatePairBatch(
 	__in ICredentialProviderCredentialEvents* pCPCE,
 	__in const FIELD_STATE_PAIR* pFSP)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(UTIL, __FUNCTION__);
 
 	HRESULT hr = S_OK;
 
@@ -342,9 +365,13 @@ HRESULT Utilities::InitializeField(
 	{
 	case FID_LDAP_PASS:
 	case FID_OTP:
+	case FID_OTP_NEXT:
 	case FID_SUBMIT_BUTTON:
 		hr = SHStrDupW(L"", &rgFieldStrings[field_index]);
 		break;
+	case FID_RESYNC_LINK:
+		hr = SHStrDupW(L"Resynchronize token", &rgFieldStrings[field_index]);
+		break;
 	case FID_USERNAME:
 		hr = SHStrDupW((user_name.empty() ? L"" : user_name.c_str()), &rgFieldStrings[field_index]);
 		break;
@@ -402,7 +429,7 @@ HRESULT Utilities::InitializeField(
 
 HRESULT Utilities::ReadFieldValues()
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(UTIL, __FUNCTION__);
 
 	switch (_config->provider.cpu)
 	{
@@ -418,22 +445,50 @@ HRESULT Utilities::ReadFieldValues()
 	return S_OK;
 }
 
-HRESULT Utilities::ReadUserField()
+bool Utilities::IsCounterBased(const wchar_t* input)
 {
-	wstring input(_config->provider.field_strings[FID_USERNAME]);
-	DebugPrint(L"Loading user/domain from GUI: '" + input + L"'");
 	wstring user_name, domain_name;
+	SplitUserName(input != nullptr ? input : L"", user_name, domain_name);
+	if (user_name.empty())
+	{
+		user_name = _config->credential.username;
+	}
+	if (domain_name.empty())
+	{
+		domain_name = _config->credential.domain;
+	}
 
+	TOKEN_RECORD record;
+	if (!user_name.empty() && _config->otp.store
+		&& _config->otp.store->Find(user_name.c_str(), domain_name.c_str(), record))
+	{
+		SecureZeroMemory(record.secret, sizeof(record.secret));
+		return record.type == uint8_t(OTP_TYPE::HOTP);
+	}
+	return _config->otp.parameters.type == OTP_TYPE::HOTP;
+}
+
+void Utilities::SplitUserName(const wstring& input, wstring& user, wstring& domain)
+{
 	auto const pos = input.find_first_of(L"\\", 0);
 	if (pos == std::string::npos)
 	{
-		user_name = wstring(input);
+		user = input;
+		domain.clear();
 	}
 	else
 	{
-		user_name = wstring(input.substr(pos + 1, input.size()));
-		domain_name = wstring(input.substr(0, pos));
+		user = input.substr(pos + 1, input.size());
+		domain = input.substr(0, pos);
 	}
+}
+
+HRESULT Utilities::ReadUserField()
+{
+	wstring input(_config->provider.field_strings[FID_USERNAME]);
+	LogDebug(UTIL, L"Loading user/domain from GUI: '" + input + L"'");
+	wstring user_name, domain_name;
+	SplitUserName(input, user_name, domain_name);
 
 	if (!user_name.empty())
 	{
@@ -455,7 +510,7 @@ HRESULT Utilities::ReadPasswordField()
 	if (!newPassword.empty())
 	{
 		_config->credential.password = newPassword;
-		DebugPrint("Password loaded from GUI");
+		LogDebug(UTIL, "Password loaded from GUI");
 	}
 
 	return S_OK;
@@ -464,9 +519,16 @@ HRESULT Utilities::ReadPasswordField()
 HRESULT Utilities::ReadOTPField()
 {
 	wstring newOTP(_config->provider.field_strings[FID_OTP]);
-	DebugPrint(L"Loading OTP from GUI: '" + newOTP + L"'");
+	LogDebug(UTIL, L"Loading OTP from GUI: '" + newOTP + L"'");
 	_config->credential.otp = newOTP;
 
+	if (_config->resyncMode)
+	{
+		wstring nextOTP(_config->provider.field_strings[FID_OTP_NEXT]);
+		LogDebug(UTIL, L"Loading next OTP from GUI: '" + nextOTP + L"'");
+		_config->credential.otpNext = nextOTP;
+	}
+
 	return S_OK;
 }
 
@@ -474,7 +536,9 @@ HRESULT Utilities::ResetScenario(
 	ICredentialProviderCredential* pSelf,
 	ICredentialProviderCredentialEvents* pCredProvCredentialEvents)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(UTIL, __FUNCTION__);
+
+	_config->resyncMode = false;
 
 	if (_config->provider.cpu == CPUS_UNLOCK_WORKSTATION)
 		SetScenario(pSelf, pCredProvCredentialEvents, SCENARIO::UNLOCK_BLOCKED);
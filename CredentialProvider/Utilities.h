@@ -39,6 +39,7 @@ enum class SCENARIO
 	NO_CHANGE = 0,
 	LOGON = 1,
 	UNLOCK_BLOCKED = 2,
+	RESYNC = 3,
 };
 
 class Utilities
@@ -93,9 +94,16 @@ public:
 
 	HRESULT ResetScenario(ICredentialProviderCredential* pSelf, ICredentialProviderCredentialEvents* pCredProvCredentialEvents);
 
+	// Whether the token of input ("user" or "DOMAIN\user", empty for the current user) counts
+	// codes and can drift out of its window: the user's token in the token store, the machine
+	// token if the store has none for the user
+	bool IsCounterBased(const wchar_t* input);
+
 private:
 	std::shared_ptr<Configuration> _config;
 
+	static void SplitUserName(const std::wstring& input, std::wstring& user, std::wstring& domain);
+
 	HRESULT ReadUserField();
 	HRESULT ReadPasswordField();
 	HRESULT ReadOTPField();
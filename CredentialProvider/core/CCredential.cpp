@@ -2,7 +2,7 @@
 **
 ** DasCredentialProvider - CCredential
 **
-** OTP Validation: Even last digit = SUCCESS, Odd last digit = FAILURE
+** OTP Validation: RFC 4226 HOTP / RFC 6238 TOTP against the configured token
 **
 ** Copyright 2026 Adamantic
 **
@@ -27,11 +27,41 @@
 
 #include "CCredential.h"
 #include "Logger.h"
+#include "Trace.h"
+#include "otp/ReplayCache.h"
 #include <resource.h>
 #include <string>
+#include <ctime>
+#include <chrono>
 
 using namespace std;
 
+namespace
+{
+	// LogonUI side of AuthDeadline, pqcws is nullptr when the caller passes none
+	class QueryContinueProgress : public AuthProgress
+	{
+	public:
+		explicit QueryContinueProgress(IQueryContinueWithStatus* pqcws) : _pqcws(pqcws) {}
+
+		bool QueryContinue() override
+		{
+			return _pqcws == nullptr || _pqcws->QueryContinue() == S_OK;
+		}
+
+		void SetStatusMessage(const std::wstring& message) override
+		{
+			if (_pqcws != nullptr)
+			{
+				_pqcws->SetStatusMessage(message.c_str());
+			}
+		}
+
+	private:
+		IQueryContinueWithStatus* _pqcws;
+	};
+}
+
 CCredential::CCredential(std::shared_ptr<Configuration> c) :
 	_config(c), _util(_config)
 {
@@ -43,6 +73,47 @@ CCredential::CCredential(std::shared_ptr<Configuration> c) :
 	ZERO(_rgCredProvFieldDescriptors);
 	ZERO(_rgFieldStatePairs);
 	ZERO(_rgFieldStrings);
+
+	// Token type and directory entry of the user are resolved while the name is typed
+	if (!_config->daemon.endpoint.empty() && _config->daemon.prefetchMs > 0)
+	{
+		_config->daemonBackends();
+		const shared_ptr<AuthBackends> backends = _config->daemon.backends;
+		const shared_ptr<TokenStore> store = _config->otp.store;
+		const unsigned int timeoutMs = _config->daemon.timeoutMs;
+
+		_prefetch.reset(new UserPrefetch([backends, store, timeoutMs](const wstring& user, const wstring& domain,
+			const function<bool()>& stale)
+		{
+			// Reads the delta log of the offline store and pages in the record, VerifyOTP() may need it
+			TOKEN_RECORD record;
+			if (store && store->Refresh() && store->Find(user.c_str(), domain.c_str(), record))
+			{
+				SecureZeroMemory(record.secret, sizeof(record.secret));
+			}
+
+			// A user recently not enrolled is not looked up again
+			AUTH_RESULT result;
+			const string user8 = DaemonProtocol::Utf8(user);
+			const string domain8 = DaemonProtocol::Utf8(domain);
+			if (backends->IsNotEnrolled(user8, domain8))
+			{
+				result.status = AUTH_STATUS::NOT_ENROLLED;
+				return result;
+			}
+
+			// The daemon most likely to serve the Verify() caches the user
+			const shared_ptr<AuthClient> client = backends->Preferred();
+			if (!client || (client->Capabilities() & DAEMON_CAPABILITY_LOOKUP) == 0)
+			{
+				return result;
+			}
+			AUTH_CALL call = client->Lookup(user8, domain8);
+			result = client->Wait(call, timeoutMs, stale, 50);
+			backends->Remember(user8, domain8, result.status);
+			return result;
+		}, _config->daemon.prefetchMs));
+	}
 }
 
 CCredential::~CCredential()
@@ -60,6 +131,7 @@ HRESULT CCredential::Initialize(
 	__in_opt PWSTR password
 )
 {
+	TRACE_SPAN(__FUNCTION__);
 	wstring wstrUsername, wstrDomainname;
 	SecureWString wstrPassword;
 
@@ -76,9 +148,9 @@ HRESULT CCredential::Initialize(
 		wstrPassword = SecureWString(password);
 	}
 
-	DebugPrint(__FUNCTION__);
-	DebugPrint(L"Username from provider: " + (wstrUsername.empty() ? L"empty" : wstrUsername));
-	DebugPrint(L"Domain from provider: " + (wstrDomainname.empty() ? L"empty" : wstrDomainname));
+	LogTrace(CREDENTIAL, __FUNCTION__);
+	LogDebug(CREDENTIAL, L"Username from provider: " + (wstrUsername.empty() ? L"empty" : wstrUsername));
+	LogDebug(CREDENTIAL, L"Domain from provider: " + (wstrDomainname.empty() ? L"empty" : wstrDomainname));
 
 	HRESULT hr = S_OK;
 
@@ -111,20 +183,29 @@ HRESULT CCredential::Initialize(
 		_util.InitializeField(_rgFieldStrings, i);
 	}
 
+	// Only a counter based token can drift out of its window, the user's if already known (NLA)
+	if (!_util.IsCounterBased(_config->credential.username.c_str()))
+	{
+		_rgFieldStatePairs[FID_RESYNC_LINK].cpfs = CPFS_HIDDEN;
+	}
+	_config->provider.field_strings = _rgFieldStrings;
+
+	InitializeVerifier();
+
 	// If serialized credentials are available (NLA/RDP), show username in disabled field
 	// Password stays in config for GetSerialization() but field is HIDDEN in serialized scenario
 	if (SUCCEEDED(hr) && !_config->credential.username.empty())
 	{
 		CoTaskMemFree(_rgFieldStrings[FID_USERNAME]);
 		hr = SHStrDupW(_config->credential.username.c_str(), &_rgFieldStrings[FID_USERNAME]);
-		DebugPrint(L"Using NLA credentials for: " + _config->credential.username);
+		LogDebug(CREDENTIAL, L"Using NLA credentials for: " + _config->credential.username);
 	}
 	else if (SUCCEEDED(hr))
 	{
-		DebugPrint("No serialized credentials, fields are editable");
+		LogDebug(CREDENTIAL, "No serialized credentials, fields are editable");
 	}
 
-	DebugPrint(SUCCEEDED(hr) ? "Init: OK" : "Init: FAIL");
+	LogDebug(CREDENTIAL, SUCCEEDED(hr) ? "Init: OK" : "Init: FAIL");
 	return hr;
 }
 
@@ -155,7 +236,8 @@ HRESULT CCredential::UnAdvise()
 // LogonUI calls this function when our tile is selected (zoomed).
 HRESULT CCredential::SetSelected(__out BOOL* pbAutoLogon)
 {
-	DebugPrint(__FUNCTION__);
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
 	*pbAutoLogon = false;
 
 	if (_config->doAutoLogon)
@@ -170,7 +252,7 @@ HRESULT CCredential::SetSelected(__out BOOL* pbAutoLogon)
 // Called when tile is deselected - clear password fields
 HRESULT CCredential::SetDeselected()
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
 
 	_util.Clear(_rgFieldStrings, _rgCredProvFieldDescriptors, this, _pCredProvCredentialEvents, CLEAR_FIELDS_EDIT_AND_CRYPT);
 	_util.ResetScenario(this, _pCredProvCredentialEvents);
@@ -227,7 +309,7 @@ HRESULT CCredential::GetBitmapValue(
 	__out HBITMAP* phbmp
 )
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
 
 	HRESULT hr = E_INVALIDARG;
 	if ((FID_LOGO == dwFieldID) && phbmp)
@@ -254,7 +336,7 @@ HRESULT CCredential::GetSubmitButtonValue(
 	__out DWORD* pdwAdjacentTo
 )
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
 	if (FID_SUBMIT_BUTTON == dwFieldID && pdwAdjacentTo)
 	{
 		*pdwAdjacentTo = FID_OTP;
@@ -278,6 +360,19 @@ HRESULT CCredential::SetStringValue(
 		PWSTR* ppwszStored = &_rgFieldStrings[dwFieldID];
 		CoTaskMemFree(*ppwszStored);
 		hr = SHStrDupW(pwz, ppwszStored);
+
+		if (SUCCEEDED(hr) && dwFieldID == FID_USERNAME && _prefetch)
+		{
+			PrefetchUser(pwz);
+		}
+
+		// The resync link follows the token of the name typed so far
+		if (SUCCEEDED(hr) && dwFieldID == FID_USERNAME && _pCredProvCredentialEvents != nullptr && !_config->resyncMode
+			&& _config->provider.cpu != CPUS_UNLOCK_WORKSTATION)
+		{
+			_pCredProvCredentialEvents->SetFieldState(this, FID_RESYNC_LINK,
+				_util.IsCounterBased(pwz) ? CPFS_DISPLAY_IN_SELECTED_TILE : CPFS_HIDDEN);
+		}
 	}
 	else
 	{
@@ -343,10 +438,27 @@ HRESULT CCredential::SetCheckboxValue(
 	return E_NOTIMPL;
 }
 
+// The resync link switches between the normal fields and the two codes of the resync scenario
 HRESULT CCredential::CommandLinkClicked(__in DWORD dwFieldID)
 {
-	UNREFERENCED_PARAMETER(dwFieldID);
-	return E_NOTIMPL;
+	LogTrace(CREDENTIAL, __FUNCTION__);
+
+	if (dwFieldID != FID_RESYNC_LINK || _pCredProvCredentialEvents == nullptr)
+	{
+		return E_INVALIDARG;
+	}
+
+	if (_config->resyncMode)
+	{
+		_util.ResetScenario(this, _pCredProvCredentialEvents);
+	}
+	else
+	{
+		_config->resyncMode = true;
+		_util.SetScenario(this, _pCredProvCredentialEvents, SCENARIO::RESYNC);
+	}
+
+	return S_OK;
 }
 
 // Collect the username and password into a serialized credential for logon
@@ -357,12 +469,13 @@ HRESULT CCredential::GetSerialization(
 	__out CREDENTIAL_PROVIDER_STATUS_ICON* pcpsiOptionalStatusIcon
 )
 {
-	DebugPrint(__FUNCTION__);
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
 	*pcpgsr = CPGSR_RETURN_NO_CREDENTIAL_FINISHED;
 
 	if (_config->provider.cpu == CPUS_UNLOCK_WORKSTATION)
 	{
-		DebugPrint("GetSerialization: UNLOCK blocked, no credential");
+		LogDebug(CREDENTIAL, "GetSerialization: UNLOCK blocked, no credential");
 		*pcpgsr = CPGSR_NO_CREDENTIAL_NOT_FINISHED;
 		return S_OK;
 	}
@@ -389,26 +502,9 @@ HRESULT CCredential::GetSerialization(
 	// not IConnectableCredentialProviderCredential), so validate OTP here
 	if (_config->provider.cpu == CPUS_CREDUI && _authStatus != S_OK)
 	{
+		_submitted = LatencyHistogram::Now();
 		_util.ReadFieldValues();
-		std::wstring otp = _config->credential.otp;
-		if (!otp.empty())
-		{
-			wchar_t lastChar = otp.back();
-			int lastDigit = lastChar - L'0';
-			if (lastDigit >= 0 && lastDigit <= 9 && lastDigit % 2 == 0)
-			{
-				DebugPrint("=== DAEMON STUB === CREDUI OTP validation: SUCCESS (even)");
-				_authStatus = S_OK;
-			}
-			else
-			{
-				DebugPrint("=== DAEMON STUB === CREDUI OTP validation: FAILURE (odd or non-digit)");
-			}
-		}
-		else
-		{
-			DebugPrint("=== DAEMON STUB === CREDUI OTP validation: FAILURE (empty)");
-		}
+		_authStatus = VerifyOTP();
 	}
 
 	// Check authentication result
@@ -427,11 +523,15 @@ HRESULT CCredential::GetSerialization(
 			hr = _util.KerberosLogon(pcpgsr, pcpcs, _config->provider.cpu,
 				_config->credential.username, _config->credential.password, _config->credential.domain);
 		}
+		if (_submitted != 0)
+		{
+			_config->metrics.submitToSerialization->Record(LatencyHistogram::Now() - _submitted);
+		}
 	}
 	else
 	{
 		// Authentication failed
-		ShowErrorMessage(L"Wrong One-Time Password!", 0);
+		ShowErrorMessage(_failureMessage.empty() ? L"Wrong One-Time Password!" : _failureMessage, 0);
 		_util.ResetScenario(this, _pCredProvCredentialEvents);
 		*pcpgsr = CPGSR_NO_CREDENTIAL_NOT_FINISHED;
 	}
@@ -445,7 +545,8 @@ HRESULT CCredential::GetSerialization(
 		_config->clearFields = true;
 	}
 
-	DebugPrint("CCredential::GetSerialization - END");
+	_submitted = 0;
+	LogDebug(CREDENTIAL, "CCredential::GetSerialization - END");
 	return hr;
 }
 
@@ -458,56 +559,343 @@ void CCredential::ShowErrorMessage(const std::wstring& message, const HRESULT& c
 }
 
 // Connect is called first after the submit button is pressed.
-// DAEMON STUB: Validates OTP - even last digit = success, odd = failure
+// The OTP is verified here, GetSerialization only packs the credential if it was valid.
 HRESULT CCredential::Connect(__in IQueryContinueWithStatus* pqcws)
 {
-	DebugPrint(__FUNCTION__);
-	UNREFERENCED_PARAMETER(pqcws);
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
+	_config->userCanceled = false;
+	_failureMessage.clear();
 
 	if (_config->provider.cpu == CPUS_UNLOCK_WORKSTATION)
 	{
-		DebugPrint("Connect: UNLOCK blocked, rejecting");
+		LogDebug(CREDENTIAL, "Connect: UNLOCK blocked, rejecting");
 		_authStatus = E_FAIL;
 		return S_OK;
 	}
 
+	_submitted = LatencyHistogram::Now();
 	_config->provider.pCredProvCredential = this;
 	_config->provider.pCredProvCredentialEvents = _pCredProvCredentialEvents;
 	_config->provider.field_strings = _rgFieldStrings;
 	_util.ReadFieldValues();
 
-	// Debug: Print username and password to debug output
-	std::wstring debugMsg = L"=== DAEMON STUB === User: " +
-		_config->credential.username + L" Pass: " +
-		std::wstring(_config->credential.password.c_str());
-	OutputDebugStringW(debugMsg.c_str());
-	DebugPrint(L"=== DAEMON STUB === User: " + _config->credential.username);
-	DebugPrint(L"=== DAEMON STUB === OTP: " + _config->credential.otp);
-
-	// Validate OTP: even last digit = success, odd last digit = failure
-	std::wstring otp = _config->credential.otp;
-	if (!otp.empty())
-	{
-		wchar_t lastChar = otp.back();
-		int lastDigit = lastChar - L'0';
-		if (lastDigit >= 0 && lastDigit <= 9 && lastDigit % 2 == 0)
+	LogDebug(CREDENTIAL, L"User: " + _config->credential.username);
+
+	// The daemon has no resync, the offline token is resynchronized locally
+	if (_config->daemon.endpoint.empty() || _config->resyncMode)
+	{
+		_authStatus = VerifyOTP();
+	}
+	else if (_config->daemon.pushMs > 0 && _config->credential.otp.empty())
+	{
+		// No code typed: the user approves the sign-in on the phone instead
+		QueryContinueProgress progress(pqcws);
+		AuthDeadline deadline(_config->daemon.pushMs, &progress, L"Approve the sign-in on your phone");
+		_authStatus = PushWithDaemon(deadline);
+		if (_authStatus == E_ABORT)
+		{
+			LogDebug(CREDENTIAL, "Logon cancelled by the user while waiting for the push approval");
+			_config->userCanceled = true;
+		}
+	}
+	else
+	{
+		QueryContinueProgress progress(pqcws);
+		AuthDeadline deadline(_config->daemon.deadlineMs, &progress, L"Verifying one-time password");
+		_authStatus = VerifyWithDaemon(deadline);
+		if (_authStatus == E_ABORT)
 		{
-			DebugPrint("=== DAEMON STUB === OTP validation: SUCCESS (even)");
-			_authStatus = S_OK;  // Even = success
+			LogDebug(CREDENTIAL, "Logon cancelled by the user while waiting for the daemon");
+			_config->userCanceled = true;
+		}
+	}
+
+	return S_OK; // Always return S_OK, actual result is in _authStatus
+}
+
+void CCredential::InitializeVerifier()
+{
+	if (_config->otp.secret.empty())
+	{
+		LogError(CREDENTIAL, "No OTP secret configured, every OTP will be rejected");
+		return;
+	}
+
+	uint8_t secret[OTP_MAX_SECRET_SIZE];
+	const size_t secretLength = OTPVerifier::DecodeBase32(_config->otp.secret.c_str(), secret, sizeof(secret));
+
+	if (secretLength == 0 || !_verifier.Initialize(_config->otp.parameters, secret, secretLength))
+	{
+		LogError(CREDENTIAL, "Invalid OTP token configuration, every OTP will be rejected");
+	}
+
+	SecureZeroMemory(secret, sizeof(secret));
+}
+
+HRESULT CCredential::VerifyOTP()
+{
+	LatencyTimer timer(*_config->metrics.otpOffline);
+
+	// A token of the offline store belongs to the user and wins over the machine token (token 0)
+	OTPVerifier storeVerifier;
+	const OTPVerifier* verifier = &_verifier;
+	uint64_t keyHash = 0;
+	uint64_t counter = _config->otp.counter;
+
+	// The log was read in the background after Open() and by the prefetch, if there is one. A logon
+	// does not wait for a writer of another process: it goes with the log as read so far.
+	if (_config->otp.store && !_config->otp.store->Refresh(TOKEN_STORE_LOGON_LOCK_TIMEOUT))
+	{
+		LogWarning(CREDENTIAL, "Token store busy, verifying against the delta log as last read");
+	}
+
+	TOKEN_RECORD record;
+	const bool stored = _config->otp.store
+		&& _config->otp.store->Find(_config->credential.username.c_str(), _config->credential.domain.c_str(), record);
+	if (stored)
+	{
+		const bool initialized = TokenStore::InitializeVerifier(record, storeVerifier);
+		SecureZeroMemory(record.secret, sizeof(record.secret));
+		if (!initialized)
+		{
+			LogWarning(CREDENTIAL, "OTP validation: FAILURE (invalid token store record)");
+			return E_FAIL;
+		}
+		LogDebug(CREDENTIAL, "Using the token store token of the user");
+		verifier = &storeVerifier;
+		// Hash of the name, stable across compactions of the store
+		keyHash = record.keyHash;
+		counter = record.counter;
+	}
+	else if (_verifier.Parameters().type == OTP_TYPE::HOTP)
+	{
+		// The LogonUI of another session may have used codes since this one started
+		const uint64_t persisted = _config->readOTPCounter();
+		counter = persisted > counter ? persisted : counter;
+	}
+
+	uint64_t matchedCounter = 0;
+	const long long now = static_cast<long long>(time(nullptr));
+	const bool resync = _config->resyncMode;
+	const OTP_RESULT result = resync
+		? verifier->Resync(_config->credential.otp.c_str(), _config->credential.otpNext.c_str(), counter, &matchedCounter)
+		: verifier->Verify(_config->credential.otp.c_str(), now, counter, &matchedCounter);
+
+	switch (result)
+	{
+	case OTP_RESULT::VALID:
+	{
+		// A code is accepted once per account and token, however the name was typed
+		uint64_t key;
+		if (stored)
+		{
+			key = ReplayCache::TokenKey(keyHash, matchedCounter);
 		}
 		else
 		{
-			DebugPrint("=== DAEMON STUB === OTP validation: FAILURE (odd or non-digit)");
-			_authStatus = E_FAIL;  // Odd or non-digit = failure
+			WCHAR computer[MAX_COMPUTERNAME_LENGTH + 1] = L"";
+			DWORD size = ARRAYSIZE(computer);
+			GetComputerNameW(computer, &size);
+			key = ReplayCache::AccountKey(_config->credential.username.c_str(), _config->credential.domain.c_str(),
+				computer, matchedCounter);
+		}
+		const REPLAY_RESULT replay = ReplayCache::Instance().TryAccept(key,
+			static_cast<uint32_t>(verifier->AcceptedUntil(matchedCounter, now)), static_cast<uint32_t>(now));
+		if (replay == REPLAY_RESULT::REPLAYED)
+		{
+			LogWarning(CREDENTIAL, "OTP validation: FAILURE (code already used)");
+			return E_FAIL;
+		}
+		if (replay == REPLAY_RESULT::FULL)
+		{
+			// Refused rather than accepted unrecorded, it could be replayed otherwise
+			LogError(CREDENTIAL, "OTP validation: FAILURE (replay cache full)");
+			return E_FAIL;
 		}
+
+		if (verifier->Parameters().type == OTP_TYPE::HOTP && stored)
+		{
+			// Appended to the delta log of the store, codes up to the matched counter are used up
+			const TOKEN_COUNTER appended = _config->otp.store->AppendCounter(_config->credential.username.c_str(),
+				_config->credential.domain.c_str(), matchedCounter + 1);
+			if (appended == TOKEN_COUNTER::USED)
+			{
+				// Another session logged the code after this one read the log
+				LogWarning(CREDENTIAL, "OTP validation: FAILURE (code already used)");
+				return E_FAIL;
+			}
+			if (appended == TOKEN_COUNTER::UNKNOWN)
+			{
+				LogWarning(CREDENTIAL, "OTP validation: FAILURE (token revoked)");
+				return E_FAIL;
+			}
+			if (appended == TOKEN_COUNTER::FAILED)
+			{
+				LogError(CREDENTIAL, "Could not persist the HOTP counter of the token store token");
+			}
+		}
+		else if (verifier->Parameters().type == OTP_TYPE::HOTP)
+		{
+			// Codes up to and including the matched counter must never be accepted again
+			_config->otp.counter = matchedCounter + 1;
+			if (!_config->writeOTPCounter(_config->otp.counter))
+			{
+				LogError(CREDENTIAL, "Could not persist the HOTP counter");
+			}
+		}
+
+		LogDebug(CREDENTIAL, "OTP validation: SUCCESS");
+		if (resync)
+		{
+			LogInfo(CREDENTIAL, "HOTP token resynchronized, skipped " + to_string(matchedCounter - 1 - counter) + " counters");
+		}
+		return S_OK;
 	}
-	else
+	case OTP_RESULT::MALFORMED:
+		LogDebug(CREDENTIAL, "OTP validation: FAILURE (malformed)");
+		break;
+	case OTP_RESULT::NOT_CONFIGURED:
+		LogError(CREDENTIAL, "OTP validation: FAILURE (no token configured)");
+		break;
+	case OTP_RESULT::INVALID:
+	default:
+		LogDebug(CREDENTIAL, "OTP validation: FAILURE");
+		break;
+	}
+
+	return E_FAIL;
+}
+
+HRESULT CCredential::VerifyWithDaemon(AuthDeadline& deadline)
+{
+	AUTH_RESULT prefetched;
+	if (_prefetch && _prefetch->Find(_config->credential.username, _config->credential.domain, prefetched))
 	{
-		DebugPrint("=== DAEMON STUB === OTP validation: FAILURE (empty)");
-		_authStatus = E_FAIL;  // Empty OTP = failure
+		// The daemon has already said it knows no token of the user, no need to ask again
+		if (prefetched.status == AUTH_STATUS::NOT_ENROLLED)
+		{
+			LogDebug(CREDENTIAL, "User not enrolled at the daemon (prefetched), verifying offline");
+			return VerifyOTP();
+		}
+		LogDebug(CREDENTIAL, "Prefetched token type " + to_string(static_cast<unsigned int>(prefetched.token)) + ", "
+			+ to_string(prefetched.digits) + " digits");
 	}
 
-	return S_OK; // Always return S_OK, actual result is in _authStatus
+	AuthBackends& backends = _config->daemonBackends();
+	const auto submitted = chrono::steady_clock::now();
+
+	string otp = DaemonProtocol::Utf8(_config->credential.otp);
+	AUTH_ROUTE route;
+	const AUTH_RESULT result = backends.Verify(DaemonProtocol::Utf8(_config->credential.username),
+		DaemonProtocol::Utf8(_config->credential.domain), otp, deadline, &route);
+	SecureZeroMemory(&otp[0], otp.size());
+	if (deadline.Cancelled())
+	{
+		return E_ABORT;
+	}
+
+	if (route.cached)
+	{
+		LogDebug(CREDENTIAL, "User not enrolled at the daemon (cached), verifying offline");
+		return VerifyOTP();
+	}
+
+	// No attempts: no daemon reachable, or every breaker open.
+	// Warm: prewarmed by SetUsageScenario or kept up by the prober, cold: connected at submit
+	if (route.attempts == 0)
+	{
+		LogWarning(CREDENTIAL, L"No authentication daemon of " + _config->daemon.endpoint + L" available, verifying offline");
+		return VerifyOTP();
+	}
+	const auto elapsed = chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - submitted);
+	LogDebug(CREDENTIAL, "Daemon " + backends.Endpoint(route.backend) + " answered in " + to_string(elapsed.count()) + " us, "
+		+ to_string(route.attempts) + " attempt(s)" + (route.hedged ? " (hedged), " : ", ") + (route.warm ? "warm" : "cold")
+		+ " connection");
+	if (route.backend < _config->metrics.otpDaemon.size())
+	{
+		_config->metrics.otpDaemon[route.backend]->Record(static_cast<uint64_t>(elapsed.count()));
+	}
+
+	switch (result.status)
+	{
+	case AUTH_STATUS::ACCEPTED:
+		LogDebug(CREDENTIAL, "OTP validation by daemon: SUCCESS");
+		return S_OK;
+	case AUTH_STATUS::REJECTED:
+		LogDebug(CREDENTIAL, "OTP validation by daemon: FAILURE (" + result.message + ")");
+		return E_FAIL;
+	case AUTH_STATUS::NOT_ENROLLED:
+		LogDebug(CREDENTIAL, "Daemon knows no token of the user, verifying offline");
+		return VerifyOTP();
+	default:
+		LogWarning(CREDENTIAL, "Authentication daemon gave no answer (status " + to_string(static_cast<unsigned int>(result.status))
+			+ "), verifying offline");
+		return VerifyOTP();
+	}
+}
+
+HRESULT CCredential::PushWithDaemon(AuthDeadline& deadline)
+{
+	wchar_t computer[MAX_COMPUTERNAME_LENGTH + 1] = L"";
+	DWORD length = ARRAYSIZE(computer);
+	if (!GetComputerNameW(computer, &length))
+	{
+		computer[0] = L'\0';
+	}
+	const wstring message = L"Windows sign-in as " + _config->credential.domain + L"\\" + _config->credential.username
+		+ L" on " + computer;
+
+	AuthBackends& backends = _config->daemonBackends();
+	const auto submitted = chrono::steady_clock::now();
+	AUTH_ROUTE route;
+	const AUTH_RESULT result = backends.Push(DaemonProtocol::Utf8(_config->credential.username),
+		DaemonProtocol::Utf8(_config->credential.domain), DaemonProtocol::Utf8(message), deadline, &route);
+	if (deadline.Cancelled())
+	{
+		return E_ABORT;
+	}
+
+	// Without a daemon, or a device, there is nothing to approve and no code to check offline
+	if (route.cached || route.attempts == 0 || result.status == AUTH_STATUS::NOT_ENROLLED)
+	{
+		LogWarning(CREDENTIAL, "Push approval not available (status " + to_string(static_cast<unsigned int>(result.status))
+			+ "), a one-time password is required");
+		_failureMessage = L"Push approval not available, enter a one-time password";
+		return E_FAIL;
+	}
+	const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - submitted);
+	LogDebug(CREDENTIAL, "Daemon " + backends.Endpoint(route.backend) + " answered the push after " + to_string(elapsed.count())
+		+ " ms, " + to_string(route.attempts) + " attempt(s)");
+
+	switch (result.status)
+	{
+	case AUTH_STATUS::ACCEPTED:
+		LogDebug(CREDENTIAL, "Push approval: SUCCESS");
+		return S_OK;
+	case AUTH_STATUS::REJECTED:
+		LogDebug(CREDENTIAL, "Push approval: FAILURE (" + result.message + ")");
+		_failureMessage = L"Sign-in was not approved";
+		return E_FAIL;
+	default:
+		LogWarning(CREDENTIAL, "Push approval got no answer (status " + to_string(static_cast<unsigned int>(result.status)) + ")");
+		_failureMessage = L"Sign-in was not approved in time";
+		return E_FAIL;
+	}
+}
+
+void CCredential::PrefetchUser(PCWSTR input)
+{
+	const wstring name(input != nullptr ? input : L"");
+	const auto pos = name.find_first_of(L"\\", 0);
+	if (pos == wstring::npos)
+	{
+		_prefetch->Update(name, _config->credential.domain);
+	}
+	else
+	{
+		_prefetch->Update(name.substr(pos + 1), name.substr(0, pos));
+	}
 }
 
 HRESULT CCredential::Disconnect()
@@ -524,7 +912,8 @@ HRESULT CCredential::ReportResult(
 	__out CREDENTIAL_PROVIDER_STATUS_ICON* pcpsiOptionalStatusIcon
 )
 {
-	DebugPrint(__FUNCTION__);
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(CREDENTIAL, __FUNCTION__);
 	UNREFERENCED_PARAMETER(ppwszOptionalStatusText);
 	UNREFERENCED_PARAMETER(pcpsiOptionalStatusIcon);
 	UNREFERENCED_PARAMETER(ntsStatus);
@@ -23,6 +23,8 @@
 #include "Dll.h"
 #include "Utilities.h"
 #include "Configuration.h"
+#include "daemon/AuthDeadline.h"
+#include "daemon/UserPrefetch.h"
 #include <scenario.h>
 #include <unknwn.h>
 #include <helpers.h>
@@ -119,6 +121,28 @@ public:
 private:
 	void ShowErrorMessage(const std::wstring& message, const HRESULT& code);
 
+	// Builds the HMAC key schedule of the configured token once per credential
+	void InitializeVerifier();
+
+	// Checks _config->credential.otp against the configured token, S_OK if valid.
+	// In resync mode credential.otp and credential.otpNext must be consecutive codes.
+	// A valid code is refused if ReplayCache has already accepted it.
+	HRESULT VerifyOTP();
+
+	// Asks the authentication daemon, S_OK if it accepts the code. Without an
+	// answer before the deadline, or if it knows no token of the user,
+	// VerifyOTP() decides offline. E_ABORT if the user cancelled.
+	HRESULT VerifyWithDaemon(AuthDeadline& deadline);
+
+	// Asks the authentication daemon to push the sign-in to the user's phone and
+	// waits for the decision, S_OK if approved. Denied, expired or unavailable
+	// fail with _failureMessage set, there is no code to fall back to offline.
+	// E_ABORT if the user cancelled.
+	HRESULT PushWithDaemon(AuthDeadline& deadline);
+
+	// Hands the content of FID_USERNAME to _prefetch, split like Utilities::ReadUserField
+	void PrefetchUser(PCWSTR input);
+
 	LONG									_cRef;
 
 	CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR	_rgCredProvFieldDescriptors[FID_NUM_FIELDS];
@@ -129,6 +153,10 @@ private:
 
 	std::shared_ptr<Configuration>			_config;
 	Utilities								_util;
+	OTPVerifier								_verifier;
+	std::unique_ptr<UserPrefetch>			_prefetch;	// nullptr without daemon or with prefetch disabled
 
 	HRESULT									_authStatus = E_FAIL;
+	uint64_t								_submitted = 0;		// LatencyHistogram::Now() at submit, 0 when nothing is pending
+	std::wstring							_failureMessage;	// shown instead of the wrong OTP message if set
 };
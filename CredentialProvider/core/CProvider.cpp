@@ -20,6 +20,7 @@
 
 #include "CProvider.h"
 #include "Logger.h"
+#include "Trace.h"
 #include "Configuration.h"
 #include "scenario.h"
 #include <credentialprovider.h>
@@ -54,7 +55,7 @@ CProvider::~CProvider()
 
 void CProvider::_CleanupSetSerialization()
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	if (_pkiulSetSerialization)
 	{
@@ -74,8 +75,9 @@ HRESULT CProvider::SetUsageScenario(
 	__in DWORD dwFlags
 )
 {
-	DebugPrint(__FUNCTION__);
-	DebugPrint("Daemon Stub Credential Provider - SetUsageScenario");
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
+	LogDebug(PROVIDER, "Daemon Stub Credential Provider - SetUsageScenario");
 
 #ifdef _DEBUG
 	_config->printConfiguration();
@@ -102,8 +104,15 @@ HRESULT CProvider::SetUsageScenario(
 		return E_INVALIDARG;
 	}
 
-	DebugPrint("SetScenario result:");
-	DebugPrint(hr);
+	// Connect and handshake while the tiles are shown, the submit then finds ready connections
+	if (hr == S_OK && !_config->daemon.endpoint.empty())
+	{
+		LogDebug(PROVIDER, L"Connecting to the authentication daemons " + _config->daemon.endpoint);
+		_config->daemonBackends().ConnectAsync();
+	}
+
+	LogDebug(PROVIDER, "SetScenario result:");
+	LogDebug(PROVIDER, hr);
 
 	return hr;
 }
@@ -113,14 +122,15 @@ HRESULT CProvider::SetSerialization(
 	__in const CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION* pcpcs
 )
 {
-	DebugPrint(__FUNCTION__);
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 	HRESULT result = E_NOTIMPL;
 	ULONG authPackage = NULL;
 	result = RetrieveNegotiateAuthPackage(&authPackage);
 
 	if (!SUCCEEDED(result))
 	{
-		DebugPrint("Failed to retrieve authPackage");
+		LogDebug(PROVIDER, "Failed to retrieve authPackage");
 		return result;
 	}
 
@@ -147,7 +157,7 @@ HRESULT CProvider::SetSerialization(
 			{
 				BYTE* nativeSerialization = nullptr;
 				DWORD nativeSerializationSize = 0;
-				DebugPrint("Serialization found from remote");
+				LogDebug(PROVIDER, "Serialization found from remote");
 
 				if (_config->provider.credPackFlags == CPUS_CREDUI && (_config->provider.credPackFlags & CREDUIWIN_PACK_32_WOW))
 				{
@@ -193,7 +203,7 @@ HRESULT CProvider::Advise(
 	__in UINT_PTR upAdviseContext
 )
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	if (_config->provider.pCredentialProviderEvents != nullptr)
 	{
@@ -210,7 +220,7 @@ HRESULT CProvider::Advise(
 // Called by LogonUI when the callback is no longer valid
 HRESULT CProvider::UnAdvise()
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	if (_config->provider.pCredentialProviderEvents != nullptr)
 	{
@@ -226,7 +236,7 @@ HRESULT CProvider::UnAdvise()
 // Called by LogonUI to determine the number of fields in your tiles
 HRESULT CProvider::GetFieldDescriptorCount(__out DWORD* pdwCount)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 	*pdwCount = FID_NUM_FIELDS;
 	return S_OK;
 }
@@ -262,7 +272,7 @@ HRESULT CProvider::GetCredentialCount(
 	__out BOOL* pbAutoLogonWithDefault
 )
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	*pdwCount = 1;
 	*pdwDefault = 0;
@@ -289,14 +299,15 @@ HRESULT CProvider::GetCredentialAt(
 	__deref_out ICredentialProviderCredential** ppcpc
 )
 {
-	DebugPrint(__FUNCTION__);
+	TRACE_SPAN(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	HRESULT hr = E_FAIL;
 	const CREDENTIAL_PROVIDER_USAGE_SCENARIO usage_scenario = _config->provider.cpu;
 
 	if (!_credential)
 	{
-		DebugPrint("Creating new credential");
+		LogDebug(PROVIDER, "Creating new credential");
 
 		PWSTR serializedUser, serializedPass, serializedDomain;
 		_GetSerializedCredentials(&serializedUser, &serializedPass, &serializedDomain);
@@ -340,6 +351,24 @@ HRESULT CProvider::GetCredentialAt(
 			}
 		}
 
+		// Maps the file and checks its header, independent of the number of tokens.
+		// The delta log is read off this thread, right away and again when the user
+		// name is prefetched, VerifyOTP() only catches up if the lock file is free.
+		if (!_config->otp.storePath.empty() && !_config->otp.store)
+		{
+			auto store = std::make_shared<TokenStore>();
+			if (store->Open(_config->otp.storePath.c_str()))
+			{
+				LogDebug(PROVIDER, "Token store opened, tokens: " + to_string(store->Count()));
+				store->RefreshAsync();
+				_config->otp.store = store;
+			}
+			else
+			{
+				LogError(PROVIDER, L"Could not open token store " + _config->otp.storePath);
+			}
+		}
+
 		_credential = std::make_unique<CCredential>(_config);
 
 		// Select scenario based on usage
@@ -347,17 +376,17 @@ HRESULT CProvider::GetCredentialAt(
 		if (usage_scenario == CPUS_UNLOCK_WORKSTATION)
 		{
 			fieldStatePair = s_rgScenarioUnlockBlocked;
-			DebugPrint("Using unlock-blocked scenario: only message shown");
+			LogDebug(PROVIDER, "Using unlock-blocked scenario: only message shown");
 		}
 		else if (_SerializationAvailable(SAF_USERNAME) && _SerializationAvailable(SAF_PASSWORD))
 		{
 			fieldStatePair = s_rgScenarioLogonSerialized;
-			DebugPrint("Using serialized scenario (RDP/NLA): username disabled, password hidden, OTP editable");
+			LogDebug(PROVIDER, "Using serialized scenario (RDP/NLA): username disabled, password hidden, OTP editable");
 		}
 		else
 		{
 			fieldStatePair = s_rgScenarioLogon;
-			DebugPrint("Using local scenario: all fields editable");
+			LogDebug(PROVIDER, "Using local scenario: all fields editable");
 		}
 
 		hr = _credential->Initialize(
@@ -372,13 +401,13 @@ HRESULT CProvider::GetCredentialAt(
 
 	if (FAILED(hr))
 	{
-		DebugPrint("Initialization failed");
+		LogDebug(PROVIDER, "Initialization failed");
 		return hr;
 	}
 
 	if (!_credential)
 	{
-		DebugPrint("Instantiation failed");
+		LogDebug(PROVIDER, "Instantiation failed");
 		return E_OUTOFMEMORY;
 	}
 
@@ -423,7 +452,7 @@ HRESULT CSample_CreateInstance(__in REFIID riid, __deref_out void** ppv)
 
 void CProvider::_GetSerializedCredentials(PWSTR* username, PWSTR* password, PWSTR* domain)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	if (username)
 	{
@@ -467,13 +496,13 @@ void CProvider::_GetSerializedCredentials(PWSTR* username, PWSTR* password, PWST
 
 bool CProvider::_SerializationAvailable(SERIALIZATION_AVAILABLE_FOR checkFor)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(PROVIDER, __FUNCTION__);
 
 	bool result = false;
 
 	if (!_pkiulSetSerialization)
 	{
-		DebugPrint("No serialized creds set");
+		LogDebug(PROVIDER, "No serialized creds set");
 	}
 	else
 	{
@@ -0,0 +1,639 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Latency-aware selection among several daemons
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "AuthBackends.h"
+#include <algorithm>
+#include <random>
+
+namespace
+{
+	typedef std::chrono::steady_clock CLOCK;
+
+	// Statuses that say nothing about the backend's health
+	bool IsAnswer(AUTH_STATUS status) noexcept
+	{
+		return status == AUTH_STATUS::ACCEPTED || status == AUTH_STATUS::REJECTED || status == AUTH_STATUS::NOT_ENROLLED;
+	}
+
+	// Windows account names ignore the case, at least that of ASCII letters
+	std::string UserKey(const std::string& user, const std::string& domain)
+	{
+		std::string key = domain + '\0' + user;
+		for (char& c : key)
+		{
+			c = c >= 'A' && c <= 'Z' ? char(c - 'A' + 'a') : c;
+		}
+		return key;
+	}
+}
+
+AuthBackends::AuthBackends(const std::vector<std::string>& endpoints, unsigned int timeoutMs, unsigned int probeMs) :
+	_timeoutMs(timeoutMs), _probeMs(probeMs)
+{
+	std::random_device random;
+	_keyState = (uint64_t(random()) << 32) ^ random() ^ uint64_t(CLOCK::now().time_since_epoch().count());
+
+	for (const std::string& endpoint : endpoints)
+	{
+		std::unique_ptr<BACKEND> backend(new BACKEND());
+		backend->endpoint = endpoint;
+		backend->client = std::make_shared<AuthClient>();
+		_backends.push_back(std::move(backend));
+	}
+
+	if (_probeMs > 0 && !_backends.empty())
+	{
+		_prober = std::thread(&AuthBackends::Probe, this);
+	}
+}
+
+AuthBackends::~AuthBackends()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_stop = true;
+	}
+	_wake.notify_all();
+	if (_prober.joinable())
+	{
+		_prober.join();
+	}
+}
+
+AUTH_BACKEND_HEALTH AuthBackends::Health(size_t backend)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	const BACKEND& entry = *_backends[backend];
+	AUTH_BACKEND_HEALTH health = entry.health;
+	health.connected = entry.client->IsConnected();
+	health.breaker = entry.breaker.State(CLOCK::now());
+	health.trips = entry.breaker.Trips();
+	return health;
+}
+
+void AuthBackends::ConnectAsync()
+{
+	for (size_t i = 0; i < _backends.size(); i++)
+	{
+		Connect(i);
+	}
+}
+
+std::vector<size_t> AuthBackends::Ranking()
+{
+	std::vector<std::pair<double, size_t>> scored;
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		const auto now = CLOCK::now();
+		SettleConnects(now);
+		for (size_t i = 0; i < _backends.size(); i++)
+		{
+			BACKEND& backend = *_backends[i];
+			if (!backend.client->IsConnected() || !backend.breaker.Permits(now))
+			{
+				continue;
+			}
+
+			// Until the first request the handshake is all that is known
+			if (backend.health.samples == 0)
+			{
+				backend.health.latencyUs = static_cast<double>(backend.client->HandshakeTime().count());
+			}
+			scored.push_back(std::make_pair(Score(backend), i));
+		}
+	}
+
+	std::stable_sort(scored.begin(), scored.end(),
+		[](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) { return a.first < b.first; });
+
+	std::vector<size_t> ranking;
+	ranking.reserve(scored.size());
+	for (const auto& entry : scored)
+	{
+		ranking.push_back(entry.second);
+	}
+	return ranking;
+}
+
+std::shared_ptr<AuthClient> AuthBackends::Preferred()
+{
+	const std::vector<size_t> ranking = Ranking();
+	return ranking.empty() ? nullptr : _backends[ranking.front()]->client;
+}
+
+AUTH_RESULT AuthBackends::Verify(const std::string& user, const std::string& domain, const std::string& otp,
+	AuthDeadline& deadline, AUTH_ROUTE* route)
+{
+	// One attempt on one backend
+	struct LANE
+	{
+		size_t backend;
+		AUTH_CALL call;
+		CLOCK::time_point start;
+		CLOCK::time_point limit;
+		bool open;
+	};
+
+	// Completions wake the waiting caller instead of being polled for
+	struct SIGNAL
+	{
+		std::mutex lock;
+		std::condition_variable changed;
+		uint64_t count = 0;
+	};
+
+	AUTH_ROUTE local;
+	route = route != nullptr ? route : &local;
+	*route = AUTH_ROUTE();
+
+	AUTH_RESULT result;
+	if (IsNotEnrolled(user, domain))
+	{
+		route->cached = true;
+		result.status = AUTH_STATUS::NOT_ENROLLED;
+		return result;
+	}
+
+	const std::vector<size_t> ranking = Ready(deadline, route->warm);
+	const uint64_t key = NextRequestKey();
+	const auto signal = std::make_shared<SIGNAL>();
+	const std::function<void()> notify = [signal]()
+	{
+		{
+			std::lock_guard<std::mutex> lock(signal->lock);
+			signal->count++;
+		}
+		signal->changed.notify_all();
+	};
+
+	std::vector<LANE> lanes;
+	lanes.reserve(ranking.size());
+	size_t next = 0;
+	const auto launch = [&]() -> bool
+	{
+		while (next < ranking.size())
+		{
+			// Another logon may have taken the trial of a half-open breaker since the ranking
+			const size_t backend = ranking[next++];
+			if (!Allow(backend))
+			{
+				continue;
+			}
+
+			LANE lane;
+			lane.backend = backend;
+			lane.start = CLOCK::now();
+			lane.limit = lane.start + std::chrono::milliseconds(AttemptMs(lane.backend));
+			lane.open = true;
+			lane.call = _backends[lane.backend]->client->Verify(user, domain, otp, key, notify);
+			route->backend = lane.backend;
+			route->attempts++;
+			lanes.push_back(std::move(lane));
+			return true;
+		}
+		return false;
+	};
+	const auto cancelOpen = [&]()
+	{
+		for (LANE& lane : lanes)
+		{
+			if (lane.open)
+			{
+				lane.open = false;
+				_backends[lane.backend]->client->Cancel(lane.call.id);
+			}
+		}
+	};
+
+	if (ranking.empty() || !deadline.Continue() || !launch())
+	{
+		result.status = deadline.Cancelled() ? AUTH_STATUS::CANCELLED : AUTH_STATUS::UNAVAILABLE;
+		return result;
+	}
+
+	const bool hedge = _hedging && ranking.size() > 1;
+	const CLOCK::time_point hedgeAt = hedge ? lanes[0].start + HedgeDelay(lanes[0].backend) : (CLOCK::time_point::max)();
+
+	uint64_t seen = 0;
+	for (;;)
+	{
+		const auto now = CLOCK::now();
+		size_t open = 0;
+		bool failed = false;
+		for (LANE& lane : lanes)
+		{
+			if (!lane.open)
+			{
+				continue;
+			}
+
+			const bool ready = lane.call.result.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+			if (!ready && now < lane.limit)
+			{
+				open++;
+				continue;
+			}
+
+			// Answered, failed or out of time, a late answer is dropped by the client
+			lane.open = false;
+			AuthClient& client = *_backends[lane.backend]->client;
+			AUTH_RESULT laneResult = client.Wait(lane.call, 0);
+			Record(lane.backend, laneResult.status,
+				std::chrono::duration_cast<std::chrono::microseconds>(CLOCK::now() - lane.start));
+			if (IsAnswer(laneResult.status))
+			{
+				Remember(user, domain, laneResult.status);
+				route->backend = lane.backend;
+				cancelOpen();
+				return laneResult;
+			}
+			result = laneResult;
+			failed = true;
+		}
+
+		// A failure hands over to the next backend at once, a slow primary only at hedgeAt
+		const bool hedgeNow = lanes.size() == 1 && now >= hedgeAt;
+		if ((failed || hedgeNow || open == 0) && next < ranking.size() && deadline.Continue() && launch())
+		{
+			route->hedged = route->hedged || (hedgeNow && open > 0);
+			open++;
+		}
+
+		if (open == 0)
+		{
+			break;
+		}
+		if (!deadline.Continue())
+		{
+			cancelOpen();
+			result.status = deadline.Cancelled() ? AUTH_STATUS::CANCELLED : AUTH_STATUS::TIMEOUT;
+			return result;
+		}
+
+		// Sleep until a completion, the hedge, the first lane limit or the next poll of the user
+		CLOCK::time_point wake = CLOCK::now() + std::chrono::milliseconds(deadline.PollMs());
+		if (lanes.size() == 1 && next < ranking.size() && hedgeAt < wake)
+		{
+			wake = hedgeAt;
+		}
+		for (const LANE& lane : lanes)
+		{
+			if (lane.open && lane.limit < wake)
+			{
+				wake = lane.limit;
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(signal->lock);
+		signal->changed.wait_until(lock, wake, [&]() { return signal->count != seen; });
+		seen = signal->count;
+	}
+
+	if (deadline.Cancelled())
+	{
+		result.status = AUTH_STATUS::CANCELLED;
+	}
+	else if (deadline.Expired())
+	{
+		result.status = AUTH_STATUS::TIMEOUT;
+	}
+	return result;
+}
+
+AUTH_RESULT AuthBackends::Push(const std::string& user, const std::string& domain, const std::string& message,
+	AuthDeadline& deadline, AUTH_ROUTE* route)
+{
+	AUTH_ROUTE local;
+	route = route != nullptr ? route : &local;
+	*route = AUTH_ROUTE();
+
+	AUTH_RESULT result;
+	if (IsNotEnrolled(user, domain))
+	{
+		route->cached = true;
+		result.status = AUTH_STATUS::NOT_ENROLLED;
+		return result;
+	}
+
+	for (const size_t backend : Ready(deadline, route->warm))
+	{
+		AuthClient& client = *_backends[backend]->client;
+		if ((client.Capabilities() & DAEMON_CAPABILITY_PUSH) == 0 || !deadline.Continue() || !Allow(backend))
+		{
+			continue;
+		}
+
+		// The daemon lets the approval expire with the deadline, one reply ends the wait either way
+		route->backend = backend;
+		route->attempts++;
+		AUTH_CALL call = client.Push(user, domain, message, deadline.RemainingMs());
+		result = deadline.Wait(client, call);
+
+		const bool failed = result.status == AUTH_STATUS::UNAVAILABLE || result.status == AUTH_STATUS::PROTOCOL_ERROR;
+		if (failed || IsAnswer(result.status))
+		{
+			const auto now = CLOCK::now();
+			std::lock_guard<std::mutex> lock(_lock);
+			if (failed)
+			{
+				_backends[backend]->breaker.Failure(now);
+			}
+			else
+			{
+				_backends[backend]->breaker.Success(now);
+			}
+		}
+		if (!failed)
+		{
+			Remember(user, domain, result.status);
+			return result;
+		}
+	}
+
+	if (deadline.Cancelled())
+	{
+		result.status = AUTH_STATUS::CANCELLED;
+	}
+	else if (deadline.Expired())
+	{
+		result.status = AUTH_STATUS::TIMEOUT;
+	}
+	return result;
+}
+
+void AuthBackends::Record(size_t backend, AUTH_STATUS status, std::chrono::microseconds elapsed)
+{
+	// The user cancelling says nothing about the backend
+	if (status == AUTH_STATUS::CANCELLED || backend >= _backends.size())
+	{
+		return;
+	}
+
+	const double failure = IsAnswer(status) ? 0.0 : 1.0;
+	const double latency = static_cast<double>(elapsed.count());
+
+	const auto now = CLOCK::now();
+	std::lock_guard<std::mutex> lock(_lock);
+	AUTH_BACKEND_HEALTH& health = _backends[backend]->health;
+	if (health.samples == 0)
+	{
+		health.latencyUs = latency;
+		health.errorRate = failure;
+	}
+	else
+	{
+		health.latencyUs += AUTH_BACKEND_EWMA_WEIGHT * (latency - health.latencyUs);
+		health.errorRate += AUTH_BACKEND_EWMA_WEIGHT * (failure - health.errorRate);
+	}
+	health.samples++;
+
+	BACKEND& entry = *_backends[backend];
+	entry.lastSample = now;
+	if (failure != 0.0)
+	{
+		entry.breaker.Failure(now);
+	}
+	else
+	{
+		entry.breaker.Success(now);
+		const uint64_t us = static_cast<uint64_t>(elapsed.count());
+		entry.recent[entry.recentCount % AUTH_BACKEND_RECENT] = us < UINT32_MAX ? uint32_t(us) : UINT32_MAX;
+		entry.recentCount++;
+	}
+}
+
+double AuthBackends::Score(const BACKEND& backend) const noexcept
+{
+	return backend.health.latencyUs + backend.health.errorRate * 1000.0 * _timeoutMs;
+}
+
+unsigned int AuthBackends::AttemptMs(size_t backend)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	const AUTH_BACKEND_HEALTH& health = _backends[backend]->health;
+	if (health.latencyUs <= 0)
+	{
+		return _timeoutMs;
+	}
+
+	const double limit = AUTH_BACKEND_ATTEMPT_FACTOR * health.latencyUs / 1000.0;
+	if (limit >= _timeoutMs)
+	{
+		return _timeoutMs;
+	}
+	return limit > AUTH_BACKEND_MIN_ATTEMPT_MS ? static_cast<unsigned int>(limit) : AUTH_BACKEND_MIN_ATTEMPT_MS;
+}
+
+std::chrono::microseconds AuthBackends::HedgeDelay(size_t backend)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	const BACKEND& entry = *_backends[backend];
+
+	// Too few answers for a percentile, twice the average has to do
+	long long delay;
+	if (entry.recentCount < AUTH_BACKEND_RECENT / 4)
+	{
+		delay = static_cast<long long>(2 * entry.health.latencyUs);
+	}
+	else
+	{
+		const size_t count = entry.recentCount < AUTH_BACKEND_RECENT ? entry.recentCount : AUTH_BACKEND_RECENT;
+		uint32_t sorted[AUTH_BACKEND_RECENT];
+		std::copy(entry.recent, entry.recent + count, sorted);
+		const size_t index = static_cast<size_t>(AUTH_BACKEND_HEDGE_PERCENTILE * (count - 1));
+		std::nth_element(sorted, sorted + index, sorted + count);
+		delay = sorted[index];
+	}
+	return std::chrono::microseconds(delay > AUTH_BACKEND_MIN_HEDGE_US ? delay : AUTH_BACKEND_MIN_HEDGE_US);
+}
+
+uint64_t AuthBackends::NextRequestKey()
+{
+	// splitmix64 over a random seed, keys only need to be unique, not secret
+	std::lock_guard<std::mutex> lock(_lock);
+	uint64_t z = (_keyState += 0x9E3779B97F4A7C15ull);
+	z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+	z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+	z ^= z >> 31;
+	return z != 0 ? z : 1;
+}
+
+void AuthBackends::SetBreaker(unsigned int failures, unsigned int openMs)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	for (const auto& backend : _backends)
+	{
+		backend->breaker = CircuitBreaker(failures, std::chrono::milliseconds(openMs));
+	}
+}
+
+void AuthBackends::SetNegativeTtl(unsigned int ttlMs)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	_notEnrolled = NegativeCache(std::chrono::milliseconds(ttlMs));
+}
+
+bool AuthBackends::IsNotEnrolled(const std::string& user, const std::string& domain)
+{
+	const std::string key = UserKey(user, domain);
+	std::lock_guard<std::mutex> lock(_lock);
+	return _notEnrolled.Contains(key, CLOCK::now());
+}
+
+void AuthBackends::Remember(const std::string& user, const std::string& domain, AUTH_STATUS status)
+{
+	if (status != AUTH_STATUS::NOT_ENROLLED && status != AUTH_STATUS::ACCEPTED && status != AUTH_STATUS::REJECTED)
+	{
+		return;
+	}
+
+	const std::string key = UserKey(user, domain);
+	std::lock_guard<std::mutex> lock(_lock);
+	if (status == AUTH_STATUS::NOT_ENROLLED)
+	{
+		_notEnrolled.Insert(key, CLOCK::now());
+	}
+	else
+	{
+		_notEnrolled.Erase(key);
+	}
+}
+
+void AuthBackends::Connect(size_t backend)
+{
+	BACKEND& entry = *_backends[backend];
+	if (entry.client->IsConnected() || entry.client->IsConnecting())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		const auto now = CLOCK::now();
+		SettleConnects(now);
+		if (entry.connecting || !entry.breaker.Allow(now))
+		{
+			return;
+		}
+		entry.connecting = true;
+	}
+	entry.client->ConnectAsync(entry.endpoint, _timeoutMs);
+}
+
+void AuthBackends::SettleConnects(CLOCK::time_point now)
+{
+	for (const auto& backend : _backends)
+	{
+		if (!backend->connecting || backend->client->IsConnecting())
+		{
+			continue;
+		}
+
+		backend->connecting = false;
+		if (backend->client->IsConnected())
+		{
+			backend->breaker.Success(now);
+		}
+		else
+		{
+			backend->breaker.Failure(now);
+		}
+	}
+}
+
+bool AuthBackends::Allow(size_t backend)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	return _backends[backend]->breaker.Allow(CLOCK::now());
+}
+
+std::vector<size_t> AuthBackends::Ready(AuthDeadline& deadline, bool& warm)
+{
+	std::vector<size_t> ranking = Ranking();
+	warm = !ranking.empty();
+	if (ranking.empty())
+	{
+		// Whichever comes up first, backends with an open breaker are not even tried
+		ConnectAsync();
+		while (ranking.empty() && deadline.Continue())
+		{
+			const bool connecting = std::any_of(_backends.begin(), _backends.end(),
+				[](const std::unique_ptr<BACKEND>& backend) { return backend->client->IsConnecting(); });
+			if (!connecting)
+			{
+				break;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(10));
+			ranking = Ranking();
+		}
+	}
+	return ranking;
+}
+
+void AuthBackends::Probe()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	while (!_stop)
+	{
+		_wake.wait_for(lock, std::chrono::milliseconds(_probeMs), [this]() { return _stop.load(); });
+		if (_stop)
+		{
+			return;
+		}
+
+		SettleConnects(CLOCK::now());
+
+		// Only backends the traffic has not sampled since the last round
+		const auto idle = CLOCK::now() - std::chrono::milliseconds(_probeMs);
+		std::vector<size_t> quiet;
+		for (size_t i = 0; i < _backends.size(); i++)
+		{
+			if (_backends[i]->lastSample < idle)
+			{
+				quiet.push_back(i);
+			}
+		}
+		lock.unlock();
+
+		// One at a time, so each round trip is timed alone
+		for (const size_t backend : quiet)
+		{
+			AuthClient& client = *_backends[backend]->client;
+			if (!client.IsConnected())
+			{
+				Connect(backend);
+				continue;
+			}
+
+			// An open breaker waits out its time, then the ping is its trial
+			if ((client.Capabilities() & DAEMON_CAPABILITY_PING) == 0 || !Allow(backend))
+			{
+				continue;
+			}
+
+			const auto start = CLOCK::now();
+			AUTH_CALL call = client.Ping();
+			const AUTH_RESULT result = client.Wait(call, AttemptMs(backend), [this]() { return _stop.load(); }, 50);
+			Record(backend, result.status, std::chrono::duration_cast<std::chrono::microseconds>(CLOCK::now() - start));
+		}
+
+		lock.lock();
+	}
+}
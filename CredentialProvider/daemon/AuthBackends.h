@@ -0,0 +1,195 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Latency-aware selection among several daemons
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "AuthClient.h"
+#include "AuthDeadline.h"
+#include "CircuitBreaker.h"
+#include "NegativeCache.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Weight of the newest sample in the moving averages
+#define AUTH_BACKEND_EWMA_WEIGHT 0.2
+// An attempt may take this many times the backend's average latency ...
+#define AUTH_BACKEND_ATTEMPT_FACTOR 8
+// ... but never less than this
+#define AUTH_BACKEND_MIN_ATTEMPT_MS 250
+// Answer times kept per backend for the hedging percentile
+#define AUTH_BACKEND_RECENT 64
+// Hedging waits for this percentile of the primary's answer times, but at
+// least this long: below it a second request costs more than it saves
+#define AUTH_BACKEND_HEDGE_PERCENTILE 0.95
+#define AUTH_BACKEND_MIN_HEDGE_US 2000
+
+struct AUTH_BACKEND_HEALTH
+{
+	double latencyUs = 0;			// EWMA of the time requests took, failures included, the handshake before
+	double errorRate = 0;			// EWMA of 1 per failure and 0 per answer
+	unsigned long long samples = 0;
+	bool connected = false;
+	BREAKER_STATE breaker = BREAKER_STATE::CLOSED;
+	unsigned long long trips = 0;	// times the breaker opened
+};
+
+// Which backend served a Verify()
+struct AUTH_ROUTE
+{
+	size_t backend = 0;				// answered, or was tried last
+	unsigned int attempts = 0;
+	bool warm = false;				// its connection was up before the first attempt
+	bool hedged = false;			// a second backend was asked before the first gave up
+	bool cached = false;			// NOT_ENROLLED came from the negative cache, no backend was asked
+};
+
+// Several daemons serving the same users, each with its own AuthClient and
+// moving averages of latency and error rate. Every request feeds them
+// passively; backends without traffic are pinged, and disconnected ones
+// reconnected, by a prober thread every probeMs. Verify() tries the connected
+// backends healthiest first, each with a time limit derived from its own
+// latency, so a slow or dead server costs a fraction of the deadline and,
+// once its averages show it, nothing at all.
+//
+// With hedging on, a primary that has not answered within its own 95th
+// percentile gets company: the same request, with the same idempotency key,
+// goes to the next backend. The first answer wins and the other request is
+// cancelled; the key lets the daemons count the code once.
+//
+// Each backend has a CircuitBreaker fed by the same signals plus failed
+// connects. An open breaker takes the backend out of the ranking and stops
+// reconnects, so while it is known bad requests fail over, or report
+// UNAVAILABLE when no backend is left, at once. The prober's ping usually is
+// the trial that closes it again. Users a daemon knows no token of are kept in
+// a NegativeCache for a short time and answered NOT_ENROLLED without asking.
+class AuthBackends
+{
+public:
+	// probeMs 0 disables the prober
+	AuthBackends(const std::vector<std::string>& endpoints, unsigned int timeoutMs, unsigned int probeMs);
+
+	~AuthBackends();
+
+	AuthBackends(const AuthBackends&) = delete;
+	AuthBackends& operator=(const AuthBackends&) = delete;
+
+	size_t Count() const noexcept { return _backends.size(); }
+
+	const std::string& Endpoint(size_t backend) const { return _backends[backend]->endpoint; }
+
+	AUTH_BACKEND_HEALTH Health(size_t backend);
+
+	// Starts ConnectAsync() on every backend that is neither connected nor connecting
+	void ConnectAsync();
+
+	// Connected backends whose breaker lets requests through, healthiest first, ties in configured order
+	std::vector<size_t> Ranking();
+
+	// Client of the healthiest connected backend, nullptr if none is connected
+	std::shared_ptr<AuthClient> Preferred();
+
+	// Verifies with the first backend that answers. Without a connected backend
+	// all are connected and the first one up is used. route may be nullptr.
+	// A user in the negative cache is NOT_ENROLLED without a request.
+	AUTH_RESULT Verify(const std::string& user, const std::string& domain, const std::string& otp,
+		AuthDeadline& deadline, AUTH_ROUTE* route);
+
+	// Sends a push approval through the healthiest backend offering it and waits
+	// for the user's decision until the deadline, countdown and cancel included.
+	// Never to two daemons at once, each would notify the phone: only a backend
+	// that fails without an answer hands over to the next. Approval times are
+	// the user's, they do not feed the latency averages.
+	AUTH_RESULT Push(const std::string& user, const std::string& domain, const std::string& message,
+		AuthDeadline& deadline, AUTH_ROUTE* route);
+
+	void SetHedging(bool enabled) noexcept { _hedging = enabled; }
+
+	// failures consecutive failures open a backend's breaker for openMs, failures 0 disables breakers
+	void SetBreaker(unsigned int failures, unsigned int openMs);
+
+	// How long NOT_ENROLLED answers are remembered, 0 disables the cache
+	void SetNegativeTtl(unsigned int ttlMs);
+
+	// A daemon answered NOT_ENROLLED for the user within the TTL. user and domain as
+	// passed to Verify() or AuthClient::Lookup(), ASCII letters compare case-insensitively.
+	bool IsNotEnrolled(const std::string& user, const std::string& domain);
+
+	// NOT_ENROLLED adds the user to the negative cache, ACCEPTED and REJECTED remove
+	// it, other statuses say nothing about the user. Verify() calls it itself.
+	void Remember(const std::string& user, const std::string& domain, AUTH_STATUS status);
+
+	// Passive health signal: one request to backend took elapsed and ended with status
+	void Record(size_t backend, AUTH_STATUS status, std::chrono::microseconds elapsed);
+
+private:
+	struct BACKEND
+	{
+		std::string endpoint;
+		std::shared_ptr<AuthClient> client;
+		AUTH_BACKEND_HEALTH health;							// under _lock
+		std::chrono::steady_clock::time_point lastSample;	// under _lock
+		uint32_t recent[AUTH_BACKEND_RECENT];				// answer times in us, under _lock
+		size_t recentCount = 0;
+		CircuitBreaker breaker;								// under _lock
+		bool connecting = false;							// a connect of ours awaits its verdict, under _lock
+	};
+
+	// Lower is better, an error rate of 1 weighs as much as a full timeout
+	double Score(const BACKEND& backend) const noexcept;
+
+	// Time limit of one attempt on backend
+	unsigned int AttemptMs(size_t backend);
+
+	// How long to wait for backend before hedging, its recent 95th percentile
+	std::chrono::microseconds HedgeDelay(size_t backend);
+
+	uint64_t NextRequestKey();
+
+	// Starts a connect of backend if it is down and its breaker allows one
+	void Connect(size_t backend);
+
+	// Feeds finished connects into the breakers, _lock held
+	void SettleConnects(std::chrono::steady_clock::time_point now);
+
+	// Claims the breaker of backend for one request
+	bool Allow(size_t backend);
+
+	// Ranking(), after connecting the backends and waiting for the first to come up if none is.
+	// warm tells whether one was connected before.
+	std::vector<size_t> Ready(AuthDeadline& deadline, bool& warm);
+
+	void Probe();
+
+	const unsigned int _timeoutMs;
+	const unsigned int _probeMs;
+	std::vector<std::unique_ptr<BACKEND>> _backends;
+	std::mutex _lock;
+	std::condition_variable _wake;
+	std::atomic<bool> _stop{ false };
+	std::atomic<bool> _hedging{ false };
+	uint64_t _keyState;									// under _lock
+	NegativeCache _notEnrolled;							// under _lock
+	std::thread _prober;
+};
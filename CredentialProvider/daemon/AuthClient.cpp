@@ -0,0 +1,522 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Asynchronous client of the authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "AuthClient.h"
+#include "DaemonJson.h"
+#include <chrono>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	bool ReadFully(DaemonTransport& transport, uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			const size_t read = transport.Read(data, size);
+			if (read == 0)
+			{
+				return false;
+			}
+			data += read;
+			size -= read;
+		}
+		return true;
+	}
+
+	AUTH_RESULT ToResult(const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS status)
+	{
+		AUTH_RESULT result;
+		result.status = status;
+		if (header == nullptr)
+		{
+			return result;
+		}
+
+		uint64_t value = 0;
+		if (header->type == uint16_t(DAEMON_MESSAGE::PING_REPLY))
+		{
+			return result;
+		}
+
+		const bool reply = header->type == uint16_t(DAEMON_MESSAGE::VERIFY_REPLY)
+			|| header->type == uint16_t(DAEMON_MESSAGE::LOOKUP_REPLY)
+			|| header->type == uint16_t(DAEMON_MESSAGE::PUSH_REPLY);
+		const DAEMON_FIELD_VIEW* json = fields->Find(DAEMON_FIELD::JSON);
+		if (reply && json != nullptr)
+		{
+			DAEMON_JSON_REPLY decoded;
+			const bool valid = DaemonJson::Decode(reinterpret_cast<const char*>(json->data), json->size, decoded);
+			result.status = valid && decoded.hasStatus ? decoded.status : AUTH_STATUS::PROTOCOL_ERROR;
+			result.message.assign(decoded.message, decoded.messageLength);
+			result.token = decoded.token;
+			result.challenge = std::move(decoded.challenge);
+		}
+		else
+		{
+			if (reply && fields->Integer(DAEMON_FIELD::STATUS, value) && value <= uint64_t(AUTH_STATUS::NOT_ENROLLED))
+			{
+				result.status = static_cast<AUTH_STATUS>(value);
+			}
+			else
+			{
+				result.status = AUTH_STATUS::PROTOCOL_ERROR;
+			}
+			fields->String(DAEMON_FIELD::MESSAGE, result.message);
+
+			if (fields->Integer(DAEMON_FIELD::TOKEN_TYPE, value) && value <= uint64_t(DAEMON_TOKEN::TOTP))
+			{
+				result.token = static_cast<DAEMON_TOKEN>(value);
+			}
+		}
+		if (fields->Integer(DAEMON_FIELD::DIGITS, value) && value < 100)
+		{
+			result.digits = static_cast<unsigned int>(value);
+		}
+		return result;
+	}
+}
+
+AuthClient::~AuthClient()
+{
+	// The background connect uses this object, it is bounded by its timeout
+	std::shared_future<bool> connecting;
+	{
+		std::lock_guard<std::mutex> lock(_asyncLock);
+		connecting = _connecting;
+	}
+	if (connecting.valid())
+	{
+		connecting.wait();
+	}
+	Disconnect();
+}
+
+bool AuthClient::Connect(const std::string& endpoint, unsigned int timeoutMs)
+{
+	return Connect(DaemonTransport::Create(), endpoint, timeoutMs);
+}
+
+bool AuthClient::Connect(std::unique_ptr<DaemonTransport> transport, const std::string& endpoint, unsigned int timeoutMs)
+{
+	Disconnect();
+
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	{
+		std::lock_guard<std::mutex> lock(_connectionLock);
+		if (!transport || !transport->Connect(endpoint, timeoutMs))
+		{
+			return false;
+		}
+
+		try
+		{
+			_transport = std::shared_ptr<DaemonTransport>(std::move(transport));
+			_connected = true;
+			_reader = std::thread(&AuthClient::ReadLoop, this, _transport);
+		}
+		catch (...)
+		{
+			_connected = false;
+			_transport.reset();
+			return false;
+		}
+	}
+
+	const auto helloStart = std::chrono::steady_clock::now();
+	auto hello = std::make_shared<std::promise<bool>>();
+	std::future<bool> ready = hello->get_future();
+
+	const uint32_t id = NextId();
+	DaemonMessage message(DAEMON_MESSAGE::HELLO, id);
+	message.AddInteger(DAEMON_FIELD::VERSION, DAEMON_PROTOCOL_VERSION).Add(DAEMON_FIELD::CLIENT, std::string("DasCredentialProvider"));
+	Submit(id, message, [this, hello](const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS)
+	{
+		uint64_t version = 0, capabilities = 0;
+		const bool ok = header != nullptr && header->type == uint16_t(DAEMON_MESSAGE::HELLO_REPLY)
+			&& fields->Integer(DAEMON_FIELD::VERSION, version) && version == DAEMON_PROTOCOL_VERSION;
+		if (ok)
+		{
+			fields->Integer(DAEMON_FIELD::CAPABILITIES, capabilities);
+			_capabilities = capabilities;
+		}
+		hello->set_value(ok);
+	});
+
+	if (ready.wait_until(deadline) != std::future_status::ready || !ready.get())
+	{
+		Cancel(id);
+		Disconnect();
+		return false;
+	}
+	_handshakeUs = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - helloStart).count();
+	return true;
+}
+
+void AuthClient::ConnectAsync(const std::string& endpoint, unsigned int timeoutMs)
+{
+	std::lock_guard<std::mutex> lock(_asyncLock);
+	if (_connected || (_connecting.valid()
+		&& _connecting.wait_for(std::chrono::seconds(0)) != std::future_status::ready))
+	{
+		return;
+	}
+
+	_connecting = std::async(std::launch::async, [this, endpoint, timeoutMs]()
+	{
+		return Connect(endpoint, timeoutMs);
+	}).share();
+}
+
+bool AuthClient::WaitConnected(unsigned int timeoutMs)
+{
+	std::shared_future<bool> connecting;
+	{
+		std::lock_guard<std::mutex> lock(_asyncLock);
+		connecting = _connecting;
+	}
+
+	// _connected is set before the handshake, only the finished connect counts
+	if (connecting.valid())
+	{
+		return connecting.wait_for(std::chrono::milliseconds(timeoutMs)) == std::future_status::ready
+			&& connecting.get() && _connected;
+	}
+	return _connected;
+}
+
+bool AuthClient::IsConnecting()
+{
+	std::lock_guard<std::mutex> lock(_asyncLock);
+	return _connecting.valid() && _connecting.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+}
+
+void AuthClient::Disconnect() noexcept
+{
+	std::lock_guard<std::mutex> lock(_connectionLock);
+	if (_transport)
+	{
+		_transport->Shutdown();
+	}
+	if (_reader.joinable())
+	{
+		_reader.join();
+	}
+	_transport.reset();
+	_connected = false;
+	_capabilities = 0;
+	_handshakeUs = 0;
+
+	// The reader has failed what was pending when it stopped, not what raced it
+	FailPending(AUTH_STATUS::UNAVAILABLE);
+}
+
+AUTH_CALL AuthClient::Verify(const std::string& user, const std::string& domain, const std::string& otp,
+	uint64_t requestKey, std::function<void()> done)
+{
+	auto promise = std::make_shared<std::promise<AUTH_RESULT>>();
+	AUTH_CALL call;
+	call.id = NextId();
+	call.result = promise->get_future();
+
+	DaemonMessage message(DAEMON_MESSAGE::VERIFY, call.id);
+	message.Add(DAEMON_FIELD::USER_NAME, user).Add(DAEMON_FIELD::DOMAIN_NAME, domain).Add(DAEMON_FIELD::OTP, otp);
+	if (requestKey != 0)
+	{
+		message.AddInteger(DAEMON_FIELD::REQUEST_KEY, requestKey);
+	}
+	Submit(call.id, message, [promise, done](const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS status)
+	{
+		promise->set_value(ToResult(header, fields, status));
+		if (done)
+		{
+			done();
+		}
+	});
+	return call;
+}
+
+AUTH_CALL AuthClient::Lookup(const std::string& user, const std::string& domain)
+{
+	auto promise = std::make_shared<std::promise<AUTH_RESULT>>();
+	AUTH_CALL call;
+	call.id = NextId();
+	call.result = promise->get_future();
+
+	DaemonMessage message(DAEMON_MESSAGE::LOOKUP, call.id);
+	message.Add(DAEMON_FIELD::USER_NAME, user).Add(DAEMON_FIELD::DOMAIN_NAME, domain);
+	Submit(call.id, message, [promise](const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS status)
+	{
+		promise->set_value(ToResult(header, fields, status));
+	});
+	return call;
+}
+
+AUTH_CALL AuthClient::Push(const std::string& user, const std::string& domain, const std::string& message,
+	unsigned int expiresMs)
+{
+	auto promise = std::make_shared<std::promise<AUTH_RESULT>>();
+	AUTH_CALL call;
+	call.id = NextId();
+	call.result = promise->get_future();
+
+	DaemonMessage request(DAEMON_MESSAGE::PUSH, call.id);
+	request.Add(DAEMON_FIELD::USER_NAME, user).Add(DAEMON_FIELD::DOMAIN_NAME, domain).Add(DAEMON_FIELD::MESSAGE, message)
+		.AddInteger(DAEMON_FIELD::EXPIRES, expiresMs);
+	Submit(call.id, request, [promise](const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS status)
+	{
+		promise->set_value(ToResult(header, fields, status));
+	});
+	return call;
+}
+
+AUTH_CALL AuthClient::Ping()
+{
+	auto promise = std::make_shared<std::promise<AUTH_RESULT>>();
+	AUTH_CALL call;
+	call.id = NextId();
+	call.result = promise->get_future();
+
+	DaemonMessage message(DAEMON_MESSAGE::PING, call.id);
+	Submit(call.id, message, [promise](const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS status)
+	{
+		promise->set_value(ToResult(header, fields, status));
+	});
+	return call;
+}
+
+void AuthClient::Cancel(uint32_t id) noexcept
+{
+	COMPLETION completion;
+	{
+		std::lock_guard<std::mutex> lock(_pendingLock);
+		const auto it = _pending.find(id);
+		if (it == _pending.end())
+		{
+			return;
+		}
+		completion = std::move(it->second);
+		_pending.erase(it);
+	}
+	completion(nullptr, nullptr, AUTH_STATUS::CANCELLED);
+
+	if ((_capabilities & DAEMON_CAPABILITY_CANCEL) == 0)
+	{
+		return;
+	}
+
+	std::shared_ptr<DaemonTransport> transport;
+	{
+		std::lock_guard<std::mutex> lock(_connectionLock);
+		transport = _transport;
+	}
+	if (!transport || !_connected)
+	{
+		return;
+	}
+
+	// Best effort, a failed write breaks the connection like any other
+	try
+	{
+		DaemonMessage message(DAEMON_MESSAGE::CANCEL, id);
+		const std::vector<uint8_t>& frame = message.Finish();
+		std::lock_guard<std::mutex> lock(_writeLock);
+		if (!transport->Write(frame.data(), frame.size()))
+		{
+			transport->Shutdown();
+		}
+	}
+	catch (...)
+	{
+	}
+}
+
+AUTH_RESULT AuthClient::Wait(AUTH_CALL& call, unsigned int timeoutMs) noexcept
+{
+	const bool late = call.result.wait_for(std::chrono::milliseconds(timeoutMs)) != std::future_status::ready;
+	if (late)
+	{
+		Cancel(call.id);
+	}
+
+	try
+	{
+		AUTH_RESULT result = call.result.get();
+		if (late && result.status == AUTH_STATUS::CANCELLED)
+		{
+			result.status = AUTH_STATUS::TIMEOUT;
+		}
+		return result;
+	}
+	catch (...)
+	{
+		AUTH_RESULT result;
+		result.status = AUTH_STATUS::UNAVAILABLE;
+		return result;
+	}
+}
+
+AUTH_RESULT AuthClient::Wait(AUTH_CALL& call, unsigned int timeoutMs, const std::function<bool()>& cancelled,
+	unsigned int pollMs) noexcept
+{
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	const auto poll = std::chrono::milliseconds(pollMs > 0 ? pollMs : 1);
+	bool stopped = false;
+	for (;;)
+	{
+		const auto now = std::chrono::steady_clock::now();
+		const auto until = deadline - now < poll ? deadline : now + poll;
+		if (call.result.wait_until(until) == std::future_status::ready)
+		{
+			break;
+		}
+
+		bool cancel;
+		try
+		{
+			cancel = cancelled();
+		}
+		catch (...)
+		{
+			cancel = true;
+		}
+		if (cancel)
+		{
+			stopped = true;
+			Cancel(call.id);
+			break;
+		}
+		if (until == deadline)
+		{
+			break;
+		}
+	}
+
+	// A timeout takes the path of the plain Wait()
+	AUTH_RESULT result = Wait(call, 0);
+	if (stopped && result.status == AUTH_STATUS::TIMEOUT)
+	{
+		result.status = AUTH_STATUS::CANCELLED;
+	}
+	return result;
+}
+
+uint32_t AuthClient::NextId() noexcept
+{
+	uint32_t id = _nextId++;
+	if (id == 0)
+	{
+		id = _nextId++;
+	}
+	return id;
+}
+
+void AuthClient::Submit(uint32_t id, DaemonMessage& message, COMPLETION completion)
+{
+	std::shared_ptr<DaemonTransport> transport;
+	{
+		std::lock_guard<std::mutex> lock(_connectionLock);
+		transport = _transport;
+	}
+
+	const std::vector<uint8_t>& frame = message.Finish();
+	if (!transport || !_connected || frame.empty())
+	{
+		completion(nullptr, nullptr, frame.empty() ? AUTH_STATUS::PROTOCOL_ERROR : AUTH_STATUS::UNAVAILABLE);
+		return;
+	}
+
+	// Registered first, the reply may arrive before Write() returns
+	{
+		std::lock_guard<std::mutex> lock(_pendingLock);
+		_pending[id] = std::move(completion);
+	}
+
+	bool written;
+	{
+		std::lock_guard<std::mutex> lock(_writeLock);
+		written = transport->Write(frame.data(), frame.size());
+	}
+
+	if (!written)
+	{
+		// Breaks the connection, the reader fails everything pending
+		transport->Shutdown();
+		Cancel(id);
+	}
+}
+
+void AuthClient::ReadLoop(std::shared_ptr<DaemonTransport> transport)
+{
+	std::vector<uint8_t> payload;
+	uint8_t headerBytes[DAEMON_FRAME_HEADER_SIZE];
+	DaemonFields fields;
+
+	for (;;)
+	{
+		DAEMON_FRAME_HEADER header;
+		if (!ReadFully(*transport, headerBytes, sizeof(headerBytes)) || !DaemonProtocol::DecodeHeader(headerBytes, header))
+		{
+			break;
+		}
+
+		payload.resize(header.length);
+		if (!ReadFully(*transport, payload.data(), payload.size()) || !fields.Parse(payload.data(), payload.size()))
+		{
+			break;
+		}
+
+		COMPLETION completion;
+		{
+			std::lock_guard<std::mutex> lock(_pendingLock);
+			const auto it = _pending.find(header.requestId);
+			if (it != _pending.end())
+			{
+				completion = std::move(it->second);
+				_pending.erase(it);
+			}
+		}
+
+		// Replies to cancelled requests are dropped
+		if (completion)
+		{
+			completion(&header, &fields, AUTH_STATUS::ACCEPTED);
+		}
+		std::fill(payload.begin(), payload.end(), uint8_t(0));
+	}
+
+	_connected = false;
+	transport->Shutdown();
+	FailPending(AUTH_STATUS::UNAVAILABLE);
+}
+
+void AuthClient::FailPending(AUTH_STATUS status) noexcept
+{
+	std::unordered_map<uint32_t, COMPLETION> pending;
+	{
+		std::lock_guard<std::mutex> lock(_pendingLock);
+		pending.swap(_pending);
+	}
+	for (auto& entry : pending)
+	{
+		entry.second(nullptr, nullptr, status);
+	}
+}
@@ -0,0 +1,150 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Asynchronous client of the authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#include "DaemonProtocol.h"
+#include "DaemonTransport.h"
+#include "SecureString.h"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+struct AUTH_RESULT
+{
+	AUTH_STATUS status = AUTH_STATUS::UNAVAILABLE;
+	std::string message;
+
+	// LOOKUP only
+	DAEMON_TOKEN token = DAEMON_TOKEN::NONE;
+	unsigned int digits = 0;
+
+	// JSON replies only, prompt of a challenge-response token
+	SecureWString challenge;
+};
+
+// Request in flight, id identifies it for Cancel()
+struct AUTH_CALL
+{
+	uint32_t id = 0;
+	std::future<AUTH_RESULT> result;
+};
+
+// One connection to the daemon, shared by all callers. Requests are written by
+// the calling thread and answered on a reader thread, which matches replies to
+// requests by their id and completes the futures, so requests never wait for
+// each other. If the connection breaks every pending request fails with
+// UNAVAILABLE and IsConnected() turns false; Connect() starts over.
+class AuthClient
+{
+public:
+	AuthClient() = default;
+	~AuthClient();
+
+	AuthClient(const AuthClient&) = delete;
+	AuthClient& operator=(const AuthClient&) = delete;
+
+	// Connects through the transport of the platform and completes the HELLO handshake within timeoutMs
+	bool Connect(const std::string& endpoint, unsigned int timeoutMs);
+
+	bool Connect(std::unique_ptr<DaemonTransport> transport, const std::string& endpoint, unsigned int timeoutMs);
+
+	// Starts Connect() on a background thread unless connected or already connecting,
+	// so the handshake is done by the time the first request is made
+	void ConnectAsync(const std::string& endpoint, unsigned int timeoutMs);
+
+	// Waits up to timeoutMs for a ConnectAsync() in progress, true if connected
+	bool WaitConnected(unsigned int timeoutMs);
+
+	// A ConnectAsync() has not finished yet
+	bool IsConnecting();
+
+	// Fails every pending request with UNAVAILABLE
+	void Disconnect() noexcept;
+
+	bool IsConnected() const noexcept { return _connected; }
+
+	uint64_t Capabilities() const noexcept { return _capabilities; }
+
+	// Round trip of the HELLO handshake of the current connection, 0 if not connected
+	std::chrono::microseconds HandshakeTime() const noexcept { return std::chrono::microseconds(_handshakeUs.load()); }
+
+	// user and domain as typed, otp as entered, all UTF-8. Copies of a request
+	// sent to several daemons share a non-zero requestKey, so the code counts
+	// once. done, if given, is called on the reader thread once the result is set.
+	AUTH_CALL Verify(const std::string& user, const std::string& domain, const std::string& otp,
+		uint64_t requestKey = 0, std::function<void()> done = nullptr);
+
+	// Resolves token type and digits of a user and lets the daemon cache its
+	// directory entry, a following Verify() of the same user is answered sooner
+	AUTH_CALL Lookup(const std::string& user, const std::string& domain);
+
+	// Sends the user an approval request, message is shown with it. The result
+	// comes when the user has decided or after expiresMs: ACCEPTED if approved,
+	// REJECTED if denied or expired, NOT_ENROLLED without a device to push to.
+	AUTH_CALL Push(const std::string& user, const std::string& domain, const std::string& message,
+		unsigned int expiresMs);
+
+	// Health probe, ACCEPTED once the daemon has answered. Daemons without
+	// DAEMON_CAPABILITY_PING answer it with ERROR_REPLY, which is PROTOCOL_ERROR.
+	AUTH_CALL Ping();
+
+	// Completes a pending request with CANCELLED, a late reply is dropped. A
+	// daemon with DAEMON_CAPABILITY_CANCEL is told to abandon the request.
+	void Cancel(uint32_t id) noexcept;
+
+	// Waits for the result, after timeoutMs the request is cancelled and TIMEOUT returned
+	AUTH_RESULT Wait(AUTH_CALL& call, unsigned int timeoutMs) noexcept;
+
+	// Same, cancelled() is polled every pollMs and cancels the request with CANCELLED
+	AUTH_RESULT Wait(AUTH_CALL& call, unsigned int timeoutMs, const std::function<bool()>& cancelled, unsigned int pollMs) noexcept;
+
+private:
+	// header and fields are nullptr if there is no reply, status tells why
+	typedef std::function<void(const DAEMON_FRAME_HEADER* header, const DaemonFields* fields, AUTH_STATUS status)> COMPLETION;
+
+	uint32_t NextId() noexcept;
+
+	// Registers completion under id and writes the frame, a failed write completes it with UNAVAILABLE
+	void Submit(uint32_t id, DaemonMessage& message, COMPLETION completion);
+
+	void ReadLoop(std::shared_ptr<DaemonTransport> transport);
+
+	void FailPending(AUTH_STATUS status) noexcept;
+
+	std::mutex _connectionLock;				// Connect() and Disconnect()
+	std::mutex _asyncLock;					// _connecting
+	std::shared_future<bool> _connecting;
+	std::mutex _writeLock;
+	std::mutex _pendingLock;
+	std::shared_ptr<DaemonTransport> _transport;
+	std::thread _reader;
+	std::unordered_map<uint32_t, COMPLETION> _pending;
+	std::atomic<uint32_t> _nextId{ 1 };
+	std::atomic<bool> _connected{ false };
+	std::atomic<uint64_t> _capabilities{ 0 };
+	std::atomic<long long> _handshakeUs{ 0 };
+};
@@ -0,0 +1,99 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Deadline and cancellation of a verification at submit
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "AuthDeadline.h"
+
+AuthDeadline::AuthDeadline(unsigned int deadlineMs, AuthProgress* progress, const std::wstring& status, unsigned int pollMs) :
+	_deadline(CLOCK::now() + std::chrono::milliseconds(deadlineMs)), _progress(progress), _status(status),
+	_pollMs(pollMs > 0 ? pollMs : 1)
+{
+	Poll();
+}
+
+bool AuthDeadline::Continue()
+{
+	return Poll() && !Expired();
+}
+
+bool AuthDeadline::Expired() const noexcept
+{
+	return CLOCK::now() >= _deadline;
+}
+
+unsigned int AuthDeadline::RemainingMs() const noexcept
+{
+	// Rounded up, a wait of RemainingMs() does not end before Expired()
+	const auto remaining = std::chrono::duration_cast<std::chrono::microseconds>(_deadline - CLOCK::now()).count();
+	return remaining > 0 ? static_cast<unsigned int>((remaining + 999) / 1000) : 0;
+}
+
+bool AuthDeadline::WaitConnected(AuthClient& client)
+{
+	for (;;)
+	{
+		const unsigned int remaining = RemainingMs();
+		if (client.WaitConnected(remaining < _pollMs ? remaining : _pollMs))
+		{
+			return true;
+		}
+		if (!client.IsConnecting() || !Continue())
+		{
+			return false;
+		}
+	}
+}
+
+AUTH_RESULT AuthDeadline::Wait(AuthClient& client, AUTH_CALL& call)
+{
+	return client.Wait(call, RemainingMs(), [this]() { return !Poll(); }, _pollMs);
+}
+
+AUTH_RESULT AuthDeadline::Wait(AuthClient& client, AUTH_CALL& call, unsigned int limitMs)
+{
+	const unsigned int remaining = RemainingMs();
+	return client.Wait(call, limitMs < remaining ? limitMs : remaining, [this]() { return !Poll(); }, _pollMs);
+}
+
+bool AuthDeadline::Poll()
+{
+	if (_cancelled)
+	{
+		return false;
+	}
+	if (_progress == nullptr)
+	{
+		return true;
+	}
+
+	if (!_progress->QueryContinue())
+	{
+		_cancelled = true;
+		return false;
+	}
+
+	// Rounded up, the last second shows 1 until it has passed
+	const long long seconds = (static_cast<long long>(RemainingMs()) + 999) / 1000;
+	if (seconds != _shownSeconds)
+	{
+		_shownSeconds = seconds;
+		_progress->SetStatusMessage(_status + L" (" + std::to_wstring(seconds) + L" s)");
+	}
+	return true;
+}
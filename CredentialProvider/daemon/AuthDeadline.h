@@ -0,0 +1,87 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Deadline and cancellation of a verification at submit
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "AuthClient.h"
+#include <chrono>
+#include <string>
+
+#define AUTH_DEADLINE_POLL_MS 100
+
+// What a wait at submit needs of LogonUI, IQueryContinueWithStatus on Windows
+class AuthProgress
+{
+public:
+	virtual ~AuthProgress() = default;
+
+	// false once the user has cancelled
+	virtual bool QueryContinue() = 0;
+
+	virtual void SetStatusMessage(const std::wstring& message) = 0;
+};
+
+// Hard deadline of one verification. Every wait polls QueryContinue() each
+// pollMs and counts the remaining seconds down in the status text, so a slow
+// daemon holds LogonUI no longer than the deadline and the user can back out
+// at any time. What is in flight when the user cancels or the deadline passes
+// is cancelled at the client and, if it supports it, at the daemon.
+class AuthDeadline
+{
+public:
+	// progress may be nullptr, the deadline alone then applies
+	AuthDeadline(unsigned int deadlineMs, AuthProgress* progress, const std::wstring& status,
+		unsigned int pollMs = AUTH_DEADLINE_POLL_MS);
+
+	AuthDeadline(const AuthDeadline&) = delete;
+	AuthDeadline& operator=(const AuthDeadline&) = delete;
+
+	// Polls the user and refreshes the status text, false once cancelled or expired
+	bool Continue();
+
+	bool Cancelled() const noexcept { return _cancelled; }
+
+	bool Expired() const noexcept;
+
+	unsigned int RemainingMs() const noexcept;
+
+	unsigned int PollMs() const noexcept { return _pollMs; }
+
+	// Waits for a ConnectAsync() in progress, true if the client is connected
+	bool WaitConnected(AuthClient& client);
+
+	// Waits for the result, TIMEOUT once expired, CANCELLED if the user cancelled
+	AUTH_RESULT Wait(AuthClient& client, AUTH_CALL& call);
+
+	// Same, but gives up with TIMEOUT after limitMs if that comes first
+	AUTH_RESULT Wait(AuthClient& client, AUTH_CALL& call, unsigned int limitMs);
+
+private:
+	typedef std::chrono::steady_clock CLOCK;
+
+	// Asks the user, the status text is rewritten when the seconds left change
+	bool Poll();
+
+	const CLOCK::time_point _deadline;
+	AuthProgress* _progress;
+	const std::wstring _status;
+	const unsigned int _pollMs;
+	bool _cancelled = false;
+	long long _shownSeconds = -1;
+};
@@ -0,0 +1,99 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Circuit breaker of one authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "CircuitBreaker.h"
+
+BREAKER_STATE CircuitBreaker::State(TIME now) const noexcept
+{
+	if (_state == BREAKER_STATE::OPEN && now >= _openUntil)
+	{
+		return BREAKER_STATE::HALF_OPEN;
+	}
+	return _state;
+}
+
+bool CircuitBreaker::Permits(TIME now) const noexcept
+{
+	switch (State(now))
+	{
+	case BREAKER_STATE::CLOSED:
+		return true;
+	case BREAKER_STATE::HALF_OPEN:
+		return !_trial || now >= _trialUntil;
+	default:
+		return false;
+	}
+}
+
+bool CircuitBreaker::Allow(TIME now) noexcept
+{
+	if (!Permits(now))
+	{
+		return false;
+	}
+
+	if (State(now) == BREAKER_STATE::HALF_OPEN)
+	{
+		_state = BREAKER_STATE::HALF_OPEN;
+		_trial = true;
+		_trialUntil = now + _openTime;
+	}
+	return true;
+}
+
+void CircuitBreaker::Success(TIME now) noexcept
+{
+	if (State(now) == BREAKER_STATE::OPEN)
+	{
+		return;
+	}
+
+	_state = BREAKER_STATE::CLOSED;
+	_failures = 0;
+	_trial = false;
+}
+
+void CircuitBreaker::Failure(TIME now) noexcept
+{
+	switch (State(now))
+	{
+	case BREAKER_STATE::CLOSED:
+		if (_threshold > 0 && ++_failures >= _threshold)
+		{
+			Open(now);
+		}
+		break;
+	case BREAKER_STATE::HALF_OPEN:
+		Open(now);
+		break;
+	default:
+		// Already open, late failures of earlier requests do not extend it
+		break;
+	}
+}
+
+void CircuitBreaker::Open(TIME now) noexcept
+{
+	_state = BREAKER_STATE::OPEN;
+	_openUntil = now + _openTime;
+	_failures = 0;
+	_trial = false;
+	_trips++;
+}
@@ -0,0 +1,81 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Circuit breaker of one authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <chrono>
+
+enum class BREAKER_STATE
+{
+	CLOSED = 0,		// requests go out, consecutive failures are counted
+	OPEN = 1,		// requests are refused at once until the open time is over
+	HALF_OPEN = 2,	// one trial request decides between CLOSED and OPEN
+};
+
+// Keeps requests away from a daemon that keeps failing. After `failures`
+// consecutive failures the breaker opens and refuses every request for
+// openTime, so callers fail over, or verify offline, without waiting out a
+// timeout. Then a single trial is let through: its answer closes the breaker,
+// its failure opens it for another openTime. A trial without a verdict
+// expires after openTime and the next one may go.
+//
+// Time is passed in, the breaker never reads a clock, which keeps it
+// deterministic. Not thread safe, the owner serializes the calls.
+class CircuitBreaker
+{
+public:
+	typedef std::chrono::steady_clock::time_point TIME;
+
+	// failures 0 never opens
+	CircuitBreaker(unsigned int failures = 0, std::chrono::milliseconds openTime = std::chrono::milliseconds(0)) noexcept :
+		_threshold(failures), _openTime(openTime)
+	{
+	}
+
+	// OPEN turns HALF_OPEN once its open time is over
+	BREAKER_STATE State(TIME now) const noexcept;
+
+	// Whether a request may go out at now, without claiming the trial
+	bool Permits(TIME now) const noexcept;
+
+	// Same, and a request of a half-open breaker claims its trial
+	bool Allow(TIME now) noexcept;
+
+	// The daemon answered. Closes a half-open breaker, an open one ignores
+	// answers to requests sent before it opened.
+	void Success(TIME now) noexcept;
+
+	// The daemon failed a request: unreachable, broken connection or no answer in time
+	void Failure(TIME now) noexcept;
+
+	// How often the breaker has opened
+	unsigned long long Trips() const noexcept { return _trips; }
+
+private:
+	void Open(TIME now) noexcept;
+
+	unsigned int _threshold;
+	std::chrono::milliseconds _openTime;
+	BREAKER_STATE _state = BREAKER_STATE::CLOSED;
+	unsigned int _failures = 0;
+	TIME _openUntil;
+	TIME _trialUntil;
+	bool _trial = false;
+	unsigned long long _trips = 0;
+};
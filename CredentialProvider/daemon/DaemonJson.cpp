@@ -0,0 +1,218 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Streaming decoder of JSON daemon replies
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Ahead of DaemonJson.h, which brings in Windows.h and its min and max macros
+#include "json.hpp"
+#include "DaemonJson.h"
+#include <cstring>
+
+namespace
+{
+	typedef nlohmann::json JSON;
+
+	enum class MEMBER
+	{
+		NONE,
+		STATUS,
+		MESSAGE,
+		TOKEN_TYPE,
+		CHALLENGE,
+	};
+
+	bool Equals(const JSON::string_t& value, const char* literal) noexcept
+	{
+		return value.size() == strlen(literal) && memcmp(value.data(), literal, value.size()) == 0;
+	}
+
+	// UTF-8 to UTF-16 (Windows) or UTF-32 wchar_t, invalid sequences become U+FFFD
+	void AppendWide(const JSON::string_t& in, SecureWString& out)
+	{
+		out.reserve(out.size() + in.size());
+		for (size_t i = 0; i < in.size();)
+		{
+			const unsigned char c = static_cast<unsigned char>(in[i]);
+			const size_t extra = c < 0x80 ? 0 : (c & 0xE0) == 0xC0 ? 1 : (c & 0xF0) == 0xE0 ? 2 : (c & 0xF8) == 0xF0 ? 3 : 4;
+			uint32_t code = extra == 0 ? c : extra == 1 ? (c & 0x1F) : extra == 2 ? (c & 0x0F) : (c & 0x07);
+			bool valid = extra < 4 && i + extra < in.size();
+			for (size_t k = 1; valid && k <= extra; k++)
+			{
+				const unsigned char next = static_cast<unsigned char>(in[i + k]);
+				valid = (next & 0xC0) == 0x80;
+				code = (code << 6) | (next & 0x3F);
+			}
+			valid = valid && code <= 0x10FFFF && (code < 0xD800 || code > 0xDFFF)
+				&& (extra < 2 || code >= (extra == 2 ? 0x800u : 0x10000u)) && (extra < 1 || code >= 0x80);
+			i += valid ? extra + 1 : 1;
+			code = valid ? code : 0xFFFD;
+
+			if (sizeof(wchar_t) == 2 && code >= 0x10000)
+			{
+				out.push_back(static_cast<wchar_t>(0xD800 + ((code - 0x10000) >> 10)));
+				out.push_back(static_cast<wchar_t>(0xDC00 + ((code - 0x10000) & 0x3FF)));
+			}
+			else
+			{
+				out.push_back(static_cast<wchar_t>(code));
+			}
+		}
+	}
+
+	// Event consumer of JSON::sax_parse, keeps nothing but the members of DAEMON_JSON_REPLY
+	class ReplyHandler
+	{
+	public:
+		explicit ReplyHandler(DAEMON_JSON_REPLY& reply) noexcept : _reply(reply) {}
+
+		bool IsObject() const noexcept { return _object; }
+
+		bool null() noexcept { return Scalar(); }
+
+		bool boolean(bool) noexcept { return Scalar(); }
+
+		bool number_integer(JSON::number_integer_t value) noexcept
+		{
+			return value >= 0 ? number_unsigned(static_cast<JSON::number_unsigned_t>(value)) : Scalar();
+		}
+
+		bool number_unsigned(JSON::number_unsigned_t value) noexcept
+		{
+			if (_depth == 1 && _member == MEMBER::STATUS && value <= uint64_t(AUTH_STATUS::NOT_ENROLLED))
+			{
+				_reply.status = static_cast<AUTH_STATUS>(value);
+				_reply.hasStatus = true;
+			}
+			return Scalar();
+		}
+
+		bool number_float(JSON::number_float_t, const JSON::string_t&) noexcept { return Scalar(); }
+
+		bool string(JSON::string_t& value)
+		{
+			if (_depth == 1)
+			{
+				switch (_member)
+				{
+				case MEMBER::STATUS:
+					Status(value);
+					break;
+				case MEMBER::MESSAGE:
+					Message(value);
+					break;
+				case MEMBER::TOKEN_TYPE:
+					_reply.token = Equals(value, "hotp") ? DAEMON_TOKEN::HOTP : Equals(value, "totp") ? DAEMON_TOKEN::TOTP : DAEMON_TOKEN::NONE;
+					break;
+				case MEMBER::CHALLENGE:
+					_reply.challenge.clear();
+					AppendWide(value, _reply.challenge);
+					SecureZeroMemory(&value[0], value.size());
+					break;
+				default:
+					break;
+				}
+			}
+			return Scalar();
+		}
+
+		bool key(JSON::string_t& value) noexcept
+		{
+			_member = _depth != 1 ? MEMBER::NONE
+				: Equals(value, "status") ? MEMBER::STATUS
+				: Equals(value, "message") ? MEMBER::MESSAGE
+				: Equals(value, "token_type") ? MEMBER::TOKEN_TYPE
+				: Equals(value, "challenge") ? MEMBER::CHALLENGE
+				: MEMBER::NONE;
+			return true;
+		}
+
+		bool start_object(std::size_t) noexcept
+		{
+			_object = _object || _depth == 0;
+			return Open();
+		}
+
+		bool end_object() noexcept { return Close(); }
+
+		bool start_array(std::size_t) noexcept { return Open(); }
+
+		bool end_array() noexcept { return Close(); }
+
+		bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) noexcept { return false; }
+
+	private:
+		bool Scalar() noexcept
+		{
+			_member = MEMBER::NONE;
+			return true;
+		}
+
+		// A nested value is skipped whole, its members are not ours
+		bool Open() noexcept
+		{
+			_member = MEMBER::NONE;
+			_depth++;
+			return true;
+		}
+
+		bool Close() noexcept
+		{
+			_depth--;
+			return true;
+		}
+
+		void Status(const JSON::string_t& value) noexcept
+		{
+			_reply.status = Equals(value, "accepted") ? AUTH_STATUS::ACCEPTED
+				: Equals(value, "rejected") ? AUTH_STATUS::REJECTED
+				: Equals(value, "not_enrolled") ? AUTH_STATUS::NOT_ENROLLED
+				: AUTH_STATUS::PROTOCOL_ERROR;
+			_reply.hasStatus = _reply.status != AUTH_STATUS::PROTOCOL_ERROR;
+		}
+
+		void Message(const JSON::string_t& value) noexcept
+		{
+			size_t length = value.size() < DAEMON_JSON_MAX_MESSAGE - 1 ? value.size() : DAEMON_JSON_MAX_MESSAGE - 1;
+			// Never end on half a character
+			while (length < value.size() && length > 0 && (static_cast<unsigned char>(value[length]) & 0xC0) == 0x80)
+			{
+				length--;
+			}
+			memcpy(_reply.message, value.data(), length);
+			_reply.message[length] = '\0';
+			_reply.messageLength = length;
+		}
+
+		DAEMON_JSON_REPLY& _reply;
+		size_t _depth = 0;
+		MEMBER _member = MEMBER::NONE;
+		bool _object = false;
+	};
+}
+
+bool DaemonJson::Decode(const char* data, size_t size, DAEMON_JSON_REPLY& reply)
+{
+	if (data == nullptr)
+	{
+		return false;
+	}
+
+	ReplyHandler handler(reply);
+	const bool parsed = JSON::sax_parse(data, data + size, &handler);
+	return parsed && handler.IsObject();
+}
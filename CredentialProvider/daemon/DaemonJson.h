@@ -0,0 +1,51 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Streaming decoder of JSON daemon replies
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "DaemonProtocol.h"
+#include "SecureString.h"
+#include <cstddef>
+
+// Longest MESSAGE kept, in UTF-8 bytes including the terminator
+#define DAEMON_JSON_MAX_MESSAGE 256
+
+// What AuthClient needs of a JSON reply. Only the top level object is read:
+//   {"status": "accepted" | "rejected" | "not_enrolled" | 0..2,
+//    "message": "...", "token_type": "hotp" | "totp", "challenge": "..."}
+// Other members, nested objects and arrays included, are skipped unread.
+struct DAEMON_JSON_REPLY
+{
+	bool hasStatus = false;
+	AUTH_STATUS status = AUTH_STATUS::PROTOCOL_ERROR;
+	char message[DAEMON_JSON_MAX_MESSAGE] = {};		// truncated at a character boundary
+	size_t messageLength = 0;
+	DAEMON_TOKEN token = DAEMON_TOKEN::NONE;
+	// Prompt of a challenge-response token, it may carry the code sent by SMS
+	// or e-mail, so it goes straight into a wiped string
+	SecureWString challenge;
+};
+
+namespace DaemonJson
+{
+	// Decodes with nlohmann::json::sax_parse, no document is built. Strings are
+	// copied out of the parser's buffer as they are read, the challenge is
+	// wiped from it. false if data is not valid JSON or not an object.
+	bool Decode(const char* data, size_t size, DAEMON_JSON_REPLY& reply);
+}
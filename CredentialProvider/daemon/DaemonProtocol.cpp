@@ -0,0 +1,206 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Framed binary protocol of the authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "DaemonProtocol.h"
+#include "Utf8.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	const size_t FIELD_HEADER_SIZE = 3;
+
+	inline void Put16(uint8_t* p, uint16_t v)
+	{
+		p[0] = uint8_t(v);
+		p[1] = uint8_t(v >> 8);
+	}
+
+	inline void Put32(uint8_t* p, uint32_t v)
+	{
+		Put16(p, uint16_t(v));
+		Put16(p + 2, uint16_t(v >> 16));
+	}
+
+	inline uint16_t Get16(const uint8_t* p)
+	{
+		return uint16_t(p[0] | (p[1] << 8));
+	}
+
+	inline uint32_t Get32(const uint8_t* p)
+	{
+		return uint32_t(Get16(p)) | (uint32_t(Get16(p + 2)) << 16);
+	}
+}
+
+void DaemonProtocol::EncodeHeader(const DAEMON_FRAME_HEADER& header, uint8_t* out) noexcept
+{
+	Put32(out, header.length);
+	Put16(out + 4, header.type);
+	Put16(out + 6, header.flags);
+	Put32(out + 8, header.requestId);
+}
+
+bool DaemonProtocol::DecodeHeader(const uint8_t* in, DAEMON_FRAME_HEADER& header) noexcept
+{
+	header.length = Get32(in);
+	header.type = Get16(in + 4);
+	header.flags = Get16(in + 6);
+	header.requestId = Get32(in + 8);
+	return header.length <= DAEMON_MAX_PAYLOAD;
+}
+
+std::string DaemonProtocol::Utf8(const wchar_t* text, size_t length)
+{
+	return ::Utf8::FromWide(text, length);
+}
+
+std::string DaemonProtocol::Utf8(const std::wstring& text)
+{
+	return Utf8(text.c_str(), text.size());
+}
+
+DaemonMessage::DaemonMessage(DAEMON_MESSAGE type, uint32_t requestId)
+	: _frame(DAEMON_FRAME_HEADER_SIZE, 0)
+{
+	DAEMON_FRAME_HEADER header = { 0, static_cast<uint16_t>(type), 0, requestId };
+	DaemonProtocol::EncodeHeader(header, _frame.data());
+}
+
+DaemonMessage::~DaemonMessage()
+{
+	std::fill(_frame.begin(), _frame.end(), uint8_t(0));
+}
+
+DaemonMessage& DaemonMessage::Add(DAEMON_FIELD field, const void* data, size_t size)
+{
+	if (size > 0xffff)
+	{
+		_valid = false;
+		size = 0xffff;
+	}
+
+	const size_t offset = _frame.size();
+	_frame.resize(offset + FIELD_HEADER_SIZE + size);
+	_frame[offset] = static_cast<uint8_t>(field);
+	Put16(&_frame[offset + 1], uint16_t(size));
+	if (size != 0)
+	{
+		memcpy(&_frame[offset + FIELD_HEADER_SIZE], data, size);
+	}
+	return *this;
+}
+
+DaemonMessage& DaemonMessage::Add(DAEMON_FIELD field, const std::string& value)
+{
+	return Add(field, value.data(), value.size());
+}
+
+DaemonMessage& DaemonMessage::AddInteger(DAEMON_FIELD field, uint64_t value)
+{
+	uint8_t bytes[8];
+	size_t size = 0;
+	do
+	{
+		bytes[size++] = uint8_t(value);
+		value >>= 8;
+	} while (value != 0);
+	return Add(field, bytes, size);
+}
+
+const std::vector<uint8_t>& DaemonMessage::Finish()
+{
+	const size_t payload = _frame.size() - DAEMON_FRAME_HEADER_SIZE;
+	if (!_valid || payload > DAEMON_MAX_PAYLOAD)
+	{
+		std::fill(_frame.begin(), _frame.end(), uint8_t(0));
+		_frame.clear();
+		return _frame;
+	}
+
+	Put32(_frame.data(), uint32_t(payload));
+	return _frame;
+}
+
+bool DaemonFields::Parse(const uint8_t* payload, size_t size) noexcept
+{
+	_count = 0;
+	size_t offset = 0;
+	while (offset < size)
+	{
+		if (size - offset < FIELD_HEADER_SIZE || _count == DAEMON_MAX_FIELDS)
+		{
+			return false;
+		}
+
+		DAEMON_FIELD_VIEW& field = _fields[_count];
+		field.tag = payload[offset];
+		field.size = Get16(payload + offset + 1);
+		field.data = payload + offset + FIELD_HEADER_SIZE;
+		if (field.size > size - offset - FIELD_HEADER_SIZE)
+		{
+			return false;
+		}
+
+		offset += FIELD_HEADER_SIZE + field.size;
+		_count++;
+	}
+	return true;
+}
+
+const DAEMON_FIELD_VIEW* DaemonFields::Find(DAEMON_FIELD field) const noexcept
+{
+	for (size_t i = 0; i < _count; i++)
+	{
+		if (_fields[i].tag == static_cast<uint8_t>(field))
+		{
+			return &_fields[i];
+		}
+	}
+	return nullptr;
+}
+
+bool DaemonFields::Integer(DAEMON_FIELD field, uint64_t& value) const noexcept
+{
+	const DAEMON_FIELD_VIEW* view = Find(field);
+	if (view == nullptr || view->size == 0 || view->size > 8)
+	{
+		return false;
+	}
+
+	value = 0;
+	for (size_t i = view->size; i > 0; i--)
+	{
+		value = (value << 8) | view->data[i - 1];
+	}
+	return true;
+}
+
+bool DaemonFields::String(DAEMON_FIELD field, std::string& value) const
+{
+	const DAEMON_FIELD_VIEW* view = Find(field);
+	if (view == nullptr)
+	{
+		return false;
+	}
+	value.assign(reinterpret_cast<const char*>(view->data), view->size);
+	return true;
+}
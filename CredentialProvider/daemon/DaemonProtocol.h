@@ -0,0 +1,179 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Framed binary protocol of the authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every message is one frame, little-endian:
+//   DAEMON_FRAME_HEADER (12 bytes): payload length, type, flags, request id
+//   payload: fields of (uint8_t tag, uint16_t size, size bytes)
+// Integers are sent in as few bytes as they need (1 to 8), strings as UTF-8
+// without terminator. A reply carries the request id of its request, so any
+// number of requests can be in flight on one connection. Unknown fields are
+// skipped, unknown message types answered with ERROR_REPLY. CANCEL is the only
+// message without a reply, its request id names the request to abandon.
+// A daemon fronting a JSON service may answer VERIFY and LOOKUP with its
+// JSON body in one JSON field instead, see DaemonJson.h.
+// PUSH is a long poll: the daemon sends the user an approval request and
+// replies once it has been approved, denied or has expired, which may take a
+// minute. CANCEL withdraws it.
+
+#define DAEMON_PROTOCOL_VERSION 1
+#define DAEMON_FRAME_HEADER_SIZE 12
+#define DAEMON_MAX_PAYLOAD (64 * 1024)
+#define DAEMON_MAX_FIELDS 16
+
+// Bits of CAPABILITIES in HELLO_REPLY
+#define DAEMON_CAPABILITY_VERIFY 0x1
+#define DAEMON_CAPABILITY_LOOKUP 0x2
+#define DAEMON_CAPABILITY_CANCEL 0x4
+#define DAEMON_CAPABILITY_PING 0x8
+#define DAEMON_CAPABILITY_PUSH 0x10
+
+enum class DAEMON_MESSAGE : uint16_t
+{
+	HELLO = 1,			// VERSION, CLIENT
+	HELLO_REPLY = 2,	// VERSION, CAPABILITIES
+	VERIFY = 3,			// USER_NAME, DOMAIN_NAME, OTP, REQUEST_KEY (optional)
+	VERIFY_REPLY = 4,	// STATUS, MESSAGE or JSON
+	ERROR_REPLY = 5,	// MESSAGE
+	LOOKUP = 6,			// USER_NAME, DOMAIN_NAME
+	LOOKUP_REPLY = 7,	// STATUS, TOKEN_TYPE, DIGITS or JSON
+	CANCEL = 8,			// none
+	PING = 9,			// none
+	PING_REPLY = 10,	// none
+	PUSH = 11,			// USER_NAME, DOMAIN_NAME, MESSAGE (shown with the request), EXPIRES
+	PUSH_REPLY = 12,	// STATUS (ACCEPTED approved, REJECTED denied or expired), MESSAGE
+};
+
+enum class DAEMON_FIELD : uint8_t
+{
+	VERSION = 1,
+	CAPABILITIES = 2,
+	CLIENT = 3,
+	USER_NAME = 4,
+	DOMAIN_NAME = 5,
+	OTP = 6,
+	STATUS = 7,			// AUTH_STATUS
+	MESSAGE = 8,
+	TOKEN_TYPE = 9,		// DAEMON_TOKEN
+	DIGITS = 10,
+	REQUEST_KEY = 11,	// idempotency key, VERIFYs with the same key are one verification
+	JSON = 12,			// UTF-8 JSON object in place of STATUS, MESSAGE and TOKEN_TYPE
+	EXPIRES = 13,		// ms a push approval stays open
+};
+
+// Token of a user as resolved by LOOKUP
+enum class DAEMON_TOKEN : uint32_t
+{
+	NONE = 0,
+	HOTP = 1,
+	TOTP = 2,
+};
+
+// Status of a verification, as sent by the daemon and as reported by AuthClient
+enum class AUTH_STATUS : uint32_t
+{
+	ACCEPTED = 0,		// LOOKUP: the user has a token
+	REJECTED = 1,		// wrong code
+	NOT_ENROLLED = 2,	// the daemon knows no token of the user
+	// Reported by the client only, the daemon gave no answer
+	UNAVAILABLE = 100,
+	TIMEOUT = 101,
+	CANCELLED = 102,
+	PROTOCOL_ERROR = 103,
+};
+
+struct DAEMON_FRAME_HEADER
+{
+	uint32_t length;
+	uint16_t type;		// DAEMON_MESSAGE
+	uint16_t flags;
+	uint32_t requestId;
+};
+
+struct DAEMON_FIELD_VIEW
+{
+	uint8_t tag;
+	uint16_t size;
+	const uint8_t* data;
+};
+
+namespace DaemonProtocol
+{
+	void EncodeHeader(const DAEMON_FRAME_HEADER& header, uint8_t* out) noexcept;
+
+	// false if the payload would exceed DAEMON_MAX_PAYLOAD
+	bool DecodeHeader(const uint8_t* in, DAEMON_FRAME_HEADER& header) noexcept;
+
+	// UTF-16 (Windows) or UTF-32 wchar_t to UTF-8, invalid code points become U+FFFD
+	std::string Utf8(const wchar_t* text, size_t length);
+
+	std::string Utf8(const std::wstring& text);
+}
+
+// Builds one frame. The buffer is wiped on destruction, fields may hold an OTP.
+class DaemonMessage
+{
+public:
+	DaemonMessage(DAEMON_MESSAGE type, uint32_t requestId);
+	~DaemonMessage();
+
+	DaemonMessage(const DaemonMessage&) = delete;
+	DaemonMessage& operator=(const DaemonMessage&) = delete;
+
+	// Fields over 64 KiB - 1 are truncated, the frame then fails Finish()
+	DaemonMessage& Add(DAEMON_FIELD field, const void* data, size_t size);
+
+	DaemonMessage& Add(DAEMON_FIELD field, const std::string& value);
+
+	DaemonMessage& AddInteger(DAEMON_FIELD field, uint64_t value);
+
+	// Complete frame, empty if the payload is too large
+	const std::vector<uint8_t>& Finish();
+
+private:
+	std::vector<uint8_t> _frame;
+	bool _valid = true;
+};
+
+// Fields of a received payload, pointing into the caller's buffer
+class DaemonFields
+{
+public:
+	// false if a field runs past the end or there are more than DAEMON_MAX_FIELDS
+	bool Parse(const uint8_t* payload, size_t size) noexcept;
+
+	const DAEMON_FIELD_VIEW* Find(DAEMON_FIELD field) const noexcept;
+
+	bool Integer(DAEMON_FIELD field, uint64_t& value) const noexcept;
+
+	bool String(DAEMON_FIELD field, std::string& value) const;
+
+	size_t Count() const noexcept { return _count; }
+
+private:
+	DAEMON_FIELD_VIEW _fields[DAEMON_MAX_FIELDS];
+	size_t _count = 0;
+};
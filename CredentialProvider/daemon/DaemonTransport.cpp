@@ -0,0 +1,46 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Byte stream to the authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "DaemonTransport.h"
+
+#ifdef _WIN32
+#include "NamedPipeTransport.h"
+#else
+#include "UnixSocketTransport.h"
+#endif
+
+std::unique_ptr<DaemonTransport> DaemonTransport::Create()
+{
+#ifdef _WIN32
+	return std::unique_ptr<DaemonTransport>(new NamedPipeTransport());
+#else
+	return std::unique_ptr<DaemonTransport>(new UnixSocketTransport());
+#endif
+}
+
+const char* DaemonTransport::DefaultEndpoint() noexcept
+{
+#ifdef _WIN32
+	return "\\\\.\\pipe\\DasAuthDaemon";
+#else
+	return "/tmp/das-auth-daemon.sock";
+#endif
+}
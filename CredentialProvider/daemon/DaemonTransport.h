@@ -0,0 +1,54 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Byte stream to the authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+// Connected byte stream to the daemon, one connection per object. Read() runs
+// on the reader thread of AuthClient while other threads Write(), so
+// implementations must allow one reader and one writer at a time. Shutdown()
+// may be called from any thread.
+class DaemonTransport
+{
+public:
+	virtual ~DaemonTransport() = default;
+
+	// endpoint is a pipe name on Windows, a socket path elsewhere (UTF-8)
+	virtual bool Connect(const std::string& endpoint, unsigned int timeoutMs) noexcept = 0;
+
+	// Writes all of data, false on error
+	virtual bool Write(const void* data, size_t size) noexcept = 0;
+
+	// Blocks until data arrives, returns the bytes read, 0 on end of stream, error or Shutdown()
+	virtual size_t Read(void* data, size_t size) noexcept = 0;
+
+	// Fails pending and later I/O and unblocks Read()
+	virtual void Shutdown() noexcept = 0;
+
+	// Named pipe on Windows, Unix domain socket elsewhere
+	static std::unique_ptr<DaemonTransport> Create();
+
+	// Default endpoint of the platform
+	static const char* DefaultEndpoint() noexcept;
+};
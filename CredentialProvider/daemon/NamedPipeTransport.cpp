@@ -0,0 +1,159 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Named pipe transport (Windows)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifdef _WIN32
+#include "NamedPipeTransport.h"
+
+namespace
+{
+	std::wstring Widen(const std::string& utf8)
+	{
+		const int length = MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), int(utf8.size()), nullptr, 0);
+		std::wstring wide(size_t(length > 0 ? length : 0), L'\0');
+		if (length > 0)
+		{
+			MultiByteToWideChar(CP_UTF8, 0, utf8.c_str(), int(utf8.size()), &wide[0], length);
+		}
+		return wide;
+	}
+}
+
+NamedPipeTransport::NamedPipeTransport() noexcept
+{
+	_shutdown = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	_readEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+	_writeEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+}
+
+NamedPipeTransport::~NamedPipeTransport()
+{
+	Shutdown();
+	if (_pipe != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(_pipe);
+	}
+	for (HANDLE event : { _shutdown, _readEvent, _writeEvent })
+	{
+		if (event != nullptr)
+		{
+			CloseHandle(event);
+		}
+	}
+}
+
+bool NamedPipeTransport::Connect(const std::string& endpoint, unsigned int timeoutMs) noexcept
+{
+	if (_shutdown == nullptr || _readEvent == nullptr || _writeEvent == nullptr || _pipe != INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	std::wstring name;
+	try
+	{
+		name = Widen(endpoint);
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+	for (;;)
+	{
+		_pipe = CreateFileW(name.c_str(), GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_EXISTING,
+			FILE_FLAG_OVERLAPPED, nullptr);
+		if (_pipe != INVALID_HANDLE_VALUE)
+		{
+			return true;
+		}
+
+		// Every instance busy: wait for one within the timeout, any other error is final
+		const ULONGLONG now = GetTickCount64();
+		if (GetLastError() != ERROR_PIPE_BUSY || now >= deadline
+			|| !WaitNamedPipeW(name.c_str(), static_cast<DWORD>(deadline - now)))
+		{
+			return false;
+		}
+	}
+}
+
+bool NamedPipeTransport::Complete(OVERLAPPED& overlapped, BOOL started, DWORD* transferred) noexcept
+{
+	if (!started && GetLastError() != ERROR_IO_PENDING)
+	{
+		return false;
+	}
+
+	const HANDLE events[2] = { overlapped.hEvent, _shutdown };
+	if (WaitForMultipleObjects(2, events, FALSE, INFINITE) != WAIT_OBJECT_0)
+	{
+		CancelIoEx(_pipe, &overlapped);
+		GetOverlappedResult(_pipe, &overlapped, transferred, TRUE);
+		return false;
+	}
+	return GetOverlappedResult(_pipe, &overlapped, transferred, FALSE) != FALSE;
+}
+
+bool NamedPipeTransport::Write(const void* data, size_t size) noexcept
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	while (size > 0)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.hEvent = _writeEvent;
+		ResetEvent(_writeEvent);
+
+		DWORD written = 0;
+		const DWORD chunk = size > 0x10000 ? 0x10000 : static_cast<DWORD>(size);
+		if (!Complete(overlapped, WriteFile(_pipe, p, chunk, nullptr, &overlapped), &written) || written == 0)
+		{
+			return false;
+		}
+		p += written;
+		size -= written;
+	}
+	return true;
+}
+
+size_t NamedPipeTransport::Read(void* data, size_t size) noexcept
+{
+	OVERLAPPED overlapped = {};
+	overlapped.hEvent = _readEvent;
+	ResetEvent(_readEvent);
+
+	DWORD read = 0;
+	const DWORD chunk = size > 0x10000 ? 0x10000 : static_cast<DWORD>(size);
+	if (!Complete(overlapped, ReadFile(_pipe, data, chunk, nullptr, &overlapped), &read))
+	{
+		return 0;
+	}
+	return read;
+}
+
+void NamedPipeTransport::Shutdown() noexcept
+{
+	if (_shutdown != nullptr)
+	{
+		SetEvent(_shutdown);
+	}
+}
+#endif
@@ -0,0 +1,55 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Named pipe transport (Windows)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#ifdef _WIN32
+#include "DaemonTransport.h"
+#include <Windows.h>
+
+// Client end of a byte mode named pipe with overlapped I/O, so Shutdown() can
+// wake a blocked Read() through an event instead of closing the handle under it
+class NamedPipeTransport : public DaemonTransport
+{
+public:
+	NamedPipeTransport() noexcept;
+	~NamedPipeTransport() override;
+
+	NamedPipeTransport(const NamedPipeTransport&) = delete;
+	NamedPipeTransport& operator=(const NamedPipeTransport&) = delete;
+
+	bool Connect(const std::string& endpoint, unsigned int timeoutMs) noexcept override;
+
+	bool Write(const void* data, size_t size) noexcept override;
+
+	size_t Read(void* data, size_t size) noexcept override;
+
+	void Shutdown() noexcept override;
+
+private:
+	// Waits for an overlapped operation, false if it failed or Shutdown() was called
+	bool Complete(OVERLAPPED& overlapped, BOOL started, DWORD* transferred) noexcept;
+
+	HANDLE _pipe = INVALID_HANDLE_VALUE;
+	HANDLE _shutdown = nullptr;
+	HANDLE _readEvent = nullptr;
+	HANDLE _writeEvent = nullptr;
+};
+#endif
@@ -0,0 +1,62 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Short-lived memory of negative answers
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "NegativeCache.h"
+#include <iterator>
+
+bool NegativeCache::Contains(const std::string& key, TIME now) const
+{
+	const auto entry = _expires.find(key);
+	return entry != _expires.end() && now < entry->second;
+}
+
+void NegativeCache::Insert(const std::string& key, TIME now)
+{
+	if (_ttl.count() <= 0 || _capacity == 0)
+	{
+		return;
+	}
+
+	if (_expires.size() >= _capacity && _expires.find(key) == _expires.end())
+	{
+		for (auto entry = _expires.begin(); entry != _expires.end();)
+		{
+			entry = now >= entry->second ? _expires.erase(entry) : std::next(entry);
+		}
+
+		// All alive, the one that expires first goes
+		if (_expires.size() >= _capacity)
+		{
+			auto oldest = _expires.begin();
+			for (auto entry = _expires.begin(); entry != _expires.end(); ++entry)
+			{
+				oldest = entry->second < oldest->second ? entry : oldest;
+			}
+			_expires.erase(oldest);
+		}
+	}
+
+	_expires[key] = now + _ttl;
+}
+
+void NegativeCache::Erase(const std::string& key)
+{
+	_expires.erase(key);
+}
@@ -0,0 +1,56 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Short-lived memory of negative answers
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <chrono>
+#include <string>
+#include <unordered_map>
+
+// Entries kept before the expired ones are dropped, then the oldest
+#define NEGATIVE_CACHE_CAPACITY 1024
+
+// Remembers keys for a fixed time, such as the users a daemon has said it
+// knows no token of, so repeated logons of such a user do not ask again.
+// Time is passed in, like CircuitBreaker. Not thread safe.
+class NegativeCache
+{
+public:
+	typedef std::chrono::steady_clock::time_point TIME;
+
+	// ttl 0 remembers nothing
+	NegativeCache(std::chrono::milliseconds ttl = std::chrono::milliseconds(0), size_t capacity = NEGATIVE_CACHE_CAPACITY) :
+		_ttl(ttl), _capacity(capacity)
+	{
+	}
+
+	bool Contains(const std::string& key, TIME now) const;
+
+	// Remembers key until now + ttl
+	void Insert(const std::string& key, TIME now);
+
+	void Erase(const std::string& key);
+
+	size_t Size() const noexcept { return _expires.size(); }
+
+private:
+	std::chrono::milliseconds _ttl;
+	size_t _capacity;
+	std::unordered_map<std::string, TIME> _expires;
+};
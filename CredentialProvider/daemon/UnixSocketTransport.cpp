@@ -0,0 +1,124 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Unix domain socket transport (Linux)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#ifndef _WIN32
+#include "UnixSocketTransport.h"
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+UnixSocketTransport::~UnixSocketTransport()
+{
+	const int fd = _socket.exchange(-1);
+	if (fd >= 0)
+	{
+		close(fd);
+	}
+}
+
+bool UnixSocketTransport::Connect(const std::string& endpoint, unsigned int timeoutMs) noexcept
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (endpoint.empty() || endpoint.size() >= sizeof(address.sun_path) || _socket >= 0)
+	{
+		return false;
+	}
+	memcpy(address.sun_path, endpoint.c_str(), endpoint.size());
+
+	const int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// Non-blocking connect, so a daemon with a full backlog cannot stall the caller past the timeout
+	const int flags = fcntl(fd, F_GETFL);
+	fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+	int result = connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address));
+	if (result != 0 && (errno == EINPROGRESS || errno == EAGAIN))
+	{
+		pollfd p = { fd, POLLOUT, 0 };
+		int error = 0;
+		socklen_t length = sizeof(error);
+		result = (poll(&p, 1, int(timeoutMs)) == 1 && getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0
+			&& error == 0) ? 0 : -1;
+	}
+	fcntl(fd, F_SETFL, flags);
+
+	if (result != 0)
+	{
+		close(fd);
+		return false;
+	}
+
+	_socket = fd;
+	return true;
+}
+
+bool UnixSocketTransport::Write(const void* data, size_t size) noexcept
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	while (size > 0)
+	{
+		const ssize_t written = send(_socket, p, size, MSG_NOSIGNAL);
+		if (written < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		if (written <= 0)
+		{
+			return false;
+		}
+		p += written;
+		size -= size_t(written);
+	}
+	return true;
+}
+
+size_t UnixSocketTransport::Read(void* data, size_t size) noexcept
+{
+	for (;;)
+	{
+		const ssize_t read = recv(_socket, data, size, 0);
+		if (read < 0 && errno == EINTR)
+		{
+			continue;
+		}
+		return read > 0 ? size_t(read) : 0;
+	}
+}
+
+void UnixSocketTransport::Shutdown() noexcept
+{
+	// Wakes a blocked recv(), the descriptor stays valid until destruction
+	const int fd = _socket;
+	if (fd >= 0)
+	{
+		shutdown(fd, SHUT_RDWR);
+	}
+}
+#endif
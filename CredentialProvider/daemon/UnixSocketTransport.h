@@ -0,0 +1,48 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Unix domain socket transport (Linux)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#ifndef _WIN32
+#include "DaemonTransport.h"
+#include <atomic>
+
+// Stream socket to a daemon listening on a Unix domain socket path
+class UnixSocketTransport : public DaemonTransport
+{
+public:
+	UnixSocketTransport() = default;
+	~UnixSocketTransport() override;
+
+	UnixSocketTransport(const UnixSocketTransport&) = delete;
+	UnixSocketTransport& operator=(const UnixSocketTransport&) = delete;
+
+	bool Connect(const std::string& endpoint, unsigned int timeoutMs) noexcept override;
+
+	bool Write(const void* data, size_t size) noexcept override;
+
+	size_t Read(void* data, size_t size) noexcept override;
+
+	void Shutdown() noexcept override;
+
+private:
+	std::atomic<int> _socket{ -1 };
+};
+#endif
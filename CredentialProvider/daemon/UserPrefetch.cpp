@@ -0,0 +1,116 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Debounced lookup of the user being typed
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "UserPrefetch.h"
+
+UserPrefetch::UserPrefetch(LOOKUP lookup, unsigned int debounceMs) :
+	_lookup(std::move(lookup)), _debounce(debounceMs)
+{
+	_worker = std::thread(&UserPrefetch::Run, this);
+}
+
+UserPrefetch::~UserPrefetch()
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		_stop = true;
+	}
+	_changed.notify_all();
+	_worker.join();
+}
+
+void UserPrefetch::Update(const std::wstring& user, const std::wstring& domain)
+{
+	{
+		std::lock_guard<std::mutex> lock(_lock);
+		if (user == _user && domain == _domain && _generation != 0)
+		{
+			return;
+		}
+		_user = user;
+		_domain = domain;
+		_changedAt = std::chrono::steady_clock::now();
+		_generation++;
+	}
+	_changed.notify_all();
+}
+
+bool UserPrefetch::Find(const std::wstring& user, const std::wstring& domain, AUTH_RESULT& result)
+{
+	std::lock_guard<std::mutex> lock(_lock);
+	if (!_hasResolved || user != _resolvedUser || domain != _resolvedDomain)
+	{
+		return false;
+	}
+	result = _resolved;
+	return true;
+}
+
+void UserPrefetch::Run()
+{
+	std::unique_lock<std::mutex> lock(_lock);
+	for (;;)
+	{
+		_changed.wait(lock, [this]() { return _stop || _generation != _handled; });
+
+		// Debounce, every edit moves _changedAt
+		while (!_stop && std::chrono::steady_clock::now() < _changedAt + _debounce)
+		{
+			_changed.wait_until(lock, _changedAt + _debounce);
+		}
+		if (_stop)
+		{
+			return;
+		}
+
+		const uint64_t generation = _generation;
+		_handled = generation;
+		if (_user.empty())
+		{
+			continue;
+		}
+		const std::wstring user = _user, domain = _domain;
+
+		lock.unlock();
+		AUTH_RESULT result;
+		try
+		{
+			result = _lookup(user, domain, [this, generation]() { return _stop || _generation != generation; });
+		}
+		catch (...)
+		{
+			result.status = AUTH_STATUS::UNAVAILABLE;
+		}
+		lock.lock();
+
+		if (result.status == AUTH_STATUS::CANCELLED)
+		{
+			_cancelled++;
+		}
+		else if (result.status == AUTH_STATUS::ACCEPTED || result.status == AUTH_STATUS::NOT_ENROLLED)
+		{
+			// Only answers are kept, the next lookup of the name may find the daemon back
+			_resolvedUser = user;
+			_resolvedDomain = domain;
+			_resolved = result;
+			_hasResolved = true;
+		}
+	}
+}
@@ -0,0 +1,82 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Debounced lookup of the user being typed
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "AuthClient.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Looks up the user while the name is still being typed. Every edit calls
+// Update(), once the name has not changed for the debounce delay the lookup
+// runs on a worker thread. An edit during a lookup makes it stale: the lookup
+// is told through its stale() callback and should give up with CANCELLED.
+// Only the result of the latest name is kept.
+class UserPrefetch
+{
+public:
+	// Resolves one user, polls stale() while it waits for anything
+	typedef std::function<AUTH_RESULT(const std::wstring& user, const std::wstring& domain,
+		const std::function<bool()>& stale)> LOOKUP;
+
+	UserPrefetch(LOOKUP lookup, unsigned int debounceMs);
+
+	// Makes a running lookup stale and waits for it
+	~UserPrefetch();
+
+	UserPrefetch(const UserPrefetch&) = delete;
+	UserPrefetch& operator=(const UserPrefetch&) = delete;
+
+	// The name changed, an empty user cancels without a new lookup
+	void Update(const std::wstring& user, const std::wstring& domain);
+
+	// Result of the lookup of exactly this name, false if there is none (yet)
+	bool Find(const std::wstring& user, const std::wstring& domain, AUTH_RESULT& result);
+
+	// Lookups given up because the name changed
+	uint64_t Cancelled() const noexcept { return _cancelled; }
+
+private:
+	void Run();
+
+	LOOKUP _lookup;
+	const std::chrono::milliseconds _debounce;
+
+	std::mutex _lock;
+	std::condition_variable _changed;
+	std::wstring _user;
+	std::wstring _domain;
+	std::chrono::steady_clock::time_point _changedAt;
+	uint64_t _handled = 0;					// generation the worker has taken
+
+	std::wstring _resolvedUser;
+	std::wstring _resolvedDomain;
+	AUTH_RESULT _resolved;
+	bool _hasResolved = false;
+
+	std::atomic<uint64_t> _generation{ 0 };	// one per Update()
+	std::atomic<bool> _stop{ false };
+	std::atomic<uint64_t> _cancelled{ 0 };
+	std::thread _worker;
+};
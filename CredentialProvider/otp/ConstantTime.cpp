@@ -0,0 +1,167 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Constant-time OTP truncation and comparison
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ConstantTime.h"
+#include "ShaMultiBuffer.h"
+
+#if SHA_MB_X86
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+	struct RECIPROCAL
+	{
+		uint32_t divisor;
+		uint32_t multiplier;	// ceil(2^shift / divisor)
+		unsigned int shift;
+	};
+
+	// Smallest shift per divisor whose rounding error stays below one for
+	// every value < 2^31 while the multiplier still fits in 32 bits
+	const RECIPROCAL RECIPROCALS[10] =
+	{
+		{ 1, 1, 0 },
+		{ 10, 1717986919, 34 },
+		{ 100, 1374389535, 37 },
+		{ 1000, 274877907, 38 },
+		{ 10000, 1759218605, 44 },
+		{ 100000, 351843721, 45 },
+		{ 1000000, 1125899907, 50 },
+		{ 10000000, 1801439851, 54 },
+		{ 100000000, 1441151881, 57 },
+		{ 1000000000, 1152921505, 60 },
+	};
+
+	// All ones if a == b, zero otherwise
+	inline uint32_t MaskEqual(uint32_t a, uint32_t b)
+	{
+		return uint32_t((uint64_t(a ^ b) - 1) >> 32);
+	}
+
+	// All ones if a < b, zero otherwise. Both must be below 2^31.
+	inline uint32_t MaskLess(uint32_t a, uint32_t b)
+	{
+		return 0u - ((a - b) >> 31);
+	}
+
+	inline uint32_t Select(uint32_t mask, uint32_t a, uint32_t b)
+	{
+		return (a & mask) | (b & ~mask);
+	}
+
+	const uint32_t NO_MATCH = 0x7fffffff;
+
+	// Position i matches if candidates[i] == code and, for pairs, candidates[i + 1] == next
+	bool FindFirst(const uint32_t* candidates, size_t count, uint32_t code, bool pair, uint32_t next, size_t* index)
+	{
+		const size_t positions = pair ? (count > 0 ? count - 1 : 0) : count;
+		uint32_t any = 0;
+		uint32_t best = NO_MATCH;
+		size_t i = 0;
+
+#if SHA_MB_X86
+		// Four positions per compare. Matching lanes carry their position,
+		// the others NO_MATCH, and a masked minimum keeps the smallest one.
+		const __m128i needle = _mm_set1_epi32(static_cast<int>(code));
+		const __m128i needleNext = _mm_set1_epi32(static_cast<int>(next));
+		const __m128i none = _mm_set1_epi32(static_cast<int>(NO_MATCH));
+		const __m128i step = _mm_set1_epi32(4);
+		__m128i position = _mm_setr_epi32(0, 1, 2, 3);
+		__m128i hits = _mm_setzero_si128();
+		__m128i lowest = none;
+
+		for (; i + 4 <= positions; i += 4)
+		{
+			const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates + i));
+			__m128i equal = _mm_cmpeq_epi32(v, needle);
+			if (pair)
+			{
+				const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(candidates + i + 1));
+				equal = _mm_and_si128(equal, _mm_cmpeq_epi32(w, needleNext));
+			}
+			hits = _mm_or_si128(hits, equal);
+
+			const __m128i found = _mm_or_si128(_mm_and_si128(equal, position), _mm_andnot_si128(equal, none));
+			const __m128i less = _mm_cmplt_epi32(found, lowest);
+			lowest = _mm_or_si128(_mm_and_si128(less, found), _mm_andnot_si128(less, lowest));
+			position = _mm_add_epi32(position, step);
+		}
+
+		alignas(16) uint32_t lanes[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), hits);
+		any = lanes[0] | lanes[1] | lanes[2] | lanes[3];
+
+		_mm_store_si128(reinterpret_cast<__m128i*>(lanes), lowest);
+		for (int lane = 0; lane < 4; lane++)
+		{
+			best = Select(MaskLess(lanes[lane], best), lanes[lane], best);
+		}
+#endif
+
+		for (; i < positions; i++)
+		{
+			uint32_t equal = MaskEqual(candidates[i], code);
+			if (pair)
+			{
+				equal &= MaskEqual(candidates[i + 1], next);
+			}
+			const uint32_t found = Select(equal, uint32_t(i), NO_MATCH);
+			any |= equal;
+			best = Select(MaskLess(found, best), found, best);
+		}
+
+		*index = best;
+		return any != 0;
+	}
+}
+
+uint32_t ConstantTime::Truncate(const uint8_t* mac, size_t digestSize) noexcept
+{
+	const uint32_t offset = mac[digestSize - 1] & 0x0f;
+	uint32_t binary = 0;
+	for (uint32_t o = 0; o < 16; o++)
+	{
+		const uint32_t word =
+			(uint32_t(mac[o]) << 24) |
+			(uint32_t(mac[o + 1]) << 16) |
+			(uint32_t(mac[o + 2]) << 8) |
+			uint32_t(mac[o + 3]);
+		binary |= word & MaskEqual(o, offset);
+	}
+	return binary & 0x7fffffff;
+}
+
+uint32_t ConstantTime::Modulo(uint32_t value, unsigned int digits) noexcept
+{
+	const RECIPROCAL& r = RECIPROCALS[digits];
+	const uint32_t quotient = uint32_t((uint64_t(value) * r.multiplier) >> r.shift);
+	return value - quotient * r.divisor;
+}
+
+bool ConstantTime::Find(const uint32_t* candidates, size_t count, uint32_t code, size_t* index) noexcept
+{
+	return FindFirst(candidates, count, code, false, 0, index);
+}
+
+bool ConstantTime::FindPair(const uint32_t* candidates, size_t count, uint32_t code, uint32_t next, size_t* index) noexcept
+{
+	return FindFirst(candidates, count, code, true, next, index);
+}
@@ -0,0 +1,48 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Constant-time OTP truncation and comparison
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Helpers for the part of verification that touches secret-derived values.
+// None of them branch on or index memory with data derived from the MAC, and
+// all of them take the same time whether or not (and where) a code matches.
+namespace ConstantTime
+{
+	// RFC 4226 section 5.4 dynamic truncation to 31 bits. All 16 possible
+	// offsets are read and the selected one is masked in, so the secret offset
+	// never becomes a memory address. digestSize must be at least 20.
+	uint32_t Truncate(const uint8_t* mac, size_t digestSize) noexcept;
+
+	// value mod 10^digits for value < 2^31 via a 32x32->64 multiply by a
+	// precomputed reciprocal, a hardware divide takes data-dependent time.
+	// digits must be in 1..9.
+	uint32_t Modulo(uint32_t value, unsigned int digits) noexcept;
+
+	// Compares code against every candidate without an early exit. Returns
+	// true if any matched and stores the smallest matching position in index.
+	// index is written in both cases, count must be below 2^31.
+	bool Find(const uint32_t* candidates, size_t count, uint32_t code, size_t* index) noexcept;
+
+	// Same for two consecutive codes: matches position i if candidates[i] == code
+	// and candidates[i + 1] == next.
+	bool FindPair(const uint32_t* candidates, size_t count, uint32_t code, uint32_t next, size_t* index) noexcept;
+}
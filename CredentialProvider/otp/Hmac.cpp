@@ -0,0 +1,126 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - HMAC over 8 byte counters
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Hmac.h"
+#include <cstring>
+
+namespace
+{
+	// Zeroing that the optimizer is not allowed to drop
+	void WipeMemory(void* p, size_t n) noexcept
+	{
+		volatile uint8_t* v = static_cast<volatile uint8_t*>(p);
+		while (n--)
+		{
+			*v++ = 0;
+		}
+	}
+
+	// Appends the Merkle-Damgard padding for a message of totalLength bytes whose
+	// last dataLength bytes already sit at the start of block.
+	void PadBlock(uint8_t* block, size_t blockSize, size_t dataLength, uint64_t totalLength) noexcept
+	{
+		memset(block + dataLength, 0, blockSize - dataLength);
+		block[dataLength] = 0x80;
+		const uint64_t bits = totalLength * 8;
+		for (int i = 0; i < 8; i++)
+		{
+			block[blockSize - 1 - i] = uint8_t(bits >> (8 * i));
+		}
+	}
+}
+
+HmacKey::HmacKey() noexcept
+{
+	memset(&_inner, 0, sizeof(_inner));
+	memset(&_outer, 0, sizeof(_outer));
+}
+
+HmacKey::~HmacKey()
+{
+	Clear();
+}
+
+void HmacKey::Initialize(OTP_ALGORITHM algorithm, const uint8_t* key, size_t keyLength) noexcept
+{
+	_algorithm = algorithm;
+	const size_t blockSize = Sha::BlockSize(algorithm);
+
+	uint8_t k[SHA_MAX_BLOCK_SIZE];
+	memset(k, 0, sizeof(k));
+	if (keyLength > blockSize)
+	{
+		Sha::Hash(algorithm, key, keyLength, k);
+	}
+	else if (keyLength > 0)
+	{
+		memcpy(k, key, keyLength);
+	}
+
+	uint8_t pad[SHA_MAX_BLOCK_SIZE];
+	for (size_t i = 0; i < blockSize; i++)
+	{
+		pad[i] = k[i] ^ 0x36;
+	}
+	Sha::Init(algorithm, _inner);
+	Sha::Compress(algorithm, _inner, pad);
+
+	for (size_t i = 0; i < blockSize; i++)
+	{
+		pad[i] = k[i] ^ 0x5c;
+	}
+	Sha::Init(algorithm, _outer);
+	Sha::Compress(algorithm, _outer, pad);
+
+	WipeMemory(pad, sizeof(pad));
+	WipeMemory(k, sizeof(k));
+	_initialized = true;
+}
+
+void HmacKey::Clear() noexcept
+{
+	WipeMemory(&_inner, sizeof(_inner));
+	WipeMemory(&_outer, sizeof(_outer));
+	_initialized = false;
+}
+
+void HmacKey::Counter(uint64_t counter, uint8_t* out) const noexcept
+{
+	const size_t blockSize = Sha::BlockSize(_algorithm);
+	const size_t digestSize = Sha::DigestSize(_algorithm);
+
+	uint8_t block[SHA_MAX_BLOCK_SIZE];
+
+	// inner = H(K ^ ipad || counter), resumed from the cached midstate
+	SHA_STATE state = _inner;
+	for (int i = 0; i < 8; i++)
+	{
+		block[i] = uint8_t(counter >> (56 - 8 * i));
+	}
+	PadBlock(block, blockSize, 8, blockSize + 8);
+	Sha::Compress(_algorithm, state, block);
+	Sha::StoreDigest(_algorithm, state, block);
+
+	// outer = H(K ^ opad || inner)
+	state = _outer;
+	PadBlock(block, blockSize, digestSize, blockSize + digestSize);
+	Sha::Compress(_algorithm, state, block);
+	Sha::StoreDigest(_algorithm, state, out);
+}
@@ -0,0 +1,58 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - HMAC over 8 byte counters
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "Sha.h"
+
+// Key schedule of one token secret. Built once per token, after that every
+// HMAC(key, counter) works on fixed-size stack buffers only.
+// The chaining states after compressing K^ipad and K^opad are cached, so one
+// HMAC over a counter costs two compression calls instead of four.
+class HmacKey
+{
+public:
+	HmacKey() noexcept;
+	~HmacKey();
+
+	HmacKey(const HmacKey&) = delete;
+	HmacKey& operator=(const HmacKey&) = delete;
+
+	// Keys longer than the block size are hashed first, as required by RFC 2104
+	void Initialize(OTP_ALGORITHM algorithm, const uint8_t* key, size_t keyLength) noexcept;
+
+	void Clear() noexcept;
+
+	// out receives DigestSize() bytes
+	void Counter(uint64_t counter, uint8_t* out) const noexcept;
+
+	OTP_ALGORITHM Algorithm() const noexcept { return _algorithm; }
+	size_t DigestSize() const noexcept { return Sha::DigestSize(_algorithm); }
+	bool IsInitialized() const noexcept { return _initialized; }
+
+	const SHA_STATE& InnerState() const noexcept { return _inner; }
+	const SHA_STATE& OuterState() const noexcept { return _outer; }
+
+private:
+	OTP_ALGORITHM _algorithm = OTP_ALGORITHM::SHA1;
+	bool _initialized = false;
+
+	SHA_STATE _inner;	// H state after K ^ ipad
+	SHA_STATE _outer;	// H state after K ^ opad
+};
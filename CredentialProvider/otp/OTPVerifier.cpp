@@ -0,0 +1,334 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - HOTP (RFC 4226) / TOTP (RFC 6238) verification
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "OTPVerifier.h"
+#include "ConstantTime.h"
+#include "ShaMultiBuffer.h"
+#include "WorkerPool.h"
+
+namespace
+{
+	// TOTP checks 2 * window + 1 steps, HOTP window + 1 counters
+	const size_t MAX_CANDIDATES = 2 * OTP_MAX_WINDOW + 1;
+
+	// Counters per resync task, a multiple of the widest kernel
+	const size_t RESYNC_CHUNK = 1024;
+	const size_t RESYNC_MAX_CHUNKS = (OTP_MAX_RESYNC_WINDOW + RESYNC_CHUNK) / RESYNC_CHUNK;
+	const size_t NO_MATCH = size_t(-1);
+}
+
+bool OTPVerifier::Initialize(const OTP_PARAMETERS& parameters, const uint8_t* secret, size_t secretLength) noexcept
+{
+	Clear();
+
+	if (secret == nullptr || secretLength == 0 || secretLength > OTP_MAX_SECRET_SIZE)
+	{
+		return false;
+	}
+
+	if (parameters.digits < OTP_MIN_DIGITS || parameters.digits > OTP_MAX_DIGITS)
+	{
+		return false;
+	}
+
+	if (parameters.type == OTP_TYPE::TOTP && parameters.period == 0)
+	{
+		return false;
+	}
+
+	if (parameters.window > OTP_MAX_WINDOW || parameters.resyncWindow > OTP_MAX_RESYNC_WINDOW)
+	{
+		return false;
+	}
+
+	_parameters = parameters;
+	_key.Initialize(parameters.algorithm, secret, secretLength);
+	return true;
+}
+
+void OTPVerifier::Clear() noexcept
+{
+	_key.Clear();
+}
+
+uint32_t OTPVerifier::Generate(uint64_t counter) const noexcept
+{
+	uint8_t mac[SHA_MAX_DIGEST_SIZE];
+	_key.Counter(counter, mac);
+	return ConstantTime::Modulo(ConstantTime::Truncate(mac, _key.DigestSize()), _parameters.digits);
+}
+
+OTP_RESULT OTPVerifier::Verify(const wchar_t* code, long long unixTime, uint64_t hotpCounter, uint64_t* matchedCounter) const noexcept
+{
+	if (!IsInitialized())
+	{
+		return OTP_RESULT::NOT_CONFIGURED;
+	}
+
+	uint32_t value = 0;
+	if (!ParseCode(code, _parameters.digits, &value))
+	{
+		return OTP_RESULT::MALFORMED;
+	}
+
+	uint64_t first, last;
+	if (_parameters.type == OTP_TYPE::TOTP)
+	{
+		if (unixTime < _parameters.t0)
+		{
+			return OTP_RESULT::INVALID;
+		}
+
+		const uint64_t now = uint64_t(unixTime - _parameters.t0) / _parameters.period;
+		first = now > _parameters.window ? now - _parameters.window : 0;
+		last = now + _parameters.window;
+	}
+	else
+	{
+		first = hotpCounter;
+		last = hotpCounter + _parameters.window;
+	}
+
+	// Every slot of the window is computed and compared, neither the position
+	// of a match nor whether there is one changes the amount of work
+	const size_t digestSize = _key.DigestSize();
+	const size_t total = size_t(last - first + 1);
+	uint64_t counters[SHA_MB_MAX_LANES];
+	uint8_t macs[SHA_MB_MAX_LANES * SHA_MAX_DIGEST_SIZE];
+	uint32_t candidates[MAX_CANDIDATES];
+
+	for (size_t base = 0; base < total; base += SHA_MB_MAX_LANES)
+	{
+		const size_t count = total - base < SHA_MB_MAX_LANES ? total - base : SHA_MB_MAX_LANES;
+		for (size_t i = 0; i < count; i++)
+		{
+			counters[i] = first + base + i;
+		}
+
+		ShaMultiBuffer::HmacCounters(_key, counters, count, macs);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			candidates[base + i] = ConstantTime::Modulo(ConstantTime::Truncate(macs + i * digestSize, digestSize), _parameters.digits);
+		}
+	}
+
+	size_t index = 0;
+	const bool found = ConstantTime::Find(candidates, total, value, &index);
+	if (!found)
+	{
+		return OTP_RESULT::INVALID;
+	}
+
+	if (matchedCounter != nullptr)
+	{
+		*matchedCounter = first + index;
+	}
+	return OTP_RESULT::VALID;
+}
+
+OTP_RESULT OTPVerifier::Resync(const wchar_t* code, const wchar_t* nextCode, uint64_t hotpCounter, uint64_t* matchedCounter) const noexcept
+{
+	// A TOTP token cannot drift out of its window for good, its clock comes back
+	if (!IsInitialized() || _parameters.type != OTP_TYPE::HOTP)
+	{
+		return OTP_RESULT::NOT_CONFIGURED;
+	}
+
+	uint32_t value = 0, nextValue = 0;
+	if (!ParseCode(code, _parameters.digits, &value) || !ParseCode(nextCode, _parameters.digits, &nextValue))
+	{
+		return OTP_RESULT::MALFORMED;
+	}
+
+	// Pairs start at hotpCounter .. hotpCounter + resyncWindow
+	struct SEARCH
+	{
+		uint64_t first;
+		size_t total;
+		uint32_t value;
+		uint32_t nextValue;
+		size_t results[RESYNC_MAX_CHUNKS];
+	} search;
+
+	search.first = hotpCounter;
+	search.total = size_t(_parameters.resyncWindow) + 1;
+	search.value = value;
+	search.nextValue = nextValue;
+	const size_t chunks = (search.total + RESYNC_CHUNK - 1) / RESYNC_CHUNK;
+
+	// Two captured pointers fit the small buffer of std::function, nothing is allocated
+	const std::function<void(size_t)> task = [this, &search](size_t chunk)
+	{
+		const size_t offset = chunk * RESYNC_CHUNK;
+		const size_t count = search.total - offset < RESYNC_CHUNK ? search.total - offset : RESYNC_CHUNK;
+		size_t index = 0;
+		search.results[chunk] = FindPair(search.first + offset, count, search.value, search.nextValue, &index)
+			? offset + index : NO_MATCH;
+	};
+
+	const unsigned int cores = _parameters.resyncThreads != 0 ? _parameters.resyncThreads : std::thread::hardware_concurrency();
+	size_t threads = cores > 1 ? cores - 1 : 0;
+	threads = threads < OTP_RESYNC_MAX_THREADS - 1 ? threads : OTP_RESYNC_MAX_THREADS - 1;
+	threads = threads < chunks - 1 ? threads : chunks - 1;
+
+	WorkerPool pool(threads);
+	pool.Run(chunks, task);
+
+	// Chunks are ordered, the first one with a match holds the smallest counter
+	size_t match = NO_MATCH;
+	for (size_t i = 0; i < chunks; i++)
+	{
+		match = (match == NO_MATCH) ? search.results[i] : match;
+	}
+
+	if (match == NO_MATCH)
+	{
+		return OTP_RESULT::INVALID;
+	}
+
+	if (matchedCounter != nullptr)
+	{
+		*matchedCounter = hotpCounter + match + 1;
+	}
+	return OTP_RESULT::VALID;
+}
+
+long long OTPVerifier::AcceptedUntil(uint64_t counter, long long unixTime) const noexcept
+{
+	if (_parameters.type == OTP_TYPE::HOTP)
+	{
+		return unixTime + OTP_HOTP_REPLAY_TTL;
+	}
+
+	// Step counter is accepted while now is at most counter + window
+	return _parameters.t0 + static_cast<long long>(counter + _parameters.window + 1) * _parameters.period;
+}
+
+bool OTPVerifier::FindPair(uint64_t first, size_t count, uint32_t code, uint32_t nextCode, size_t* index) const noexcept
+{
+	const size_t digestSize = _key.DigestSize();
+	const size_t total = count + 1;
+	uint64_t counters[SHA_MB_MAX_LANES];
+	uint8_t macs[SHA_MB_MAX_LANES * SHA_MAX_DIGEST_SIZE];
+	uint32_t candidates[RESYNC_CHUNK + 1];
+
+	for (size_t base = 0; base < total; base += SHA_MB_MAX_LANES)
+	{
+		const size_t batch = total - base < SHA_MB_MAX_LANES ? total - base : SHA_MB_MAX_LANES;
+		for (size_t i = 0; i < batch; i++)
+		{
+			counters[i] = first + base + i;
+		}
+
+		ShaMultiBuffer::HmacCounters(_key, counters, batch, macs);
+
+		for (size_t i = 0; i < batch; i++)
+		{
+			candidates[base + i] = ConstantTime::Modulo(ConstantTime::Truncate(macs + i * digestSize, digestSize), _parameters.digits);
+		}
+	}
+
+	return ConstantTime::FindPair(candidates, total, code, nextCode, index);
+}
+
+bool OTPVerifier::ParseCode(const wchar_t* code, unsigned int digits, uint32_t* value) noexcept
+{
+	if (code == nullptr || value == nullptr || digits < OTP_MIN_DIGITS || digits > OTP_MAX_DIGITS)
+	{
+		return false;
+	}
+
+	uint32_t result = 0;
+	unsigned int count = 0;
+	for (const wchar_t* p = code; *p != L'\0'; p++)
+	{
+		if (*p == L' ')
+		{
+			continue;
+		}
+		if (*p < L'0' || *p > L'9' || count == digits)
+		{
+			return false;
+		}
+		result = result * 10 + uint32_t(*p - L'0');
+		count++;
+	}
+
+	if (count != digits)
+	{
+		return false;
+	}
+
+	*value = result;
+	return true;
+}
+
+size_t OTPVerifier::DecodeBase32(const char* input, uint8_t* output, size_t outputSize) noexcept
+{
+	if (input == nullptr || output == nullptr)
+	{
+		return 0;
+	}
+
+	uint32_t buffer = 0;
+	int bits = 0;
+	size_t written = 0;
+
+	for (const char* p = input; *p != '\0'; p++)
+	{
+		const char c = *p;
+		uint32_t v;
+		if (c >= 'A' && c <= 'Z')
+		{
+			v = uint32_t(c - 'A');
+		}
+		else if (c >= 'a' && c <= 'z')
+		{
+			v = uint32_t(c - 'a');
+		}
+		else if (c >= '2' && c <= '7')
+		{
+			v = uint32_t(c - '2' + 26);
+		}
+		else if (c == '=' || c == ' ' || c == '-')
+		{
+			continue;
+		}
+		else
+		{
+			return 0;
+		}
+
+		buffer = (buffer << 5) | v;
+		bits += 5;
+		if (bits >= 8)
+		{
+			if (written == outputSize)
+			{
+				return 0;
+			}
+			bits -= 8;
+			output[written++] = uint8_t(buffer >> bits);
+		}
+	}
+
+	return written;
+}
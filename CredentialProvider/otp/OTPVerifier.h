@@ -0,0 +1,106 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - HOTP (RFC 4226) / TOTP (RFC 6238) verification
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "Hmac.h"
+
+#define OTP_MIN_DIGITS 6
+#define OTP_MAX_DIGITS 9
+#define OTP_MAX_SECRET_SIZE 256
+#define OTP_MAX_WINDOW 1000
+#define OTP_MAX_RESYNC_WINDOW 100000
+#define OTP_RESYNC_MAX_THREADS 4
+// How long an accepted HOTP code stays in the replay cache, the counter already excludes it
+#define OTP_HOTP_REPLAY_TTL 3600
+
+enum class OTP_TYPE
+{
+	HOTP = 0,
+	TOTP = 1,
+};
+
+enum class OTP_RESULT
+{
+	VALID = 0,
+	INVALID = 1,		// well-formed code that matched no counter in the window
+	MALFORMED = 2,		// wrong length or non-digit characters
+	NOT_CONFIGURED = 3,	// no token secret loaded
+};
+
+struct OTP_PARAMETERS
+{
+	OTP_TYPE type = OTP_TYPE::TOTP;
+	OTP_ALGORITHM algorithm = OTP_ALGORITHM::SHA1;
+	unsigned int digits = 6;
+	unsigned int period = 30;		// TOTP time step in seconds
+	long long t0 = 0;				// TOTP epoch in unix seconds
+	unsigned int window = 1;		// TOTP: +/- steps around now, HOTP: look-ahead after the expected counter
+	unsigned int resyncWindow = 10000;	// HOTP: look-ahead of Resync()
+	unsigned int resyncThreads = 0;		// threads of Resync(), 0 for one per core up to OTP_RESYNC_MAX_THREADS
+};
+
+// Verifies codes of one token. Initialize() precomputes the HMAC key schedule,
+// Verify() does not allocate and costs one HMAC per window slot. Window slots
+// are hashed in batches through the multi-buffer kernels of ShaMultiBuffer and
+// truncated and compared with the branch-free routines of ConstantTime.
+class OTPVerifier
+{
+public:
+	OTPVerifier() = default;
+
+	OTPVerifier(const OTPVerifier&) = delete;
+	OTPVerifier& operator=(const OTPVerifier&) = delete;
+
+	bool Initialize(const OTP_PARAMETERS& parameters, const uint8_t* secret, size_t secretLength) noexcept;
+
+	void Clear() noexcept;
+
+	bool IsInitialized() const noexcept { return _key.IsInitialized(); }
+
+	const OTP_PARAMETERS& Parameters() const noexcept { return _parameters; }
+
+	// RFC 4226 section 5.3: HOTP(K, C) = Truncate(HMAC(K, C)) mod 10^digits
+	uint32_t Generate(uint64_t counter) const noexcept;
+
+	// TOTP uses unixTime and ignores hotpCounter, HOTP the other way round.
+	// On VALID, matchedCounter (if given) receives the counter that produced the code.
+	OTP_RESULT Verify(const wchar_t* code, long long unixTime, uint64_t hotpCounter, uint64_t* matchedCounter) const noexcept;
+
+	// HOTP only: searches resyncWindow counters after hotpCounter for two consecutive
+	// codes, split into chunks across up to OTP_RESYNC_MAX_THREADS threads.
+	// On VALID, matchedCounter (if given) receives the counter that produced nextCode.
+	OTP_RESULT Resync(const wchar_t* code, const wchar_t* nextCode, uint64_t hotpCounter, uint64_t* matchedCounter) const noexcept;
+
+	// Unix time from which the code of counter can no longer verify, the replay cache keeps it until then
+	long long AcceptedUntil(uint64_t counter, long long unixTime) const noexcept;
+
+	// Parses exactly `digits` decimal digits, spaces are ignored. Returns false for anything else.
+	static bool ParseCode(const wchar_t* code, unsigned int digits, uint32_t* value) noexcept;
+
+	// RFC 4648 base32 without padding requirements, case-insensitive. Returns the decoded size, 0 on error.
+	static size_t DecodeBase32(const char* input, uint8_t* output, size_t outputSize) noexcept;
+
+private:
+	// Index of the first pair in the count codes after first, count + 1 counters are hashed
+	bool FindPair(uint64_t first, size_t count, uint32_t code, uint32_t nextCode, size_t* index) const noexcept;
+
+	OTP_PARAMETERS _parameters;
+	HmacKey _key;
+};
@@ -0,0 +1,291 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Replay cache of recently accepted OTPs
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ReplayCache.h"
+#include "TokenStore.h"
+#include <cwchar>
+
+#ifdef _WIN32
+#include <Windows.h>
+#include <sddl.h>
+#else
+#include <climits>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// A slot holds (fingerprint << 32) | expiry. The fingerprint is never 0, so an
+// all-zero word is an empty slot.
+
+namespace
+{
+	inline uint32_t Fingerprint(uint64_t key)
+	{
+		return uint32_t(key >> 32) | 1;
+	}
+
+	inline uint32_t Expiry(uint64_t slot)
+	{
+		return uint32_t(slot);
+	}
+
+	inline bool IsLive(uint64_t slot, uint32_t fingerprint, uint32_t now)
+	{
+		return slot != 0 && uint32_t(slot >> 32) == fingerprint && Expiry(slot) > now;
+	}
+
+	inline uint64_t Mix(uint64_t h)
+	{
+		// Finalizer of MurmurHash3
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+
+	const size_t SECTION_SIZE = sizeof(std::atomic<uint64_t>) * OTP_REPLAY_SLOTS;
+
+#ifdef _WIN32
+	// Returns the section handle and sets view, nullptr on failure
+	void* OpenSection(const wchar_t* name, void** view) noexcept
+	{
+		// Creating in Global\ needs SeCreateGlobalPrivilege, which users lack, so
+		// nobody but a service or an administrator can put a section there first
+		SECURITY_ATTRIBUTES attributes = { sizeof(attributes), nullptr, FALSE };
+		if (!ConvertStringSecurityDescriptorToSecurityDescriptorW(L"D:P(A;;GA;;;SY)(A;;GA;;;BA)", SDDL_REVISION_1,
+			&attributes.lpSecurityDescriptor, nullptr))
+		{
+			return nullptr;
+		}
+		HANDLE mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, &attributes, PAGE_READWRITE, 0, DWORD(SECTION_SIZE), name);
+		LocalFree(attributes.lpSecurityDescriptor);
+		if (mapping == nullptr)
+		{
+			return nullptr;
+		}
+		// Fails if a section of that name is smaller than ours
+		*view = MapViewOfFile(mapping, FILE_MAP_READ | FILE_MAP_WRITE, 0, 0, SECTION_SIZE);
+		if (*view == nullptr)
+		{
+			CloseHandle(mapping);
+			return nullptr;
+		}
+		return mapping;
+	}
+
+	void CloseSection(void* section, void* view) noexcept
+	{
+		UnmapViewOfFile(view);
+		CloseHandle(section);
+	}
+#else
+	void* OpenSection(const wchar_t* name, void** view) noexcept
+	{
+		char narrow[PATH_MAX];
+		const size_t converted = wcstombs(narrow, name, sizeof(narrow));
+		if (converted == static_cast<size_t>(-1) || converted == sizeof(narrow))
+		{
+			return nullptr;
+		}
+		const int fd = shm_open(narrow, O_RDWR | O_CREAT, 0600);
+		if (fd < 0)
+		{
+			return nullptr;
+		}
+		// New objects are empty, growing them fills with zeros, an empty table
+		struct stat status;
+		if (fstat(fd, &status) != 0 || (status.st_size < off_t(SECTION_SIZE) && ftruncate(fd, off_t(SECTION_SIZE)) != 0))
+		{
+			close(fd);
+			return nullptr;
+		}
+		void* mapped = mmap(nullptr, SECTION_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		close(fd);
+		if (mapped == MAP_FAILED)
+		{
+			return nullptr;
+		}
+		*view = mapped;
+		return mapped;
+	}
+
+	void CloseSection(void*, void* view) noexcept
+	{
+		munmap(view, SECTION_SIZE);
+	}
+#endif
+}
+
+ReplayCache::ReplayCache() noexcept
+	: _slots(_local)
+{
+	Clear();
+}
+
+ReplayCache::ReplayCache(const wchar_t* section) noexcept
+	: _slots(_local)
+{
+	Clear();
+
+	// Words that are not lock-free would be guarded by a lock of this process only
+	void* view = nullptr;
+	if (section != nullptr && _local[0].is_lock_free())
+	{
+		_section = OpenSection(section, &view);
+	}
+	if (_section != nullptr)
+	{
+		_slots = static_cast<std::atomic<uint64_t>*>(view);
+	}
+}
+
+ReplayCache::~ReplayCache()
+{
+	if (_section != nullptr)
+	{
+		CloseSection(_section, _slots);
+	}
+}
+
+ReplayCache& ReplayCache::Instance() noexcept
+{
+	static ReplayCache cache(OTP_REPLAY_SECTION);
+	return cache;
+}
+
+uint64_t ReplayCache::Key(const wchar_t* user, uint64_t token, uint64_t counter) noexcept
+{
+	// FNV-1a over the lowercased user, then token and counter
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (const wchar_t* p = user; p != nullptr && *p != L'\0'; p++)
+	{
+		const wchar_t c = (*p >= L'A' && *p <= L'Z') ? wchar_t(*p - L'A' + L'a') : *p;
+		h = (h ^ uint64_t(c)) * 0x100000001b3ULL;
+	}
+	h = Mix(h ^ token);
+	return Mix(h ^ counter);
+}
+
+uint64_t ReplayCache::AccountKey(const wchar_t* user, const wchar_t* domain, const wchar_t* computer,
+	uint64_t counter) noexcept
+{
+	const bool local = domain == nullptr || *domain == L'\0' || wcscmp(domain, L".") == 0;
+	uint16_t normalized[TOKEN_STORE_MAX_KEY];
+	const size_t length = TokenStore::Normalize(user, local ? computer : domain, normalized, TOKEN_STORE_MAX_KEY);
+
+	// A name too long for a store key is hashed as typed, it cannot be logged on with anyway
+	wchar_t account[TOKEN_STORE_MAX_KEY + 1];
+	for (size_t i = 0; i < length; i++)
+	{
+		account[i] = wchar_t(normalized[i]);
+	}
+	account[length] = L'\0';
+	return Key(length > 0 ? account : user, 0, counter);
+}
+
+uint64_t ReplayCache::TokenKey(uint64_t keyHash, uint64_t counter) noexcept
+{
+	// Tagged, so a name hash and the token number of an account key hash apart
+	const uint64_t h = Mix(keyHash ^ 0x746f6b656e6b6579ULL);
+	return Mix(Mix(h) ^ counter);
+}
+
+REPLAY_RESULT ReplayCache::TryAccept(uint64_t key, uint32_t expiry, uint32_t now) noexcept
+{
+	const uint32_t fingerprint = Fingerprint(key);
+	const uint64_t entry = (uint64_t(fingerprint) << 32) | expiry;
+	const size_t home = size_t(key) & (OTP_REPLAY_SLOTS - 1);
+
+	// Known and still valid: replay
+	for (size_t probe = 0; probe < OTP_REPLAY_PROBES; probe++)
+	{
+		if (IsLive(_slots[(home + probe) & (OTP_REPLAY_SLOTS - 1)].load(), fingerprint, now))
+		{
+			return REPLAY_RESULT::REPLAYED;
+		}
+	}
+
+	// Claim the first empty or expired slot. A live entry of another code is
+	// never taken, that code could be replayed afterwards.
+	size_t claimed = OTP_REPLAY_SLOTS;
+	for (size_t probe = 0; probe < OTP_REPLAY_PROBES && claimed == OTP_REPLAY_SLOTS; probe++)
+	{
+		const size_t index = (home + probe) & (OTP_REPLAY_SLOTS - 1);
+		uint64_t current = _slots[index].load();
+		if (IsLive(current, fingerprint, now))
+		{
+			return REPLAY_RESULT::REPLAYED;
+		}
+		if ((current == 0 || Expiry(current) <= now) && _slots[index].compare_exchange_strong(current, entry))
+		{
+			claimed = index;
+		}
+		else if (IsLive(current, fingerprint, now))
+		{
+			// Lost the slot to the same key
+			return REPLAY_RESULT::REPLAYED;
+		}
+	}
+
+	if (claimed == OTP_REPLAY_SLOTS)
+	{
+		return REPLAY_RESULT::FULL;
+	}
+
+	// Another thread may have claimed a slot for the same key meanwhile. Each of
+	// the two sees the other (or the first one completed before the second
+	// looked), and whoever sees a second live entry backs off.
+	for (size_t probe = 0; probe < OTP_REPLAY_PROBES; probe++)
+	{
+		const size_t index = (home + probe) & (OTP_REPLAY_SLOTS - 1);
+		if (index != claimed && IsLive(_slots[index].load(), fingerprint, now))
+		{
+			uint64_t own = entry;
+			_slots[claimed].compare_exchange_strong(own, 0);
+			return REPLAY_RESULT::REPLAYED;
+		}
+	}
+
+	return REPLAY_RESULT::ACCEPTED;
+}
+
+size_t ReplayCache::Count(uint32_t now) const noexcept
+{
+	size_t count = 0;
+	for (size_t i = 0; i < OTP_REPLAY_SLOTS; i++)
+	{
+		const uint64_t value = _slots[i].load(std::memory_order_relaxed);
+		count += (value != 0 && Expiry(value) > now) ? 1 : 0;
+	}
+	return count;
+}
+
+void ReplayCache::Clear() noexcept
+{
+	for (size_t i = 0; i < OTP_REPLAY_SLOTS; i++)
+	{
+		_slots[i].store(0, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,103 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Replay cache of recently accepted OTPs
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Slots of the cache, a power of two. 128 KB, shared by every session.
+#define OTP_REPLAY_SLOTS 16384
+// Linear probe length, a key lives in one of these slots after its home slot
+#define OTP_REPLAY_PROBES 32
+// Section the LogonUI processes of all sessions map, readable by SYSTEM and Administrators only
+#ifdef _WIN32
+#define OTP_REPLAY_SECTION L"Global\\DasCredentialProviderReplayCache"
+#else
+#define OTP_REPLAY_SECTION L"/das-credential-provider-replay"
+#endif
+
+enum class REPLAY_RESULT
+{
+	ACCEPTED = 0,
+	REPLAYED = 1,	// accepted before and not expired
+	FULL = 2,		// every slot of the probe range holds a live code, nothing was recorded
+};
+
+// Remembers (user, token, counter) triples that were accepted, until the code
+// could no longer be accepted anyway. Fixed-size open-addressing table, every
+// slot is one 64 bit word of key fingerprint and expiry, so lookups and
+// inserts are plain atomic loads and compare-exchanges without locks.
+// Expired slots are reused in place, so memory stays bounded no matter how
+// many logons arrive. A live entry is never evicted: when the probe range
+// holds only live codes the new one is refused as FULL instead.
+// LogonUI runs one process per session, so the table lives in a named
+// section and a code accepted in one session is refused in all others.
+class ReplayCache
+{
+public:
+	// Table of this process only
+	ReplayCache() noexcept;
+
+	// Table in the named section, created zeroed by the first process. Falls
+	// back to a table of this process if the section cannot be opened, e.g.
+	// in a CredUI process without the rights to it.
+	explicit ReplayCache(const wchar_t* section) noexcept;
+
+	~ReplayCache();
+
+	ReplayCache(const ReplayCache&) = delete;
+	ReplayCache& operator=(const ReplayCache&) = delete;
+
+	// Shared by all credentials of the process and, through OTP_REPLAY_SECTION, all sessions
+	static ReplayCache& Instance() noexcept;
+
+	// 64 bit hash of the triple. user is compared case-insensitively (ASCII).
+	static uint64_t Key(const wchar_t* user, uint64_t token, uint64_t counter) noexcept;
+
+	// Key of a code of the machine token, for the account the logon is packed
+	// for: an empty domain and "." are the local computer, as in KerberosLogon,
+	// and the name is normalized like a token store key. So user, .\user and
+	// HOST\user share one key.
+	static uint64_t AccountKey(const wchar_t* user, const wchar_t* domain, const wchar_t* computer,
+		uint64_t counter) noexcept;
+
+	// Key of a code of a token store token, by the hash of its normalized name
+	// rather than by how the user typed it
+	static uint64_t TokenKey(uint64_t keyHash, uint64_t counter) noexcept;
+
+	// Records key until expiry (unix seconds) if it is not recorded yet, or
+	// its entry expired at now. Two threads or processes racing with the same
+	// key may both get REPLAYED, never both ACCEPTED.
+	REPLAY_RESULT TryAccept(uint64_t key, uint32_t expiry, uint32_t now) noexcept;
+
+	// Live entries at now, for diagnostics
+	size_t Count(uint32_t now) const noexcept;
+
+	void Clear() noexcept;
+
+	// false if the table is local to this process
+	bool IsShared() const noexcept { return _slots != _local; }
+
+private:
+	std::atomic<uint64_t>* _slots;
+	std::atomic<uint64_t> _local[OTP_REPLAY_SLOTS];
+	void* _section = nullptr;
+};
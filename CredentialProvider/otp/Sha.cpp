@@ -0,0 +1,375 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - SHA-1 / SHA-2 compression functions
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Sha.h"
+#include <cstring>
+
+namespace
+{
+	inline uint32_t Rotl32(uint32_t x, int n) noexcept
+	{
+		return (x << n) | (x >> (32 - n));
+	}
+
+	inline uint32_t Rotr32(uint32_t x, int n) noexcept
+	{
+		return (x >> n) | (x << (32 - n));
+	}
+
+	inline uint64_t Rotr64(uint64_t x, int n) noexcept
+	{
+		return (x >> n) | (x << (64 - n));
+	}
+
+	inline uint32_t Load32(const uint8_t* p) noexcept
+	{
+		return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+	}
+
+	inline uint64_t Load64(const uint8_t* p) noexcept
+	{
+		return (uint64_t(Load32(p)) << 32) | uint64_t(Load32(p + 4));
+	}
+
+	inline void Store32(uint8_t* p, uint32_t v) noexcept
+	{
+		p[0] = uint8_t(v >> 24);
+		p[1] = uint8_t(v >> 16);
+		p[2] = uint8_t(v >> 8);
+		p[3] = uint8_t(v);
+	}
+
+	inline void Store64(uint8_t* p, uint64_t v) noexcept
+	{
+		Store32(p, uint32_t(v >> 32));
+		Store32(p + 4, uint32_t(v));
+	}
+
+	const uint32_t SHA1_IV[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+
+	const uint32_t SHA256_IV[8] =
+	{
+		0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+	};
+
+	const uint32_t SHA256_K[64] =
+	{
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+	};
+
+	const uint64_t SHA512_IV[8] =
+	{
+		0x6a09e667f3bcc908ULL, 0xbb67ae8584caa73bULL, 0x3c6ef372fe94f82bULL, 0xa54ff53a5f1d36f1ULL,
+		0x510e527fade682d1ULL, 0x9b05688c2b3e6c1fULL, 0x1f83d9abfb41bd6bULL, 0x5be0cd19137e2179ULL
+	};
+
+	const uint64_t SHA512_K[80] =
+	{
+		0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+		0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+		0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+		0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+		0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+		0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+		0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+		0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+		0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+		0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+		0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+		0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+		0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+		0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+		0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+		0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+		0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+		0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+		0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+		0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+	};
+}
+
+namespace Sha
+{
+	size_t BlockSize(OTP_ALGORITHM algorithm) noexcept
+	{
+		return algorithm == OTP_ALGORITHM::SHA512 ? 128 : 64;
+	}
+
+	size_t DigestSize(OTP_ALGORITHM algorithm) noexcept
+	{
+		switch (algorithm)
+		{
+		case OTP_ALGORITHM::SHA256:
+			return 32;
+		case OTP_ALGORITHM::SHA512:
+			return 64;
+		case OTP_ALGORITHM::SHA1:
+		default:
+			return 20;
+		}
+	}
+
+	void Init(OTP_ALGORITHM algorithm, SHA_STATE& state) noexcept
+	{
+		memset(&state, 0, sizeof(state));
+		switch (algorithm)
+		{
+		case OTP_ALGORITHM::SHA256:
+			memcpy(state.w32, SHA256_IV, sizeof(SHA256_IV));
+			break;
+		case OTP_ALGORITHM::SHA512:
+			memcpy(state.w64, SHA512_IV, sizeof(SHA512_IV));
+			break;
+		case OTP_ALGORITHM::SHA1:
+		default:
+			memcpy(state.w32, SHA1_IV, sizeof(SHA1_IV));
+			break;
+		}
+	}
+
+	void Compress(OTP_ALGORITHM algorithm, SHA_STATE& state, const uint8_t* block) noexcept
+	{
+		switch (algorithm)
+		{
+		case OTP_ALGORITHM::SHA256:
+			Sha256Compress(state.w32, block);
+			break;
+		case OTP_ALGORITHM::SHA512:
+			Sha512Compress(state.w64, block);
+			break;
+		case OTP_ALGORITHM::SHA1:
+		default:
+			Sha1Compress(state.w32, block);
+			break;
+		}
+	}
+
+	void StoreDigest(OTP_ALGORITHM algorithm, const SHA_STATE& state, uint8_t* out) noexcept
+	{
+		if (algorithm == OTP_ALGORITHM::SHA512)
+		{
+			for (int i = 0; i < 8; i++)
+			{
+				Store64(out + 8 * i, state.w64[i]);
+			}
+			return;
+		}
+
+		const size_t words = DigestSize(algorithm) / 4;
+		for (size_t i = 0; i < words; i++)
+		{
+			Store32(out + 4 * i, state.w32[i]);
+		}
+	}
+
+	void Hash(OTP_ALGORITHM algorithm, const uint8_t* data, size_t length, uint8_t* out) noexcept
+	{
+		const size_t blockSize = BlockSize(algorithm);
+		// SHA-512 carries a 128 bit length, the others 64 bit. The upper half is always zero here.
+		const size_t lengthBytes = blockSize == 128 ? 16 : 8;
+
+		SHA_STATE state;
+		Init(algorithm, state);
+
+		size_t remaining = length;
+		while (remaining >= blockSize)
+		{
+			Compress(algorithm, state, data);
+			data += blockSize;
+			remaining -= blockSize;
+		}
+
+		uint8_t block[SHA_MAX_BLOCK_SIZE];
+		memset(block, 0, sizeof(block));
+		memcpy(block, data, remaining);
+		block[remaining] = 0x80;
+
+		if (remaining + 1 > blockSize - lengthBytes)
+		{
+			Compress(algorithm, state, block);
+			memset(block, 0, sizeof(block));
+		}
+
+		Store64(block + blockSize - 8, uint64_t(length) * 8);
+		Compress(algorithm, state, block);
+		StoreDigest(algorithm, state, out);
+
+		memset(block, 0, sizeof(block));
+		memset(&state, 0, sizeof(state));
+	}
+
+	void Sha1Compress(uint32_t state[5], const uint8_t block[64]) noexcept
+	{
+		uint32_t w[80];
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = Load32(block + 4 * i);
+		}
+		for (int i = 16; i < 80; i++)
+		{
+			w[i] = Rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3], e = state[4];
+
+		// One loop per round function keeps the round selection out of the inner loop
+		for (int i = 0; i < 20; i++)
+		{
+			const uint32_t t = Rotl32(a, 5) + ((b & c) | (~b & d)) + e + 0x5A827999 + w[i];
+			e = d;
+			d = c;
+			c = Rotl32(b, 30);
+			b = a;
+			a = t;
+		}
+		for (int i = 20; i < 40; i++)
+		{
+			const uint32_t t = Rotl32(a, 5) + (b ^ c ^ d) + e + 0x6ED9EBA1 + w[i];
+			e = d;
+			d = c;
+			c = Rotl32(b, 30);
+			b = a;
+			a = t;
+		}
+		for (int i = 40; i < 60; i++)
+		{
+			const uint32_t t = Rotl32(a, 5) + ((b & c) | (b & d) | (c & d)) + e + 0x8F1BBCDC + w[i];
+			e = d;
+			d = c;
+			c = Rotl32(b, 30);
+			b = a;
+			a = t;
+		}
+		for (int i = 60; i < 80; i++)
+		{
+			const uint32_t t = Rotl32(a, 5) + (b ^ c ^ d) + e + 0xCA62C1D6 + w[i];
+			e = d;
+			d = c;
+			c = Rotl32(b, 30);
+			b = a;
+			a = t;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+	}
+
+	void Sha256Compress(uint32_t state[8], const uint8_t block[64]) noexcept
+	{
+		uint32_t w[64];
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = Load32(block + 4 * i);
+		}
+		for (int i = 16; i < 64; i++)
+		{
+			const uint32_t s0 = Rotr32(w[i - 15], 7) ^ Rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+			const uint32_t s1 = Rotr32(w[i - 2], 17) ^ Rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+		for (int i = 0; i < 64; i++)
+		{
+			const uint32_t S1 = Rotr32(e, 6) ^ Rotr32(e, 11) ^ Rotr32(e, 25);
+			const uint32_t ch = (e & f) ^ (~e & g);
+			const uint32_t t1 = h + S1 + ch + SHA256_K[i] + w[i];
+			const uint32_t S0 = Rotr32(a, 2) ^ Rotr32(a, 13) ^ Rotr32(a, 22);
+			const uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+			const uint32_t t2 = S0 + maj;
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+
+	void Sha512Compress(uint64_t state[8], const uint8_t block[128]) noexcept
+	{
+		uint64_t w[80];
+		for (int i = 0; i < 16; i++)
+		{
+			w[i] = Load64(block + 8 * i);
+		}
+		for (int i = 16; i < 80; i++)
+		{
+			const uint64_t s0 = Rotr64(w[i - 15], 1) ^ Rotr64(w[i - 15], 8) ^ (w[i - 15] >> 7);
+			const uint64_t s1 = Rotr64(w[i - 2], 19) ^ Rotr64(w[i - 2], 61) ^ (w[i - 2] >> 6);
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		uint64_t a = state[0], b = state[1], c = state[2], d = state[3];
+		uint64_t e = state[4], f = state[5], g = state[6], h = state[7];
+
+		for (int i = 0; i < 80; i++)
+		{
+			const uint64_t S1 = Rotr64(e, 14) ^ Rotr64(e, 18) ^ Rotr64(e, 41);
+			const uint64_t ch = (e & f) ^ (~e & g);
+			const uint64_t t1 = h + S1 + ch + SHA512_K[i] + w[i];
+			const uint64_t S0 = Rotr64(a, 28) ^ Rotr64(a, 34) ^ Rotr64(a, 39);
+			const uint64_t maj = (a & b) ^ (a & c) ^ (b & c);
+			const uint64_t t2 = S0 + maj;
+
+			h = g;
+			g = f;
+			f = e;
+			e = d + t1;
+			d = c;
+			c = b;
+			b = a;
+			a = t1 + t2;
+		}
+
+		state[0] += a;
+		state[1] += b;
+		state[2] += c;
+		state[3] += d;
+		state[4] += e;
+		state[5] += f;
+		state[6] += g;
+		state[7] += h;
+	}
+}
@@ -0,0 +1,68 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - SHA-1 / SHA-2 compression functions
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Platform-neutral: this file and everything else in otp/ only depends on the
+// C++ standard library so the engine can be built and exercised off Windows.
+
+#define SHA_MAX_BLOCK_SIZE 128
+#define SHA_MAX_DIGEST_SIZE 64
+
+enum class OTP_ALGORITHM
+{
+	SHA1 = 0,
+	SHA256 = 1,
+	SHA512 = 2,
+};
+
+// Chaining state large enough for any of the supported algorithms.
+// SHA-1 uses w32[0..4], SHA-256 w32[0..7], SHA-512 w64[0..7].
+union SHA_STATE
+{
+	uint32_t w32[16];
+	uint64_t w64[8];
+};
+
+namespace Sha
+{
+	size_t BlockSize(OTP_ALGORITHM algorithm) noexcept;
+
+	size_t DigestSize(OTP_ALGORITHM algorithm) noexcept;
+
+	void Init(OTP_ALGORITHM algorithm, SHA_STATE& state) noexcept;
+
+	// Runs the compression function over exactly one block of BlockSize() bytes
+	void Compress(OTP_ALGORITHM algorithm, SHA_STATE& state, const uint8_t* block) noexcept;
+
+	// Writes the big-endian digest of the current state to out (DigestSize() bytes)
+	void StoreDigest(OTP_ALGORITHM algorithm, const SHA_STATE& state, uint8_t* out) noexcept;
+
+	// One-shot hash of an arbitrary message. Only used when preparing keys, never per OTP.
+	void Hash(OTP_ALGORITHM algorithm, const uint8_t* data, size_t length, uint8_t* out) noexcept;
+
+	void Sha1Compress(uint32_t state[5], const uint8_t block[64]) noexcept;
+
+	void Sha256Compress(uint32_t state[8], const uint8_t block[64]) noexcept;
+
+	void Sha512Compress(uint64_t state[8], const uint8_t block[128]) noexcept;
+}
@@ -0,0 +1,203 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Multi-buffer HMAC-SHA-1 / HMAC-SHA-256 over counters
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ShaMultiBuffer.h"
+#include <cstring>
+
+#if SHA_MB_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+	typedef void (*HMAC_BATCH)(OTP_ALGORITHM, const SHA_STATE&, const SHA_STATE&, const uint64_t*, uint8_t*);
+
+#if SHA_MB_X86
+	void CpuId(int leaf, int subleaf, unsigned int regs[4]) noexcept
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, leaf, subleaf);
+		for (int i = 0; i < 4; i++)
+		{
+			regs[i] = static_cast<unsigned int>(info[i]);
+		}
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	unsigned long long ReadXcr0() noexcept
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+#endif
+
+	SHA_KERNEL Detect() noexcept
+	{
+#if SHA_MB_X86
+		unsigned int regs[4];
+		CpuId(0, 0, regs);
+		const unsigned int maxLeaf = regs[0];
+
+		CpuId(1, 0, regs);
+		const bool sse2 = (regs[3] & (1u << 26)) != 0;
+		const bool osxsave = (regs[2] & (1u << 27)) != 0;
+
+		bool avx2 = false;
+		bool avx512 = false;
+		if (maxLeaf >= 7 && osxsave)
+		{
+			// The OS must save YMM (bits 1, 2) and for AVX-512 also opmask and ZMM state (bits 5-7)
+			const unsigned long long xcr0 = ReadXcr0();
+			CpuId(7, 0, regs);
+			avx2 = (regs[1] & (1u << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+			avx512 = (regs[1] & (1u << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+		}
+
+		if (avx512)
+		{
+			return SHA_KERNEL::AVX512;
+		}
+		if (avx2)
+		{
+			return SHA_KERNEL::AVX2;
+		}
+		if (sse2)
+		{
+			return SHA_KERNEL::SSE2;
+		}
+#endif
+		return SHA_KERNEL::SCALAR;
+	}
+
+	HMAC_BATCH BatchFunction(SHA_KERNEL kernel) noexcept
+	{
+#if SHA_MB_X86
+		switch (kernel)
+		{
+		case SHA_KERNEL::SSE2:
+			return &ShaMultiBuffer::HmacBatchSse2;
+		case SHA_KERNEL::AVX2:
+			return &ShaMultiBuffer::HmacBatchAvx2;
+		case SHA_KERNEL::AVX512:
+			return &ShaMultiBuffer::HmacBatchAvx512;
+		default:
+			break;
+		}
+#else
+		(void)kernel;
+#endif
+		return nullptr;
+	}
+}
+
+namespace ShaMultiBuffer
+{
+	SHA_KERNEL ActiveKernel() noexcept
+	{
+		static const SHA_KERNEL kernel = Detect();
+		return kernel;
+	}
+
+	bool IsSupported(SHA_KERNEL kernel) noexcept
+	{
+		// Kernels are ordered, a CPU with AVX-512 also runs the AVX2 and SSE2 ones
+		return static_cast<int>(kernel) <= static_cast<int>(ActiveKernel());
+	}
+
+	size_t Lanes(SHA_KERNEL kernel) noexcept
+	{
+		switch (kernel)
+		{
+		case SHA_KERNEL::SSE2:
+			return 4;
+		case SHA_KERNEL::AVX2:
+			return 8;
+		case SHA_KERNEL::AVX512:
+			return 16;
+		case SHA_KERNEL::SCALAR:
+		default:
+			return 1;
+		}
+	}
+
+	const char* KernelName(SHA_KERNEL kernel) noexcept
+	{
+		switch (kernel)
+		{
+		case SHA_KERNEL::SSE2:
+			return "sse2";
+		case SHA_KERNEL::AVX2:
+			return "avx2";
+		case SHA_KERNEL::AVX512:
+			return "avx512";
+		case SHA_KERNEL::SCALAR:
+		default:
+			return "scalar";
+		}
+	}
+
+	void HmacCounters(const HmacKey& key, const uint64_t* counters, size_t count, uint8_t* out) noexcept
+	{
+		HmacCounters(ActiveKernel(), key, counters, count, out);
+	}
+
+	void HmacCounters(SHA_KERNEL kernel, const HmacKey& key, const uint64_t* counters, size_t count, uint8_t* out) noexcept
+	{
+		const size_t digestSize = key.DigestSize();
+		size_t done = 0;
+
+		if (key.Algorithm() != OTP_ALGORITHM::SHA512 && IsSupported(kernel))
+		{
+			// Full batches on the requested kernel, the remainder on the narrower ones
+			for (int k = static_cast<int>(kernel); k > static_cast<int>(SHA_KERNEL::SCALAR); k--)
+			{
+				const SHA_KERNEL current = static_cast<SHA_KERNEL>(k);
+				const HMAC_BATCH batch = BatchFunction(current);
+				const size_t lanes = Lanes(current);
+				if (batch == nullptr)
+				{
+					break;
+				}
+
+				for (; done + lanes <= count; done += lanes)
+				{
+					batch(key.Algorithm(), key.InnerState(), key.OuterState(), counters + done, out + done * digestSize);
+				}
+			}
+		}
+
+		for (; done < count; done++)
+		{
+			key.Counter(counters[done], out + done * digestSize);
+		}
+	}
+}
@@ -0,0 +1,70 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Multi-buffer HMAC-SHA-1 / HMAC-SHA-256 over counters
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "Hmac.h"
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define SHA_MB_X86 1
+#else
+#define SHA_MB_X86 0
+#endif
+
+// Widest kernel, one counter per 32 bit lane
+#define SHA_MB_MAX_LANES 16
+
+enum class SHA_KERNEL
+{
+	SCALAR = 0,
+	SSE2 = 1,		// 4 lanes
+	AVX2 = 2,		// 8 lanes
+	AVX512 = 3,		// 16 lanes
+};
+
+// Hashes many independent counters with the same key at once: every SIMD lane
+// runs its own SHA-1/SHA-256 instance over one 8 byte counter. SHA-512 keys and
+// CPUs without SSE2 (ARM64) take the scalar path.
+namespace ShaMultiBuffer
+{
+	// Widest kernel supported by both CPU and OS, detected once per process
+	SHA_KERNEL ActiveKernel() noexcept;
+
+	bool IsSupported(SHA_KERNEL kernel) noexcept;
+
+	size_t Lanes(SHA_KERNEL kernel) noexcept;
+
+	const char* KernelName(SHA_KERNEL kernel) noexcept;
+
+	// out + i * key.DigestSize() receives HMAC(key, counters[i]) for i < count
+	void HmacCounters(const HmacKey& key, const uint64_t* counters, size_t count, uint8_t* out) noexcept;
+
+	// Same with a fixed kernel, falls back to scalar if the kernel is not supported
+	void HmacCounters(SHA_KERNEL kernel, const HmacKey& key, const uint64_t* counters, size_t count, uint8_t* out) noexcept;
+
+	// Kernels, each one processes exactly Lanes() counters
+	void HmacBatchSse2(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+		const uint64_t* counters, uint8_t* out) noexcept;
+
+	void HmacBatchAvx2(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+		const uint64_t* counters, uint8_t* out) noexcept;
+
+	void HmacBatchAvx512(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+		const uint64_t* counters, uint8_t* out) noexcept;
+}
@@ -0,0 +1,69 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Multi-buffer SHA kernel, AVX2 (8 lanes)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ShaMultiBuffer.h"
+
+#if SHA_MB_X86
+
+// MSVC accepts AVX2 intrinsics without /arch, GCC and Clang need the target
+// enabled for this translation unit only. The kernel is only called after
+// ShaMultiBuffer::IsSupported has checked the CPU.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+#include <immintrin.h>
+
+namespace
+{
+	struct VecAvx2
+	{
+		using T = __m256i;
+		static const int LANES = 8;
+
+		static T Add(T a, T b) { return _mm256_add_epi32(a, b); }
+		static T Xor(T a, T b) { return _mm256_xor_si256(a, b); }
+		static T And(T a, T b) { return _mm256_and_si256(a, b); }
+		static T Or(T a, T b) { return _mm256_or_si256(a, b); }
+		static T AndNot(T a, T b) { return _mm256_andnot_si256(a, b); }
+		template <int N> static T Rotl(T a) { return _mm256_or_si256(_mm256_slli_epi32(a, N), _mm256_srli_epi32(a, 32 - N)); }
+		template <int N> static T Shr(T a) { return _mm256_srli_epi32(a, N); }
+		static T Set1(uint32_t v) { return _mm256_set1_epi32(static_cast<int>(v)); }
+		static T Load(const uint32_t* p) { return _mm256_load_si256(reinterpret_cast<const __m256i*>(p)); }
+		static void Store(uint32_t* p, T v) { _mm256_store_si256(reinterpret_cast<__m256i*>(p), v); }
+	};
+}
+
+#include "ShaMultiBufferKernel.h"
+
+void ShaMultiBuffer::HmacBatchAvx2(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+	const uint64_t* counters, uint8_t* out) noexcept
+{
+	HmacBatch<VecAvx2>(algorithm, inner, outer, counters, out);
+	_mm256_zeroupper();
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif // SHA_MB_X86
@@ -0,0 +1,67 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Multi-buffer SHA kernel, AVX-512 (16 lanes)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ShaMultiBuffer.h"
+
+#if SHA_MB_X86
+
+// See ShaMultiBufferAvx2.cpp for why the target is set per translation unit
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx512f"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx512f")
+#endif
+
+#include <immintrin.h>
+
+namespace
+{
+	struct VecAvx512
+	{
+		using T = __m512i;
+		static const int LANES = 16;
+
+		static T Add(T a, T b) { return _mm512_add_epi32(a, b); }
+		static T Xor(T a, T b) { return _mm512_xor_si512(a, b); }
+		static T And(T a, T b) { return _mm512_and_si512(a, b); }
+		static T Or(T a, T b) { return _mm512_or_si512(a, b); }
+		static T AndNot(T a, T b) { return _mm512_andnot_si512(a, b); }
+		template <int N> static T Rotl(T a) { return _mm512_rol_epi32(a, N); }
+		template <int N> static T Shr(T a) { return _mm512_srli_epi32(a, N); }
+		static T Set1(uint32_t v) { return _mm512_set1_epi32(static_cast<int>(v)); }
+		static T Load(const uint32_t* p) { return _mm512_load_si512(p); }
+		static void Store(uint32_t* p, T v) { _mm512_store_si512(p, v); }
+	};
+}
+
+#include "ShaMultiBufferKernel.h"
+
+void ShaMultiBuffer::HmacBatchAvx512(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+	const uint64_t* counters, uint8_t* out) noexcept
+{
+	HmacBatch<VecAvx512>(algorithm, inner, outer, counters, out);
+	_mm256_zeroupper();
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif // SHA_MB_X86
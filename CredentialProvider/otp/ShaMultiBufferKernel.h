@@ -0,0 +1,229 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Multi-buffer SHA kernel template
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Included by exactly one kernel translation unit per instruction set, after
+// that unit has selected its target and defined its vector type V:
+//   V::T, V::LANES, Add, Xor, And, Or, AndNot (~a & b), Rotl<N>, Shr<N>, Set1, Load, Store
+// Everything lives in an anonymous namespace so instantiations compiled for
+// different instruction sets can never be merged by the linker.
+
+#include "Sha.h"
+
+namespace
+{
+	const uint32_t MB_SHA256_K[64] =
+	{
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+	};
+
+	template <class V>
+	inline void Sha1Round(typename V::T& a, typename V::T& b, typename V::T& c, typename V::T& d, typename V::T& e,
+		typename V::T f, typename V::T k, typename V::T w)
+	{
+		const typename V::T t = V::Add(V::Add(V::Add(V::template Rotl<5>(a), f), V::Add(e, k)), w);
+		e = d;
+		d = c;
+		c = V::template Rotl<30>(b);
+		b = a;
+		a = t;
+	}
+
+	template <class V>
+	inline typename V::T Sha1Schedule(typename V::T* w, int i)
+	{
+		w[i & 15] = V::template Rotl<1>(V::Xor(V::Xor(w[(i + 13) & 15], w[(i + 8) & 15]), V::Xor(w[(i + 2) & 15], w[i & 15])));
+		return w[i & 15];
+	}
+
+	// w holds the 16 message words per lane and is overwritten by the schedule
+	template <class V>
+	void Sha1CompressLanes(typename V::T* s, typename V::T* w)
+	{
+		using T = typename V::T;
+		T a = s[0], b = s[1], c = s[2], d = s[3], e = s[4];
+
+		const T k0 = V::Set1(0x5A827999);
+		const T k1 = V::Set1(0x6ED9EBA1);
+		const T k2 = V::Set1(0x8F1BBCDC);
+		const T k3 = V::Set1(0xCA62C1D6);
+
+		for (int i = 0; i < 20; i++)
+		{
+			const T wi = i < 16 ? w[i] : Sha1Schedule<V>(w, i);
+			Sha1Round<V>(a, b, c, d, e, V::Or(V::And(b, c), V::AndNot(b, d)), k0, wi);
+		}
+		for (int i = 20; i < 40; i++)
+		{
+			Sha1Round<V>(a, b, c, d, e, V::Xor(V::Xor(b, c), d), k1, Sha1Schedule<V>(w, i));
+		}
+		for (int i = 40; i < 60; i++)
+		{
+			Sha1Round<V>(a, b, c, d, e, V::Or(V::And(b, c), V::And(d, V::Or(b, c))), k2, Sha1Schedule<V>(w, i));
+		}
+		for (int i = 60; i < 80; i++)
+		{
+			Sha1Round<V>(a, b, c, d, e, V::Xor(V::Xor(b, c), d), k3, Sha1Schedule<V>(w, i));
+		}
+
+		s[0] = V::Add(s[0], a);
+		s[1] = V::Add(s[1], b);
+		s[2] = V::Add(s[2], c);
+		s[3] = V::Add(s[3], d);
+		s[4] = V::Add(s[4], e);
+	}
+
+	template <class V>
+	void Sha256CompressLanes(typename V::T* s, typename V::T* w)
+	{
+		using T = typename V::T;
+		T a = s[0], b = s[1], c = s[2], d = s[3], e = s[4], f = s[5], g = s[6], h = s[7];
+
+		for (int i = 0; i < 64; i++)
+		{
+			if (i >= 16)
+			{
+				const T w15 = w[(i + 1) & 15];
+				const T w2 = w[(i + 14) & 15];
+				const T s0 = V::Xor(V::Xor(V::template Rotl<25>(w15), V::template Rotl<14>(w15)), V::template Shr<3>(w15));
+				const T s1 = V::Xor(V::Xor(V::template Rotl<15>(w2), V::template Rotl<13>(w2)), V::template Shr<10>(w2));
+				w[i & 15] = V::Add(V::Add(w[i & 15], s0), V::Add(w[(i + 9) & 15], s1));
+			}
+
+			const T S1 = V::Xor(V::Xor(V::template Rotl<26>(e), V::template Rotl<21>(e)), V::template Rotl<7>(e));
+			const T ch = V::Xor(V::And(e, f), V::AndNot(e, g));
+			const T t1 = V::Add(V::Add(V::Add(h, S1), V::Add(ch, V::Set1(MB_SHA256_K[i]))), w[i & 15]);
+			const T S0 = V::Xor(V::Xor(V::template Rotl<30>(a), V::template Rotl<19>(a)), V::template Rotl<10>(a));
+			const T maj = V::Or(V::And(a, b), V::And(c, V::Or(a, b)));
+			const T t2 = V::Add(S0, maj);
+
+			h = g;
+			g = f;
+			f = e;
+			e = V::Add(d, t1);
+			d = c;
+			c = b;
+			b = a;
+			a = V::Add(t1, t2);
+		}
+
+		s[0] = V::Add(s[0], a);
+		s[1] = V::Add(s[1], b);
+		s[2] = V::Add(s[2], c);
+		s[3] = V::Add(s[3], d);
+		s[4] = V::Add(s[4], e);
+		s[5] = V::Add(s[5], f);
+		s[6] = V::Add(s[6], g);
+		s[7] = V::Add(s[7], h);
+	}
+
+	// HMAC(key, counter) for V::LANES counters, resumed from the cached inner/outer midstates
+	template <class V>
+	void HmacBatch(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+		const uint64_t* counters, uint8_t* out)
+	{
+		using T = typename V::T;
+		const bool sha256 = algorithm == OTP_ALGORITHM::SHA256;
+		const int words = sha256 ? 8 : 5;
+		const size_t digestSize = size_t(words) * 4;
+
+		alignas(64) uint32_t high[V::LANES];
+		alignas(64) uint32_t low[V::LANES];
+		for (int lane = 0; lane < V::LANES; lane++)
+		{
+			high[lane] = uint32_t(counters[lane] >> 32);
+			low[lane] = uint32_t(counters[lane]);
+		}
+
+		// Inner block: counter || 0x80 || 0... || bit length of (block + 8)
+		T w[16];
+		T s[8];
+		const T zero = V::Set1(0);
+		w[0] = V::Load(high);
+		w[1] = V::Load(low);
+		w[2] = V::Set1(0x80000000);
+		for (int i = 3; i < 15; i++)
+		{
+			w[i] = zero;
+		}
+		w[15] = V::Set1((64 + 8) * 8);
+
+		for (int i = 0; i < words; i++)
+		{
+			s[i] = V::Set1(inner.w32[i]);
+		}
+
+		if (sha256)
+		{
+			Sha256CompressLanes<V>(s, w);
+		}
+		else
+		{
+			Sha1CompressLanes<V>(s, w);
+		}
+
+		// Outer block: inner digest || 0x80 || 0... || bit length of (block + digest)
+		for (int i = 0; i < words; i++)
+		{
+			w[i] = s[i];
+			s[i] = V::Set1(outer.w32[i]);
+		}
+		w[words] = V::Set1(0x80000000);
+		for (int i = words + 1; i < 15; i++)
+		{
+			w[i] = zero;
+		}
+		w[15] = V::Set1(uint32_t((64 + digestSize) * 8));
+
+		if (sha256)
+		{
+			Sha256CompressLanes<V>(s, w);
+		}
+		else
+		{
+			Sha1CompressLanes<V>(s, w);
+		}
+
+		alignas(64) uint32_t digest[8][V::LANES];
+		for (int i = 0; i < words; i++)
+		{
+			V::Store(digest[i], s[i]);
+		}
+
+		for (int lane = 0; lane < V::LANES; lane++)
+		{
+			uint8_t* p = out + size_t(lane) * digestSize;
+			for (int i = 0; i < words; i++)
+			{
+				const uint32_t v = digest[i][lane];
+				p[4 * i] = uint8_t(v >> 24);
+				p[4 * i + 1] = uint8_t(v >> 16);
+				p[4 * i + 2] = uint8_t(v >> 8);
+				p[4 * i + 3] = uint8_t(v);
+			}
+		}
+	}
+}
@@ -0,0 +1,55 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Multi-buffer SHA kernel, SSE2 (4 lanes)
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "ShaMultiBuffer.h"
+
+#if SHA_MB_X86
+
+#include <emmintrin.h>
+
+namespace
+{
+	struct VecSse2
+	{
+		using T = __m128i;
+		static const int LANES = 4;
+
+		static T Add(T a, T b) { return _mm_add_epi32(a, b); }
+		static T Xor(T a, T b) { return _mm_xor_si128(a, b); }
+		static T And(T a, T b) { return _mm_and_si128(a, b); }
+		static T Or(T a, T b) { return _mm_or_si128(a, b); }
+		static T AndNot(T a, T b) { return _mm_andnot_si128(a, b); }
+		template <int N> static T Rotl(T a) { return _mm_or_si128(_mm_slli_epi32(a, N), _mm_srli_epi32(a, 32 - N)); }
+		template <int N> static T Shr(T a) { return _mm_srli_epi32(a, N); }
+		static T Set1(uint32_t v) { return _mm_set1_epi32(static_cast<int>(v)); }
+		static T Load(const uint32_t* p) { return _mm_load_si128(reinterpret_cast<const __m128i*>(p)); }
+		static void Store(uint32_t* p, T v) { _mm_store_si128(reinterpret_cast<__m128i*>(p), v); }
+	};
+}
+
+#include "ShaMultiBufferKernel.h"
+
+void ShaMultiBuffer::HmacBatchSse2(OTP_ALGORITHM algorithm, const SHA_STATE& inner, const SHA_STATE& outer,
+	const uint64_t* counters, uint8_t* out) noexcept
+{
+	HmacBatch<VecSse2>(algorithm, inner, outer, counters, out);
+}
+
+#endif // SHA_MB_X86
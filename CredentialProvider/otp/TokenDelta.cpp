@@ -0,0 +1,378 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Append-only delta log of the token database
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "TokenDelta.h"
+#include "TokenFile.h"
+#include "TokenStoreWriter.h"
+#include <algorithm>
+#include <cstring>
+
+namespace
+{
+	struct CRC_TABLE
+	{
+		uint32_t entries[256];
+
+		CRC_TABLE() noexcept
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t c = i;
+				for (int k = 0; k < 8; k++)
+				{
+					c = (c & 1) ? 0xedb88320 ^ (c >> 1) : c >> 1;
+				}
+				entries[i] = c;
+			}
+		}
+	};
+
+	const CRC_TABLE CRC32_TABLE;
+
+	size_t Padded(size_t size)
+	{
+		return (size + 7) & ~size_t(7);
+	}
+
+	// Payload bytes an entry of this kind needs at least
+	uint64_t Needed(uint16_t type, uint16_t keyLength)
+	{
+		const uint64_t key = uint64_t(keyLength) * sizeof(uint16_t);
+		return type == uint16_t(TOKEN_DELTA::INSERT) ? sizeof(TOKEN_RECORD) + key : key;
+	}
+
+	const uint64_t MAX_ENTRY = sizeof(TOKEN_DELTA_ENTRY) + sizeof(TOKEN_RECORD) + TOKEN_STORE_MAX_KEY * sizeof(uint16_t);
+
+	static_assert(TOKEN_DELTA_READ_SIZE > MAX_ENTRY, "a read holds at least one whole entry");
+
+	bool IsHeader(const uint8_t* data, uint64_t size)
+	{
+		const TOKEN_DELTA_HEADER* header = reinterpret_cast<const TOKEN_DELTA_HEADER*>(data);
+		return data != nullptr && size >= sizeof(TOKEN_DELTA_HEADER)
+			&& memcmp(header->magic, TOKEN_DELTA_MAGIC, sizeof(header->magic)) == 0
+			&& header->version == TOKEN_DELTA_VERSION
+			&& header->headerSize == sizeof(TOKEN_DELTA_HEADER);
+	}
+
+	// Sequence of the base file, 0 if it is missing or of the first format
+	uint64_t BaseSequence(const std::wstring& path)
+	{
+		std::vector<uint8_t> data;
+		uint64_t size = 0;
+		TOKEN_STORE_HEADER header;
+		if (!TokenFile::Read(path.c_str(), 0, sizeof(header), data, size) || data.size() != sizeof(header))
+		{
+			return 0;
+		}
+		memcpy(&header, data.data(), sizeof(header));
+		return memcmp(header.magic, TOKEN_STORE_MAGIC, sizeof(header.magic)) == 0 && header.version == TOKEN_STORE_VERSION
+			&& header.headerSize == sizeof(header) ? header.sequence : 0;
+	}
+}
+
+uint32_t TokenDelta::Crc32(const void* data, size_t size, uint32_t crc) noexcept
+{
+	const uint8_t* p = static_cast<const uint8_t*>(data);
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = CRC32_TABLE.entries[(crc ^ p[i]) & 0xff] ^ (crc >> 8);
+	}
+	return ~crc;
+}
+
+std::wstring TokenDelta::PathOf(const std::wstring& path)
+{
+	return path + L".delta";
+}
+
+std::wstring TokenDelta::LockPathOf(const std::wstring& path)
+{
+	return path + L".lock";
+}
+
+TOKEN_DELTA_HEADER TokenDelta::Header(uint64_t sequence) noexcept
+{
+	TOKEN_DELTA_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TOKEN_DELTA_MAGIC, sizeof(header.magic));
+	header.version = TOKEN_DELTA_VERSION;
+	header.headerSize = sizeof(TOKEN_DELTA_HEADER);
+	header.sequence = sequence;
+	return header;
+}
+
+uint64_t TokenDelta::Scan(const uint8_t* data, uint64_t size, const VISITOR& visit, uint64_t* sequence)
+{
+	if (!IsHeader(data, size))
+	{
+		return 0;
+	}
+
+	uint64_t highest = reinterpret_cast<const TOKEN_DELTA_HEADER*>(data)->sequence;
+	const uint64_t intact = ScanEntries(data + sizeof(TOKEN_DELTA_HEADER), size - sizeof(TOKEN_DELTA_HEADER), visit, &highest);
+	if (sequence != nullptr)
+	{
+		*sequence = highest;
+	}
+	return sizeof(TOKEN_DELTA_HEADER) + intact;
+}
+
+uint64_t TokenDelta::ScanEntries(const uint8_t* data, uint64_t size, const VISITOR& visit, uint64_t* sequence)
+{
+	uint64_t highest = *sequence;
+	uint64_t offset = 0;
+	while (size - offset >= sizeof(TOKEN_DELTA_ENTRY))
+	{
+		const TOKEN_DELTA_ENTRY* entry = reinterpret_cast<const TOKEN_DELTA_ENTRY*>(data + offset);
+		if (entry->type < uint16_t(TOKEN_DELTA::INSERT) || entry->type > uint16_t(TOKEN_DELTA::COUNTER)
+			|| entry->keyLength == 0 || entry->keyLength > TOKEN_STORE_MAX_KEY
+			|| (entry->size & 7) != 0 || entry->size < Needed(entry->type, entry->keyLength)
+			|| entry->size > size - offset - sizeof(TOKEN_DELTA_ENTRY))
+		{
+			break;
+		}
+
+		const uint8_t* payload = data + offset + sizeof(TOKEN_DELTA_ENTRY);
+		const uint32_t crc = Crc32(payload, entry->size,
+			Crc32(&entry->type, sizeof(TOKEN_DELTA_ENTRY) - sizeof(entry->crc)));
+		if (crc != entry->crc)
+		{
+			break;
+		}
+
+		const TOKEN_RECORD* record = nullptr;
+		if (entry->type == uint16_t(TOKEN_DELTA::INSERT))
+		{
+			record = reinterpret_cast<const TOKEN_RECORD*>(payload);
+			payload += sizeof(TOKEN_RECORD);
+		}
+		visit(*entry, record, reinterpret_cast<const uint16_t*>(payload));
+
+		highest = entry->sequence > highest ? entry->sequence : highest;
+		offset += sizeof(TOKEN_DELTA_ENTRY) + entry->size;
+	}
+
+	*sequence = highest;
+	return offset;
+}
+
+TOKEN_DELTA_READ TokenDelta::Check(const std::wstring& path, TOKEN_DELTA_CURSOR& cursor) noexcept
+{
+	std::vector<uint8_t> data;
+	uint64_t size = 0;
+	if (!TokenFile::Read(path.c_str(), 0, sizeof(TOKEN_DELTA_HEADER), data, size))
+	{
+		return TOKEN_DELTA_READ::MISSING;
+	}
+	if (!IsHeader(data.data(), data.size()))
+	{
+		return TOKEN_DELTA_READ::INVALID;
+	}
+
+	// A reset writes a header with a higher sequence and cuts the file off behind it
+	const TOKEN_DELTA_HEADER* header = reinterpret_cast<const TOKEN_DELTA_HEADER*>(data.data());
+	cursor.size = size;
+	if (cursor.offset != 0 && header->sequence == cursor.header && size >= cursor.offset)
+	{
+		return TOKEN_DELTA_READ::APPENDED;
+	}
+
+	cursor.header = header->sequence;
+	cursor.offset = sizeof(TOKEN_DELTA_HEADER);
+	cursor.sequence = header->sequence;
+	return TOKEN_DELTA_READ::RESTARTED;
+}
+
+bool TokenDelta::Read(const std::wstring& path, TOKEN_DELTA_CURSOR& cursor, const VISITOR& visit)
+{
+	std::vector<uint8_t> data;
+	bool ok = true;
+	for (;;)
+	{
+		uint64_t size = 0;
+		if (!TokenFile::Read(path.c_str(), cursor.offset, TOKEN_DELTA_READ_SIZE, data, size))
+		{
+			ok = false;
+			break;
+		}
+		cursor.size = size;
+		const uint64_t intact = ScanEntries(data.data(), data.size(), visit, &cursor.sequence);
+		cursor.offset += intact;
+
+		// The end of the file, or a damaged entry that the end of the piece did not cut
+		if (data.size() < TOKEN_DELTA_READ_SIZE || data.size() - intact >= MAX_ENTRY)
+		{
+			break;
+		}
+	}
+	std::fill(data.begin(), data.end(), uint8_t(0));
+	return ok;
+}
+
+void TokenDelta::Encode(TOKEN_DELTA type, uint64_t sequence, const uint16_t* key, size_t keyLength,
+	const TOKEN_RECORD* record, uint64_t counter, std::vector<uint8_t>& out)
+{
+	const size_t recordSize = type == TOKEN_DELTA::INSERT ? sizeof(TOKEN_RECORD) : 0;
+	const size_t payloadSize = Padded(recordSize + keyLength * sizeof(uint16_t));
+
+	TOKEN_DELTA_ENTRY entry;
+	memset(&entry, 0, sizeof(entry));
+	entry.type = uint16_t(type);
+	entry.keyLength = uint16_t(keyLength);
+	entry.size = uint32_t(payloadSize);
+	entry.sequence = sequence;
+	entry.counter = counter;
+
+	const size_t start = out.size();
+	out.resize(start + sizeof(entry) + payloadSize, 0);
+	uint8_t* payload = out.data() + start + sizeof(entry);
+	if (recordSize != 0)
+	{
+		memcpy(payload, record, recordSize);
+	}
+	memcpy(payload + recordSize, key, keyLength * sizeof(uint16_t));
+
+	entry.crc = Crc32(payload, payloadSize, Crc32(&entry.type, sizeof(entry) - sizeof(entry.crc)));
+	memcpy(out.data() + start, &entry, sizeof(entry));
+}
+
+bool TokenDeltaWriter::Open(const std::wstring& basePath)
+{
+	_basePath = basePath;
+	_path = TokenDelta::PathOf(basePath);
+	_lockPath = TokenDelta::LockPathOf(basePath);
+	_cursor = TOKEN_DELTA_CURSOR();
+
+	const TokenFileLock lock(_lockPath.c_str(), true, TOKEN_STORE_LOCK_TIMEOUT);
+	return lock.IsLocked() && CatchUp();
+}
+
+bool TokenDeltaWriter::CatchUp()
+{
+	switch (TokenDelta::Check(_path, _cursor))
+	{
+	case TOKEN_DELTA_READ::MISSING:
+	{
+		// Numbered after the base, a compacted one skips entries up to its sequence.
+		// Never replaces a log that exists but could not be read.
+		const uint64_t sequence = BaseSequence(_basePath);
+		const TOKEN_DELTA_HEADER header = TokenDelta::Header(sequence);
+		if (!TokenFile::Create(_path.c_str(), &header, sizeof(header)))
+		{
+			return false;
+		}
+		_cursor.header = sequence;
+		_cursor.offset = sizeof(header);
+		_cursor.sequence = sequence;
+		_cursor.size = sizeof(header);
+		return true;
+	}
+	case TOKEN_DELTA_READ::INVALID:
+		// Not a delta log, never overwrite what might be someone else's file
+		return false;
+	default:
+		break;
+	}
+
+	if (!TokenDelta::Read(_path, _cursor, [](const TOKEN_DELTA_ENTRY&, const TOKEN_RECORD*, const uint16_t*) {}))
+	{
+		return false;
+	}
+
+	// Torn append of a writer that crashed: cut it off, entries behind it would never be read
+	if (_cursor.size > _cursor.offset)
+	{
+		if (!TokenFile::Truncate(_path.c_str(), _cursor.offset))
+		{
+			return false;
+		}
+		_cursor.size = _cursor.offset;
+	}
+	return true;
+}
+
+bool TokenDeltaWriter::Insert(const wchar_t* user, const wchar_t* domain, const OTP_PARAMETERS& parameters,
+	const uint8_t* secret, size_t secretLength, uint64_t counter)
+{
+	TOKEN_RECORD record;
+	if (!TokenStoreWriter::BuildRecord(parameters, secret, secretLength, counter, record))
+	{
+		return false;
+	}
+
+	const bool ok = Append(TOKEN_DELTA::INSERT, user, domain, &record, 0);
+	memset(record.secret, 0, sizeof(record.secret));
+	return ok;
+}
+
+bool TokenDeltaWriter::Revoke(const wchar_t* user, const wchar_t* domain)
+{
+	return Append(TOKEN_DELTA::REVOKE, user, domain, nullptr, 0);
+}
+
+bool TokenDeltaWriter::Counter(const wchar_t* user, const wchar_t* domain, uint64_t counter)
+{
+	return Append(TOKEN_DELTA::COUNTER, user, domain, nullptr, counter);
+}
+
+bool TokenDeltaWriter::Append(TOKEN_DELTA type, const wchar_t* user, const wchar_t* domain, const TOKEN_RECORD* record,
+	uint64_t counter)
+{
+	uint16_t key[TOKEN_STORE_MAX_KEY];
+	const size_t length = TokenStore::Normalize(user, domain, key, TOKEN_STORE_MAX_KEY);
+	if (length == 0 || _path.empty())
+	{
+		return false;
+	}
+
+	TOKEN_RECORD keyed;
+	if (record != nullptr)
+	{
+		keyed = *record;
+		keyed.keyHash = TokenStore::Hash(key, length);
+		keyed.keyOffset = 0;
+		keyed.keyLength = uint16_t(length);
+		record = &keyed;
+	}
+
+	const TokenFileLock lock(_lockPath.c_str(), true, TOKEN_STORE_LOCK_TIMEOUT);
+	std::vector<uint8_t> entry;
+	bool ok = lock.IsLocked() && CatchUp();
+	if (ok)
+	{
+		TokenDelta::Encode(type, _cursor.sequence + 1, key, length, record, counter, entry);
+		ok = TokenFile::Append(_path.c_str(), entry.data(), entry.size());
+	}
+	if (record != nullptr)
+	{
+		memset(keyed.secret, 0, sizeof(keyed.secret));
+	}
+	std::fill(entry.begin(), entry.end(), uint8_t(0));
+
+	if (ok)
+	{
+		_cursor.sequence++;
+		_cursor.offset += entry.size();
+		_cursor.size = _cursor.offset;
+	}
+	return ok;
+}
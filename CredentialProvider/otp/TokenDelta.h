@@ -0,0 +1,156 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Append-only delta log of the token database
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#include "TokenStore.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+// File layout, little-endian, every entry 8 byte aligned:
+//   TOKEN_DELTA_HEADER
+//   TOKEN_DELTA_ENTRY + payload, repeated
+// Payload of INSERT is a TOKEN_RECORD followed by the key, REVOKE and COUNTER
+// carry the key only. The key is the normalized name of TokenStore::Normalize,
+// padded to 8 bytes. Entries apply in file order; a reader stops at the first
+// entry whose checksum or bounds do not hold, that is a torn append.
+// Writers hold the lock file of the database exclusively (TokenFileLock), read
+// the entries appended since their last read, cut off a torn tail and number
+// their entry after the highest sequence in the file. Readers share the lock
+// and never change the file.
+// A base file folds in every entry up to its own sequence, the reader skips
+// those, so a crash between writing a compacted base and resetting the log
+// replays nothing twice. Resetting writes a header with the sequence of the
+// new base, readers that see the header change read the base again.
+
+#define TOKEN_DELTA_MAGIC "DASTOKDL"
+#define TOKEN_DELTA_VERSION 1
+// Bytes read from the log at a time, more than the largest entry
+#define TOKEN_DELTA_READ_SIZE (1024 * 1024)
+
+enum class TOKEN_DELTA : uint16_t
+{
+	INSERT = 1,		// adds or replaces the token of a name
+	REVOKE = 2,		// removes the token of a name
+	COUNTER = 3,	// moves the HOTP counter of a name forward
+};
+
+struct TOKEN_DELTA_HEADER
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint64_t sequence;			// highest sequence of the base the log was started on
+};
+
+struct TOKEN_DELTA_ENTRY
+{
+	uint32_t crc;				// CRC-32 of the rest of the entry and the payload
+	uint16_t type;				// TOKEN_DELTA
+	uint16_t keyLength;			// code units
+	uint32_t size;				// payload bytes, multiple of 8
+	uint32_t reserved;
+	uint64_t sequence;
+	uint64_t counter;			// COUNTER: next expected HOTP counter
+};
+
+static_assert(sizeof(TOKEN_DELTA_HEADER) == 24, "TOKEN_DELTA_HEADER layout");
+static_assert(sizeof(TOKEN_DELTA_ENTRY) == 32, "TOKEN_DELTA_ENTRY layout");
+
+enum class TOKEN_DELTA_READ
+{
+	MISSING,	// no log, or it cannot be read
+	INVALID,	// not a log of this version
+	APPENDED,	// the cursor continues
+	RESTARTED,	// first read, or the log was reset: the cursor starts behind the header
+};
+
+namespace TokenDelta
+{
+	// record is the INSERT record or nullptr, key points into the log
+	typedef std::function<void(const TOKEN_DELTA_ENTRY& entry, const TOKEN_RECORD* record, const uint16_t* key)> VISITOR;
+
+	// CRC-32 (IEEE 802.3), crc continues a previous call
+	uint32_t Crc32(const void* data, size_t size, uint32_t crc = 0) noexcept;
+
+	// Delta path of the base file at path
+	std::wstring PathOf(const std::wstring& path);
+
+	// Lock file of the base file at path
+	std::wstring LockPathOf(const std::wstring& path);
+
+	TOKEN_DELTA_HEADER Header(uint64_t sequence) noexcept;
+
+	// Checks the header and visits every intact entry. Returns the size of the
+	// intact part of the log, 0 if the header is invalid. sequence receives the
+	// highest sequence of the header and the entries.
+	uint64_t Scan(const uint8_t* data, uint64_t size, const VISITOR& visit, uint64_t* sequence);
+
+	// Visits the intact entries of data, which starts at an entry. Returns their
+	// size in bytes and raises sequence to the highest among them.
+	uint64_t ScanEntries(const uint8_t* data, uint64_t size, const VISITOR& visit, uint64_t* sequence);
+
+	// Reads the header of the log at path and tells whether cursor can read on,
+	// moves it behind the header if not. The caller holds the lock file.
+	TOKEN_DELTA_READ Check(const std::wstring& path, TOKEN_DELTA_CURSOR& cursor) noexcept;
+
+	// Visits the entries from cursor to the end of the intact log, in pieces of
+	// TOKEN_DELTA_READ_SIZE, and moves cursor behind them. Key and record point
+	// into a buffer that is wiped afterwards.
+	bool Read(const std::wstring& path, TOKEN_DELTA_CURSOR& cursor, const VISITOR& visit);
+
+	// Appends one entry with checksum and padding to out, record is required for INSERT only
+	void Encode(TOKEN_DELTA type, uint64_t sequence, const uint16_t* key, size_t keyLength,
+		const TOKEN_RECORD* record, uint64_t counter, std::vector<uint8_t>& out);
+}
+
+// Appends to the delta log of a token database, used by provisioning tools.
+// Each call is one flushed append under the lock file, so a crash loses at
+// most a torn entry and writers in other processes are numbered after it.
+class TokenDeltaWriter
+{
+public:
+	// Creates the log if missing, otherwise reads it to its last intact entry
+	// and cuts off a torn tail
+	bool Open(const std::wstring& basePath);
+
+	// false for names that do not normalize and invalid tokens
+	bool Insert(const wchar_t* user, const wchar_t* domain, const OTP_PARAMETERS& parameters,
+		const uint8_t* secret, size_t secretLength, uint64_t counter);
+
+	bool Revoke(const wchar_t* user, const wchar_t* domain);
+
+	bool Counter(const wchar_t* user, const wchar_t* domain, uint64_t counter);
+
+	// Highest sequence written or found in the log
+	uint64_t Sequence() const noexcept { return _cursor.sequence; }
+
+private:
+	bool Append(TOKEN_DELTA type, const wchar_t* user, const wchar_t* domain, const TOKEN_RECORD* record, uint64_t counter);
+
+	// Reads what other writers appended and repairs the tail, the caller holds the lock file
+	bool CatchUp();
+
+	std::wstring _basePath;
+	std::wstring _path;
+	std::wstring _lockPath;
+	TOKEN_DELTA_CURSOR _cursor;
+};
@@ -0,0 +1,512 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Token database file access
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#include "TokenFile.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+namespace
+{
+	const DWORD SHARE_ALL = FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE;
+
+	bool WriteAll(HANDLE file, const void* data, size_t size)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (size > 0)
+		{
+			const DWORD chunk = size > 0x40000000 ? 0x40000000 : DWORD(size);
+			DWORD written = 0;
+			if (!WriteFile(file, p, chunk, &written, nullptr) || written == 0)
+			{
+				return false;
+			}
+			p += written;
+			size -= written;
+		}
+		return FlushFileBuffers(file) != FALSE;
+	}
+
+	bool WriteWith(const wchar_t* path, DWORD disposition, const void* data, size_t size)
+	{
+		HANDLE file = CreateFileW(path, GENERIC_WRITE, 0, nullptr, disposition, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+		const bool ok = WriteAll(file, data, size);
+		CloseHandle(file);
+		return ok;
+	}
+}
+
+bool TokenFile::Map(const wchar_t* path, TOKEN_FILE_VIEW& view) noexcept
+{
+	HANDLE file = CreateFileW(path, GENERIC_READ, SHARE_ALL, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	HANDLE mapping = nullptr;
+	if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+	{
+		mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	}
+	if (mapping == nullptr)
+	{
+		CloseHandle(file);
+		return false;
+	}
+
+	const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (data == nullptr)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return false;
+	}
+
+	view.data = static_cast<const uint8_t*>(data);
+	view.size = static_cast<uint64_t>(size.QuadPart);
+	view.file = file;
+	view.mapping = mapping;
+	return true;
+}
+
+void TokenFile::Unmap(TOKEN_FILE_VIEW& view) noexcept
+{
+	if (view.data != nullptr)
+	{
+		UnmapViewOfFile(view.data);
+	}
+	if (view.mapping != nullptr)
+	{
+		CloseHandle(view.mapping);
+	}
+	if (view.file != nullptr)
+	{
+		CloseHandle(view.file);
+	}
+	view = TOKEN_FILE_VIEW();
+}
+
+bool TokenFile::Read(const wchar_t* path, uint64_t offset, uint64_t size, std::vector<uint8_t>& out, uint64_t& fileSize) noexcept
+{
+	HANDLE file = CreateFileW(path, GENERIC_READ, SHARE_ALL, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	bool ok = false;
+	LARGE_INTEGER total;
+	if (GetFileSizeEx(file, &total))
+	{
+		fileSize = static_cast<uint64_t>(total.QuadPart);
+		const uint64_t available = offset < fileSize ? fileSize - offset : 0;
+		LARGE_INTEGER position;
+		position.QuadPart = static_cast<LONGLONG>(offset);
+		try
+		{
+			out.resize(size_t(size < available ? size : available));
+			ok = SetFilePointerEx(file, position, nullptr, FILE_BEGIN) != FALSE;
+		}
+		catch (...)
+		{
+		}
+
+		size_t done = 0;
+		while (ok && done < out.size())
+		{
+			const size_t left = out.size() - done;
+			DWORD read = 0;
+			ok = ReadFile(file, out.data() + done, left > 0x40000000 ? 0x40000000 : DWORD(left), &read, nullptr) && read != 0;
+			done += read;
+		}
+	}
+	CloseHandle(file);
+	return ok;
+}
+
+bool TokenFile::Write(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	return WriteWith(path, CREATE_ALWAYS, data, size);
+}
+
+bool TokenFile::Create(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	return WriteWith(path, CREATE_NEW, data, size);
+}
+
+bool TokenFile::Overwrite(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	HANDLE file = CreateFileW(path, GENERIC_WRITE, SHARE_ALL, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	const bool ok = WriteAll(file, data, size) && SetEndOfFile(file) && FlushFileBuffers(file);
+	CloseHandle(file);
+	return ok;
+}
+
+bool TokenFile::Append(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	HANDLE file = CreateFileW(path, FILE_APPEND_DATA, SHARE_ALL, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	const bool ok = WriteAll(file, data, size);
+	CloseHandle(file);
+	return ok;
+}
+
+bool TokenFile::Size(const wchar_t* path, uint64_t& size) noexcept
+{
+	WIN32_FILE_ATTRIBUTE_DATA data;
+	if (!GetFileAttributesExW(path, GetFileExInfoStandard, &data))
+	{
+		return false;
+	}
+	size = (uint64_t(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+	return true;
+}
+
+bool TokenFile::Truncate(const wchar_t* path, uint64_t size) noexcept
+{
+	HANDLE file = CreateFileW(path, GENERIC_WRITE, SHARE_ALL, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	LARGE_INTEGER position;
+	position.QuadPart = static_cast<LONGLONG>(size);
+	const bool ok = SetFilePointerEx(file, position, nullptr, FILE_BEGIN) && SetEndOfFile(file) && FlushFileBuffers(file);
+	CloseHandle(file);
+	return ok;
+}
+
+bool TokenFile::Replace(const wchar_t* from, const wchar_t* to) noexcept
+{
+	return MoveFileExW(from, to, MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != FALSE;
+}
+
+bool TokenFile::Remove(const wchar_t* path) noexcept
+{
+	return DeleteFileW(path) != FALSE;
+}
+
+TokenFileLock::TokenFileLock(const wchar_t* path, bool exclusive, unsigned int timeoutMs) noexcept
+{
+	HANDLE file = CreateFileW(path, GENERIC_READ | GENERIC_WRITE, SHARE_ALL, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+
+	// LockFileEx waits without a timeout, so poll
+	const DWORD flags = LOCKFILE_FAIL_IMMEDIATELY | (exclusive ? LOCKFILE_EXCLUSIVE_LOCK : 0);
+	const ULONGLONG deadline = GetTickCount64() + timeoutMs;
+	for (;;)
+	{
+		OVERLAPPED overlapped = {};
+		if (LockFileEx(file, flags, 0, 1, 0, &overlapped))
+		{
+			_file = file;
+			return;
+		}
+		if (GetLastError() != ERROR_LOCK_VIOLATION || GetTickCount64() >= deadline)
+		{
+			break;
+		}
+		Sleep(1);
+	}
+	CloseHandle(file);
+}
+
+TokenFileLock::~TokenFileLock()
+{
+	if (_file != nullptr)
+	{
+		OVERLAPPED overlapped = {};
+		UnlockFileEx(_file, 0, 1, 0, &overlapped);
+		CloseHandle(_file);
+	}
+}
+
+bool TokenFileLock::IsLocked() const noexcept
+{
+	return _file != nullptr;
+}
+
+#else
+
+namespace
+{
+	bool Narrow(const wchar_t* path, char (&out)[PATH_MAX])
+	{
+		if (path == nullptr)
+		{
+			return false;
+		}
+		const size_t converted = wcstombs(out, path, sizeof(out));
+		return converted != static_cast<size_t>(-1) && converted != sizeof(out);
+	}
+
+	bool WriteAll(int fd, const void* data, size_t size)
+	{
+		const uint8_t* p = static_cast<const uint8_t*>(data);
+		while (size > 0)
+		{
+			const ssize_t written = write(fd, p, size);
+			if (written < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			if (written <= 0)
+			{
+				return false;
+			}
+			p += written;
+			size -= size_t(written);
+		}
+		return fsync(fd) == 0;
+	}
+
+	bool WriteWith(const wchar_t* path, int flags, const void* data, size_t size)
+	{
+		char narrow[PATH_MAX];
+		if (!Narrow(path, narrow))
+		{
+			return false;
+		}
+
+		const int fd = open(narrow, flags | O_WRONLY | O_CLOEXEC, 0600);
+		if (fd < 0)
+		{
+			return false;
+		}
+		const bool ok = WriteAll(fd, data, size);
+		return close(fd) == 0 && ok;
+	}
+
+	int Open(const wchar_t* path, int flags)
+	{
+		char narrow[PATH_MAX];
+		return Narrow(path, narrow) ? open(narrow, flags | O_CLOEXEC, 0600) : -1;
+	}
+}
+
+bool TokenFile::Map(const wchar_t* path, TOKEN_FILE_VIEW& view) noexcept
+{
+	char narrow[PATH_MAX];
+	if (!Narrow(path, narrow))
+	{
+		return false;
+	}
+
+	const int fd = open(narrow, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	struct stat st;
+	void* data = MAP_FAILED;
+	if (fstat(fd, &st) == 0 && st.st_size > 0)
+	{
+		data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+	}
+	close(fd);
+
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+
+	view.data = static_cast<const uint8_t*>(data);
+	view.size = static_cast<uint64_t>(st.st_size);
+	return true;
+}
+
+void TokenFile::Unmap(TOKEN_FILE_VIEW& view) noexcept
+{
+	if (view.data != nullptr)
+	{
+		munmap(const_cast<uint8_t*>(view.data), static_cast<size_t>(view.size));
+	}
+	view = TOKEN_FILE_VIEW();
+}
+
+bool TokenFile::Read(const wchar_t* path, uint64_t offset, uint64_t size, std::vector<uint8_t>& out, uint64_t& fileSize) noexcept
+{
+	const int fd = Open(path, O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	bool ok = false;
+	struct stat st;
+	if (fstat(fd, &st) == 0)
+	{
+		fileSize = static_cast<uint64_t>(st.st_size);
+		const uint64_t available = offset < fileSize ? fileSize - offset : 0;
+		try
+		{
+			out.resize(size_t(size < available ? size : available));
+			ok = true;
+		}
+		catch (...)
+		{
+		}
+
+		size_t done = 0;
+		while (ok && done < out.size())
+		{
+			const ssize_t read = pread(fd, out.data() + done, out.size() - done, static_cast<off_t>(offset + done));
+			if (read < 0 && errno == EINTR)
+			{
+				continue;
+			}
+			ok = read > 0;
+			done += ok ? size_t(read) : 0;
+		}
+	}
+	close(fd);
+	return ok;
+}
+
+bool TokenFile::Write(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	return WriteWith(path, O_CREAT | O_TRUNC, data, size);
+}
+
+bool TokenFile::Create(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	return WriteWith(path, O_CREAT | O_EXCL, data, size);
+}
+
+bool TokenFile::Overwrite(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	const int fd = Open(path, O_WRONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	const bool ok = WriteAll(fd, data, size) && ftruncate(fd, static_cast<off_t>(size)) == 0 && fsync(fd) == 0;
+	return close(fd) == 0 && ok;
+}
+
+bool TokenFile::Append(const wchar_t* path, const void* data, size_t size) noexcept
+{
+	return WriteWith(path, O_APPEND, data, size);
+}
+
+bool TokenFile::Size(const wchar_t* path, uint64_t& size) noexcept
+{
+	char narrow[PATH_MAX];
+	struct stat st;
+	if (!Narrow(path, narrow) || stat(narrow, &st) != 0)
+	{
+		return false;
+	}
+	size = static_cast<uint64_t>(st.st_size);
+	return true;
+}
+
+bool TokenFile::Truncate(const wchar_t* path, uint64_t size) noexcept
+{
+	char narrow[PATH_MAX];
+	return Narrow(path, narrow) && truncate(narrow, static_cast<off_t>(size)) == 0;
+}
+
+bool TokenFile::Replace(const wchar_t* from, const wchar_t* to) noexcept
+{
+	char narrowFrom[PATH_MAX], narrowTo[PATH_MAX];
+	return Narrow(from, narrowFrom) && Narrow(to, narrowTo) && std::rename(narrowFrom, narrowTo) == 0;
+}
+
+bool TokenFile::Remove(const wchar_t* path) noexcept
+{
+	char narrow[PATH_MAX];
+	return Narrow(path, narrow) && unlink(narrow) == 0;
+}
+
+TokenFileLock::TokenFileLock(const wchar_t* path, bool exclusive, unsigned int timeoutMs) noexcept
+{
+	const int fd = Open(path, O_RDWR | O_CREAT);
+	if (fd < 0)
+	{
+		return;
+	}
+
+	// flock() waits without a timeout, so poll
+	const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+	for (;;)
+	{
+		if (flock(fd, (exclusive ? LOCK_EX : LOCK_SH) | LOCK_NB) == 0)
+		{
+			_fd = fd;
+			return;
+		}
+		if ((errno != EWOULDBLOCK && errno != EINTR) || std::chrono::steady_clock::now() >= deadline)
+		{
+			break;
+		}
+		usleep(1000);
+	}
+	close(fd);
+}
+
+TokenFileLock::~TokenFileLock()
+{
+	if (_fd >= 0)
+	{
+		// Closing the descriptor releases the lock
+		close(_fd);
+	}
+}
+
+bool TokenFileLock::IsLocked() const noexcept
+{
+	return _fd >= 0;
+}
+
+#endif
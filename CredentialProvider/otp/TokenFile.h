@@ -0,0 +1,99 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Token database file access
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Read-only view of a whole file
+struct TOKEN_FILE_VIEW
+{
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+#ifdef _WIN32
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// The few file operations of the token database, on Win32 and POSIX. Paths are
+// wide on both, POSIX converts them with wcstombs. Views share read, write and
+// delete access, so a mapped base file can be renamed aside. The delta log is
+// never mapped, it is read with Read() and can be truncated at any time.
+namespace TokenFile
+{
+	// false for missing and empty files
+	bool Map(const wchar_t* path, TOKEN_FILE_VIEW& view) noexcept;
+
+	void Unmap(TOKEN_FILE_VIEW& view) noexcept;
+
+	// Reads at most size bytes from offset into out, less at the end of the file.
+	// fileSize receives the size of the whole file.
+	bool Read(const wchar_t* path, uint64_t offset, uint64_t size, std::vector<uint8_t>& out, uint64_t& fileSize) noexcept;
+
+	// Creates or truncates path, data is flushed to disk on success
+	bool Write(const wchar_t* path, const void* data, size_t size) noexcept;
+
+	// Like Write(), but fails if path exists
+	bool Create(const wchar_t* path, const void* data, size_t size) noexcept;
+
+	// Writes data at the start of path, which must exist, and cuts the file off
+	// behind it. Works while other processes have the file open, Write() does not.
+	bool Overwrite(const wchar_t* path, const void* data, size_t size) noexcept;
+
+	// Appends to path, which must exist, data is flushed to disk on success
+	bool Append(const wchar_t* path, const void* data, size_t size) noexcept;
+
+	bool Size(const wchar_t* path, uint64_t& size) noexcept;
+
+	// Fails on Windows while path is mapped
+	bool Truncate(const wchar_t* path, uint64_t size) noexcept;
+
+	// Atomically replaces to with from
+	bool Replace(const wchar_t* from, const wchar_t* to) noexcept;
+
+	bool Remove(const wchar_t* path) noexcept;
+}
+
+// Lock file of a token database, held by every process that writes the delta
+// log or swaps the base file and shared by those that read the log. The lock
+// belongs to the open file, not the process, so two stores of one process
+// exclude each other as well. The file is created if missing and never removed.
+class TokenFileLock
+{
+public:
+	// Polls for the lock up to timeoutMs, IsLocked() tells whether it was taken
+	TokenFileLock(const wchar_t* path, bool exclusive, unsigned int timeoutMs) noexcept;
+	~TokenFileLock();
+
+	TokenFileLock(const TokenFileLock&) = delete;
+	TokenFileLock& operator=(const TokenFileLock&) = delete;
+
+	bool IsLocked() const noexcept;
+
+private:
+#ifdef _WIN32
+	void* _file = nullptr;
+#else
+	int _fd = -1;
+#endif
+};
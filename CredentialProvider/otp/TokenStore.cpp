@@ -0,0 +1,852 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Memory-mapped offline token database
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "TokenStore.h"
+#include "TokenDelta.h"
+#include "TokenStoreWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <cwchar>
+
+namespace
+{
+	inline uint16_t Lower(wchar_t c)
+	{
+		return uint16_t((c >= L'A' && c <= L'Z') ? c - L'A' + L'a' : c);
+	}
+
+	// Appends [begin, end) lowercased, false if it does not fit or is not UTF-16 representable
+	bool Append(const wchar_t* begin, const wchar_t* end, uint16_t* out, size_t outSize, size_t* length)
+	{
+		for (const wchar_t* p = begin; p != end; p++)
+		{
+			if (*length == outSize || static_cast<unsigned long>(*p) > 0xffff)
+			{
+				return false;
+			}
+			out[(*length)++] = Lower(*p);
+		}
+		return true;
+	}
+
+	const wchar_t* End(const wchar_t* s)
+	{
+		return s + wcslen(s);
+	}
+
+	bool InBounds(uint64_t offset, uint64_t size, uint64_t fileSize)
+	{
+		return offset <= fileSize && size <= fileSize - offset && (offset & 7) == 0;
+	}
+
+	// Header of the first format, without the sequence
+	const uint32_t HEADER_SIZE_V1 = 72;
+
+	const int COMPACTION_ATTEMPTS = 3;
+
+	inline uint64_t Mix(uint64_t h)
+	{
+		// Finalizer of MurmurHash3
+		h ^= h >> 33;
+		h *= 0xff51afd7ed558ccdULL;
+		h ^= h >> 33;
+		h *= 0xc4ceb9fe1a85ec53ULL;
+		h ^= h >> 33;
+		return h;
+	}
+}
+
+TokenStore::~TokenStore()
+{
+	Close();
+}
+
+bool TokenStore::Open(const wchar_t* path) noexcept
+{
+	Close();
+
+	if (path == nullptr || *path == L'\0')
+	{
+		return false;
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(_lock);
+	try
+	{
+		_path = path;
+		_deltaPath = TokenDelta::PathOf(_path);
+		_lockPath = TokenDelta::LockPathOf(_path);
+	}
+	catch (...)
+	{
+		return false;
+	}
+	return MapBase();
+}
+
+bool TokenStore::Refresh(unsigned int timeoutMs) noexcept
+{
+	const TokenFileLock fileLock(_lockPath.c_str(), false, timeoutMs);
+	if (!fileLock.IsLocked())
+	{
+		return false;
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(_lock, std::chrono::milliseconds(timeoutMs));
+	return lock.owns_lock() && _header != nullptr && ReadDelta();
+}
+
+void TokenStore::RefreshAsync() noexcept
+{
+	try
+	{
+		if (_refresher.joinable())
+		{
+			_refresher.join();
+		}
+		_refresher = std::thread([this]()
+		{
+			Refresh();
+		});
+	}
+	catch (...)
+	{
+	}
+}
+
+void TokenStore::Close() noexcept
+{
+	if (_refresher.joinable())
+	{
+		_refresher.join();
+	}
+	if (_compactor.joinable())
+	{
+		_compactor.join();
+	}
+
+	std::unique_lock<std::shared_timed_mutex> lock(_lock);
+	Unload();
+}
+
+bool TokenStore::IsOpen() const noexcept
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_lock);
+	return _header != nullptr;
+}
+
+size_t TokenStore::Count() const noexcept
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_lock);
+	return _header ? _header->recordCount : 0;
+}
+
+size_t TokenStore::DeltaCount() const noexcept
+{
+	std::shared_lock<std::shared_timed_mutex> lock(_lock);
+	return _deltaEntries;
+}
+
+bool TokenStore::MapBase() noexcept
+{
+	UnmapBase();
+
+	// A compaction that failed between moving the base aside and moving the new one in leaves the old one
+	try
+	{
+		if (!TokenFile::Map(_path.c_str(), _base) && !TokenFile::Map((_path + L".old").c_str(), _base))
+		{
+			return false;
+		}
+	}
+	catch (...)
+	{
+		return false;
+	}
+
+	if (!Validate())
+	{
+		UnmapBase();
+		return false;
+	}
+	_sequence = _cursor.sequence > _baseSequence ? _cursor.sequence : _baseSequence;
+	return true;
+}
+
+void TokenStore::UnmapBase() noexcept
+{
+	TokenFile::Unmap(_base);
+
+	_header = nullptr;
+	_records = nullptr;
+	_slots = nullptr;
+	_slotMask = 0;
+	_chd = nullptr;
+	_displacements = nullptr;
+	_keys = nullptr;
+	_keyUnits = 0;
+	_baseSequence = 0;
+}
+
+void TokenStore::ClearOverlay() noexcept
+{
+	// INSERT records carry secrets
+	if (!_overlayRecords.empty())
+	{
+		memset(_overlayRecords.data(), 0, _overlayRecords.size() * sizeof(TOKEN_RECORD));
+	}
+	std::vector<TOKEN_OVERLAY>().swap(_overlay);
+	std::vector<uint16_t>().swap(_overlayKeys);
+	std::vector<TOKEN_RECORD>().swap(_overlayRecords);
+	_overlayUsed = 0;
+	_deltaEntries = 0;
+	_cursor = TOKEN_DELTA_CURSOR();
+	_sequence = _baseSequence;
+}
+
+void TokenStore::Unload() noexcept
+{
+	UnmapBase();
+	ClearOverlay();
+	_deltaWritable = false;
+}
+
+bool TokenStore::Validate() noexcept
+{
+	const uint8_t* base = _base.data;
+	const uint64_t fileSize = _base.size;
+	if (fileSize < sizeof(TOKEN_STORE_HEADER))
+	{
+		return false;
+	}
+
+	const TOKEN_STORE_HEADER* header = reinterpret_cast<const TOKEN_STORE_HEADER*>(base);
+	const bool v1 = header->version == 1 && header->headerSize == HEADER_SIZE_V1;
+	const bool v2 = header->version == TOKEN_STORE_VERSION && header->headerSize == sizeof(TOKEN_STORE_HEADER);
+	if (memcmp(header->magic, TOKEN_STORE_MAGIC, sizeof(header->magic)) != 0
+		|| !(v1 || v2)
+		|| header->recordSize != sizeof(TOKEN_RECORD))
+	{
+		return false;
+	}
+
+	if (!InBounds(header->recordsOffset, uint64_t(header->recordCount) * sizeof(TOKEN_RECORD), fileSize)
+		|| !InBounds(header->indexOffset, header->indexSize, fileSize)
+		|| !InBounds(header->keysOffset, header->keysSize, fileSize))
+	{
+		return false;
+	}
+
+	if (header->indexKind == static_cast<uint32_t>(TOKEN_INDEX::HASH))
+	{
+		// Power of two with at least one empty slot, so every probe terminates
+		const uint64_t slots = header->indexSize / sizeof(uint32_t);
+		if (slots == 0 || (slots & (slots - 1)) != 0 || slots <= header->recordCount || slots > 0xffffffffULL)
+		{
+			return false;
+		}
+		_slotMask = uint32_t(slots - 1);
+	}
+	else if (header->indexKind == static_cast<uint32_t>(TOKEN_INDEX::PERFECT_HASH))
+	{
+		if (header->indexSize < sizeof(TOKEN_CHD_HEADER))
+		{
+			return false;
+		}
+		const TOKEN_CHD_HEADER* chd = reinterpret_cast<const TOKEN_CHD_HEADER*>(base + header->indexOffset);
+		if ((chd->buckets == 0 && header->recordCount != 0)
+			|| header->indexSize != sizeof(TOKEN_CHD_HEADER) + uint64_t(chd->buckets) * 2 * sizeof(uint32_t))
+		{
+			return false;
+		}
+		_chd = chd;
+		_displacements = reinterpret_cast<const uint32_t*>(chd + 1);
+	}
+	else
+	{
+		return false;
+	}
+
+	_header = header;
+	_records = reinterpret_cast<const TOKEN_RECORD*>(base + header->recordsOffset);
+	_slots = reinterpret_cast<const uint32_t*>(base + header->indexOffset);
+	_keys = reinterpret_cast<const uint16_t*>(base + header->keysOffset);
+	_keyUnits = header->keysSize / sizeof(uint16_t);
+	_baseSequence = v2 ? header->sequence : 0;
+	return true;
+}
+
+bool TokenStore::ReadDelta() noexcept
+{
+	try
+	{
+		switch (TokenDelta::Check(_deltaPath, _cursor))
+		{
+		case TOKEN_DELTA_READ::MISSING:
+			// No log yet, the first append creates it. Changes of a log that went away went with it.
+			ClearOverlay();
+			_deltaWritable = true;
+			return true;
+		case TOKEN_DELTA_READ::INVALID:
+			// Not a log of this version, leave it alone
+			ClearOverlay();
+			_deltaWritable = false;
+			return true;
+		case TOKEN_DELTA_READ::RESTARTED:
+		{
+			const TOKEN_DELTA_CURSOR cursor = _cursor;
+			ClearOverlay();
+			_cursor = cursor;
+			// Another process compacted: its base folds in everything up to the new header
+			if (_cursor.header > _baseSequence && !MapBase())
+			{
+				return false;
+			}
+			break;
+		}
+		case TOKEN_DELTA_READ::APPENDED:
+			break;
+		}
+
+		if (!TokenDelta::Read(_deltaPath, _cursor,
+			[this](const TOKEN_DELTA_ENTRY& entry, const TOKEN_RECORD* record, const uint16_t* key)
+			{
+				Apply(entry, record, key);
+			}))
+		{
+			// Part of the entries may be applied, read all of them again next time
+			ClearOverlay();
+			return false;
+		}
+	}
+	catch (...)
+	{
+		ClearOverlay();
+		return false;
+	}
+
+	_sequence = _cursor.sequence > _baseSequence ? _cursor.sequence : _baseSequence;
+	_deltaWritable = true;
+	return true;
+}
+
+void TokenStore::Apply(const TOKEN_DELTA_ENTRY& entry, const TOKEN_RECORD* record, const uint16_t* key)
+{
+	// Already folded into the base file
+	if (entry.sequence <= _baseSequence)
+	{
+		return;
+	}
+
+	TOKEN_OVERLAY& slot = OverlaySlot(Hash(key, entry.keyLength), key, entry.keyLength);
+	switch (static_cast<TOKEN_DELTA>(entry.type))
+	{
+	case TOKEN_DELTA::INSERT:
+		// A name inserted again reuses its copy
+		if (slot.record == 0)
+		{
+			_overlayRecords.push_back(*record);
+			slot.record = uint32_t(_overlayRecords.size());
+		}
+		else
+		{
+			_overlayRecords[slot.record - 1] = *record;
+		}
+		slot.revoked = false;
+		slot.counter = 0;
+		break;
+	case TOKEN_DELTA::REVOKE:
+		slot.revoked = true;
+		slot.counter = 0;
+		break;
+	case TOKEN_DELTA::COUNTER:
+		slot.counter = entry.counter > slot.counter ? entry.counter : slot.counter;
+		break;
+	}
+	_deltaEntries++;
+}
+
+bool TokenStore::Find(const wchar_t* user, const wchar_t* domain, TOKEN_RECORD& record) const noexcept
+{
+	uint16_t key[TOKEN_STORE_MAX_KEY];
+	const size_t length = Normalize(user, domain, key, TOKEN_STORE_MAX_KEY);
+	if (length == 0)
+	{
+		return false;
+	}
+
+	const uint64_t hash = Hash(key, length);
+
+	std::shared_lock<std::shared_timed_mutex> lock(_lock);
+	if (_header == nullptr)
+	{
+		return false;
+	}
+
+	const TOKEN_OVERLAY* overlay = FindOverlay(hash, key, length);
+	if (overlay != nullptr && overlay->revoked)
+	{
+		return false;
+	}
+
+	const TOKEN_RECORD* found = (overlay != nullptr && overlay->record != 0) ? OverlayRecord(*overlay) : FindBase(hash, key, length);
+	if (found == nullptr)
+	{
+		return false;
+	}
+
+	record = *found;
+	if (overlay != nullptr && overlay->counter > record.counter)
+	{
+		record.counter = overlay->counter;
+	}
+	return true;
+}
+
+TOKEN_COUNTER TokenStore::AppendCounter(const wchar_t* user, const wchar_t* domain, uint64_t counter) noexcept
+{
+	uint16_t key[TOKEN_STORE_MAX_KEY];
+	const size_t length = Normalize(user, domain, key, TOKEN_STORE_MAX_KEY);
+	if (length == 0)
+	{
+		return TOKEN_COUNTER::UNKNOWN;
+	}
+
+	const uint64_t hash = Hash(key, length);
+	bool compact = false;
+	{
+		const TokenFileLock fileLock(_lockPath.c_str(), true, TOKEN_STORE_LOCK_TIMEOUT);
+		if (!fileLock.IsLocked())
+		{
+			return TOKEN_COUNTER::FAILED;
+		}
+
+		// What other processes appended decides whether the counter is still ahead
+		std::unique_lock<std::shared_timed_mutex> lock(_lock);
+		if (_header == nullptr || !ReadDelta() || !_deltaWritable)
+		{
+			return TOKEN_COUNTER::FAILED;
+		}
+
+		const TOKEN_OVERLAY* overlay = FindOverlay(hash, key, length);
+		if (overlay != nullptr && overlay->revoked)
+		{
+			return TOKEN_COUNTER::UNKNOWN;
+		}
+
+		const TOKEN_RECORD* found = (overlay != nullptr && overlay->record != 0) ? OverlayRecord(*overlay) : FindBase(hash, key, length);
+		if (found == nullptr)
+		{
+			return TOKEN_COUNTER::UNKNOWN;
+		}
+
+		const uint64_t current = (overlay != nullptr && overlay->counter > found->counter) ? overlay->counter : found->counter;
+		if (counter <= current)
+		{
+			return TOKEN_COUNTER::USED;
+		}
+
+		try
+		{
+			if (_cursor.offset == 0)
+			{
+				// Never replaces a log that exists but could not be read
+				const TOKEN_DELTA_HEADER header = TokenDelta::Header(_baseSequence);
+				if (!TokenFile::Create(_deltaPath.c_str(), &header, sizeof(header)))
+				{
+					return TOKEN_COUNTER::FAILED;
+				}
+				_cursor.header = _baseSequence;
+				_cursor.offset = sizeof(header);
+				_cursor.sequence = _baseSequence;
+				_cursor.size = sizeof(header);
+			}
+			else if (_cursor.size > _cursor.offset)
+			{
+				// Torn append of a writer that crashed: cut it off, entries behind it would never be read
+				if (!TokenFile::Truncate(_deltaPath.c_str(), _cursor.offset))
+				{
+					return TOKEN_COUNTER::FAILED;
+				}
+				_cursor.size = _cursor.offset;
+			}
+
+			std::vector<uint8_t> entry;
+			TokenDelta::Encode(TOKEN_DELTA::COUNTER, _sequence + 1, key, length, nullptr, counter, entry);
+			if (!TokenFile::Append(_deltaPath.c_str(), entry.data(), entry.size()))
+			{
+				return TOKEN_COUNTER::FAILED;
+			}
+
+			_sequence++;
+			_cursor.offset += entry.size();
+			_cursor.size = _cursor.offset;
+			_cursor.sequence = _sequence;
+			_deltaEntries++;
+			OverlaySlot(hash, key, length).counter = counter;
+		}
+		catch (...)
+		{
+			return TOKEN_COUNTER::FAILED;
+		}
+
+		compact = _compactionThreshold != 0 && _cursor.offset >= _compactionThreshold;
+	}
+
+	if (compact)
+	{
+		StartCompaction();
+	}
+	return TOKEN_COUNTER::ADVANCED;
+}
+
+void TokenStore::StartCompaction() noexcept
+{
+	bool idle = false;
+	if (!_compacting.compare_exchange_strong(idle, true))
+	{
+		return;
+	}
+
+	try
+	{
+		// The previous compaction has finished, _compacting was cleared
+		if (_compactor.joinable())
+		{
+			_compactor.join();
+		}
+		_compactor = std::thread([this]()
+		{
+			// Fails when appends race the snapshot, they are rare enough to win again soon
+			for (int attempt = 0; attempt < COMPACTION_ATTEMPTS; attempt++)
+			{
+				if (Compact())
+				{
+					break;
+				}
+			}
+			_compacting = false;
+		});
+	}
+	catch (...)
+	{
+		_compacting = false;
+	}
+}
+
+bool TokenStore::Compact() noexcept
+{
+	std::lock_guard<std::mutex> serial(_compactionLock);
+
+	// With what other processes appended, or the swap below finds the log changed
+	if (!Refresh())
+	{
+		return false;
+	}
+
+	try
+	{
+		// Find() goes on while the new file is built, appends wait
+		std::vector<uint8_t> image;
+		TOKEN_DELTA_CURSOR snapshot;
+		uint64_t sequence;
+		{
+			std::shared_lock<std::shared_timed_mutex> lock(_lock);
+			if (_header == nullptr || !_deltaWritable)
+			{
+				return false;
+			}
+			if (_deltaEntries == 0)
+			{
+				return true;
+			}
+			snapshot = _cursor;
+			sequence = _sequence;
+
+			TokenStoreWriter writer;
+			TOKEN_RECORD record;
+			for (uint32_t i = 0; i < _header->recordCount; i++)
+			{
+				const TOKEN_RECORD& base = _records[i];
+				if (uint64_t(base.keyOffset) + base.keyLength > _keyUnits)
+				{
+					continue;
+				}
+
+				const uint16_t* key = _keys + base.keyOffset;
+				const TOKEN_OVERLAY* change = FindOverlay(base.keyHash, key, base.keyLength);
+				if (change != nullptr && (change->revoked || change->record != 0))
+				{
+					continue;
+				}
+
+				record = base;
+				record.counter = (change != nullptr && change->counter > record.counter) ? change->counter : record.counter;
+				writer.AddRecord(record, key, base.keyLength);
+			}
+
+			for (const TOKEN_OVERLAY& change : _overlay)
+			{
+				if (change.keyLength != 0 && change.record != 0 && !change.revoked)
+				{
+					record = *OverlayRecord(change);
+					record.counter = change.counter > record.counter ? change.counter : record.counter;
+					writer.AddRecord(record, _overlayKeys.data() + change.keyOffset, change.keyLength);
+				}
+			}
+			memset(record.secret, 0, sizeof(record.secret));
+
+			image = writer.Serialize(static_cast<TOKEN_INDEX>(_header->indexKind), sequence);
+		}
+
+		const std::wstring next = _path + L".compact";
+		const bool written = TokenFile::Write(next.c_str(), image.data(), image.size());
+		std::fill(image.begin(), image.end(), uint8_t(0));
+		if (!written)
+		{
+			TokenFile::Remove(next.c_str());
+			return false;
+		}
+
+		const TokenFileLock fileLock(_lockPath.c_str(), true, TOKEN_STORE_LOCK_TIMEOUT);
+		std::unique_lock<std::shared_timed_mutex> lock(_lock);
+
+		// An append since the snapshot, by this or another process, is not in the new file
+		if (!fileLock.IsLocked() || _header == nullptr || !ReadDelta()
+			|| _cursor.header != snapshot.header || _cursor.offset != snapshot.offset)
+		{
+			TokenFile::Remove(next.c_str());
+			return false;
+		}
+
+		// Windows cannot replace a mapped file, but can rename it aside. Other
+		// processes keep the old one mapped until they see the log reset.
+		UnmapBase();
+		const std::wstring old = _path + L".old";
+		TokenFile::Remove(old.c_str());
+		bool swapped = TokenFile::Replace(next.c_str(), _path.c_str());
+		if (!swapped && TokenFile::Replace(_path.c_str(), old.c_str()))
+		{
+			swapped = TokenFile::Replace(next.c_str(), _path.c_str());
+			if (!swapped)
+			{
+				TokenFile::Replace(old.c_str(), _path.c_str());
+			}
+		}
+
+		if (swapped)
+		{
+			// Entries up to sequence are skipped from now on even if this fails
+			const TOKEN_DELTA_HEADER header = TokenDelta::Header(sequence);
+			TokenFile::Overwrite(_deltaPath.c_str(), &header, sizeof(header));
+			TokenFile::Remove(old.c_str());
+		}
+		else
+		{
+			TokenFile::Remove(next.c_str());
+		}
+
+		ClearOverlay();
+		return MapBase() && ReadDelta() && swapped;
+	}
+	catch (...)
+	{
+		return false;
+	}
+}
+
+const TOKEN_RECORD* TokenStore::FindBase(uint64_t hash, const uint16_t* key, size_t length) const noexcept
+{
+	if (_chd != nullptr)
+	{
+		if (_header->recordCount == 0)
+		{
+			return nullptr;
+		}
+
+		const TOKEN_CHD_HASH h = ChdHash(hash, _chd->seed, _chd->buckets);
+		const uint32_t* d = _displacements + 2 * size_t(h.bucket);
+		const TOKEN_RECORD& record = _records[ChdSlot(h, d[0], d[1], _header->recordCount)];
+		return (record.keyHash == hash && KeyEquals(record, key, length)) ? &record : nullptr;
+	}
+
+	for (uint32_t i = uint32_t(hash) & _slotMask, probes = 0; probes <= _slotMask; i = (i + 1) & _slotMask, probes++)
+	{
+		const uint32_t slot = _slots[i];
+		if (slot == 0 || slot > _header->recordCount)
+		{
+			return nullptr;
+		}
+
+		const TOKEN_RECORD& record = _records[slot - 1];
+		if (record.keyHash == hash && KeyEquals(record, key, length))
+		{
+			return &record;
+		}
+	}
+	return nullptr;
+}
+
+const TOKEN_OVERLAY* TokenStore::FindOverlay(uint64_t hash, const uint16_t* key, size_t length) const noexcept
+{
+	if (_overlayUsed == 0)
+	{
+		return nullptr;
+	}
+
+	const size_t mask = _overlay.size() - 1;
+	for (size_t i = size_t(hash) & mask; _overlay[i].keyLength != 0; i = (i + 1) & mask)
+	{
+		const TOKEN_OVERLAY& slot = _overlay[i];
+		if (slot.keyHash == hash && slot.keyLength == length
+			&& memcmp(_overlayKeys.data() + slot.keyOffset, key, length * sizeof(uint16_t)) == 0)
+		{
+			return &slot;
+		}
+	}
+	return nullptr;
+}
+
+TOKEN_OVERLAY& TokenStore::OverlaySlot(uint64_t hash, const uint16_t* key, size_t length)
+{
+	if (2 * (_overlayUsed + 1) > _overlay.size())
+	{
+		std::vector<TOKEN_OVERLAY> grown(_overlay.empty() ? 64 : 2 * _overlay.size(), TOKEN_OVERLAY());
+		const size_t mask = grown.size() - 1;
+		for (const TOKEN_OVERLAY& slot : _overlay)
+		{
+			if (slot.keyLength != 0)
+			{
+				size_t i = size_t(slot.keyHash) & mask;
+				while (grown[i].keyLength != 0)
+				{
+					i = (i + 1) & mask;
+				}
+				grown[i] = slot;
+			}
+		}
+		_overlay.swap(grown);
+	}
+
+	const size_t mask = _overlay.size() - 1;
+	size_t i = size_t(hash) & mask;
+	for (; _overlay[i].keyLength != 0; i = (i + 1) & mask)
+	{
+		TOKEN_OVERLAY& slot = _overlay[i];
+		if (slot.keyHash == hash && slot.keyLength == length
+			&& memcmp(_overlayKeys.data() + slot.keyOffset, key, length * sizeof(uint16_t)) == 0)
+		{
+			return slot;
+		}
+	}
+
+	// The key points into a read buffer or the caller's stack, keep a copy
+	const size_t offset = _overlayKeys.size();
+	_overlayKeys.insert(_overlayKeys.end(), key, key + length);
+
+	TOKEN_OVERLAY& slot = _overlay[i];
+	slot.keyHash = hash;
+	slot.keyOffset = uint32_t(offset);
+	slot.keyLength = uint16_t(length);
+	_overlayUsed++;
+	return slot;
+}
+
+bool TokenStore::KeyEquals(const TOKEN_RECORD& record, const uint16_t* key, size_t length) const noexcept
+{
+	return record.keyLength == length
+		&& uint64_t(record.keyOffset) + record.keyLength <= _keyUnits
+		&& memcmp(_keys + record.keyOffset, key, length * sizeof(uint16_t)) == 0;
+}
+
+bool TokenStore::InitializeVerifier(const TOKEN_RECORD& record, OTPVerifier& verifier) noexcept
+{
+	if (record.secretLength > TOKEN_STORE_MAX_SECRET || record.type > uint8_t(OTP_TYPE::TOTP)
+		|| record.algorithm > uint8_t(OTP_ALGORITHM::SHA512))
+	{
+		return false;
+	}
+
+	OTP_PARAMETERS parameters;
+	parameters.type = static_cast<OTP_TYPE>(record.type);
+	parameters.algorithm = static_cast<OTP_ALGORITHM>(record.algorithm);
+	parameters.digits = record.digits;
+	parameters.period = record.period;
+	parameters.t0 = record.t0;
+	parameters.window = record.window;
+	parameters.resyncWindow = record.resyncWindow;
+	return verifier.Initialize(parameters, record.secret, record.secretLength);
+}
+
+size_t TokenStore::Normalize(const wchar_t* user, const wchar_t* domain, uint16_t* out, size_t outSize) noexcept
+{
+	if (user == nullptr || *user == L'\0')
+	{
+		return 0;
+	}
+
+	size_t length = 0;
+	const wchar_t* userEnd = End(user);
+	const wchar_t* backslash = wcschr(user, L'\\');
+	bool ok;
+
+	if (backslash != nullptr)
+	{
+		// DOMAIN\user
+		ok = Append(backslash + 1, userEnd, out, outSize, &length);
+		if (ok && backslash != user)
+		{
+			ok = Append(L"@", End(L"@"), out, outSize, &length) && Append(user, backslash, out, outSize, &length);
+		}
+	}
+	else
+	{
+		ok = Append(user, userEnd, out, outSize, &length);
+		if (ok && wcschr(user, L'@') == nullptr && domain != nullptr && *domain != L'\0')
+		{
+			ok = Append(L"@", End(L"@"), out, outSize, &length) && Append(domain, End(domain), out, outSize, &length);
+		}
+	}
+
+	return ok ? length : 0;
+}
+
+TOKEN_CHD_HASH TokenStore::ChdHash(uint64_t keyHash, uint64_t seed, uint32_t buckets) noexcept
+{
+	const uint64_t g = Mix(keyHash ^ seed);
+	const uint64_t f = Mix(g + 0x9e3779b97f4a7c15ULL);
+
+	TOKEN_CHD_HASH h;
+	h.bucket = uint32_t(((g >> 32) * buckets) >> 32);
+	h.f1 = uint32_t(g);
+	h.f2 = uint32_t(f) | 1;
+	return h;
+}
+
+uint64_t TokenStore::Hash(const uint16_t* key, size_t length) noexcept
+{
+	uint64_t h = 0xcbf29ce484222325ULL;
+	for (size_t i = 0; i < length; i++)
+	{
+		h = (h ^ key[i]) * 0x100000001b3ULL;
+	}
+	return h;
+}
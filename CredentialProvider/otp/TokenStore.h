@@ -0,0 +1,292 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Memory-mapped offline token database
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "OTPVerifier.h"
+#include "TokenFile.h"
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// File layout, little-endian, every section 8 byte aligned:
+//   TOKEN_STORE_HEADER
+//   TOKEN_RECORD[recordCount]
+//   index (layout depends on indexKind)
+//   keys: normalized "user@domain" of every record, UTF-16 code units
+// Files are written by TokenStoreWriter, changes go to the delta log next to
+// the file (TokenDelta.h). The provider maps the file read-only and reads the
+// log into memory.
+
+#define TOKEN_STORE_MAGIC "DASTOKDB"
+#define TOKEN_STORE_VERSION 2
+// Longest normalized key in code units, longer names never match
+#define TOKEN_STORE_MAX_KEY 256
+#define TOKEN_STORE_MAX_SECRET 64
+// Delta log size in bytes from which TokenStore folds the log into a new base file
+#define TOKEN_DELTA_COMPACT_SIZE (4 * 1024 * 1024)
+// Milliseconds to wait for the lock file another process holds
+#define TOKEN_STORE_LOCK_TIMEOUT 5000
+// Milliseconds a logon waits for the lock file before it goes with what the store has read
+#define TOKEN_STORE_LOGON_LOCK_TIMEOUT 50
+
+enum class TOKEN_INDEX : uint32_t
+{
+	HASH = 1,			// open addressing, uint32_t slots holding record + 1, power of two, load <= 1/2
+	PERFECT_HASH = 2,	// CHD minimal perfect hash, TOKEN_CHD_HEADER + uint32_t (d0, d1) per bucket
+};
+
+struct TOKEN_STORE_HEADER
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t headerSize;
+	uint32_t indexKind;			// TOKEN_INDEX
+	uint32_t recordCount;
+	uint32_t recordSize;
+	uint32_t reserved;
+	uint64_t recordsOffset;
+	uint64_t indexOffset;
+	uint64_t indexSize;			// bytes
+	uint64_t keysOffset;
+	uint64_t keysSize;			// bytes
+	uint64_t sequence;			// last delta log entry folded into the file, see TokenDelta.h
+};
+
+struct TOKEN_RECORD
+{
+	uint64_t keyHash;			// TokenStore::Hash of the normalized key
+	uint32_t keyOffset;			// code units into the keys section
+	uint16_t keyLength;			// code units
+	uint8_t type;				// OTP_TYPE
+	uint8_t algorithm;			// OTP_ALGORITHM
+	uint8_t digits;
+	uint8_t secretLength;
+	uint16_t flags;
+	uint32_t period;
+	int64_t t0;
+	uint32_t window;
+	uint32_t resyncWindow;
+	uint64_t counter;			// next expected HOTP counter when the file was written
+	uint8_t secret[TOKEN_STORE_MAX_SECRET];
+};
+
+// Index of kind PERFECT_HASH. Records are stored in slot order, the slot of a
+// key is its record: (f1 + d0 * f2 + d1) mod recordCount, with f1, f2 and
+// the bucket from TokenStore::ChdHash and (d0, d1) the displacement pair of
+// the bucket (compress, hash and displace).
+struct TOKEN_CHD_HEADER
+{
+	uint64_t seed;
+	uint32_t buckets;
+	uint32_t reserved;
+};
+
+struct TOKEN_CHD_HASH
+{
+	uint32_t bucket;
+	uint32_t f1;
+	uint32_t f2;
+};
+
+static_assert(sizeof(TOKEN_STORE_HEADER) == 80, "TOKEN_STORE_HEADER layout");
+static_assert(sizeof(TOKEN_RECORD) == 112, "TOKEN_RECORD layout");
+
+struct TOKEN_DELTA_ENTRY;
+
+// Change of one name applied from the delta log on top of the base file
+struct TOKEN_OVERLAY
+{
+	uint64_t keyHash;
+	uint64_t counter;			// highest COUNTER, 0 for none
+	uint32_t keyOffset;			// code units into the key copies of the store
+	uint32_t record;			// INSERT record copied into the store + 1, 0 if the base record applies
+	uint16_t keyLength;			// 0 for an empty slot
+	bool revoked;
+};
+
+// How far a reader got in the delta log
+struct TOKEN_DELTA_CURSOR
+{
+	uint64_t header = 0;		// sequence in the header of the log
+	uint64_t offset = 0;		// end of the intact entries read, 0 before the first read
+	uint64_t sequence = 0;		// highest sequence of the header and the entries read
+	uint64_t size = 0;			// file size at the last read, more than offset means a torn tail
+};
+
+enum class TOKEN_COUNTER
+{
+	ADVANCED,	// logged as the next expected counter
+	USED,		// the log has the counter or a later one, the code was used in another session
+	UNKNOWN,	// no token for the name, or it was revoked
+	FAILED,		// the lock could not be taken or the log not written
+};
+
+// View of a token database: the base file and its delta log (TokenDelta.h).
+// Open() only maps the base file and checks its header and section bounds,
+// independent of the size of the log. Refresh() reads the log into an
+// in-memory table of the names it changes, the first time all of it, then
+// the entries appended since, and is meant for a background thread. Find()
+// normalizes the name into a stack buffer, probes that table and the base
+// index and copies the record out: no heap allocation. With a perfect hash
+// index the base probe is a single record read plus the key comparison.
+// AppendCounter() persists HOTP counters to the log. Processes coordinate
+// through a lock file next to the base file: writers take it exclusively,
+// read what other processes appended, repair a torn tail and number their
+// entry after the highest sequence in the file. Once the log grows past the
+// compaction threshold a background thread writes a new base file with every
+// change folded in, swaps it in and resets the log.
+class TokenStore
+{
+public:
+	TokenStore() = default;
+	~TokenStore();
+
+	TokenStore(const TokenStore&) = delete;
+	TokenStore& operator=(const TokenStore&) = delete;
+
+	// Maps and checks the base file, the delta log is read by Refresh()
+	bool Open(const wchar_t* path) noexcept;
+
+	// Reads what was appended to the delta log since the last call, the whole log
+	// the first time or after another process compacted it. The log is optional,
+	// a damaged one is ignored from the damage on. Waits up to timeoutMs for the
+	// lock file and for a refresh of another thread, false if that was not enough,
+	// the store keeps what it had then.
+	bool Refresh(unsigned int timeoutMs = TOKEN_STORE_LOCK_TIMEOUT) noexcept;
+
+	// Refresh() on a background thread, meant for right after Open()
+	void RefreshAsync() noexcept;
+
+	// Waits for a running compaction
+	void Close() noexcept;
+
+	bool IsOpen() const noexcept;
+
+	// Records in the base file
+	size_t Count() const noexcept;
+
+	// Delta log entries applied on top of the base file
+	size_t DeltaCount() const noexcept;
+
+	// user may be "user", "user@domain" or "DOMAIN\user", domain is used if user names none.
+	// record receives a copy, the caller wipes its secret. Sees the log as of the last
+	// Refresh() or AppendCounter().
+	bool Find(const wchar_t* user, const wchar_t* domain, TOKEN_RECORD& record) const noexcept;
+
+	// Logs counter as the next expected HOTP counter of an existing name. Checked
+	// against the log under the lock file, so of two sessions that verified the same
+	// code only one gets ADVANCED.
+	TOKEN_COUNTER AppendCounter(const wchar_t* user, const wchar_t* domain, uint64_t counter) noexcept;
+
+	// Log size in bytes that starts a compaction, 0 never compacts
+	void SetCompactionThreshold(uint64_t bytes) noexcept { _compactionThreshold = bytes; }
+
+	// Folds the log into a new base file now, on the calling thread
+	bool Compact() noexcept;
+
+	// Loads the token of record into verifier
+	static bool InitializeVerifier(const TOKEN_RECORD& record, OTPVerifier& verifier) noexcept;
+
+	// Lowercased "user@domain" (or "user" without a domain) into out, returns the
+	// length in code units, 0 if it is empty or does not fit
+	static size_t Normalize(const wchar_t* user, const wchar_t* domain, uint16_t* out, size_t outSize) noexcept;
+
+	// 64 bit FNV-1a over the code units
+	static uint64_t Hash(const uint16_t* key, size_t length) noexcept;
+
+	// Bucket and the two slot hashes of a key for the perfect hash index
+	static TOKEN_CHD_HASH ChdHash(uint64_t keyHash, uint64_t seed, uint32_t buckets) noexcept;
+
+	static uint32_t ChdSlot(const TOKEN_CHD_HASH& hash, uint32_t d0, uint32_t d1, uint32_t slots) noexcept
+	{
+		return uint32_t((uint64_t(hash.f1) + uint64_t(d0) * hash.f2 + d1) % slots);
+	}
+
+private:
+	// The caller holds _lock exclusively for these, and the lock file for ReadDelta()
+
+	// Maps the base file, or what a compaction left of it
+	bool MapBase() noexcept;
+
+	void UnmapBase() noexcept;
+
+	bool Validate() noexcept;
+
+	// Reads the log on from _cursor, starts over if it was reset
+	bool ReadDelta() noexcept;
+
+	void ClearOverlay() noexcept;
+
+	void Unload() noexcept;
+
+	void Apply(const TOKEN_DELTA_ENTRY& entry, const TOKEN_RECORD* record, const uint16_t* key);
+
+	const TOKEN_RECORD* FindBase(uint64_t hash, const uint16_t* key, size_t length) const noexcept;
+
+	const TOKEN_OVERLAY* FindOverlay(uint64_t hash, const uint16_t* key, size_t length) const noexcept;
+
+	// Existing or new slot of key, grows the table and copies the key
+	TOKEN_OVERLAY& OverlaySlot(uint64_t hash, const uint16_t* key, size_t length);
+
+	const TOKEN_RECORD* OverlayRecord(const TOKEN_OVERLAY& slot) const noexcept
+	{
+		return slot.record != 0 ? &_overlayRecords[slot.record - 1] : nullptr;
+	}
+
+	bool KeyEquals(const TOKEN_RECORD& record, const uint16_t* key, size_t length) const noexcept;
+
+	void StartCompaction() noexcept;
+
+	std::wstring _path;
+	std::wstring _deltaPath;
+	std::wstring _lockPath;
+	TOKEN_FILE_VIEW _base;
+
+	const TOKEN_STORE_HEADER* _header = nullptr;
+	const TOKEN_RECORD* _records = nullptr;
+	const uint32_t* _slots = nullptr;		// HASH
+	uint32_t _slotMask = 0;
+	const TOKEN_CHD_HEADER* _chd = nullptr;	// PERFECT_HASH
+	const uint32_t* _displacements = nullptr;
+	const uint16_t* _keys = nullptr;
+	uint64_t _keyUnits = 0;
+	uint64_t _baseSequence = 0;
+
+	std::vector<TOKEN_OVERLAY> _overlay;	// open addressing, power of two, load <= 1/2
+	std::vector<uint16_t> _overlayKeys;
+	std::vector<TOKEN_RECORD> _overlayRecords;
+	size_t _overlayUsed = 0;
+	size_t _deltaEntries = 0;
+	TOKEN_DELTA_CURSOR _cursor;
+	uint64_t _sequence = 0;					// highest sequence of base and log
+
+	// Find() and Compact() share it, reading the log, appending and swapping the
+	// base take it exclusively. Taken after the lock file.
+	mutable std::shared_timed_mutex _lock;
+	std::mutex _compactionLock;
+	std::thread _compactor;
+	std::thread _refresher;
+	std::atomic<bool> _compacting{ false };
+	bool _deltaWritable = false;
+	uint64_t _compactionThreshold = TOKEN_DELTA_COMPACT_SIZE;
+};
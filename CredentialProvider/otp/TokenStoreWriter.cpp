@@ -0,0 +1,354 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Offline token database writer
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "TokenStoreWriter.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+
+namespace
+{
+	uint64_t Align8(uint64_t value)
+	{
+		return (value + 7) & ~uint64_t(7);
+	}
+
+	// Average keys per perfect hash bucket
+	const uint32_t CHD_BUCKET_SIZE = 5;
+	// Displacement pairs tried for one bucket before the seed is given up
+	const uint64_t CHD_MAX_TRIES = 1ULL << 24;
+	const uint64_t CHD_MAX_SEEDS = 64;
+}
+
+bool TokenStoreWriter::Add(const wchar_t* user, const wchar_t* domain, const OTP_PARAMETERS& parameters,
+	const uint8_t* secret, size_t secretLength, uint64_t counter)
+{
+	uint16_t key[TOKEN_STORE_MAX_KEY];
+	const size_t length = TokenStore::Normalize(user, domain, key, TOKEN_STORE_MAX_KEY);
+	TOKEN_RECORD record;
+	if (length == 0 || !BuildRecord(parameters, secret, secretLength, counter, record))
+	{
+		return false;
+	}
+
+	const bool added = AddRecord(record, key, length);
+	memset(record.secret, 0, sizeof(record.secret));
+	return added;
+}
+
+bool TokenStoreWriter::AddRecord(const TOKEN_RECORD& record, const uint16_t* key, size_t keyLength)
+{
+	if (keyLength == 0 || keyLength > TOKEN_STORE_MAX_KEY)
+	{
+		return false;
+	}
+
+	std::vector<uint16_t> name(key, key + keyLength);
+	if (_names.find(name) != _names.end())
+	{
+		return false;
+	}
+
+	TOKEN_RECORD copy = record;
+	copy.keyHash = TokenStore::Hash(key, keyLength);
+	copy.keyOffset = uint32_t(_keys.size());
+	copy.keyLength = uint16_t(keyLength);
+
+	_names.emplace(std::move(name), _records.size());
+	_keys.insert(_keys.end(), key, key + keyLength);
+	_records.push_back(copy);
+	return true;
+}
+
+bool TokenStoreWriter::BuildRecord(const OTP_PARAMETERS& parameters, const uint8_t* secret, size_t secretLength,
+	uint64_t counter, TOKEN_RECORD& record) noexcept
+{
+	if (secretLength == 0 || secretLength > TOKEN_STORE_MAX_SECRET)
+	{
+		return false;
+	}
+
+	// Same checks the provider applies when it loads the record
+	OTPVerifier verifier;
+	if (!verifier.Initialize(parameters, secret, secretLength))
+	{
+		return false;
+	}
+
+	memset(&record, 0, sizeof(record));
+	record.type = uint8_t(parameters.type);
+	record.algorithm = uint8_t(parameters.algorithm);
+	record.digits = uint8_t(parameters.digits);
+	record.secretLength = uint8_t(secretLength);
+	record.period = parameters.period;
+	record.t0 = parameters.t0;
+	record.window = parameters.window;
+	record.resyncWindow = parameters.resyncWindow;
+	record.counter = counter;
+	memcpy(record.secret, secret, secretLength);
+	return true;
+}
+
+std::vector<uint8_t> TokenStoreWriter::Serialize(TOKEN_INDEX index, uint64_t sequence) const
+{
+	// Records in file order, the index refers to these positions
+	std::vector<uint32_t> order(_records.size());
+	std::vector<uint8_t> indexImage;
+
+	if (index == TOKEN_INDEX::PERFECT_HASH)
+	{
+		TOKEN_CHD_HEADER chd;
+		std::vector<uint32_t> displacements;
+		BuildPerfectHash(chd, displacements, order);
+
+		indexImage.resize(sizeof(chd) + displacements.size() * sizeof(uint32_t));
+		memcpy(indexImage.data(), &chd, sizeof(chd));
+		if (!displacements.empty())
+		{
+			memcpy(indexImage.data() + sizeof(chd), displacements.data(), displacements.size() * sizeof(uint32_t));
+		}
+	}
+	else
+	{
+		// Load factor at most 1/2
+		uint64_t slots = 1;
+		while (slots < 2 * uint64_t(_records.size()) + 1)
+		{
+			slots <<= 1;
+		}
+
+		std::vector<uint32_t> table(size_t(slots), 0);
+		for (size_t i = 0; i < _records.size(); i++)
+		{
+			order[i] = uint32_t(i);
+
+			uint64_t slot = _records[i].keyHash & (slots - 1);
+			while (table[size_t(slot)] != 0)
+			{
+				slot = (slot + 1) & (slots - 1);
+			}
+			table[size_t(slot)] = uint32_t(i + 1);
+		}
+
+		indexImage.resize(table.size() * sizeof(uint32_t));
+		memcpy(indexImage.data(), table.data(), indexImage.size());
+	}
+
+	TOKEN_STORE_HEADER header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, TOKEN_STORE_MAGIC, sizeof(header.magic));
+	header.version = TOKEN_STORE_VERSION;
+	header.headerSize = sizeof(TOKEN_STORE_HEADER);
+	header.indexKind = static_cast<uint32_t>(index);
+	header.recordCount = uint32_t(_records.size());
+	header.recordSize = sizeof(TOKEN_RECORD);
+	header.recordsOffset = Align8(sizeof(TOKEN_STORE_HEADER));
+	header.indexOffset = Align8(header.recordsOffset + _records.size() * sizeof(TOKEN_RECORD));
+	header.indexSize = indexImage.size();
+	header.keysOffset = Align8(header.indexOffset + header.indexSize);
+	header.keysSize = _keys.size() * sizeof(uint16_t);
+	header.sequence = sequence;
+
+	std::vector<uint8_t> image(size_t(header.keysOffset + header.keysSize), 0);
+	memcpy(image.data(), &header, sizeof(header));
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		memcpy(image.data() + header.recordsOffset + i * sizeof(TOKEN_RECORD), &_records[order[i]], sizeof(TOKEN_RECORD));
+	}
+	memcpy(image.data() + header.indexOffset, indexImage.data(), indexImage.size());
+	if (!_keys.empty())
+	{
+		memcpy(image.data() + header.keysOffset, _keys.data(), size_t(header.keysSize));
+	}
+	return image;
+}
+
+void TokenStoreWriter::BuildPerfectHash(TOKEN_CHD_HEADER& header, std::vector<uint32_t>& displacements,
+	std::vector<uint32_t>& slotRecord) const
+{
+	memset(&header, 0, sizeof(header));
+	header.buckets = uint32_t((_records.size() + CHD_BUCKET_SIZE - 1) / CHD_BUCKET_SIZE);
+	displacements.assign(size_t(header.buckets) * 2, 0);
+	slotRecord.assign(_records.size(), 0);
+
+	if (_records.empty())
+	{
+		return;
+	}
+
+	// Names are unique, so a seed that works is found after a few tries at most
+	for (uint64_t seed = 0; seed < CHD_MAX_SEEDS; seed++)
+	{
+		if (PlacePerfectHash(seed, header.buckets, displacements, slotRecord))
+		{
+			header.seed = seed;
+			return;
+		}
+	}
+
+	// Only two names with the same 64 bit hash get here, they cannot be separated by any seed
+	throw std::runtime_error("No perfect hash found, duplicate key hashes?");
+}
+
+bool TokenStoreWriter::PlacePerfectHash(uint64_t seed, uint32_t buckets, std::vector<uint32_t>& displacements,
+	std::vector<uint32_t>& slotRecord) const
+{
+	const uint32_t slots = uint32_t(_records.size());
+
+	std::vector<TOKEN_CHD_HASH> hashes(_records.size());
+	std::vector<uint32_t> bucketStart(size_t(buckets) + 1, 0);
+	for (size_t i = 0; i < _records.size(); i++)
+	{
+		hashes[i] = TokenStore::ChdHash(_records[i].keyHash, seed, buckets);
+		bucketStart[hashes[i].bucket + 1]++;
+	}
+	for (uint32_t b = 0; b < buckets; b++)
+	{
+		bucketStart[b + 1] += bucketStart[b];
+	}
+
+	std::vector<uint32_t> members(_records.size());
+	std::vector<uint32_t> fill(bucketStart.begin(), bucketStart.end() - 1);
+	for (size_t i = 0; i < _records.size(); i++)
+	{
+		members[fill[hashes[i].bucket]++] = uint32_t(i);
+	}
+
+	// Largest buckets first, while the table is still empty
+	std::vector<uint32_t> order(buckets);
+	for (uint32_t b = 0; b < buckets; b++)
+	{
+		order[b] = b;
+	}
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+	{
+		return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+	});
+
+	std::vector<bool> taken(slots, false);
+	std::vector<uint32_t> base;
+	uint32_t nextFree = 0;
+
+	for (uint32_t bucket : order)
+	{
+		const uint32_t first = bucketStart[bucket];
+		const uint32_t size = bucketStart[bucket + 1] - first;
+		if (size == 0)
+		{
+			break;
+		}
+
+		if (size == 1)
+		{
+			// d0 = 0 makes the slot f1 + d1, any free slot can be reached directly
+			while (taken[nextFree])
+			{
+				nextFree++;
+			}
+			const uint32_t record = members[first];
+			displacements[2 * size_t(bucket)] = 0;
+			displacements[2 * size_t(bucket) + 1] = uint32_t((uint64_t(nextFree) + slots - hashes[record].f1 % slots) % slots);
+			taken[nextFree] = true;
+			slotRecord[nextFree] = record;
+			continue;
+		}
+
+		bool placed = false;
+		uint64_t tries = 0;
+		base.resize(size);
+		for (uint32_t d0 = 0; d0 < slots && !placed && tries < CHD_MAX_TRIES; d0++)
+		{
+			for (uint32_t k = 0; k < size; k++)
+			{
+				base[k] = TokenStore::ChdSlot(hashes[members[first + k]], d0, 0, slots);
+			}
+
+			// The shift by d1 keeps the distance between members, equal bases never separate
+			std::vector<uint32_t> sorted(base);
+			std::sort(sorted.begin(), sorted.end());
+			if (std::adjacent_find(sorted.begin(), sorted.end()) != sorted.end())
+			{
+				continue;
+			}
+
+			for (uint32_t d1 = 0; d1 < slots && tries < CHD_MAX_TRIES; d1++, tries++)
+			{
+				uint32_t k = 0;
+				while (k < size && !taken[(uint64_t(base[k]) + d1) % slots])
+				{
+					k++;
+				}
+				if (k < size)
+				{
+					continue;
+				}
+
+				for (k = 0; k < size; k++)
+				{
+					const uint32_t slot = uint32_t((uint64_t(base[k]) + d1) % slots);
+					taken[slot] = true;
+					slotRecord[slot] = members[first + k];
+				}
+				displacements[2 * size_t(bucket)] = d0;
+				displacements[2 * size_t(bucket) + 1] = d1;
+				placed = true;
+				break;
+			}
+		}
+
+		if (!placed)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool TokenStoreWriter::Write(const std::string& path, TOKEN_INDEX index) const
+{
+	return WriteImage(path, Serialize(index));
+}
+
+bool TokenStoreWriter::WriteImage(const std::string& path, const std::vector<uint8_t>& image)
+{
+	const std::string temporary = path + ".tmp";
+
+	std::ofstream os(temporary, std::ios::binary | std::ios::trunc);
+	os.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+	os.close();
+	if (!os)
+	{
+		std::remove(temporary.c_str());
+		return false;
+	}
+
+#ifdef _WIN32
+	return MoveFileExA(temporary.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+#else
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+}
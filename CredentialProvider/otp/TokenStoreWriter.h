@@ -0,0 +1,63 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Offline token database writer
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include "TokenStore.h"
+#include <map>
+#include <string>
+#include <vector>
+
+// Builds token database files for TokenStore. Used by provisioning tools and
+// by the compaction of TokenStore, which folds the delta log into a new file.
+class TokenStoreWriter
+{
+public:
+	// false for names that do not normalize, duplicates and invalid tokens
+	bool Add(const wchar_t* user, const wchar_t* domain, const OTP_PARAMETERS& parameters,
+		const uint8_t* secret, size_t secretLength, uint64_t counter);
+
+	// Adds a record as read from a store or delta log, under the given normalized key
+	bool AddRecord(const TOKEN_RECORD& record, const uint16_t* key, size_t keyLength);
+
+	size_t Count() const noexcept { return _records.size(); }
+
+	// Complete file image, sequence is the last delta log entry folded into it
+	std::vector<uint8_t> Serialize(TOKEN_INDEX index = TOKEN_INDEX::HASH, uint64_t sequence = 0) const;
+
+	// Writes path.tmp and renames it over path, a mapped reader never sees a partial file
+	bool Write(const std::string& path, TOKEN_INDEX index = TOKEN_INDEX::HASH) const;
+
+	static bool WriteImage(const std::string& path, const std::vector<uint8_t>& image);
+
+	// Record of a token without its key fields, false for invalid tokens
+	static bool BuildRecord(const OTP_PARAMETERS& parameters, const uint8_t* secret, size_t secretLength,
+		uint64_t counter, TOKEN_RECORD& record) noexcept;
+
+private:
+	// Minimal perfect hash over all names: slot of every record and the displacement pair per bucket
+	void BuildPerfectHash(TOKEN_CHD_HEADER& header, std::vector<uint32_t>& displacements, std::vector<uint32_t>& slotRecord) const;
+
+	// Tries one seed, false if some bucket could not be placed
+	bool PlacePerfectHash(uint64_t seed, uint32_t buckets, std::vector<uint32_t>& displacements, std::vector<uint32_t>& slotRecord) const;
+
+	std::vector<TOKEN_RECORD> _records;
+	std::vector<uint16_t> _keys;
+	std::map<std::vector<uint16_t>, size_t> _names;
+};
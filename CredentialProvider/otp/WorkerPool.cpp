@@ -0,0 +1,103 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Fixed-size worker pool for chunked OTP searches
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(size_t threads) noexcept
+{
+	try
+	{
+		_threads.reserve(threads);
+		for (size_t i = 0; i < threads; i++)
+		{
+			_threads.emplace_back(&WorkerPool::WorkerLoop, this);
+		}
+	}
+	catch (...)
+	{
+		// Out of threads or memory, run with the ones we got
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop = true;
+	}
+	_wake.notify_all();
+
+	for (std::thread& thread : _threads)
+	{
+		thread.join();
+	}
+}
+
+void WorkerPool::Run(size_t tasks, const std::function<void(size_t)>& task) noexcept
+{
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_task = &task;
+		_tasks = tasks;
+		_next.store(0, std::memory_order_relaxed);
+		_busy = _threads.size();
+		_generation++;
+	}
+	_wake.notify_all();
+
+	Drain();
+
+	std::unique_lock<std::mutex> lock(_mutex);
+	_done.wait(lock, [this] { return _busy == 0; });
+	_task = nullptr;
+}
+
+void WorkerPool::WorkerLoop() noexcept
+{
+	uint64_t seen = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(_mutex);
+			_wake.wait(lock, [this, seen] { return _stop || _generation != seen; });
+			if (_stop)
+			{
+				return;
+			}
+			seen = _generation;
+		}
+
+		Drain();
+
+		std::lock_guard<std::mutex> lock(_mutex);
+		if (--_busy == 0)
+		{
+			_done.notify_one();
+		}
+	}
+}
+
+void WorkerPool::Drain() noexcept
+{
+	for (size_t i = _next.fetch_add(1, std::memory_order_relaxed); i < _tasks; i = _next.fetch_add(1, std::memory_order_relaxed))
+	{
+		(*_task)(i);
+	}
+}
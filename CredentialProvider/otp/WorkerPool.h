@@ -0,0 +1,66 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Fixed-size worker pool for chunked OTP searches
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs the indices 0..tasks-1 of one job on a fixed set of threads. The
+// calling thread takes part in every job, so a pool whose threads could
+// not be created still completes the work, only slower. Threads are joined
+// by the destructor, a pool never outlives the call that needs it.
+class WorkerPool
+{
+public:
+	explicit WorkerPool(size_t threads) noexcept;
+	~WorkerPool();
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// Threads working on a job, including the caller
+	size_t Concurrency() const noexcept { return _threads.size() + 1; }
+
+	// Blocks until task(i) returned for every i < tasks. task must not throw.
+	void Run(size_t tasks, const std::function<void(size_t)>& task) noexcept;
+
+private:
+	void WorkerLoop() noexcept;
+	void Drain() noexcept;
+
+	std::vector<std::thread> _threads;
+
+	std::mutex _mutex;
+	std::condition_variable _wake;
+	std::condition_variable _done;
+
+	const std::function<void(size_t)>* _task = nullptr;
+	size_t _tasks = 0;
+	std::atomic<size_t> _next{ 0 };
+	size_t _busy = 0;				// workers that have not finished the current job
+	uint64_t _generation = 0;		// incremented per job, wakes the workers
+	bool _stop = false;
+};
@@ -9,8 +9,10 @@ enum FIELD_ID
 	FID_USERNAME = 3,
 	FID_LDAP_PASS = 4,
 	FID_OTP = 5,
-	FID_SUBMIT_BUTTON = 6,
-	FID_NUM_FIELDS = 7
+	FID_OTP_NEXT = 6,
+	FID_RESYNC_LINK = 7,
+	FID_SUBMIT_BUTTON = 8,
+	FID_NUM_FIELDS = 9
 };
 
 // The first value indicates when the tile is displayed (selected, not selected)
@@ -32,6 +34,8 @@ static const FIELD_STATE_PAIR s_rgScenarioLogon[] =
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_FOCUSED },		// FID_USERNAME (editable)
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_LDAP_PASS (editable)
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_OTP (editable)
+	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_OTP_NEXT
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_RESYNC_LINK (hidden for TOTP tokens)
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_SUBMIT_BUTTON
 };
 
@@ -45,6 +49,22 @@ static const FIELD_STATE_PAIR s_rgScenarioLogonSerialized[] =
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_DISABLED },		// FID_USERNAME (from NLA, visible but disabled)
 	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_LDAP_PASS (from NLA, HIDDEN)
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_FOCUSED },		// FID_OTP (editable, focused)
+	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_OTP_NEXT
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_RESYNC_LINK (hidden for TOTP tokens)
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_SUBMIT_BUTTON
+};
+
+// Scenario: HOTP RESYNC - Like LOGON, the user types two consecutive codes of a drifted token
+static const FIELD_STATE_PAIR s_rgScenarioResync[] =
+{
+	{ CPFS_DISPLAY_IN_BOTH, CPFIS_NONE },					// FID_LOGO
+	{ CPFS_DISPLAY_IN_BOTH, CPFIS_NONE },					// FID_LARGE_TEXT
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_SMALL_TEXT (instructions)
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_USERNAME (editable)
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_LDAP_PASS (editable)
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_FOCUSED },		// FID_OTP (editable, focused)
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_OTP_NEXT (editable)
+	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_RESYNC_LINK (cancels resync)
 	{ CPFS_DISPLAY_IN_SELECTED_TILE, CPFIS_NONE },			// FID_SUBMIT_BUTTON
 };
 
@@ -57,6 +77,8 @@ static const FIELD_STATE_PAIR s_rgScenarioUnlockBlocked[] =
 	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_USERNAME
 	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_LDAP_PASS
 	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_OTP
+	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_OTP_NEXT
+	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_RESYNC_LINK
 	{ CPFS_HIDDEN, CPFIS_NONE },							// FID_SUBMIT_BUTTON
 };
 
@@ -72,5 +94,7 @@ static CREDENTIAL_PROVIDER_FIELD_DESCRIPTOR s_rgScenarioCredProvFieldDescriptors
 	{ FID_USERNAME, CPFT_EDIT_TEXT, L"Username" },
 	{ FID_LDAP_PASS, CPFT_PASSWORD_TEXT, L"Password" },
 	{ FID_OTP, CPFT_EDIT_TEXT, L"One-Time Password" },
+	{ FID_OTP_NEXT, CPFT_EDIT_TEXT, L"Next One-Time Password" },
+	{ FID_RESYNC_LINK, CPFT_COMMAND_LINK, L"Resynchronize token" },
 	{ FID_SUBMIT_BUTTON, CPFT_SUBMIT_BUTTON, L"Submit" },
 };
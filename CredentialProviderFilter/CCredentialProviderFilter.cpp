@@ -33,7 +33,7 @@
 
 HRESULT CSample_CreateInstance(__in REFIID riid, __deref_out void** ppv)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(FILTER, __FUNCTION__);
 	HRESULT hr;
 
 	CCredentialProviderFilter* pProvider = new CCredentialProviderFilter();
@@ -55,7 +55,7 @@ HRESULT CCredentialProviderFilter::Filter(CREDENTIAL_PROVIDER_USAGE_SCENARIO cpu
 	BOOL* rgbAllow, DWORD cProviders)
 {
 	UNREFERENCED_PARAMETER(dwFlags);
-	DebugPrint(std::string(__FUNCTION__) + ": " + Shared::CPUStoString(cpus));
+	LogDebug(FILTER, std::string(__FUNCTION__) + ": " + Shared::CPUStoString(cpus));
 
 	switch (cpus)
 	{
@@ -76,7 +76,7 @@ HRESULT CCredentialProviderFilter::Filter(CREDENTIAL_PROVIDER_USAGE_SCENARIO cpu
 		if (IsEqualGUID(rgclsidProviders[i], CLSID_COTP_LOGON))
 		{
 			rgbAllow[i] = TRUE;  // Show DasCredentialProvider
-			DebugPrint("Allowing DasCredentialProvider");
+			LogDebug(FILTER, "Allowing DasCredentialProvider");
 		}
 		else
 		{
@@ -90,19 +90,19 @@ HRESULT CCredentialProviderFilter::Filter(CREDENTIAL_PROVIDER_USAGE_SCENARIO cpu
 CCredentialProviderFilter::CCredentialProviderFilter() :
 	_cRef(1)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(FILTER, __FUNCTION__);
 	DllAddRef();
 }
 
 CCredentialProviderFilter::~CCredentialProviderFilter()
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(FILTER, __FUNCTION__);
 	DllRelease();
 }
 
 HRESULT CCredentialProviderFilter::UpdateRemoteCredential(const CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION* pcpcsIn, CREDENTIAL_PROVIDER_CREDENTIAL_SERIALIZATION* pcpcsOut)
 {
-	DebugPrint(__FUNCTION__);
+	LogTrace(FILTER, __FUNCTION__);
 
 	if (!pcpcsIn)
 	{
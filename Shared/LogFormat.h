@@ -0,0 +1,87 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstdint>
+
+// Binary log, little-endian, every record 8 byte aligned:
+//   LOG_RECORD_HEADER + payload + padding, repeated
+// A log is appended to by several loggers, the provider's and the filter's,
+// each under its own session number. A logger starts each time it opens the
+// file with a SESSION record, then describes every call site it knows with a
+// SITE record. A MESSAGE refers to its site by number and carries the raw
+// argument of the call, it is only turned into text by the decoder. Sites a
+// logger sees for the first time are described in the same write as their
+// first message, not necessarily before it, a reader collects the sites first.
+
+#define LOG_BINARY_MAGIC "DASLOGBN"
+#define LOG_BINARY_VERSION 1
+
+enum class LOG_RECORD : uint16_t
+{
+	SESSION = 1,	// LOG_SESSION_RECORD
+	SITE = 2,		// LOG_SITE_RECORD, then the file name
+	MESSAGE = 3,	// the argument, as LOG_ARG says
+	DROPPED = 4,	// uint64_t, messages lost because the ring was full
+};
+
+enum class LOG_ARG : uint16_t
+{
+	NONE = 0,
+	TEXT = 1,		// narrow string as logged
+	UTF16 = 2,		// wide string, UTF-16 code units
+	UTF32 = 3,		// wide string, where wchar_t has 32 bits
+	INT = 4,		// int32_t
+};
+
+struct LOG_RECORD_HEADER
+{
+	uint32_t size;				// header, payload and padding
+	uint16_t type;				// LOG_RECORD
+	uint16_t arg;				// LOG_ARG of a MESSAGE
+	uint32_t session;
+	uint32_t site;				// SITE and MESSAGE, from 1
+	uint64_t ticks;				// steady clock of the process
+	uint32_t length;			// payload bytes without padding
+	uint32_t reserved;
+};
+
+struct LOG_SESSION_RECORD
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t process;
+	uint64_t ticksPerSecond;
+	int64_t unixMicros;			// wall clock at the ticks of the header
+	int32_t utcOffset;			// seconds local time is ahead of UTC
+	uint32_t reserved;
+};
+
+#define LOG_SITE_PRODUCTION 1	// ReleaseDebugPrint, also logged by the text log of a release build
+
+struct LOG_SITE_RECORD
+{
+	int32_t line;
+	uint32_t flags;				// LOG_SITE_*
+};
+
+static_assert(sizeof(LOG_RECORD_HEADER) == 32, "LOG_RECORD_HEADER layout");
+static_assert(sizeof(LOG_SESSION_RECORD) == 40, "LOG_SESSION_RECORD layout");
+static_assert(sizeof(LOG_SITE_RECORD) == 8, "LOG_SITE_RECORD layout");
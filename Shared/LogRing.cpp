@@ -0,0 +1,118 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "LogRing.h"
+#include <cstring>
+
+// A slot at position p (index p & mask) has sequence p while it is free for
+// the producer of p, p + 1 once that producer published it, and p + capacity
+// after the consumer read it, i.e. free for the next lap.
+
+LogRing::LogRing(size_t capacity)
+{
+	size_t size = LOG_RING_MAX_SLOTS;
+	while (size < capacity)
+	{
+		size <<= 1;
+	}
+	_slots.reset(new SLOT[size]);
+	_mask = size - 1;
+	for (size_t i = 0; i < size; i++)
+	{
+		_slots[i].sequence.store(i, std::memory_order_relaxed);
+		_slots[i].length = 0;
+	}
+}
+
+bool LogRing::TryPush(const char* const* parts, const size_t* lengths, size_t count) noexcept
+{
+	size_t total = 0;
+	for (size_t i = 0; i < count; i++)
+	{
+		total += lengths[i];
+	}
+	size_t slots = total == 0 ? 1 : (total + SlotText - 1) / SlotText;
+	if (slots > LOG_RING_MAX_SLOTS)
+	{
+		slots = LOG_RING_MAX_SLOTS;
+		total = slots * SlotText;
+	}
+
+	// Claim positions tail..tail+slots-1. The consumer frees slots in order,
+	// so the last one being free means all of them are.
+	uint64_t tail = _tail.load(std::memory_order_relaxed);
+	for (;;)
+	{
+		const uint64_t last = tail + slots - 1;
+		const uint64_t sequence = _slots[last & _mask].sequence.load(std::memory_order_acquire);
+		const int64_t difference = static_cast<int64_t>(sequence - last);
+		if (difference == 0)
+		{
+			if (_tail.compare_exchange_weak(tail, tail + slots, std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if (difference < 0)
+		{
+			return false;
+		}
+		else
+		{
+			tail = _tail.load(std::memory_order_relaxed);
+		}
+	}
+
+	// Gather the parts into the claimed slots
+	size_t part = 0;
+	size_t offset = 0;
+	for (size_t i = 0; i < slots; i++)
+	{
+		SLOT& slot = _slots[(tail + i) & _mask];
+		size_t filled = 0;
+		while (filled < SlotText && part < count && total > 0)
+		{
+			size_t n = lengths[part] - offset;
+			n = n < SlotText - filled ? n : SlotText - filled;
+			n = n < total ? n : total;
+			memcpy(slot.text + filled, parts[part] + offset, n);
+			filled += n;
+			offset += n;
+			total -= n;
+			if (offset == lengths[part])
+			{
+				part++;
+				offset = 0;
+			}
+		}
+		slot.length = static_cast<uint32_t>(filled);
+	}
+
+	for (size_t i = 0; i < slots; i++)
+	{
+		_slots[(tail + i) & _mask].sequence.store(tail + i + 1, std::memory_order_release);
+	}
+	return true;
+}
+
+bool LogRing::Empty() const noexcept
+{
+	return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_acquire);
+}
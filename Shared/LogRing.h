@@ -0,0 +1,106 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+// Bytes of one ring slot, including its sequence number and length
+#define LOG_RING_SLOT_BYTES 256
+// Longest record in slots, longer records are truncated
+#define LOG_RING_MAX_SLOTS 16
+
+// Bounded multi-producer, single-consumer queue of log records. A record is
+// copied into one or more consecutive fixed-size slots, claimed with a
+// single compare-exchange on the tail, so producers never take a lock or
+// allocate. Every slot carries a sequence number (Vyukov's bounded queue):
+// it says whether the slot is free for a producer at a given position or
+// published for the consumer. The consumer hands out the bytes of the
+// published slots in order, a record spread over several slots comes out
+// in one piece because its slots are consecutive.
+class LogRing
+{
+public:
+	// capacity in slots, rounded up to a power of two
+	explicit LogRing(size_t capacity);
+
+	LogRing(const LogRing&) = delete;
+	LogRing& operator=(const LogRing&) = delete;
+
+	// Copies the concatenation of parts[0..count-1] as one record. Returns
+	// false, leaving the ring unchanged, if there are not enough free slots.
+	// Safe to call from any number of threads.
+	bool TryPush(const char* const* parts, const size_t* lengths, size_t count) noexcept;
+
+	// Calls sink(text, length) for each published slot in order, up to
+	// maxSlots, and frees them. Returns the number of slots consumed.
+	// Only one thread may consume.
+	template <typename SINK>
+	size_t Consume(SINK&& sink, size_t maxSlots) noexcept
+	{
+		uint64_t head = _head.load(std::memory_order_relaxed);
+		size_t consumed = 0;
+		while (consumed < maxSlots)
+		{
+			SLOT& slot = _slots[head & _mask];
+			if (slot.sequence.load(std::memory_order_acquire) != head + 1)
+			{
+				break;
+			}
+			sink(slot.text, static_cast<size_t>(slot.length));
+			slot.sequence.store(head + _mask + 1, std::memory_order_release);
+			head++;
+			consumed++;
+		}
+		_head.store(head, std::memory_order_release);
+		return consumed;
+	}
+
+	// Whether the consumer has seen every claimed slot. Approximate while producers are active.
+	bool Empty() const noexcept;
+
+	// Positions claimed by producers so far, the consumer has read them all
+	// once it consumed this many slots in total
+	uint64_t Claimed() const noexcept { return _tail.load(std::memory_order_acquire); }
+
+	size_t Capacity() const noexcept { return _mask + 1; }
+
+	// Payload bytes of one slot
+	static constexpr size_t SlotText = LOG_RING_SLOT_BYTES - sizeof(uint64_t) - sizeof(uint32_t);
+
+private:
+	struct SLOT
+	{
+		std::atomic<uint64_t> sequence;
+		uint32_t length;
+		char text[SlotText];
+	};
+
+	std::unique_ptr<SLOT[]> _slots;
+	size_t _mask;
+
+	// Producers and the consumer write to different cache lines
+	char _padding0[64];
+	std::atomic<uint64_t> _tail{ 0 };	// next position a producer claims
+	char _padding1[64 - sizeof(std::atomic<uint64_t>)];
+	std::atomic<uint64_t> _head{ 0 };	// next position the consumer reads, written by it only
+};
@@ -19,17 +19,273 @@
 ** * * * * * * * * * * * * * * * * * * */
 
 #include "Logger.h"
+#include "Utf8.h"
 
+#ifdef _WIN32
 #include <Windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 #include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
 #include <fstream>
 #include <iostream>
-#include <codecvt>
 
 using namespace std;
 
-void Logger::logS(const string& message, const char* file, int line, bool logInProduction)
+// Bytes the writer collects before it writes, and the most it takes out of the ring at once
+#define LOG_WRITER_BATCH (64 * 1024)
+// The writer wakes up at least this often, a missed wake-up delays a line by no more
+#define LOG_WRITER_IDLE_MS 100
+// 1 ms naps of an idle writer before it waits to be woken
+#define LOG_WRITER_NAPS 10
+// Binary records are padded to this
+#define LOG_RECORD_ALIGN 8
+// The text log time is the monotonic clock plus an offset. It is taken
+// again if it is this far from the wall clock, checked once a second.
+#define LOG_TIME_MAX_SKEW_MICROS 1000000
+#define LOG_TIME_MICROS 1000000
+
+namespace
 {
+#ifdef _WIN32
+	typedef HANDLE LOG_FILE;
+	const LOG_FILE INVALID_LOG_FILE = INVALID_HANDLE_VALUE;
+
+	// Appends are atomic per write, other processes and the filter may share the file
+	LOG_FILE OpenLogFile(const string& path)
+	{
+		return CreateFileA(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+			nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+	}
+
+	void WriteLogFile(LOG_FILE file, const char* data, size_t length)
+	{
+		DWORD written = 0;
+		WriteFile(file, data, static_cast<DWORD>(length), &written, nullptr);
+	}
+
+	void CloseLogFile(LOG_FILE file)
+	{
+		CloseHandle(file);
+	}
+#else
+	typedef int LOG_FILE;
+	const LOG_FILE INVALID_LOG_FILE = -1;
+
+	LOG_FILE OpenLogFile(const string& path)
+	{
+		return open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+	}
+
+	void WriteLogFile(LOG_FILE file, const char* data, size_t length)
+	{
+		while (length > 0)
+		{
+			const ssize_t written = write(file, data, length);
+			if (written <= 0)
+			{
+				return;
+			}
+			data += written;
+			length -= static_cast<size_t>(written);
+		}
+	}
+
+	void CloseLogFile(LOG_FILE file)
+	{
+		close(file);
+	}
+#endif
+
+	const char* BaseName(const char* path)
+	{
+		const char* name = path;
+		for (const char* p = path; *p != '\0'; p++)
+		{
+			if (*p == '\\' || *p == '/')
+			{
+				name = p + 1;
+			}
+		}
+		return name;
+	}
+
+	uint64_t Ticks()
+	{
+		return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+	}
+
+	// Seconds local time is ahead of UTC at t
+	int32_t UtcOffset(time_t t)
+	{
+		struct tm local;
+		struct tm utc;
+#ifdef _WIN32
+		if (localtime_s(&local, &t) != 0 || gmtime_s(&utc, &t) != 0)
+		{
+			return 0;
+		}
+#else
+		if (localtime_r(&t, &local) == nullptr || gmtime_r(&t, &utc) == nullptr)
+		{
+			return 0;
+		}
+#endif
+		int days = local.tm_yday - utc.tm_yday;
+		if (local.tm_year != utc.tm_year)
+		{
+			days = local.tm_year > utc.tm_year ? 1 : -1;
+		}
+		return ((days * 24 + local.tm_hour - utc.tm_hour) * 60 + local.tm_min - utc.tm_min) * 60 + local.tm_sec - utc.tm_sec;
+	}
+
+	void AppendRecord(string& out, LOG_RECORD type, uint32_t session, uint32_t site, uint64_t ticks,
+		const void* payload, size_t length, const void* extra = nullptr, size_t extraLength = 0)
+	{
+		LOG_RECORD_HEADER header = {};
+		const size_t unpadded = sizeof(header) + length + extraLength;
+		header.size = static_cast<uint32_t>((unpadded + LOG_RECORD_ALIGN - 1) & ~size_t(LOG_RECORD_ALIGN - 1));
+		header.type = static_cast<uint16_t>(type);
+		header.session = session;
+		header.site = site;
+		header.ticks = ticks;
+		header.length = static_cast<uint32_t>(length + extraLength);
+		out.append(reinterpret_cast<const char*>(&header), sizeof(header));
+		out.append(static_cast<const char*>(payload), length);
+		if (extraLength > 0)
+		{
+			out.append(static_cast<const char*>(extra), extraLength);
+		}
+		out.append(header.size - unpadded, '\0');
+	}
+
+	// Local time of second, a time_t, as "dd-mm-yyyy hh:mm:ss" in 24-hour format
+	bool FormatSecond(int64_t second, char* buffer, size_t size)
+	{
+		const time_t rawtime = static_cast<time_t>(second);
+		struct tm timeinfo;
+#ifdef _WIN32
+		if (localtime_s(&timeinfo, &rawtime) != 0)
+		{
+			return false;
+		}
+#else
+		if (localtime_r(&rawtime, &timeinfo) == nullptr)
+		{
+			return false;
+		}
+#endif
+		return strftime(buffer, size, "%d-%m-%Y %H:%M:%S", &timeinfo) > 0;
+	}
+
+	int64_t WallMicros()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	}
+
+	int64_t TickMicros()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Wall clock minus the monotonic clock. Lines follow the monotonic clock,
+	// so they stay in order, and the offset only moves if the wall clock was set.
+	std::atomic<int64_t> wallOffset(INT64_MIN);
+
+	// Seconds formatted last by this thread
+	struct TIME_CACHE
+	{
+		int64_t second = INT64_MIN;
+		size_t length = 0;
+		char text[32] = {};
+	};
+
+	// [Time] in buffer with microseconds, false if the local time is not
+	// available. Only a new second goes through localtime and strftime.
+	bool FormatTime(char* buffer, size_t size)
+	{
+		thread_local TIME_CACHE cache;
+		const int64_t ticks = TickMicros();
+		int64_t offset = wallOffset.load(std::memory_order_relaxed);
+		if (offset == INT64_MIN)
+		{
+			offset = WallMicros() - ticks;
+			wallOffset.store(offset, std::memory_order_relaxed);
+		}
+
+		int64_t micros = ticks + offset;
+		if (micros / LOG_TIME_MICROS != cache.second)
+		{
+			// Once a second, check whether the wall clock was set
+			const int64_t wall = WallMicros();
+			if (wall - micros > LOG_TIME_MAX_SKEW_MICROS || micros - wall > LOG_TIME_MAX_SKEW_MICROS)
+			{
+				offset = wall - ticks;
+				wallOffset.store(offset, std::memory_order_relaxed);
+				micros = ticks + offset;
+			}
+			const int64_t second = micros / LOG_TIME_MICROS;
+			if (!FormatSecond(second, cache.text, sizeof(cache.text)))
+			{
+				cache.second = INT64_MIN;
+				return false;
+			}
+			cache.second = second;
+			cache.length = strlen(cache.text);
+		}
+
+		// ".uuuuuu" after the cached seconds
+		if (size < cache.length + 8)
+		{
+			return false;
+		}
+		memcpy(buffer, cache.text, cache.length);
+		char* fraction = buffer + cache.length;
+		fraction[0] = '.';
+		uint32_t rest = static_cast<uint32_t>(micros % LOG_TIME_MICROS);
+		for (int i = 6; i > 0; i--)
+		{
+			fraction[i] = static_cast<char>('0' + rest % 10);
+			rest /= 10;
+		}
+		fraction[7] = '\0';
+		return true;
+	}
+}
+
+Logger::Logger()
+{
+	for (std::atomic<int>& level : _verbosity)
+	{
+		level.store(LOG_COMPILED_LEVEL, std::memory_order_relaxed);
+	}
+}
+
+void Logger::setVerbosity(LOG_CATEGORY category, int level) noexcept
+{
+	const int index = static_cast<int>(category);
+	if (index >= 0 && index < LOG_CATEGORIES)
+	{
+		_verbosity[index].store(level, std::memory_order_relaxed);
+	}
+}
+
+int Logger::verbosity(LOG_CATEGORY category) const noexcept
+{
+	const int index = static_cast<int>(category);
+	return index >= 0 && index < LOG_CATEGORIES ? _verbosity[index].load(std::memory_order_relaxed) : LOG_LEVEL_OFF;
+}
+
+void Logger::logS(const char* message, size_t length, LOG_SITE& site)
+{
+	const char* file = BaseName(site.file);
+	const int line = site.line;
+	const bool logInProduction = site.production;
+
 	#ifdef _DEBUG
 		UNREFERENCED_PARAMETER(logInProduction);
 	#endif
@@ -44,23 +300,26 @@ void Logger::logS(const string& message, const char* file, int line, bool logInP
 	#endif // !_DEBUG
 
 	// Format: [Time] [file:line]  message
-	time_t rawtime = NULL;
-	struct tm* timeinfo = (tm*)CoTaskMemAlloc(sizeof(tm));
 	char buffer[80];
 	SecureZeroMemory(buffer, sizeof(buffer));
-	if (timeinfo == nullptr)
+	if (!FormatTime(buffer, sizeof(buffer)))
 	{
 		return;
 	}
-	time(&rawtime);
-	const errno_t err = localtime_s(timeinfo, &rawtime);
-	if (err != 0)
+
+	if (_async.load(std::memory_order_acquire))
 	{
-		return;
+		char prefix[sizeof(buffer) + 300];
+		const int written = snprintf(prefix, sizeof(prefix), "[%s] [%s:%d] ", buffer, file, line);
+		const size_t prefixLength = written < 0 ? 0 : (static_cast<size_t>(written) < sizeof(prefix) ? written : sizeof(prefix) - 1);
+		if (prefixLength > 0 && logAsync(prefix, prefixLength, message, length))
+		{
+			return;
+		}
 	}
-	strftime(buffer, sizeof(buffer), "%d-%m-%Y %I:%M:%S", timeinfo);
-	CoTaskMemFree(timeinfo);
-	string fullMessage = "[" + string(buffer) + "] [" + string(file) + ":" + to_string(line) + "] " + message;
+
+	string fullMessage = "[" + string(buffer) + "] [" + string(file) + ":" + to_string(line) + "] ";
+	fullMessage.append(message, length);
 
 	ofstream os;
 	os.open(outfilePath.c_str(), std::ios_base::app);
@@ -68,62 +327,415 @@ void Logger::logS(const string& message, const char* file, int line, bool logInP
 
 
 #ifndef _OUTPUT_TO_COUT
+#ifdef _WIN32
 	OutputDebugStringA(fullMessage.c_str());
 	OutputDebugStringA("\n");
+#endif
 #else
 	//std::cout << fullMessage << std::endl;
 #endif // !_OUTPUT_TO_COUT
 }
 
-void Logger::logW(const wstring& message, const char* file, int line, bool logInProduction)
+bool Logger::logAsync(const char* prefix, size_t prefixLength, const char* message, size_t length)
+{
+	// Longer lines are cut to what one record holds
+	const size_t limit = LOG_RING_MAX_SLOTS * LogRing::SlotText - prefixLength - 1;
+	const char* parts[3] = { prefix, message, "\n" };
+	const size_t lengths[3] = { prefixLength, length < limit ? length : limit, 1 };
+	return push(parts, lengths, 3);
+}
+
+bool Logger::logBinary(LOG_SITE& site, LOG_ARG arg, const void* data, size_t length)
+{
+	if (!_binary.load(std::memory_order_acquire))
+	{
+		return false;
+	}
+#ifndef _DEBUG
+	// The same sites as in the text log, the rest is dropped here and not written as text either
+	if (!site.production || !this->releaseLog)
+	{
+		return true;
+	}
+#endif // !_DEBUG
+
+	// Longer arguments are cut to what one record holds, wide strings between code units
+	const size_t limit = LOG_RING_MAX_SLOTS * LogRing::SlotText - sizeof(LOG_RECORD_HEADER) - LOG_RECORD_ALIGN;
+	if (length > limit)
+	{
+		length = limit - limit % sizeof(wchar_t);
+	}
+
+	LOG_RECORD_HEADER header = {};
+	header.size = static_cast<uint32_t>((sizeof(header) + length + LOG_RECORD_ALIGN - 1) & ~size_t(LOG_RECORD_ALIGN - 1));
+	header.type = static_cast<uint16_t>(LOG_RECORD::MESSAGE);
+	header.arg = static_cast<uint16_t>(arg);
+	header.session = _session;
+	header.site = siteId(site);
+	header.ticks = Ticks();
+	header.length = static_cast<uint32_t>(length);
+
+	static const char padding[LOG_RECORD_ALIGN] = {};
+	const char* parts[3] = { reinterpret_cast<const char*>(&header), static_cast<const char*>(data), padding };
+	const size_t lengths[3] = { sizeof(header), length, header.size - sizeof(header) - length };
+	return push(parts, lengths, 3);
+}
+
+uint32_t Logger::siteId(LOG_SITE& site)
+{
+	uint32_t id = site.id.load(std::memory_order_acquire);
+	if (id != 0)
+	{
+		return id;
+	}
+
+	// The first caller numbers the site and links it, the writer describes it
+	const uint32_t fresh = _lastSite.fetch_add(1, std::memory_order_relaxed) + 1;
+	if (!site.id.compare_exchange_strong(id, fresh, std::memory_order_acq_rel))
+	{
+		return id;
+	}
+	LOG_SITE* head = _sites.load(std::memory_order_relaxed);
+	do
+	{
+		site.next = head;
+	} while (!_sites.compare_exchange_weak(head, &site, std::memory_order_release, std::memory_order_relaxed));
+	return fresh;
+}
+
+void Logger::describeSession(string& out)
+{
+	LOG_SESSION_RECORD session = {};
+	memcpy(session.magic, LOG_BINARY_MAGIC, sizeof(session.magic));
+	session.version = LOG_BINARY_VERSION;
+#ifdef _WIN32
+	session.process = GetCurrentProcessId();
+#else
+	session.process = static_cast<uint32_t>(getpid());
+#endif
+	session.ticksPerSecond = std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
+	const uint64_t ticks = Ticks();
+	const auto now = std::chrono::system_clock::now();
+	session.unixMicros = std::chrono::duration_cast<std::chrono::microseconds>(now.time_since_epoch()).count();
+	session.utcOffset = UtcOffset(std::chrono::system_clock::to_time_t(now));
+	AppendRecord(out, LOG_RECORD::SESSION, _session, 0, ticks, &session, sizeof(session));
+}
+
+void Logger::describeSites(string& out, const LOG_SITE* first, const LOG_SITE* last)
+{
+	for (const LOG_SITE* site = first; site != last; site = site->next)
+	{
+		LOG_SITE_RECORD record = {};
+		record.line = site->line;
+		record.flags = site->production ? LOG_SITE_PRODUCTION : 0;
+		const char* name = BaseName(site->file);
+		AppendRecord(out, LOG_RECORD::SITE, _session, site->id.load(std::memory_order_relaxed), 0,
+			&record, sizeof(record), name, strlen(name));
+	}
+}
+
+bool Logger::push(const char* const* parts, const size_t* lengths, size_t count)
+{
+	// stopAsync() waits for the producers it lets in here
+	_producers.fetch_add(1, std::memory_order_seq_cst);
+	if (!_async.load(std::memory_order_seq_cst))
+	{
+		_producers.fetch_sub(1, std::memory_order_release);
+		return false;
+	}
+
+	bool pushed = _ring->TryPush(parts, lengths, count);
+	if (!pushed && _overflow == LOG_OVERFLOW::BLOCK)
+	{
+		_blocked.fetch_add(1, std::memory_order_seq_cst);
+		while (!pushed)
+		{
+			{
+				std::unique_lock<std::mutex> lock(_mutex);
+				_wake.notify_one();
+				_space.wait_for(lock, std::chrono::milliseconds(1));
+			}
+			pushed = _ring->TryPush(parts, lengths, count);
+		}
+		_blocked.fetch_sub(1, std::memory_order_relaxed);
+	}
+	if (!pushed)
+	{
+		_dropped.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Pairs with the fence of the writer before it sleeps, one of both sees the other
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	if (_writerSleeping.load(std::memory_order_relaxed))
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_writerSleeping.store(false, std::memory_order_relaxed);
+		_wake.notify_one();
+	}
+
+	_producers.fetch_sub(1, std::memory_order_release);
+	return true;
+}
+
+void Logger::startAsync(LOG_OVERFLOW overflow, LOG_FORMAT format, size_t capacity)
 {
-	using convert_typeX = std::codecvt_utf8<wchar_t>;
-	std::wstring_convert<convert_typeX, wchar_t> converterX;
+	std::lock_guard<std::mutex> control(_control);
+	if (_asyncUsers++ > 0)
+	{
+		return;
+	}
 
-	string conv = converterX.to_bytes(message);
-	logS(conv, file, line, logInProduction);
+#ifdef _DEBUG
+	_asyncPath = format == LOG_FORMAT::BINARY ? logfilePathBinary : logfilePathDebug;
+#else
+	_asyncPath = format == LOG_FORMAT::BINARY ? logfilePathBinary : logfilePathProduction;
+#endif
+	if (_session == 0)
+	{
+		// Tells apart the loggers of the provider and the filter in one file
+		_session = static_cast<uint32_t>((Ticks() * 0x9e3779b97f4a7c15ULL) >> 32) ^ static_cast<uint32_t>(reinterpret_cast<uintptr_t>(this));
+		_session = _session != 0 ? _session : 1;
+	}
+	try
+	{
+		if (!_ring || _ring->Capacity() < capacity)
+		{
+			_ring.reset(new LogRing(capacity));
+			_written.store(0, std::memory_order_relaxed);
+		}
+		_overflow = overflow;
+		_format = format;
+		_stop.store(false);
+		_writer = std::thread(&Logger::writerLoop, this);
+		_binary.store(format == LOG_FORMAT::BINARY, std::memory_order_relaxed);
+		_async.store(true, std::memory_order_seq_cst);
+	}
+	catch (...)
+	{
+		// No memory or thread, stay synchronous
+		_asyncUsers = 0;
+	}
 }
 
-void Logger::log(const char* message, const char* file, int line, bool logInProduction)
+void Logger::stopAsync()
 {
-	string msg = "";
-	if (message != nullptr && message[0] != NULL) {
-		msg = string(message);
+	std::lock_guard<std::mutex> control(_control);
+	if (_asyncUsers == 0 || --_asyncUsers > 0)
+	{
+		return;
 	}
-	logS(msg, file, line, logInProduction);
+	stopWriter();
 }
 
-void Logger::log(const wchar_t* message, const char* file, int line, bool logInProduction)
+void Logger::stopWriter()
 {
-	wstring msg = L"";
-	if (message != nullptr && message[0] != NULL) {
-		msg = wstring(message);
+	if (!_writer.joinable())
+	{
+		return;
 	}
-	logW(msg, file, line, logInProduction);
+
+	// New lines go the direct way, the ones already on their way into the ring are waited for
+	_async.store(false, std::memory_order_seq_cst);
+	_binary.store(false, std::memory_order_relaxed);
+	while (_producers.load(std::memory_order_acquire) != 0)
+	{
+		std::this_thread::yield();
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(_mutex);
+		_stop.store(true);
+		_wake.notify_one();
+	}
+	_writer.join();
 }
 
-void Logger::log(const int message, const char* file, int line, bool logInProduction)
+void Logger::flush()
 {
+	if (!_async.load(std::memory_order_acquire))
+	{
+		return;
+	}
+	const unsigned long long target = _ring->Claimed();
+	while (_written.load(std::memory_order_acquire) < target)
+	{
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_wake.notify_one();
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(100));
+	}
+}
+
+void Logger::writerLoop()
+{
+	LOG_FILE file = OpenLogFile(_asyncPath);
+	string batch;
+	batch.reserve(LOG_WRITER_BATCH + LogRing::SlotText);
+	unsigned long long position = _written.load(std::memory_order_relaxed);
+	unsigned long long droppedReported = _dropped.load(std::memory_order_relaxed);
+	unsigned int naps = 0;
+	const bool binary = _format == LOG_FORMAT::BINARY;
+
+	// Every site is described again in a file that may be new
+	const LOG_SITE* described = nullptr;
+	if (binary)
+	{
+		describeSession(batch);
+		described = _sites.load(std::memory_order_acquire);
+		describeSites(batch, described, nullptr);
+	}
+
+	for (;;)
+	{
+		const size_t consumed = _ring->Consume([&batch](const char* text, size_t length)
+			{
+				batch.append(text, length);
+			}, LOG_WRITER_BATCH / LogRing::SlotText);
+		position += consumed;
+
+		const unsigned long long dropped = _dropped.load(std::memory_order_relaxed);
+		if (dropped != droppedReported)
+		{
+			const uint64_t lost = dropped - droppedReported;
+			if (binary)
+			{
+				AppendRecord(batch, LOG_RECORD::DROPPED, _session, 0, Ticks(), &lost, sizeof(lost));
+			}
+			else
+			{
+				batch += "[Logger] " + to_string(lost) + " lines dropped, the log ring was full\n";
+			}
+			droppedReported = dropped;
+		}
+
+		// Sites numbered since the last write. Their first messages may already be in the batch.
+		if (binary && _sites.load(std::memory_order_acquire) != described)
+		{
+			const LOG_SITE* head = _sites.load(std::memory_order_acquire);
+			describeSites(batch, head, described);
+			described = head;
+		}
+
+		if (!batch.empty())
+		{
+			if (file != INVALID_LOG_FILE)
+			{
+				WriteLogFile(file, batch.data(), batch.size());
+			}
+#if defined(_WIN32) && !defined(_OUTPUT_TO_COUT)
+			if (!binary)
+			{
+				OutputDebugStringA(batch.c_str());
+			}
+#endif
+			batch.clear();
+		}
+		_written.store(position, std::memory_order_release);
+
+		if (consumed > 0 && _blocked.load(std::memory_order_relaxed) != 0)
+		{
+			std::lock_guard<std::mutex> lock(_mutex);
+			_space.notify_all();
+		}
+		if (consumed > 0)
+		{
+			naps = 0;
+			continue;
+		}
+
+		// While lines keep coming, nap without telling the producers, so they
+		// need not wake the writer per line and more lines go into one write
+		if (naps < LOG_WRITER_NAPS && !_stop.load(std::memory_order_relaxed))
+		{
+			naps++;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		if (_stop && _ring->Empty())
+		{
+			break;
+		}
+		_writerSleeping.store(true, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (_ring->Empty() && !_stop)
+		{
+			_wake.wait_for(lock, std::chrono::milliseconds(LOG_WRITER_IDLE_MS));
+		}
+		_writerSleeping.store(false, std::memory_order_relaxed);
+	}
+
+	if (file != INVALID_LOG_FILE)
+	{
+		CloseLogFile(file);
+	}
+}
+
+void Logger::logW(const wchar_t* message, size_t length, LOG_SITE& site)
+{
+	// Converted into a buffer of the thread, logS copies it before anything else converts
+	size_t converted = 0;
+	const char* text = Utf8::FromWide(message, length, converted);
+	logS(text, converted, site);
+}
+
+void Logger::log(const char* message, LOG_SITE& site)
+{
+	const size_t length = message != nullptr ? strlen(message) : 0;
+	if (logBinary(site, LOG_ARG::TEXT, message, length))
+	{
+		return;
+	}
+	logS(length > 0 ? message : "", length, site);
+}
+
+void Logger::log(const wchar_t* message, LOG_SITE& site)
+{
+	const size_t length = message != nullptr ? wcslen(message) : 0;
+	if (logBinary(site, sizeof(wchar_t) == 2 ? LOG_ARG::UTF16 : LOG_ARG::UTF32, message, length * sizeof(wchar_t)))
+	{
+		return;
+	}
+	logW(length > 0 ? message : L"", length, site);
+}
+
+void Logger::log(const int message, LOG_SITE& site)
+{
+	const int32_t value = message;
+	if (logBinary(site, LOG_ARG::INT, &value, sizeof(value)))
+	{
+		return;
+	}
 	string i = "(int) " + to_string(message);
-	logS(i, file, line, logInProduction);
+	logS(i.data(), i.size(), site);
 }
 
-void Logger::log(const std::string& message, const char* file, int line, bool logInProduction)
+void Logger::log(const std::string& message, LOG_SITE& site)
 {
-	logS(message, file, line, logInProduction);
+	if (logBinary(site, LOG_ARG::TEXT, message.data(), message.size()))
+	{
+		return;
+	}
+	logS(message.data(), message.size(), site);
 }
 
-void Logger::log(const std::wstring& message, const char* file, int line, bool logInProduction)
+void Logger::log(const std::wstring& message, LOG_SITE& site)
 {
-	logW(message, file, line, logInProduction);
+	if (logBinary(site, sizeof(wchar_t) == 2 ? LOG_ARG::UTF16 : LOG_ARG::UTF32, message.data(), message.size() * sizeof(wchar_t)))
+	{
+		return;
+	}
+	logW(message.c_str(), message.size(), site);
 }
 
-void Logger::log(const SecureString& message, const char* file, int line, bool logInProduction)
+void Logger::log(const SecureString& message, LOG_SITE& site)
 {
-	logS(message.c_str(), file, line, logInProduction);
+	log(message.c_str(), site);
 }
 
-void Logger::log(const SecureWString& message, const char* file, int line, bool logInProduction)
+void Logger::log(const SecureWString& message, LOG_SITE& site)
 {
-	logW(message.c_str(), file, line, logInProduction);
+	log(message.c_str(), site);
 }
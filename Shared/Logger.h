@@ -19,49 +19,243 @@
 
 #pragma once
 #include "SecureString.h"
+#include "LogFormat.h"
+#include "LogRing.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
 
 #define __FILENAME__ (strrchr(__FILE__, '\\') ? strrchr(__FILE__, '\\') + 1 : __FILE__)
 
-#define ReleaseDebugPrint(message)	Logger::Get().log(message, __FILENAME__, __LINE__, true)
-#define DebugPrint(message)			Logger::Get().log(message, __FILENAME__, __LINE__, false)
-#define PrintLn(message)			Logger::Get().log(message, __FILENAME__, __LINE__, false)
+// Every call site has a constant LOG_SITE, the binary log refers to it by number
+#define LOG_AT_SITE(message, production) do { \
+		static LOG_SITE logSite = { __FILE__, __LINE__, production, { 0 }, nullptr }; \
+		Logger::Get().log(message, logSite); \
+	} while (0)
 
-// Singleton logger class that writes to a file on C: and to OutputDebugString
+// Uncategorized, their argument is built even if the line is discarded
+#define ReleaseDebugPrint(message)	LOG_AT_SITE(message, true)
+#define DebugPrint(message)			LOG_AT_SITE(message, false)
+#define PrintLn(message)			LOG_AT_SITE(message, false)
+
+#define LOG_LEVEL_OFF		0
+#define LOG_LEVEL_ERROR		1
+#define LOG_LEVEL_WARNING	2
+#define LOG_LEVEL_INFO		3
+#define LOG_LEVEL_DEBUG		4
+#define LOG_LEVEL_TRACE		5
+
+// Levels above this are not compiled in. Release builds keep what
+// ReleaseDebugPrint logged before, debug builds everything.
+#ifndef LOG_COMPILED_LEVEL
+#ifdef _DEBUG
+#define LOG_COMPILED_LEVEL LOG_LEVEL_TRACE
+#else
+#define LOG_COMPILED_LEVEL LOG_LEVEL_INFO
+#endif
+#endif
+
+// The message is only built if the category logs the level at runtime
+#define LOG_AT_LEVEL(category, level, message) do { \
+		if (Logger::Get().enabled(LOG_CATEGORY::category, level)) \
+		{ \
+			LOG_AT_SITE(message, true); \
+		} \
+	} while (0)
+
+// Nothing is evaluated, sizeof only keeps the variables of the message used
+#define LOG_COMPILED_OUT(message) do { (void)sizeof((message), 0); } while (0)
+
+// LogDebug(CREDENTIAL, L"User: " + username) and so on, the category is a LOG_CATEGORY name
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_ERROR
+#define LogError(category, message)		LOG_AT_LEVEL(category, LOG_LEVEL_ERROR, message)
+#else
+#define LogError(category, message)		LOG_COMPILED_OUT(message)
+#endif
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_WARNING
+#define LogWarning(category, message)	LOG_AT_LEVEL(category, LOG_LEVEL_WARNING, message)
+#else
+#define LogWarning(category, message)	LOG_COMPILED_OUT(message)
+#endif
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_INFO
+#define LogInfo(category, message)		LOG_AT_LEVEL(category, LOG_LEVEL_INFO, message)
+#else
+#define LogInfo(category, message)		LOG_COMPILED_OUT(message)
+#endif
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_DEBUG
+#define LogDebug(category, message)		LOG_AT_LEVEL(category, LOG_LEVEL_DEBUG, message)
+#else
+#define LogDebug(category, message)		LOG_COMPILED_OUT(message)
+#endif
+#if LOG_COMPILED_LEVEL >= LOG_LEVEL_TRACE
+#define LogTrace(category, message)		LOG_AT_LEVEL(category, LOG_LEVEL_TRACE, message)
+#else
+#define LogTrace(category, message)		LOG_COMPILED_OUT(message)
+#endif
+
+// Parts of the provider whose verbosity is set separately
+enum class LOG_CATEGORY
+{
+	PROVIDER = 0,		// CProvider and the configuration
+	CREDENTIAL = 1,		// CCredential
+	UTIL = 2,			// Utilities and Shared
+	FILTER = 3,			// CCredentialProviderFilter
+	KERB = 4,			// packing the Kerberos logon
+};
+
+#define LOG_CATEGORIES 5
+
+// A logging call site
+struct LOG_SITE
+{
+	const char* file;			// as the compiler names it, the log shows the file name only
+	int line;
+	bool production;			// also logged by a release build
+	std::atomic<uint32_t> id;	// number in the binary log, 0 until first logged there
+	LOG_SITE* next;				// sites with a number, newest first
+};
+
+// What the asynchronous mode writes
+enum class LOG_FORMAT
+{
+	TEXT = 0,		// the lines of the direct mode
+	BINARY = 1,		// LogFormat.h records, made readable by the LogDecoder tool
+};
+
+// What a producer does when the ring of the asynchronous mode is full
+enum class LOG_OVERFLOW
+{
+	DROP = 0,		// the line is counted and discarded, the caller never waits
+	BLOCK = 1,		// the caller waits until the writer made room
+};
+
+// Singleton logger class that writes to a file on C: and to OutputDebugString.
+// By default every line opens, appends to and closes the file on the calling
+// thread. In asynchronous mode the caller formats the line into a LogRing and
+// returns, a background writer appends whatever has accumulated in batches to
+// a file that stays open, so LogonUI threads never wait for the disk.
+// The binary format goes further: a call stores the number of its site, a
+// clock reading and its raw argument, without formatting a time, a prefix or
+// converting a wide string. It records the sites of DebugPrint, too.
 class Logger
 {
 public:
 	std::string logfilePathDebug = "C:\\DasCredentialProviderDebugLog.txt";
 	std::string logfilePathProduction = "C:\\DasCredentialProviderLog.txt";
+	std::string logfilePathBinary = "C:\\DasCredentialProviderLog.bin";
 
 	Logger(Logger const&) = delete;
 	void operator=(Logger const&) = delete;
 
+	// Never destroyed: a static destructor runs under the loader lock, where
+	// the writer thread cannot be joined. Configuration stops it with stopAsync().
 	static Logger& Get() {
-		static Logger instance;
-		return instance;
+		static Logger* instance = new Logger();
+		return *instance;
 	}
 
-	void log(const char* message, const char* file, int line, bool logInProduction);
+	void log(const char* message, LOG_SITE& site);
 
-	void log(const wchar_t* message, const char* file, int line, bool logInProduction);
+	void log(const wchar_t* message, LOG_SITE& site);
 
-	void log(const int message, const char* file, int line, bool logInProduction);
+	void log(const int message, LOG_SITE& site);
 
-	void log(const std::string& message, const char* file, int line, bool logInProduction);
+	void log(const std::string& message, LOG_SITE& site);
 
-	void log(const std::wstring& message, const char* file, int line, bool logInProduction);
+	void log(const std::wstring& message, LOG_SITE& site);
 
-	void log(const SecureString& message, const char* file, int line, bool logInProduction);
+	void log(const SecureString& message, LOG_SITE& site);
 
-	void log(const SecureWString& message, const char* file, int line, bool logInProduction);
+	void log(const SecureWString& message, LOG_SITE& site);
 
 	bool releaseLog = false;
 
+	// Verbosity of a category, LOG_LEVEL_OFF to LOG_LEVEL_TRACE. Starts at LOG_COMPILED_LEVEL.
+	void setVerbosity(LOG_CATEGORY category, int level) noexcept;
+
+	int verbosity(LOG_CATEGORY category) const noexcept;
+
+	// Whether a line of the level would be logged, checked before its message is built.
+	// A release build logs nothing unless releaseLog is on, in either format.
+	bool enabled(LOG_CATEGORY category, int level) const noexcept
+	{
+#ifndef _DEBUG
+		if (!releaseLog)
+		{
+			return false;
+		}
+#endif
+		return level <= _verbosity[static_cast<int>(category)].load(std::memory_order_relaxed);
+	}
+
+	// Switches to the asynchronous mode. Calls are counted, the mode ends with
+	// the last matching stopAsync(), the first one decides. capacity is in ring slots.
+	void startAsync(LOG_OVERFLOW overflow = LOG_OVERFLOW::DROP, LOG_FORMAT format = LOG_FORMAT::TEXT,
+		size_t capacity = 4096);
+
+	// Writes what is queued, stops the writer and closes the file once every
+	// startAsync() has been matched. Lines logged afterwards are written directly.
+	// Nothing else stops the writer, call it before the DLL is unloaded.
+	void stopAsync();
+
+	// Blocks until every line queued before the call is written
+	void flush();
+
+	// Lines discarded because the ring was full
+	unsigned long long dropped() const noexcept { return _dropped.load(std::memory_order_relaxed); }
+
 private:
-	Logger() = default;
+	Logger();
+	~Logger() = default;
+
+	// Hands a record to the writer, false if the asynchronous mode is off
+	bool push(const char* const* parts, const size_t* lengths, size_t count);
+
+	bool logAsync(const char* prefix, size_t prefixLength, const char* message, size_t length);
+
+	// false if the binary format is off
+	bool logBinary(LOG_SITE& site, LOG_ARG arg, const void* data, size_t length);
+
+	uint32_t siteId(LOG_SITE& site);
+
+	// Appends the SESSION record, or SITE records of sites from first to last, exclusive
+	void describeSession(std::string& out);
+	void describeSites(std::string& out, const LOG_SITE* first, const LOG_SITE* last);
+
+	void writerLoop();
+
+	void stopWriter();
+
+	void logS(const char* message, size_t length, LOG_SITE& site);
+
+	void logW(const wchar_t* message, size_t length, LOG_SITE& site);
 
-	void logS(const std::string& message, const char* file, int line, bool logInProduction);
+	// Asynchronous mode
+	std::unique_ptr<LogRing> _ring;
+	std::thread _writer;
+	std::mutex _control;				// serializes startAsync() and stopAsync()
+	std::mutex _mutex;					// for the waits below
+	std::condition_variable _wake;		// the writer waits for lines
+	std::condition_variable _space;		// blocked producers wait for room
+	std::atomic<bool> _async{ false };
+	std::atomic<bool> _binary{ false };			// _async in the binary format
+	std::atomic<bool> _writerSleeping{ false };
+	std::atomic<unsigned int> _producers{ 0 };	// producers between the _async check and their push
+	std::atomic<unsigned int> _blocked{ 0 };	// producers waiting for room
+	std::atomic<unsigned long long> _dropped{ 0 };
+	std::atomic<unsigned long long> _written{ 0 };	// ring positions the writer has written, for flush()
+	LOG_OVERFLOW _overflow = LOG_OVERFLOW::DROP;
+	LOG_FORMAT _format = LOG_FORMAT::TEXT;
+	std::atomic<LOG_SITE*> _sites{ nullptr };	// every site with a number
+	std::atomic<uint32_t> _lastSite{ 0 };
+	uint32_t _session = 0;
+	std::string _asyncPath;
+	unsigned int _asyncUsers = 0;
+	std::atomic<bool> _stop{ false };
 
-	void logW(const std::wstring& message, const char* file, int line, bool logInProduction);
+	std::atomic<int> _verbosity[LOG_CATEGORIES];
 };
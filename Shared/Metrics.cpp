@@ -0,0 +1,346 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Metrics.h"
+#ifdef _WIN32
+#include <Windows.h>
+#include <intrin.h>
+#endif
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+
+// Bucket of v >= 2^S, with b the index of its leading bit: the S bits from
+// b down give 2^(S-1) + the position in the octave, every octave after the
+// first 2^S values adds 2^(S-1) buckets.
+
+namespace
+{
+	const uint64_t LINEAR = 1ULL << HISTOGRAM_SUB_BITS;
+	const uint64_t HALF = LINEAR >> 1;
+	const uint64_t LARGEST = (1ULL << HISTOGRAM_MAX_BITS) - 1;
+
+	unsigned int LeadingBit(uint64_t value) noexcept
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanReverse64(&index, value);
+		return index;
+#else
+		return 63 - __builtin_clzll(value);
+#endif
+	}
+
+	// Microseconds as seconds, the base unit of Prometheus
+	void AppendSeconds(std::string& out, uint64_t micros)
+	{
+		char number[32];
+		snprintf(number, sizeof(number), "%llu.%06u", static_cast<unsigned long long>(micros / 1000000),
+			static_cast<unsigned int>(micros % 1000000));
+		out += number;
+	}
+
+	void AppendSample(std::string& out, const std::string& name, const std::string& labels, const char* extra)
+	{
+		out += name;
+		if (!labels.empty() || extra != nullptr)
+		{
+			out += '{';
+			out += labels;
+			if (extra != nullptr)
+			{
+				out += labels.empty() ? "" : ",";
+				out += extra;
+			}
+			out += '}';
+		}
+		out += ' ';
+	}
+}
+
+uint64_t HISTOGRAM_SNAPSHOT::Quantile(double q) const noexcept
+{
+	if (count == 0)
+	{
+		return 0;
+	}
+	q = q < 0 ? 0 : (q > 1 ? 1 : q);
+	uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(count)));
+	rank = rank == 0 ? 1 : rank;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < counts.size(); i++)
+	{
+		seen += counts[i];
+		if (seen >= rank)
+		{
+			return LatencyHistogram::UpperBound(i);
+		}
+	}
+	return LatencyHistogram::UpperBound(counts.size() - 1);
+}
+
+LatencyHistogram::LatencyHistogram() noexcept
+{
+	Reset();
+}
+
+void LatencyHistogram::Reset() noexcept
+{
+	for (std::atomic<uint64_t>& count : _counts)
+	{
+		count.store(0, std::memory_order_relaxed);
+	}
+	_sum.store(0, std::memory_order_relaxed);
+}
+
+size_t LatencyHistogram::Index(uint64_t value) noexcept
+{
+	if (value < LINEAR)
+	{
+		return static_cast<size_t>(value);
+	}
+	value = value < LARGEST ? value : LARGEST;
+	const unsigned int bit = LeadingBit(value);
+	const uint64_t sub = value >> (bit - (HISTOGRAM_SUB_BITS - 1));
+	return static_cast<size_t>(LINEAR + (bit - HISTOGRAM_SUB_BITS) * HALF + (sub - HALF));
+}
+
+uint64_t LatencyHistogram::UpperBound(size_t index) noexcept
+{
+	if (index < LINEAR)
+	{
+		return index;
+	}
+	const uint64_t above = index - LINEAR;
+	const unsigned int bit = static_cast<unsigned int>(HISTOGRAM_SUB_BITS + above / HALF);
+	const uint64_t sub = HALF + above % HALF;
+	return ((sub + 1) << (bit - (HISTOGRAM_SUB_BITS - 1))) - 1;
+}
+
+uint64_t LatencyHistogram::Now() noexcept
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+HISTOGRAM_SNAPSHOT LatencyHistogram::Snapshot() const
+{
+	HISTOGRAM_SNAPSHOT snapshot;
+	snapshot.counts.resize(HISTOGRAM_BUCKETS);
+	for (size_t i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		snapshot.counts[i] = _counts[i].load(std::memory_order_relaxed);
+		snapshot.count += snapshot.counts[i];
+	}
+	snapshot.sum = _sum.load(std::memory_order_relaxed);
+	return snapshot;
+}
+
+Metrics& Metrics::Get()
+{
+	// Never destroyed: a static destructor runs under the loader lock, where
+	// the dump thread cannot be joined. Configuration stops it with StopDump().
+	static Metrics* metrics = new Metrics();
+	return *metrics;
+}
+
+LatencyHistogram& Metrics::Register(const std::string& name, const std::string& help, const std::string& labels)
+{
+	std::lock_guard<std::mutex> lock(_registerMutex);
+	const size_t registered = _registered.load(std::memory_order_relaxed);
+	for (size_t i = 0; i < registered; i++)
+	{
+		if (_entries[i].name == name && _entries[i].labels == labels)
+		{
+			return _entries[i].histogram;
+		}
+	}
+	if (registered == METRICS_HISTOGRAMS)
+	{
+		return _discard;
+	}
+	ENTRY& entry = _entries[registered];
+	entry.name = name;
+	entry.help = help;
+	entry.labels = labels;
+	_registered.store(registered + 1, std::memory_order_release);
+	return entry.histogram;
+}
+
+std::string Metrics::Label(const std::string& name, const std::string& value)
+{
+	std::string label = name + "=\"";
+	for (char c : value)
+	{
+		if (c == '"' || c == '\\')
+		{
+			label += '\\';
+			label += c;
+		}
+		else if (c == '\n')
+		{
+			label += "\\n";
+		}
+		else
+		{
+			label += c;
+		}
+	}
+	return label + "\"";
+}
+
+std::string Metrics::Text() const
+{
+	static const double quantiles[] = METRICS_QUANTILES;
+	const size_t registered = _registered.load(std::memory_order_acquire);
+	std::string out;
+	out.reserve(registered * 512);
+	for (size_t i = 0; i < registered; i++)
+	{
+		const ENTRY& family = _entries[i];
+
+		// A family is written where its name is first registered, HELP and
+		// TYPE once with the first help text, then all of its label sets
+		bool first = true;
+		for (size_t j = 0; j < i && first; j++)
+		{
+			first = _entries[j].name != family.name;
+		}
+		if (!first)
+		{
+			continue;
+		}
+		out += "# HELP " + family.name + " " + family.help + "\n";
+		out += "# TYPE " + family.name + " summary\n";
+
+		for (size_t j = i; j < registered; j++)
+		{
+			const ENTRY& entry = _entries[j];
+			if (entry.name != family.name)
+			{
+				continue;
+			}
+			const HISTOGRAM_SNAPSHOT snapshot = entry.histogram.Snapshot();
+			for (double q : quantiles)
+			{
+				char label[32];
+				snprintf(label, sizeof(label), "quantile=\"%g\"", q);
+				AppendSample(out, entry.name, entry.labels, label);
+				AppendSeconds(out, snapshot.Quantile(q));
+				out += '\n';
+			}
+			AppendSample(out, entry.name + "_sum", entry.labels, nullptr);
+			AppendSeconds(out, snapshot.sum);
+			out += '\n';
+			AppendSample(out, entry.name + "_count", entry.labels, nullptr);
+			out += std::to_string(snapshot.count);
+			out += '\n';
+		}
+	}
+	return out;
+}
+
+bool Metrics::Write(const std::string& path) const
+{
+	const std::string text = Text();
+	const std::string temporary = path + ".tmp";
+#ifdef _WIN32
+	const int units = MultiByteToWideChar(CP_UTF8, 0, temporary.c_str(), -1, nullptr, 0);
+	if (units <= 0)
+	{
+		return false;
+	}
+	std::wstring wideTemporary(static_cast<size_t>(units), L'\0');
+	MultiByteToWideChar(CP_UTF8, 0, temporary.c_str(), -1, &wideTemporary[0], units);
+	wideTemporary.resize(static_cast<size_t>(units) - 1);
+	const std::wstring widePath = wideTemporary.substr(0, wideTemporary.size() - 4);
+	{
+		std::ofstream file(wideTemporary.c_str(), std::ios::binary | std::ios::trunc);
+		file << text;
+		if (!file.flush())
+		{
+			return false;
+		}
+	}
+	return MoveFileExW(wideTemporary.c_str(), widePath.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	{
+		std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+		file << text;
+		if (!file.flush())
+		{
+			return false;
+		}
+	}
+	return std::rename(temporary.c_str(), path.c_str()) == 0;
+#endif
+}
+
+void Metrics::StartDump(const std::string& path, unsigned int intervalMs)
+{
+	std::lock_guard<std::mutex> control(_control);
+	if (_dumpUsers++ > 0)
+	{
+		return;
+	}
+	try
+	{
+		_dumpPath = path;
+		_dumpIntervalMs = intervalMs > 0 ? intervalMs : 1;
+		_dumpStop = false;
+		_dumper = std::thread(&Metrics::dumpLoop, this);
+	}
+	catch (...)
+	{
+		// No memory or thread, the histograms still record
+		_dumpUsers = 0;
+	}
+}
+
+void Metrics::StopDump()
+{
+	std::lock_guard<std::mutex> control(_control);
+	if (_dumpUsers == 0 || --_dumpUsers > 0)
+	{
+		return;
+	}
+	if (_dumper.joinable())
+	{
+		{
+			std::lock_guard<std::mutex> lock(_dumpMutex);
+			_dumpStop = true;
+			_dumpWake.notify_one();
+		}
+		_dumper.join();
+	}
+}
+
+void Metrics::dumpLoop()
+{
+	std::unique_lock<std::mutex> lock(_dumpMutex);
+	while (!_dumpStop)
+	{
+		_dumpWake.wait_for(lock, std::chrono::milliseconds(_dumpIntervalMs));
+		lock.unlock();
+		Write(_dumpPath);
+		lock.lock();
+	}
+}
@@ -0,0 +1,172 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Values below 2^HISTOGRAM_SUB_BITS have a bucket each, above that every
+// power of two is split into 2^(HISTOGRAM_SUB_BITS - 1) buckets: 3.1 % error
+#define HISTOGRAM_SUB_BITS 6
+// Largest value kept apart, larger ones count as this: 2^36 us, 19 hours
+#define HISTOGRAM_MAX_BITS 36
+#define HISTOGRAM_BUCKETS ((1 << HISTOGRAM_SUB_BITS) + (HISTOGRAM_MAX_BITS - HISTOGRAM_SUB_BITS) * (1 << (HISTOGRAM_SUB_BITS - 1)))
+
+// Histograms Metrics holds, registering more gives a histogram that is not dumped
+#define METRICS_HISTOGRAMS 32
+// Quantiles written for every histogram
+#define METRICS_QUANTILES { 0.5, 0.9, 0.99, 0.999, 1.0 }
+
+// Copy of a LatencyHistogram, for reading
+struct HISTOGRAM_SNAPSHOT
+{
+	std::vector<uint64_t> counts;	// per bucket
+	uint64_t count = 0;
+	uint64_t sum = 0;				// microseconds
+
+	// Highest value of the bucket holding quantile q, 0 to 1. 0 if empty.
+	uint64_t Quantile(double q) const noexcept;
+};
+
+// Log-linear (HDR-style) histogram of latencies in microseconds. Recording
+// is a bucket index from the leading bit and two relaxed fetch_add, wait-free
+// and without allocation, from any number of threads.
+class LatencyHistogram
+{
+public:
+	LatencyHistogram() noexcept;
+
+	LatencyHistogram(const LatencyHistogram&) = delete;
+	LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+	void Record(uint64_t micros) noexcept
+	{
+		_counts[Index(micros)].fetch_add(1, std::memory_order_relaxed);
+		_sum.fetch_add(micros, std::memory_order_relaxed);
+	}
+
+	// Counts taken one by one, a recording in between may be in the sum but not the buckets
+	HISTOGRAM_SNAPSHOT Snapshot() const;
+
+	void Reset() noexcept;
+
+	static size_t Index(uint64_t value) noexcept;
+
+	// Highest value that falls into bucket index
+	static uint64_t UpperBound(size_t index) noexcept;
+
+	// Steady clock in microseconds
+	static uint64_t Now() noexcept;
+
+private:
+	std::atomic<uint64_t> _counts[HISTOGRAM_BUCKETS];
+	std::atomic<uint64_t> _sum;
+};
+
+// Records the time from construction to destruction
+class LatencyTimer
+{
+public:
+	explicit LatencyTimer(LatencyHistogram& histogram) noexcept
+		: _histogram(histogram), _start(LatencyHistogram::Now())
+	{
+	}
+
+	~LatencyTimer()
+	{
+		_histogram.Record(LatencyHistogram::Now() - _start);
+	}
+
+	LatencyTimer(const LatencyTimer&) = delete;
+	LatencyTimer& operator=(const LatencyTimer&) = delete;
+
+private:
+	LatencyHistogram& _histogram;
+	const uint64_t _start;
+};
+
+// The histograms of the process, written as Prometheus text (summaries in
+// seconds) to a file that a monitoring agent scrapes, e.g. the textfile
+// collector of windows_exporter. The file is replaced as a whole, a scrape
+// never sees half of it.
+class Metrics
+{
+public:
+	Metrics(const Metrics&) = delete;
+	void operator=(const Metrics&) = delete;
+
+	static Metrics& Get();
+
+	// Returns the histogram of name and labels, created on first use. labels
+	// is Prometheus syntax without braces, endpoint="a", or empty. Takes a
+	// lock and may allocate, call it before the logon path needs the histogram.
+	LatencyHistogram& Register(const std::string& name, const std::string& help, const std::string& labels);
+
+	// name="value" with value escaped, for the labels of Register()
+	static std::string Label(const std::string& name, const std::string& value);
+
+	// The Prometheus text of every registered histogram
+	std::string Text() const;
+
+	// Writes Text() to path, a UTF-8 path, through a temporary file. false on an I/O error.
+	bool Write(const std::string& path) const;
+
+	// Writes to path every intervalMs on a background thread. Calls are
+	// counted like Logger::startAsync, the first one decides.
+	void StartDump(const std::string& path, unsigned int intervalMs);
+
+	// Writes a last time and stops the thread once every StartDump() has been
+	// matched. Nothing else stops it, call it before the DLL is unloaded.
+	void StopDump();
+
+private:
+	Metrics() = default;
+	~Metrics() = default;
+
+	void dumpLoop();
+
+	struct ENTRY
+	{
+		std::string name;
+		std::string help;
+		std::string labels;
+		LatencyHistogram histogram;
+	};
+
+	ENTRY _entries[METRICS_HISTOGRAMS];
+	std::atomic<size_t> _registered{ 0 };	// entries with a name, published after their name is set
+	LatencyHistogram _discard;				// handed out when the entries are used up
+	std::mutex _registerMutex;
+
+	std::thread _dumper;
+	std::mutex _dumpMutex;
+	std::condition_variable _dumpWake;
+	bool _dumpStop = false;
+	std::string _dumpPath;
+	unsigned int _dumpIntervalMs = 0;
+	unsigned int _dumpUsers = 0;
+	std::mutex _control;					// serializes StartDump() and StopDump()
+};
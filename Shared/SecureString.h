@@ -2,7 +2,16 @@
 #include <algorithm>
 #include <memory>
 #include <string>
+#ifdef _WIN32
 #include <Windows.h>
+#else
+// The platform neutral libraries (otp, daemon) and their tools build on Linux too
+inline void* SecureZeroMemory(void* ptr, std::size_t cnt) {
+	volatile unsigned char* p = static_cast<volatile unsigned char*>(ptr);
+	while (cnt--) *p++ = 0;
+	return ptr;
+}
+#endif
 
 template <typename T> struct allocator {
 	using value_type = T;
@@ -39,14 +48,14 @@ using SecureWString = std::basic_string<wchar_t, std::char_traits<wchar_t>,
 
 namespace std {
 	// Zero the strings own memory on destruction
-	template<> SecureString::~basic_string() {
+	template<> inline SecureString::~basic_string() {
 		using X = basic_string<char, char_traits<char>,
 			::allocator<unsigned char>>;
 		((X*)this)->~X();
 		SecureZeroMemory(this, sizeof * this);
 	}
 
-	template<> SecureWString::~basic_string() {
+	template<> inline SecureWString::~basic_string() {
 		using X = basic_string<wchar_t, char_traits<wchar_t>,
 			::allocator<unsigned char>>;
 		((X*)this)->~X();
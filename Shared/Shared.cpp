@@ -25,10 +25,10 @@
 namespace Shared {
 	bool IsRequiredForScenario(CREDENTIAL_PROVIDER_USAGE_SCENARIO cpus, int caller)
 	{
-		DebugPrint(__FUNCTION__);
+		LogTrace(UTIL, __FUNCTION__);
 		if (caller != FILTER && caller != PROVIDER)
 		{
-			DebugPrint("Invalid argument for caller: " + std::to_string(caller));
+			LogDebug(UTIL, "Invalid argument for caller: " + std::to_string(caller));
 			return false;
 		}
 
@@ -53,7 +53,7 @@ namespace Shared {
 	bool IsCurrentSessionRemote()
 	{
 		bool fIsRemoteable = false;
-		DebugPrint("check for remote session...");
+		LogDebug(UTIL, "check for remote session...");
 		if (GetSystemMetrics(SM_REMOTESESSION))
 		{
 			fIsRemoteable = true;
@@ -103,7 +103,7 @@ namespace Shared {
 			}
 		}
 
-		DebugPrint(fIsRemoteable ? "session is remote" : "session is not remote");
+		LogDebug(UTIL, fIsRemoteable ? "session is remote" : "session is not remote");
 
 		return fIsRemoteable;
 	}
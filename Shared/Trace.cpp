@@ -0,0 +1,191 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Trace.h"
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+#include <chrono>
+#include <cstdio>
+
+// A writer of position p stores sequence 2p + 1, the fields, then 2p + 2.
+// A reader wants 2p + 2 before and after copying the fields. Two writers
+// share a slot only if one of them is a whole ring behind, the reader then
+// sees a different sequence and skips the slot.
+
+namespace
+{
+	uint64_t RoundUp(size_t capacity)
+	{
+		uint64_t size = 16;
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		return size;
+	}
+
+	uint32_t ThreadId() noexcept
+	{
+		thread_local uint32_t id = 0;
+		if (id == 0)
+		{
+#ifdef _WIN32
+			id = GetCurrentThreadId();
+#else
+			id = static_cast<uint32_t>(syscall(SYS_gettid));
+#endif
+		}
+		return id;
+	}
+
+	uint32_t ProcessId() noexcept
+	{
+#ifdef _WIN32
+		return GetCurrentProcessId();
+#else
+		return static_cast<uint32_t>(getpid());
+#endif
+	}
+
+	void AppendEscaped(std::string& out, const char* text)
+	{
+		for (const char* p = text; *p != '\0'; p++)
+		{
+			const unsigned char c = static_cast<unsigned char>(*p);
+			if (c == '"' || c == '\\')
+			{
+				out += '\\';
+				out += static_cast<char>(c);
+			}
+			else if (c < 0x20)
+			{
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out += escaped;
+			}
+			else
+			{
+				out += static_cast<char>(c);
+			}
+		}
+	}
+
+	// Nanoseconds as microseconds with three decimals, the unit of the format
+	void AppendMicros(std::string& out, uint64_t nanos)
+	{
+		char number[32];
+		snprintf(number, sizeof(number), "%llu.%03u", static_cast<unsigned long long>(nanos / 1000),
+			static_cast<unsigned int>(nanos % 1000));
+		out += number;
+	}
+}
+
+Tracer::Tracer(size_t capacity)
+	: _mask(RoundUp(capacity) - 1)
+{
+	_slots.reset(new SLOT[_mask + 1]);
+	for (uint64_t i = 0; i <= _mask; i++)
+	{
+		_slots[i].sequence.store(0, std::memory_order_relaxed);
+		_slots[i].name.store(nullptr, std::memory_order_relaxed);
+		_slots[i].begin.store(0, std::memory_order_relaxed);
+		_slots[i].duration.store(0, std::memory_order_relaxed);
+		_slots[i].thread.store(0, std::memory_order_relaxed);
+	}
+}
+
+Tracer& Tracer::Get()
+{
+	static Tracer tracer(TRACE_RING_EVENTS);
+	return tracer;
+}
+
+uint64_t Tracer::Now() noexcept
+{
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::Record(const char* name, uint64_t begin, uint64_t end) noexcept
+{
+	const uint64_t position = _next.fetch_add(1, std::memory_order_relaxed);
+	SLOT& slot = _slots[position & _mask];
+	slot.sequence.store(2 * position + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.name.store(name, std::memory_order_relaxed);
+	slot.begin.store(begin, std::memory_order_relaxed);
+	slot.duration.store(end > begin ? end - begin : 0, std::memory_order_relaxed);
+	slot.thread.store(ThreadId(), std::memory_order_relaxed);
+	slot.sequence.store(2 * position + 2, std::memory_order_release);
+}
+
+std::vector<TRACE_EVENT> Tracer::Snapshot() const
+{
+	const uint64_t next = _next.load(std::memory_order_acquire);
+	const uint64_t first = next > _mask + 1 ? next - (_mask + 1) : 0;
+	std::vector<TRACE_EVENT> events;
+	events.reserve(static_cast<size_t>(next - first));
+	for (uint64_t position = first; position < next; position++)
+	{
+		const SLOT& slot = _slots[position & _mask];
+		const uint64_t done = 2 * position + 2;
+		if (slot.sequence.load(std::memory_order_acquire) != done)
+		{
+			continue;	// still being written, or already overwritten
+		}
+		TRACE_EVENT event;
+		event.name = slot.name.load(std::memory_order_relaxed);
+		event.begin = slot.begin.load(std::memory_order_relaxed);
+		event.duration = slot.duration.load(std::memory_order_relaxed);
+		event.thread = slot.thread.load(std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.sequence.load(std::memory_order_relaxed) == done && event.name != nullptr)
+		{
+			events.push_back(event);
+		}
+	}
+	return events;
+}
+
+std::string Tracer::ChromeJson() const
+{
+	const std::vector<TRACE_EVENT> events = Snapshot();
+	const std::string pid = std::to_string(ProcessId());
+	std::string out;
+	out.reserve(128 + events.size() * 128);
+	out += "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	out += "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" + pid + ",\"args\":{\"name\":\"DasCredentialProvider\"}}";
+	for (const TRACE_EVENT& event : events)
+	{
+		out += ",\n{\"name\":\"";
+		AppendEscaped(out, event.name);
+		out += "\",\"cat\":\"logon\",\"ph\":\"X\",\"ts\":";
+		AppendMicros(out, event.begin);
+		out += ",\"dur\":";
+		AppendMicros(out, event.duration);
+		out += ",\"pid\":" + pid + ",\"tid\":" + std::to_string(event.thread) + "}";
+	}
+	out += "\n]}\n";
+	return out;
+}
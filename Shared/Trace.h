@@ -0,0 +1,123 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Spans the ring of the process keeps, the oldest are overwritten
+#define TRACE_RING_EVENTS 4096
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// Traces the rest of the enclosing scope as one span. name must outlive the
+// process, a literal or __FUNCTION__.
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(Tracer::Get(), name)
+
+// A finished span, times in steady clock nanoseconds
+struct TRACE_EVENT
+{
+	const char* name;
+	uint64_t begin;
+	uint64_t duration;
+	uint32_t thread;
+};
+
+// Fixed ring of spans for a timeline of the LogonUI calls. Recording claims
+// a slot with one fetch_add and writes it under a per-slot sequence number,
+// no lock and no allocation. A reader copies a slot and keeps it only if the
+// sequence number was the same before and after, so a snapshot taken while
+// spans are recorded never holds a torn one. Off, a span costs one load.
+class Tracer
+{
+public:
+	// capacity in spans, rounded up to a power of two
+	explicit Tracer(size_t capacity);
+
+	Tracer(const Tracer&) = delete;
+	Tracer& operator=(const Tracer&) = delete;
+
+	// The ring of the process, TRACE_RING_EVENTS spans, off until Enable(true)
+	static Tracer& Get();
+
+	void Enable(bool enabled) noexcept { _enabled.store(enabled, std::memory_order_relaxed); }
+
+	bool Enabled() const noexcept { return _enabled.load(std::memory_order_relaxed); }
+
+	static uint64_t Now() noexcept;
+
+	// Adds a span of the calling thread. Safe to call from any number of threads.
+	void Record(const char* name, uint64_t begin, uint64_t end) noexcept;
+
+	// Spans in the ring, oldest first
+	std::vector<TRACE_EVENT> Snapshot() const;
+
+	// Spans recorded since construction, including overwritten ones
+	uint64_t Recorded() const noexcept { return _next.load(std::memory_order_relaxed); }
+
+	// Chrome trace-event JSON of Snapshot(), for chrome://tracing or Perfetto
+	std::string ChromeJson() const;
+
+private:
+	struct SLOT
+	{
+		std::atomic<uint64_t> sequence;		// 2 * position + 1 while written, + 2 when done
+		std::atomic<const char*> name;
+		std::atomic<uint64_t> begin;
+		std::atomic<uint64_t> duration;
+		std::atomic<uint32_t> thread;
+	};
+
+	std::unique_ptr<SLOT[]> _slots;
+	const uint64_t _mask;
+	std::atomic<uint64_t> _next{ 0 };
+	std::atomic<bool> _enabled{ false };
+};
+
+// Records the span from construction to destruction if the tracer was on at the start
+class TraceSpan
+{
+public:
+	TraceSpan(Tracer& tracer, const char* name) noexcept
+		: _tracer(tracer), _name(tracer.Enabled() ? name : nullptr), _begin(_name != nullptr ? Tracer::Now() : 0)
+	{
+	}
+
+	~TraceSpan()
+	{
+		if (_name != nullptr)
+		{
+			_tracer.Record(_name, _begin, Tracer::Now());
+		}
+	}
+
+	TraceSpan(const TraceSpan&) = delete;
+	TraceSpan& operator=(const TraceSpan&) = delete;
+
+private:
+	Tracer& _tracer;
+	const char* const _name;
+	const uint64_t _begin;
+};
@@ -0,0 +1,306 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Utf8.h"
+
+#if UTF8_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+namespace
+{
+	struct SHUFFLE_TABLE
+	{
+		Utf8::SHUFFLE entries[256];
+	};
+
+	// Unit i of 8 sits in bytes 2i (lead or ASCII) and 2i + 1 (continuation)
+	constexpr SHUFFLE_TABLE BuildTwoByteShuffles()
+	{
+		SHUFFLE_TABLE table{};
+		for (int mask = 0; mask < 256; mask++)
+		{
+			Utf8::SHUFFLE& entry = table.entries[mask];
+			int n = 0;
+			for (int i = 0; i < 8; i++)
+			{
+				entry.bytes[n++] = static_cast<uint8_t>(2 * i);
+				if ((mask & (1 << i)) != 0)
+				{
+					entry.bytes[n++] = static_cast<uint8_t>(2 * i + 1);
+				}
+			}
+			entry.length = static_cast<uint8_t>(n);
+			for (; n < 16; n++)
+			{
+				entry.bytes[n] = 0x80;
+			}
+		}
+		return table;
+	}
+
+	// Unit i of 4 sits in bytes 4i to 4i + 2, the lead byte first
+	constexpr SHUFFLE_TABLE BuildThreeByteShuffles()
+	{
+		SHUFFLE_TABLE table{};
+		for (int index = 0; index < 256; index++)
+		{
+			Utf8::SHUFFLE& entry = table.entries[index];
+			int n = 0;
+			for (int i = 0; i < 4; i++)
+			{
+				const int extra = (index >> (2 * i)) & 3;
+				for (int j = 0; j <= extra && j < 3; j++)
+				{
+					entry.bytes[n++] = static_cast<uint8_t>(4 * i + j);
+				}
+			}
+			entry.length = static_cast<uint8_t>(n);
+			for (; n < 16; n++)
+			{
+				entry.bytes[n] = 0x80;
+			}
+		}
+		return table;
+	}
+
+	constexpr SHUFFLE_TABLE twoByteShuffles = BuildTwoByteShuffles();
+	constexpr SHUFFLE_TABLE threeByteShuffles = BuildThreeByteShuffles();
+
+	inline void Put(char*& out, uint32_t c) noexcept
+	{
+		if (c < 0x80)
+		{
+			*out++ = static_cast<char>(c);
+		}
+		else if (c < 0x800)
+		{
+			*out++ = static_cast<char>(0xC0 | (c >> 6));
+			*out++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else if (c < 0x10000)
+		{
+			*out++ = static_cast<char>(0xE0 | (c >> 12));
+			*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+		else
+		{
+			*out++ = static_cast<char>(0xF0 | (c >> 18));
+			*out++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			*out++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*out++ = static_cast<char>(0x80 | (c & 0x3F));
+		}
+	}
+
+#if UTF8_X86
+	void CpuId(int leaf, int subleaf, unsigned int regs[4]) noexcept
+	{
+#if defined(_MSC_VER)
+		int info[4];
+		__cpuidex(info, leaf, subleaf);
+		for (int i = 0; i < 4; i++)
+		{
+			regs[i] = static_cast<unsigned int>(info[i]);
+		}
+#else
+		__cpuid_count(leaf, subleaf, regs[0], regs[1], regs[2], regs[3]);
+#endif
+	}
+
+	unsigned long long ReadXcr0() noexcept
+	{
+#if defined(_MSC_VER)
+		return _xgetbv(0);
+#else
+		unsigned int eax, edx;
+		__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+		return (static_cast<unsigned long long>(edx) << 32) | eax;
+#endif
+	}
+#endif
+
+	UTF8_KERNEL Detect() noexcept
+	{
+#if UTF8_X86
+		unsigned int regs[4];
+		CpuId(0, 0, regs);
+		const unsigned int maxLeaf = regs[0];
+
+		CpuId(1, 0, regs);
+		const bool sse4 = (regs[2] & (1u << 19)) != 0 && (regs[2] & (1u << 9)) != 0;	// SSE4.1 and SSSE3
+		const bool osxsave = (regs[2] & (1u << 27)) != 0;
+
+		bool avx2 = false;
+		if (maxLeaf >= 7 && osxsave)
+		{
+			// The OS must save the YMM state
+			const unsigned long long xcr0 = ReadXcr0();
+			CpuId(7, 0, regs);
+			avx2 = (regs[1] & (1u << 5)) != 0 && (xcr0 & 0x06) == 0x06;
+		}
+
+		if (avx2 && sse4)
+		{
+			return UTF8_KERNEL::AVX2;
+		}
+		if (sse4)
+		{
+			return UTF8_KERNEL::SSE4;
+		}
+#endif
+		return UTF8_KERNEL::SCALAR;
+	}
+}
+
+namespace Utf8
+{
+	UTF8_KERNEL ActiveKernel() noexcept
+	{
+		static const UTF8_KERNEL kernel = Detect();
+		return kernel;
+	}
+
+	bool IsSupported(UTF8_KERNEL kernel) noexcept
+	{
+		return static_cast<int>(kernel) <= static_cast<int>(ActiveKernel());
+	}
+
+	const char* KernelName(UTF8_KERNEL kernel) noexcept
+	{
+		switch (kernel)
+		{
+		case UTF8_KERNEL::SSE4:
+			return "sse4";
+		case UTF8_KERNEL::AVX2:
+			return "avx2";
+		case UTF8_KERNEL::SCALAR:
+		default:
+			return "scalar";
+		}
+	}
+
+	const SHUFFLE* TwoByteShuffles() noexcept
+	{
+		return twoByteShuffles.entries;
+	}
+
+	const SHUFFLE* ThreeByteShuffles() noexcept
+	{
+		return threeByteShuffles.entries;
+	}
+
+	size_t EncodeScalar(const char16_t* in, size_t start, size_t end, size_t length, char*& out) noexcept
+	{
+		size_t i = start;
+		while (i < end)
+		{
+			uint32_t c = in[i++];
+			if ((c & 0xF800) == 0xD800)
+			{
+				const uint32_t low = i < length ? in[i] : 0;
+				if (c <= 0xDBFF && low >= 0xDC00 && low <= 0xDFFF)
+				{
+					c = 0x10000 + ((c - 0xD800) << 10) + (low - 0xDC00);
+					i++;
+				}
+				else
+				{
+					c = 0xFFFD;
+				}
+			}
+			Put(out, c);
+		}
+		return i;
+	}
+
+	size_t FromUtf16(UTF8_KERNEL kernel, const char16_t* in, size_t length, char* out) noexcept
+	{
+		char* p = out;
+		size_t i = 0;
+#if UTF8_X86
+		if (kernel == UTF8_KERNEL::AVX2 && IsSupported(UTF8_KERNEL::AVX2))
+		{
+			i = FromUtf16Avx2(in, length, p);
+		}
+		else if (kernel != UTF8_KERNEL::SCALAR && IsSupported(UTF8_KERNEL::SSE4))
+		{
+			i = FromUtf16Sse4(in, length, p);
+		}
+#else
+		(void)kernel;
+#endif
+		EncodeScalar(in, i, length, length, p);
+		return static_cast<size_t>(p - out);
+	}
+
+	size_t FromUtf16(const char16_t* in, size_t length, char* out) noexcept
+	{
+		return FromUtf16(ActiveKernel(), in, length, out);
+	}
+
+	size_t FromUtf32(const char32_t* in, size_t length, char* out) noexcept
+	{
+		char* p = out;
+		for (size_t i = 0; i < length; i++)
+		{
+			uint32_t c = in[i];
+			if (c > 0x10FFFF || (c & 0xFFFFF800) == 0xD800)
+			{
+				c = 0xFFFD;
+			}
+			Put(p, c);
+		}
+		return static_cast<size_t>(p - out);
+	}
+
+	size_t FromWide(const wchar_t* in, size_t length, char* out) noexcept
+	{
+		if (sizeof(wchar_t) == 2)
+		{
+			return FromUtf16(reinterpret_cast<const char16_t*>(in), length, out);
+		}
+		return FromUtf32(reinterpret_cast<const char32_t*>(in), length, out);
+	}
+
+	const char* FromWide(const wchar_t* in, size_t length, size_t& outLength)
+	{
+		thread_local std::string buffer;
+		const size_t needed = MaxBytesWide(length) + 1;
+		if (buffer.size() < needed)
+		{
+			buffer.resize(needed);
+		}
+		outLength = FromWide(in, length, &buffer[0]);
+		buffer[outLength] = '\0';
+		return buffer.c_str();
+	}
+
+	std::string FromWide(const wchar_t* in, size_t length)
+	{
+		std::string out(MaxBytesWide(length), '\0');
+		out.resize(FromWide(in, length, &out[0]));
+		return out;
+	}
+}
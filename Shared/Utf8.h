@@ -0,0 +1,101 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define UTF8_X86 1
+#else
+#define UTF8_X86 0
+#endif
+
+enum class UTF8_KERNEL
+{
+	SCALAR = 0,
+	SSE4 = 1,		// 8 code units per step, SSE4.1
+	AVX2 = 2,		// 16 code units per step while they are ASCII
+};
+
+// UTF-16 to UTF-8 without allocations and without failing: an unpaired
+// surrogate becomes U+FFFD. The SIMD kernels take 8 or 16 code units at a
+// time. Runs of ASCII are packed to bytes. Blocks below U+0800 are encoded
+// in all lanes at once and compacted with a byte shuffle. Blocks with
+// surrogates, rare in names and log lines, take the scalar path.
+namespace Utf8
+{
+	// Bytes out needs for length UTF-16 code units
+	inline size_t MaxBytes(size_t length) noexcept { return length * 3; }
+
+	// Same for length wchar_t, UTF-16 on Windows and UTF-32 elsewhere
+	inline size_t MaxBytesWide(size_t length) noexcept { return length * (sizeof(wchar_t) == 2 ? 3 : 4); }
+
+	// Widest kernel supported by both CPU and OS, detected once per process
+	UTF8_KERNEL ActiveKernel() noexcept;
+
+	bool IsSupported(UTF8_KERNEL kernel) noexcept;
+
+	const char* KernelName(UTF8_KERNEL kernel) noexcept;
+
+	// Converts length code units into out, which holds MaxBytes(length). Returns the bytes written.
+	size_t FromUtf16(const char16_t* in, size_t length, char* out) noexcept;
+
+	// Same with a fixed kernel, falls back to scalar if the kernel is not supported
+	size_t FromUtf16(UTF8_KERNEL kernel, const char16_t* in, size_t length, char* out) noexcept;
+
+	// UTF-32 to UTF-8, out holds 4 * length bytes
+	size_t FromUtf32(const char32_t* in, size_t length, char* out) noexcept;
+
+	// wchar_t to UTF-8, out holds MaxBytesWide(length)
+	size_t FromWide(const wchar_t* in, size_t length, char* out) noexcept;
+
+	// Converts into a buffer of the calling thread and returns it. The text
+	// stays valid until the thread converts again.
+	const char* FromWide(const wchar_t* in, size_t length, size_t& outLength);
+
+	std::string FromWide(const wchar_t* in, size_t length);
+
+	inline std::string FromWide(const std::wstring& in) { return FromWide(in.c_str(), in.size()); }
+
+	// Scalar conversion of in[start..end), a pair straddling end is taken
+	// whole. Returns where the next conversion starts.
+	size_t EncodeScalar(const char16_t* in, size_t start, size_t end, size_t length, char*& out) noexcept;
+
+	// Kernels, they convert as many whole blocks as they can and return the
+	// code units consumed, the caller converts the rest
+	size_t FromUtf16Sse4(const char16_t* in, size_t length, char*& out) noexcept;
+
+	size_t FromUtf16Avx2(const char16_t* in, size_t length, char*& out) noexcept;
+
+	// Shuffle tables of the kernels, built at compile time
+	struct SHUFFLE
+	{
+		uint8_t bytes[16];
+		uint8_t length;
+	};
+
+	// 256 entries, bit i set: unit i of 8 takes 2 bytes instead of 1
+	const SHUFFLE* TwoByteShuffles() noexcept;
+
+	// 256 entries, bits 2i and 2i + 1: unit i of 4 takes that many bytes more than 1
+	const SHUFFLE* ThreeByteShuffles() noexcept;
+}
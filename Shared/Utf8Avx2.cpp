@@ -0,0 +1,79 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Utf8.h"
+
+#if UTF8_X86
+
+// MSVC accepts AVX2 intrinsics without /arch, GCC and Clang need the target
+// enabled for this translation unit only. The kernel is only called after
+// Utf8::IsSupported has checked the CPU.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("avx2"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("avx2")
+#endif
+
+#include "Utf8Kernel.h"
+
+size_t Utf8::FromUtf16Avx2(const char16_t* in, size_t length, char*& out) noexcept
+{
+	const SHUFFLE* twoByteShuffles = TwoByteShuffles();
+	const SHUFFLE* threeByteShuffles = ThreeByteShuffles();
+	const __m256i notAscii = _mm256_set1_epi16(static_cast<short>(0xFF80));
+	size_t i = 0;
+	bool wide = true;
+	while (i + 8 <= length)
+	{
+		// 16 units of ASCII at once while the text is ASCII. After a miss the
+		// blocks of 8 go on until one of them is ASCII again, a 256-bit test
+		// per block costs more than it saves in names and CJK text.
+		if (wide && i + 16 <= length)
+		{
+			const __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+			if (_mm256_testz_si256(units, notAscii))
+			{
+				const __m128i bytes = _mm_packus_epi16(_mm256_castsi256_si128(units), _mm256_extracti128_si256(units, 1));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+				out += 16;
+				i += 16;
+				continue;
+			}
+		}
+		const char* before = out;
+		if (EncodeBlock(in + i, out, i + 12 <= length, twoByteShuffles, threeByteShuffles))
+		{
+			i += 8;
+			wide = out - before == 8;
+		}
+		else
+		{
+			i = EncodeScalar(in, i, i + 8, length, out);
+			wide = false;
+		}
+	}
+	return i;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
@@ -0,0 +1,101 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Block conversion of 8 UTF-16 code units with SSE4.1. Included by the kernel
+// translation units after they enabled their target, so the same code is
+// compiled once for SSE4.1 and once with the VEX encoding of AVX2.
+
+#include <immintrin.h>
+
+namespace
+{
+	// 4 units of 1 to 3 bytes, zero-extended to 32 bits. Writes 16 bytes, advances by the bytes used.
+	inline void EncodeHalf(__m128i c, char*& out, const Utf8::SHUFFLE* shuffles)
+	{
+		const __m128i low6 = _mm_set1_epi32(0x3F);
+		const __m128i continuation = _mm_set1_epi32(0x80);
+		const __m128i twoBytes = _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7F));
+		const __m128i threeBytes = _mm_cmpgt_epi32(c, _mm_set1_epi32(0x7FF));
+
+		const __m128i last = _mm_or_si128(_mm_and_si128(c, low6), continuation);
+		const __m128i middle = _mm_or_si128(_mm_and_si128(_mm_srli_epi32(c, 6), low6), continuation);
+
+		// Lead byte first, the shuffle keeps bytes 4i to 4i + length - 1
+		const __m128i word2 = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(c, 6), _mm_set1_epi32(0xC0)), _mm_slli_epi32(last, 8));
+		const __m128i word3 = _mm_or_si128(_mm_or_si128(_mm_srli_epi32(c, 12), _mm_set1_epi32(0xE0)),
+			_mm_or_si128(_mm_slli_epi32(middle, 8), _mm_slli_epi32(last, 16)));
+		const __m128i upTo2 = _mm_or_si128(_mm_and_si128(twoBytes, word2), _mm_andnot_si128(twoBytes, c));
+		const __m128i word = _mm_or_si128(_mm_and_si128(threeBytes, word3), _mm_andnot_si128(threeBytes, upTo2));
+
+		// Two bits per unit, the bytes it takes beyond the first
+		const unsigned int more = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(twoBytes)));
+		const unsigned int most = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(threeBytes)));
+		const unsigned int spread = (more & 1) | ((more & 2) << 1) | ((more & 4) << 2) | ((more & 8) << 3);
+		const unsigned int spread3 = (most & 1) | ((most & 2) << 1) | ((most & 4) << 2) | ((most & 8) << 3);
+		const Utf8::SHUFFLE& shuffle = shuffles[spread + spread3];
+
+		const __m128i bytes = _mm_shuffle_epi8(word, _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.bytes)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+		out += shuffle.length;
+	}
+
+	// Converts in[0..8) unless it holds a surrogate, or a unit of 3 bytes and
+	// roomy is false. out has room for 24 bytes, or 28 with roomy. Returns
+	// false without writing anything if the block is left to the scalar path.
+	inline bool EncodeBlock(const char16_t* in, char*& out, bool roomy,
+		const Utf8::SHUFFLE* twoByteShuffles, const Utf8::SHUFFLE* threeByteShuffles)
+	{
+		const __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+		const __m128i notAscii = _mm_set1_epi16(static_cast<short>(0xFF80));
+		if (_mm_testz_si128(units, notAscii))
+		{
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out), _mm_packus_epi16(units, units));
+			out += 8;
+			return true;
+		}
+
+		const __m128i high5 = _mm_set1_epi16(static_cast<short>(0xF800));
+		if (!_mm_testz_si128(units, high5))
+		{
+			const __m128i surrogates = _mm_cmpeq_epi16(_mm_and_si128(units, high5), _mm_set1_epi16(static_cast<short>(0xD800)));
+			if (!roomy || !_mm_testz_si128(surrogates, surrogates))
+			{
+				return false;
+			}
+			EncodeHalf(_mm_cvtepu16_epi32(units), out, threeByteShuffles);
+			EncodeHalf(_mm_cvtepu16_epi32(_mm_srli_si128(units, 8)), out, threeByteShuffles);
+			return true;
+		}
+
+		// Units of 1 and 2 bytes: byte 2i is the unit or its lead byte, 2i + 1 its continuation
+		const __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, notAscii), _mm_setzero_si128());
+		const __m128i lead = _mm_or_si128(_mm_srli_epi16(units, 6), _mm_set1_epi16(0xC0));
+		const __m128i last = _mm_or_si128(_mm_and_si128(units, _mm_set1_epi16(0x3F)), _mm_set1_epi16(0x80));
+		const __m128i pair = _mm_or_si128(lead, _mm_slli_epi16(last, 8));
+		const __m128i word = _mm_or_si128(_mm_and_si128(ascii, units), _mm_andnot_si128(ascii, pair));
+
+		const unsigned int twoBytes = ~static_cast<unsigned int>(_mm_movemask_epi8(_mm_packs_epi16(ascii, ascii))) & 0xFF;
+		const Utf8::SHUFFLE& shuffle = twoByteShuffles[twoBytes];
+		const __m128i bytes = _mm_shuffle_epi8(word, _mm_loadu_si128(reinterpret_cast<const __m128i*>(shuffle.bytes)));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out), bytes);
+		out += shuffle.length;
+		return true;
+	}
+}
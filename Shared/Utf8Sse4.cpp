@@ -0,0 +1,59 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Shared Library
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+#include "Utf8.h"
+
+#if UTF8_X86
+
+// MSVC accepts SSE4.1 intrinsics without /arch, GCC and Clang need the target
+// enabled for this translation unit only. The kernel is only called after
+// Utf8::IsSupported has checked the CPU.
+#if defined(__clang__)
+#pragma clang attribute push(__attribute__((target("sse4.1"))), apply_to = function)
+#elif defined(__GNUC__)
+#pragma GCC target("sse4.1")
+#endif
+
+#include "Utf8Kernel.h"
+
+size_t Utf8::FromUtf16Sse4(const char16_t* in, size_t length, char*& out) noexcept
+{
+	const SHUFFLE* twoByteShuffles = TwoByteShuffles();
+	const SHUFFLE* threeByteShuffles = ThreeByteShuffles();
+	size_t i = 0;
+	while (i + 8 <= length)
+	{
+		if (EncodeBlock(in + i, out, i + 12 <= length, twoByteShuffles, threeByteShuffles))
+		{
+			i += 8;
+		}
+		else
+		{
+			i = EncodeScalar(in, i, i + 8, length, out);
+		}
+	}
+	return i;
+}
+
+#if defined(__clang__)
+#pragma clang attribute pop
+#endif
+
+#endif
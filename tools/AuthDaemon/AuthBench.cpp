@@ -0,0 +1,611 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Authentication daemon client benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Measures AuthClient against a running daemon, usually the stand-in
+// AuthDaemon. Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider -IShared tools/AuthDaemon/AuthBench.cpp CredentialProvider/daemon/*.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o AuthBench
+//
+// Usage: AuthBench [--socket path] [--requests n] [--inflight k] [--logons n] [--typed n]
+//                  [--debounce ms] [--user name] [--otp code]
+//        AuthBench --backends path;path;... [--logons n] [--user name] [--otp code] [--unenrolled name]
+//        AuthBench --outage path;path;... [--logons n] [--user name] [--otp code]
+//        AuthBench --push n [--socket path] [--approve ms] [--user name]
+//
+// Reports the time to connect and handshake, the submit-to-result latency of
+// a logon with a cold connection against one prewarmed by ConnectAsync(), the
+// round trip latency of sequential requests and the throughput with k
+// requests in flight.
+//
+// --typed n logons type a new user name keystroke by keystroke, with a pause
+// mid-name, and submit with and without UserPrefetch. Run the daemon with
+// --delay to see the directory latency the prefetch hides.
+//
+// --backends compares AuthBackends, without and with hedging, with trying
+// the daemons in configured order, each with the full timeout, over n
+// logons. Start daemons with --latency, --spike and --fail first, for example
+//   AuthDaemon --socket /tmp/a.sock --fail 50 &
+//   AuthDaemon --socket /tmp/b.sock --latency 40 &
+//   AuthDaemon --socket /tmp/c.sock &
+//   AuthBench --backends "/tmp/a.sock;/tmp/b.sock;/tmp/c.sock" --logons 200
+// or, for the tail that hedging cuts, two daemons with --spike 2:20
+//
+// These scenarios fail with exit code 1 when a logon goes unanswered or past
+// its deadline while a daemon is healthy, a NOT_ENROLLED user is asked again
+// despite the negative cache, the breakers save no time during an outage
+// or a push is answered early or not at all. FailoverTest injects faults into
+// its own daemons and checks the failover itself.
+//
+// --unenrolled name logs on, with --backends, a user the daemons know no
+// token of (start them with --store), without and with the negative cache.
+//
+// --outage logs on against daemons that are down or never answer (--fail
+// 100), without and with circuit breakers, 10 ms apart.
+//
+// --push waits for one push approval the way a logon does, with the
+// countdown, then for n approvals pending at once on one connection. Start
+// the daemon with the same --approve, for example
+//   AuthDaemon --socket /tmp/a.sock --approve 2000 &
+//   AuthBench --socket /tmp/a.sock --push 10000 --approve 2000
+
+#include "daemon/AuthBackends.h"
+#include "daemon/AuthClient.h"
+#include "daemon/UserPrefetch.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/resource.h>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	double Micros(CLOCK::duration d)
+	{
+		return chrono::duration<double, micro>(d).count();
+	}
+
+	double Percentile(vector<double>& sorted, double p)
+	{
+		const size_t index = min(sorted.size() - 1, size_t(p * double(sorted.size())));
+		return sorted[index];
+	}
+
+	void Report(const char* name, vector<double>& latencies)
+	{
+		sort(latencies.begin(), latencies.end());
+		printf("%s: p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n", name, Percentile(latencies, 0.5),
+			Percentile(latencies, 0.99), Percentile(latencies, 0.999), latencies.back());
+	}
+
+	// Types name into prefetch the way a user would, the pause after three
+	// keystrokes is long enough to start a lookup the next keystroke makes stale
+	void Type(UserPrefetch* prefetch, const string& name, unsigned int debounceMs)
+	{
+		for (size_t i = 1; i <= name.size(); i++)
+		{
+			if (prefetch != nullptr)
+			{
+				prefetch->Update(wstring(name.begin(), name.begin() + i), L"corp");
+			}
+			this_thread::sleep_for(chrono::milliseconds(i == 3 ? debounceMs + 20 : 60));
+		}
+		// Tabbing to the OTP field and typing the code
+		this_thread::sleep_for(chrono::milliseconds(1500));
+	}
+
+	// CPU time of the process, all threads
+	double CpuMs()
+	{
+		rusage usage;
+		getrusage(RUSAGE_SELF, &usage);
+		return double(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0
+			+ double(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+	}
+
+	// Stands in for LogonUI, counts what AuthDeadline asks of it
+	class CountingProgress : public AuthProgress
+	{
+	public:
+		bool QueryContinue() override
+		{
+			polls++;
+			return true;
+		}
+
+		void SetStatusMessage(const std::wstring& message) override
+		{
+			updates++;
+			last = message;
+		}
+
+		size_t polls = 0;
+		size_t updates = 0;
+		wstring last;
+	};
+
+	vector<string> Split(const string& list)
+	{
+		vector<string> parts;
+		size_t start = 0;
+		while (start <= list.size())
+		{
+			const size_t end = min(list.find(';', start), list.size());
+			if (end > start)
+			{
+				parts.push_back(list.substr(start, end - start));
+			}
+			start = end + 1;
+		}
+		return parts;
+	}
+
+	int Failover(const vector<string>& endpoints, size_t logons, const string& user, const string& otp)
+	{
+		const unsigned int timeoutMs = 2000;
+
+		// Configured order, full timeout each: what one slow server costs without health tracking
+		vector<unique_ptr<AuthClient>> clients;
+		for (const string& endpoint : endpoints)
+		{
+			clients.emplace_back(new AuthClient());
+			clients.back()->Connect(endpoint, timeoutMs);
+		}
+		vector<double> serial;
+		size_t serialFailed = 0;
+		for (size_t i = 0; i < logons; i++)
+		{
+			const auto start = CLOCK::now();
+			bool answered = false;
+			for (size_t b = 0; b < clients.size() && !answered; b++)
+			{
+				if (!clients[b]->IsConnected())
+				{
+					clients[b]->Connect(endpoints[b], timeoutMs);
+				}
+				AUTH_CALL call = clients[b]->Verify(user, "corp", otp);
+				const AUTH_STATUS status = clients[b]->Wait(call, timeoutMs).status;
+				answered = status == AUTH_STATUS::ACCEPTED || status == AUTH_STATUS::REJECTED;
+			}
+			serialFailed += !answered;
+			serial.push_back(Micros(CLOCK::now() - start));
+		}
+
+		Report("configured order, full timeouts", serial);
+		printf("  unanswered: %zu of %zu\n", serialFailed, logons);
+
+		for (int hedging = 0; hedging < 2; hedging++)
+		{
+			AuthBackends backends(endpoints, timeoutMs, 500);
+			backends.SetHedging(hedging != 0);
+			backends.ConnectAsync();
+			this_thread::sleep_for(chrono::milliseconds(200));
+			vector<double> ranked;
+			vector<size_t> served(endpoints.size(), 0);
+			size_t unanswered = 0, attempts = 0, hedged = 0;
+			for (size_t i = 0; i < logons; i++)
+			{
+				AuthDeadline deadline(3 * timeoutMs, nullptr, L"");
+				AUTH_ROUTE route;
+				const auto start = CLOCK::now();
+				const AUTH_RESULT result = backends.Verify(user, "corp", otp, deadline, &route);
+				ranked.push_back(Micros(CLOCK::now() - start));
+				unanswered += result.status != AUTH_STATUS::ACCEPTED && result.status != AUTH_STATUS::REJECTED;
+				served[route.backend]++;
+				attempts += route.attempts;
+				hedged += route.hedged;
+			}
+
+			Report(hedging ? "AuthBackends, hedged" : "AuthBackends", ranked);
+			printf("  unanswered: %zu of %zu, %.2f attempts per logon, %zu hedged\n", unanswered, logons,
+				double(attempts) / double(logons), hedged);
+			size_t busiest = 0;
+			for (size_t b = 0; b < endpoints.size(); b++)
+			{
+				const AUTH_BACKEND_HEALTH health = backends.Health(b);
+				printf("  %s: served %zu, latency %.0f us, error rate %.2f\n", endpoints[b].c_str(), served[b],
+					health.latencyUs, health.errorRate);
+				busiest = served[b] > served[busiest] ? b : busiest;
+			}
+
+			// With one daemon that answers reliably, as in the examples above, it takes the traffic
+			const AUTH_BACKEND_HEALTH best = backends.Health(busiest);
+			bool healthiest = true;
+			for (size_t b = 0; b < endpoints.size(); b++)
+			{
+				const AUTH_BACKEND_HEALTH health = backends.Health(b);
+				healthiest = healthiest && (b == busiest || health.samples == 0 || health.errorRate >= best.errorRate);
+			}
+			Expect(unanswered == 0, "AuthBackends answers every logon while a daemon is healthy");
+			Expect(ranked.back() < 3 * timeoutMs * 1000.0, "every logon ends before its deadline");
+			Expect(healthiest, "the daemon serving most logons has the lowest error rate");
+		}
+		return failed ? 1 : 0;
+	}
+
+	int NotEnrolled(const vector<string>& endpoints, size_t logons, const string& user, const string& otp)
+	{
+		size_t uncached = 0;
+		for (int cache = 0; cache < 2; cache++)
+		{
+			AuthBackends backends(endpoints, 2000, 0);
+			backends.SetNegativeTtl(cache ? 30000 : 0);
+			backends.ConnectAsync();
+			this_thread::sleep_for(chrono::milliseconds(200));
+			vector<double> latencies;
+			size_t attempts = 0, enrolled = 0;
+			for (size_t i = 0; i < logons; i++)
+			{
+				AuthDeadline deadline(6000, nullptr, L"");
+				AUTH_ROUTE route;
+				const auto start = CLOCK::now();
+				const AUTH_RESULT result = backends.Verify(user, "corp", otp, deadline, &route);
+				latencies.push_back(Micros(CLOCK::now() - start));
+				attempts += route.attempts;
+				enrolled += result.status != AUTH_STATUS::NOT_ENROLLED;
+			}
+
+			Report(cache ? "not enrolled, negative cache" : "not enrolled", latencies);
+			printf("  %zu requests to daemons, %zu answers other than NOT_ENROLLED\n", attempts, enrolled);
+			Expect(enrolled == 0, "every logon of the user is NOT_ENROLLED");
+			if (cache)
+			{
+				Expect(attempts <= endpoints.size() && (logons < 2 || attempts < uncached),
+					"with the negative cache only the first logon asks a daemon");
+			}
+			uncached = attempts;
+		}
+		return failed ? 1 : 0;
+	}
+
+	int Push(const string& endpoint, size_t pushes, const string& user, unsigned int approveMs)
+	{
+		// One logon: AuthBackends, a deadline and the countdown
+		{
+			AuthBackends backends({ endpoint }, 2000, 0);
+			backends.ConnectAsync();
+			this_thread::sleep_for(chrono::milliseconds(200));
+			CountingProgress progress;
+			AuthDeadline deadline(approveMs + 5000, &progress, L"Approve the sign-in on your phone");
+			AUTH_ROUTE route;
+			const double cpu = CpuMs();
+			const auto start = CLOCK::now();
+			const AUTH_RESULT result = backends.Push(user, "corp", "Windows sign-in as corp\\" + user, deadline, &route);
+			const double elapsed = Micros(CLOCK::now() - start) / 1000.0;
+			printf("push logon: status %u (%s) after %.1f ms, %.1f ms late, %zu attempt(s)\n", unsigned(result.status),
+				result.message.c_str(), elapsed, elapsed - approveMs, size_t(route.attempts));
+			printf("  %zu polls, %zu status updates, last \"%s\", %.1f ms CPU\n", progress.polls, progress.updates,
+				string(progress.last.begin(), progress.last.end()).c_str(), CpuMs() - cpu);
+			Expect(result.status == AUTH_STATUS::ACCEPTED || result.status == AUTH_STATUS::REJECTED,
+				"the push logon gets the user's decision");
+			Expect(elapsed >= approveMs && elapsed < approveMs + 5000, "the decision arrives after the approval, before the deadline");
+			Expect(progress.updates > 0, "the countdown is shown");
+		}
+
+		// Many approvals pending at once, multiplexed over one connection
+		AuthClient client;
+		if (!client.Connect(endpoint, 2000))
+		{
+			fprintf(stderr, "Cannot connect to %s\n", endpoint.c_str());
+			return 1;
+		}
+		vector<AUTH_CALL> calls(pushes);
+		vector<CLOCK::time_point> sent(pushes);
+		const double cpu = CpuMs();
+		const auto start = CLOCK::now();
+		for (size_t i = 0; i < pushes; i++)
+		{
+			sent[i] = CLOCK::now();
+			calls[i] = client.Push(user, "corp", "sign-in " + to_string(i), approveMs + 60000);
+		}
+		const double submitMs = Micros(CLOCK::now() - start) / 1000.0;
+
+		// Answers come in the order sent, so waiting in order sees each one soon after it arrives
+		vector<double> late;
+		late.reserve(pushes);
+		size_t accepted = 0, decided = 0;
+		for (size_t i = 0; i < pushes; i++)
+		{
+			const AUTH_RESULT result = client.Wait(calls[i], approveMs + 60000);
+			late.push_back(Micros(CLOCK::now() - sent[i]) - approveMs * 1000.0);
+			accepted += result.status == AUTH_STATUS::ACCEPTED;
+			decided += result.status == AUTH_STATUS::ACCEPTED || result.status == AUTH_STATUS::REJECTED;
+		}
+		printf("%zu pushes pending at once: sent in %.1f ms, %zu accepted, %.1f ms CPU in total\n", pushes, submitMs,
+			accepted, CpuMs() - cpu);
+		Report("  answer after approval", late);
+		Expect(decided == pushes, "every pending push gets a decision");
+		Expect(late.front() >= 0, "no push is answered before its approval");
+		return failed ? 1 : 0;
+	}
+
+	int Outage(const vector<string>& endpoints, size_t logons, const string& user, const string& otp)
+	{
+		double unbrokenUs = 0;
+		for (int breaker = 0; breaker < 2; breaker++)
+		{
+			AuthBackends backends(endpoints, 2000, 500);
+			backends.SetBreaker(breaker ? 3 : 0, 1000);
+			backends.ConnectAsync();
+			this_thread::sleep_for(chrono::milliseconds(200));
+			vector<double> latencies;
+			size_t attempts = 0, answered = 0;
+			const auto first = CLOCK::now();
+			for (size_t i = 0; i < logons; i++)
+			{
+				AuthDeadline deadline(6000, nullptr, L"");
+				AUTH_ROUTE route;
+				const auto start = CLOCK::now();
+				const AUTH_RESULT result = backends.Verify(user, "corp", otp, deadline, &route);
+				latencies.push_back(Micros(CLOCK::now() - start));
+				attempts += route.attempts;
+				answered += result.status == AUTH_STATUS::ACCEPTED || result.status == AUTH_STATUS::REJECTED;
+				this_thread::sleep_for(chrono::milliseconds(10));
+			}
+
+			Report(breaker ? "outage, breakers" : "outage", latencies);
+			printf("  %zu answered, %zu requests to daemons, %.1f s in total\n", answered, attempts,
+				chrono::duration<double>(CLOCK::now() - first).count());
+			unsigned long long trips = 0;
+			double waitedUs = 0;
+			for (double latency : latencies)
+			{
+				waitedUs += latency;
+			}
+			for (size_t b = 0; b < endpoints.size(); b++)
+			{
+				const AUTH_BACKEND_HEALTH health = backends.Health(b);
+				printf("  %s: breaker opened %llu times\n", endpoints[b].c_str(), health.trips);
+				trips += health.trips;
+			}
+
+			// Every logon ends within its deadline, with breakers the daemons that are down are not waited for
+			Expect(latencies.back() < 6000 * 1000.0, "every logon ends before its deadline");
+			if (breaker)
+			{
+				Expect(answered > 0 || trips > 0, "the breakers open while the daemons are down");
+				Expect(answered > 0 || logons < 10 || waitedUs < unbrokenUs, "open breakers shorten the logons during the outage");
+			}
+			unbrokenUs = waitedUs;
+		}
+		return failed ? 1 : 0;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	string endpoint = DaemonTransport::DefaultEndpoint();
+	string user = "alice", otp = "123456", backends, outage, unenrolled;
+	size_t requests = 10000, inflight = 32, logons = 200, typed = 0, pushes = 0;
+	unsigned int debounceMs = 150, approveMs = 0;
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--socket")
+		{
+			endpoint = argv[i + 1];
+		}
+		else if (arg == "--requests")
+		{
+			requests = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--inflight")
+		{
+			inflight = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--logons")
+		{
+			logons = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--typed")
+		{
+			typed = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--debounce")
+		{
+			debounceMs = unsigned(strtoul(argv[i + 1], nullptr, 10));
+		}
+		else if (arg == "--backends")
+		{
+			backends = argv[i + 1];
+		}
+		else if (arg == "--outage")
+		{
+			outage = argv[i + 1];
+		}
+		else if (arg == "--unenrolled")
+		{
+			unenrolled = argv[i + 1];
+		}
+		else if (arg == "--push")
+		{
+			pushes = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--approve")
+		{
+			approveMs = unsigned(strtoul(argv[i + 1], nullptr, 10));
+		}
+		else if (arg == "--user")
+		{
+			user = argv[i + 1];
+		}
+		else if (arg == "--otp")
+		{
+			otp = argv[i + 1];
+		}
+	}
+	if (requests == 0 || inflight == 0 || logons == 0)
+	{
+		fprintf(stderr, "Usage: AuthBench [--socket path] [--requests n] [--inflight k] [--logons n] [--typed n] "
+			"[--debounce ms] [--user name] [--otp code]\n");
+		return 2;
+	}
+
+	if (pushes > 0)
+	{
+		return Push(endpoint, pushes, user, approveMs);
+	}
+	if (!outage.empty())
+	{
+		return Outage(Split(outage), logons, user, otp);
+	}
+	if (!backends.empty())
+	{
+		return unenrolled.empty() ? Failover(Split(backends), logons, user, otp)
+			: NotEnrolled(Split(backends), logons, unenrolled, otp);
+	}
+
+	AuthClient client;
+	const auto connectStart = CLOCK::now();
+	if (!client.Connect(endpoint, 2000))
+	{
+		fprintf(stderr, "Cannot connect to %s\n", endpoint.c_str());
+		return 1;
+	}
+	printf("connect + handshake: %.1f us, capabilities 0x%llx\n", Micros(CLOCK::now() - connectStart),
+		static_cast<unsigned long long>(client.Capabilities()));
+
+	// Submit to result of one logon, each with a new client. Cold connects at
+	// submit time, warm was prewarmed while the tiles were shown.
+	vector<double> cold, warm;
+	cold.reserve(logons);
+	warm.reserve(logons);
+	for (size_t i = 0; i < logons; i++)
+	{
+		{
+			AuthClient logon;
+			const auto submit = CLOCK::now();
+			if (logon.Connect(endpoint, 2000))
+			{
+				AUTH_CALL call = logon.Verify(user, "corp", otp);
+				logon.Wait(call, 2000);
+			}
+			cold.push_back(Micros(CLOCK::now() - submit));
+		}
+		{
+			AuthClient logon;
+			logon.ConnectAsync(endpoint, 2000);
+			this_thread::sleep_for(chrono::milliseconds(2));
+			const auto submit = CLOCK::now();
+			if (logon.WaitConnected(2000))
+			{
+				AUTH_CALL call = logon.Verify(user, "corp", otp);
+				logon.Wait(call, 2000);
+			}
+			warm.push_back(Micros(CLOCK::now() - submit));
+		}
+	}
+	Report("logon, cold connection", cold);
+	Report("logon, prewarmed connection", warm);
+	printf("prewarming saves %.1f us at p50\n", Percentile(cold, 0.5) - Percentile(warm, 0.5));
+
+	// Typed user names, each one new to the daemon
+	if (typed > 0)
+	{
+		const auto lookup = [&client](const wstring& name, const wstring& domain, const function<bool()>& stale)
+		{
+			AUTH_CALL call = client.Lookup(string(name.begin(), name.end()), string(domain.begin(), domain.end()));
+			return client.Wait(call, 10000, stale, 10);
+		};
+
+		vector<double> plain, prefetched;
+		uint64_t cancelled = 0;
+		const long long run = static_cast<long long>(CLOCK::now().time_since_epoch().count());
+		for (size_t i = 0; i < typed; i++)
+		{
+			for (int prefetching = 0; prefetching < 2; prefetching++)
+			{
+				const string name = user + "-" + to_string(run) + "-" + to_string(i) + (prefetching ? "p" : "c");
+				unique_ptr<UserPrefetch> prefetch;
+				if (prefetching)
+				{
+					prefetch.reset(new UserPrefetch(lookup, debounceMs));
+				}
+				Type(prefetch.get(), name, debounceMs);
+
+				const auto submit = CLOCK::now();
+				AUTH_CALL call = client.Verify(name, "corp", otp);
+				client.Wait(call, 10000);
+				(prefetching ? prefetched : plain).push_back(Micros(CLOCK::now() - submit));
+				if (prefetch)
+				{
+					cancelled += prefetch->Cancelled();
+				}
+			}
+		}
+		Report("typed logon, no prefetch", plain);
+		Report("typed logon, prefetched", prefetched);
+		printf("stale prefetches cancelled: %llu of %zu logons\n", static_cast<unsigned long long>(cancelled), typed);
+	}
+
+	// Sequential round trips
+	vector<double> latencies;
+	latencies.reserve(requests);
+	size_t accepted = 0;
+	for (size_t i = 0; i < requests; i++)
+	{
+		const auto start = CLOCK::now();
+		AUTH_CALL call = client.Verify(user, "corp", otp);
+		const AUTH_RESULT result = client.Wait(call, 2000);
+		latencies.push_back(Micros(CLOCK::now() - start));
+		accepted += result.status == AUTH_STATUS::ACCEPTED;
+	}
+	sort(latencies.begin(), latencies.end());
+	printf("sequential: %zu requests, %zu accepted, p50 %.1f us, p99 %.1f us, p99.9 %.1f us, max %.1f us\n",
+		requests, accepted, Percentile(latencies, 0.5), Percentile(latencies, 0.99), Percentile(latencies, 0.999),
+		latencies.back());
+
+	// Pipelined, inflight requests outstanding at any time
+	deque<AUTH_CALL> window;
+	size_t completed = 0, sent = 0;
+	const auto start = CLOCK::now();
+	while (completed < requests)
+	{
+		while (sent < requests && window.size() < inflight)
+		{
+			window.push_back(client.Verify(user, "corp", otp));
+			sent++;
+		}
+		client.Wait(window.front(), 2000);
+		window.pop_front();
+		completed++;
+	}
+	const double seconds = Micros(CLOCK::now() - start) / 1e6;
+	printf("pipelined: %zu requests, %zu in flight, %.0f requests/s\n", requests, inflight, double(requests) / seconds);
+	return 0;
+}
@@ -0,0 +1,792 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Stand-in authentication daemon
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Stand-in for the authentication daemon, Linux only. Speaks the protocol of
+// CredentialProvider/daemon/DaemonProtocol.h on a Unix domain socket, so the
+// client can be tested and benchmarked without the real service. Build it
+// from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider -IShared tools/AuthDaemon/AuthDaemon.cpp CredentialProvider/daemon/*.cpp CredentialProvider/otp/*.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o AuthDaemon
+//
+// Usage: AuthDaemon [--socket path] [--store tokens.db] [--accept code] [--delay ms]
+//                   [--latency ms] [--spike percent:ms] [--fail percent] [--reply binary|json]
+//                   [--approve ms] [--deny percent]
+//
+// With --store codes are verified against a token database the way the
+// provider does it offline, names without a token are NOT_ENROLLED. Without
+// it every name is enrolled and --accept (default 123456) is the valid code.
+// --delay simulates a slow directory: resolving a user the daemon has not
+// seen in the last minute takes that long, LOOKUP and VERIFY alike.
+// --latency, --spike and --fail inject faults for failover and hedging tests:
+// every request but CANCEL is answered --latency later, a --spike share of
+// them another ms later, and a --fail share never.
+// VERIFYs carrying a REQUEST_KEY are verified once: copies with the same key
+// and the same user and code, as hedging sends them, get the first outcome.
+// --reply json answers VERIFY and LOOKUP with a JSON field, the way a daemon
+// fronting a JSON service would, instead of STATUS, MESSAGE and TOKEN_TYPE.
+// PUSH stands in for the phone: the user approves --approve ms after the
+// request arrives, or denies a --deny share. Without --approve, or when
+// EXPIRES comes first, the request expires. Pending pushes wait in one timer
+// heap, not on threads, so any number of them can be open.
+// Each connection is served by its own thread, requests in order, except
+// LOOKUP which runs on a thread of its own and PUSH which waits on the timer,
+// both can be cancelled.
+
+#include "daemon/DaemonProtocol.h"
+#include "daemon/DaemonTransport.h"
+#include "otp/ReplayCache.h"
+#include "otp/Sha.h"
+#include "otp/TokenStore.h"
+#include <array>
+#include <clocale>
+#include <condition_variable>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+	struct OPTIONS
+	{
+		string socket = DaemonTransport::DefaultEndpoint();
+		string store;
+		string accept = "123456";
+		unsigned int delayMs = 0;
+		unsigned int latencyMs = 0;
+		double spikePercent = 0;
+		unsigned int spikeMs = 0;
+		unsigned int failPercent = 0;
+		bool json = false;
+		unsigned int approveMs = 0;
+		unsigned int denyPercent = 0;
+	};
+
+	// Outcome of a VERIFY with a REQUEST_KEY, bound to what was verified
+	struct OUTCOME
+	{
+		array<uint8_t, 32> request;		// SHA-256 of domain, user and code
+		bool done = false;
+		AUTH_STATUS status = AUTH_STATUS::REJECTED;
+		string message;
+		chrono::steady_clock::time_point at;
+	};
+
+	// Directory entry of a user
+	struct ENTRY
+	{
+		bool enrolled = false;
+		DAEMON_TOKEN token = DAEMON_TOKEN::NONE;
+		unsigned int digits = 0;
+		chrono::steady_clock::time_point resolved;
+	};
+
+	// One client. The socket is closed when the reader and the last lookup are done.
+	struct CONNECTION
+	{
+		explicit CONNECTION(int socket) : fd(socket) {}
+		~CONNECTION() { close(fd); }
+
+		const int fd;
+		mutex writeLock;
+		mutex pendingLock;
+		unordered_map<uint32_t, shared_ptr<atomic<bool>>> pending;	// lookups and pushes running, by request id
+	};
+
+	// Push waiting for the phone's answer
+	struct PUSH
+	{
+		chrono::steady_clock::time_point at;	// of the answer
+		weak_ptr<CONNECTION> connection;
+		uint32_t requestId;
+		shared_ptr<atomic<bool>> cancelled;
+		AUTH_STATUS status;
+		const char* message;
+
+		bool operator>(const PUSH& other) const { return at > other.at; }
+	};
+
+	const chrono::seconds DIRECTORY_TTL(60);
+	const chrono::seconds OUTCOME_TTL(60);
+
+	OPTIONS options;
+	TokenStore store;
+	mutex directoryLock;
+	unordered_map<string, ENTRY> directory;
+	mutex outcomeLock;
+	condition_variable outcomeDone;
+	unordered_map<uint64_t, shared_ptr<OUTCOME>> outcomes;
+	mutex pushLock;
+	condition_variable pushAdded;
+	priority_queue<PUSH, vector<PUSH>, greater<PUSH>> pushes;
+
+	bool ReadFully(int fd, uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t read = recv(fd, data, size, 0);
+			if (read <= 0)
+			{
+				return false;
+			}
+			data += read;
+			size -= size_t(read);
+		}
+		return true;
+	}
+
+	// Reply body of --reply json, with some of the detail real services add
+	string JsonReply(AUTH_STATUS status, const string& message, DAEMON_TOKEN token, uint32_t requestId)
+	{
+		const char* const statuses[] = { "accepted", "rejected", "not_enrolled" };
+		string json = "{\"id\":" + to_string(requestId) + ",\"status\":\"" + statuses[unsigned(status) % 3] + "\",\"message\":\"";
+		for (const char c : message)
+		{
+			if (c == '"' || c == '\\')
+			{
+				json += '\\';
+			}
+			json += static_cast<unsigned char>(c) < 0x20 ? ' ' : c;
+		}
+		json += "\"";
+		if (token != DAEMON_TOKEN::NONE)
+		{
+			json += string(",\"token_type\":\"") + (token == DAEMON_TOKEN::HOTP ? "hotp" : "totp") + "\"";
+		}
+		json += ",\"detail\":{\"daemon\":\"AuthDaemon\",\"version\":1,\"threadid\":" + to_string(requestId % 64) + "}}";
+		return json;
+	}
+
+	bool WriteFrame(CONNECTION& connection, DaemonMessage& message)
+	{
+		const vector<uint8_t>& frame = message.Finish();
+		lock_guard<mutex> lock(connection.writeLock);
+		return !frame.empty() && send(connection.fd, frame.data(), frame.size(), MSG_NOSIGNAL) == ssize_t(frame.size());
+	}
+
+	wstring Widen(const string& in)
+	{
+		wstring out(in.size() + 1, L'\0');
+		const size_t length = mbstowcs(&out[0], in.c_str(), out.size());
+		out.resize(length == size_t(-1) ? 0 : length);
+		return out;
+	}
+
+	// Cached for DIRECTORY_TTL, a miss costs --delay. false if cancelled first.
+	bool Resolve(const string& user, const string& domain, const atomic<bool>* cancelled, ENTRY& entry)
+	{
+		const string key = domain + "\\" + user;
+		const auto now = chrono::steady_clock::now();
+		{
+			lock_guard<mutex> lock(directoryLock);
+			const auto it = directory.find(key);
+			if (it != directory.end() && now - it->second.resolved < DIRECTORY_TTL)
+			{
+				entry = it->second;
+				return true;
+			}
+		}
+
+		const auto done = now + chrono::milliseconds(options.delayMs);
+		while (chrono::steady_clock::now() < done)
+		{
+			if (cancelled != nullptr && *cancelled)
+			{
+				return false;
+			}
+			this_thread::sleep_for(min<chrono::steady_clock::duration>(chrono::milliseconds(5), done - chrono::steady_clock::now()));
+		}
+
+		entry = ENTRY();
+		if (!store.IsOpen())
+		{
+			entry.enrolled = true;
+			entry.token = DAEMON_TOKEN::TOTP;
+			entry.digits = unsigned(options.accept.size());
+		}
+		else
+		{
+			const wstring wideUser = Widen(user), wideDomain = Widen(domain);
+			TOKEN_RECORD record;
+			store.Refresh();
+			if (store.Find(wideUser.c_str(), wideDomain.c_str(), record))
+			{
+				memset(record.secret, 0, sizeof(record.secret));
+				entry.enrolled = true;
+				entry.token = record.type == uint8_t(OTP_TYPE::HOTP) ? DAEMON_TOKEN::HOTP : DAEMON_TOKEN::TOTP;
+				entry.digits = record.digits;
+			}
+		}
+		entry.resolved = chrono::steady_clock::now();
+
+		lock_guard<mutex> lock(directoryLock);
+		directory[key] = entry;
+		return true;
+	}
+
+	void Lookup(shared_ptr<CONNECTION> connection, uint32_t requestId, string user, string domain,
+		shared_ptr<atomic<bool>> cancelled)
+	{
+		ENTRY entry;
+		const bool resolved = Resolve(user, domain, cancelled.get(), entry);
+		{
+			lock_guard<mutex> lock(connection->pendingLock);
+			connection->pending.erase(requestId);
+		}
+
+		// A cancelled request gets no reply, the client has already completed it
+		if (!resolved)
+		{
+			return;
+		}
+
+		DaemonMessage reply(DAEMON_MESSAGE::LOOKUP_REPLY, requestId);
+		if (options.json)
+		{
+			reply.Add(DAEMON_FIELD::JSON, JsonReply(entry.enrolled ? AUTH_STATUS::ACCEPTED : AUTH_STATUS::NOT_ENROLLED, "",
+				entry.token, requestId)).AddInteger(DAEMON_FIELD::DIGITS, entry.digits);
+		}
+		else
+		{
+			reply.AddInteger(DAEMON_FIELD::STATUS, uint64_t(entry.enrolled ? AUTH_STATUS::ACCEPTED : AUTH_STATUS::NOT_ENROLLED))
+			.AddInteger(DAEMON_FIELD::TOKEN_TYPE, uint64_t(entry.token))
+			.AddInteger(DAEMON_FIELD::DIGITS, entry.digits);
+		}
+		if (!WriteFrame(*connection, reply))
+		{
+			shutdown(connection->fd, SHUT_RDWR);
+		}
+	}
+
+	AUTH_STATUS Verify(const string& user, const string& domain, const string& otp, string& message)
+	{
+		ENTRY entry;
+		Resolve(user, domain, nullptr, entry);
+		if (!entry.enrolled)
+		{
+			message = "no token enrolled";
+			return AUTH_STATUS::NOT_ENROLLED;
+		}
+
+		if (!store.IsOpen())
+		{
+			message = otp == options.accept ? "accepted" : "wrong code";
+			return otp == options.accept ? AUTH_STATUS::ACCEPTED : AUTH_STATUS::REJECTED;
+		}
+
+		const wstring wideUser = Widen(user), wideDomain = Widen(domain), wideOtp = Widen(otp);
+		TOKEN_RECORD record;
+		store.Refresh();
+		if (!store.Find(wideUser.c_str(), wideDomain.c_str(), record))
+		{
+			message = "no token enrolled";
+			return AUTH_STATUS::NOT_ENROLLED;
+		}
+
+		OTPVerifier verifier;
+		const bool initialized = TokenStore::InitializeVerifier(record, verifier);
+		memset(record.secret, 0, sizeof(record.secret));
+		if (!initialized)
+		{
+			message = "invalid token";
+			return AUTH_STATUS::REJECTED;
+		}
+
+		const long long now = static_cast<long long>(time(nullptr));
+		uint64_t matched = 0;
+		if (verifier.Verify(wideOtp.c_str(), now, record.counter, &matched) != OTP_RESULT::VALID)
+		{
+			message = "wrong code";
+			return AUTH_STATUS::REJECTED;
+		}
+
+		const uint64_t key = ReplayCache::TokenKey(record.keyHash, matched);
+		const REPLAY_RESULT replay = ReplayCache::Instance().TryAccept(key, uint32_t(verifier.AcceptedUntil(matched, now)), uint32_t(now));
+		if (replay != REPLAY_RESULT::ACCEPTED)
+		{
+			message = replay == REPLAY_RESULT::FULL ? "replay cache full" : "code already used";
+			return AUTH_STATUS::REJECTED;
+		}
+		// Another process may have logged the code since the refresh above
+		if (verifier.Parameters().type == OTP_TYPE::HOTP)
+		{
+			const TOKEN_COUNTER appended = store.AppendCounter(wideUser.c_str(), wideDomain.c_str(), matched + 1);
+			if (appended == TOKEN_COUNTER::USED || appended == TOKEN_COUNTER::UNKNOWN)
+			{
+				message = appended == TOKEN_COUNTER::USED ? "code already used" : "token revoked";
+				return AUTH_STATUS::REJECTED;
+			}
+		}
+		message = "accepted";
+		return AUTH_STATUS::ACCEPTED;
+	}
+
+	// Applies --latency and --fail, false if the request is to be dropped
+	bool Inject(DAEMON_MESSAGE type)
+	{
+		if (type == DAEMON_MESSAGE::CANCEL)
+		{
+			return true;
+		}
+		thread_local mt19937 random(random_device{}());
+		unsigned int latencyMs = options.latencyMs;
+		if (options.spikePercent > 0 && uniform_real_distribution<double>(0, 100)(random) < options.spikePercent)
+		{
+			latencyMs += options.spikeMs;
+		}
+		if (latencyMs > 0)
+		{
+			this_thread::sleep_for(chrono::milliseconds(latencyMs));
+		}
+		return options.failPercent == 0 || uniform_int_distribution<unsigned int>(0, 99)(random) >= options.failPercent;
+	}
+
+	// Verify() once per key: a copy waits for the first and gets its outcome.
+	// A key that comes with another user or code is verified on its own.
+	AUTH_STATUS VerifyOnce(uint64_t key, const string& user, const string& domain, const string& otp, string& message)
+	{
+		if (key == 0)
+		{
+			return Verify(user, domain, otp, message);
+		}
+
+		string request = domain + '\0' + user + '\0' + otp;
+		array<uint8_t, 32> digest;
+		Sha::Hash(OTP_ALGORITHM::SHA256, reinterpret_cast<const uint8_t*>(request.data()), request.size(), digest.data());
+		fill(request.begin(), request.end(), '\0');
+
+		shared_ptr<OUTCOME> outcome;
+		{
+			unique_lock<mutex> lock(outcomeLock);
+			const auto now = chrono::steady_clock::now();
+			if (outcomes.size() > 1024)
+			{
+				for (auto it = outcomes.begin(); it != outcomes.end();)
+				{
+					it = it->second->done && now - it->second->at > OUTCOME_TTL ? outcomes.erase(it) : next(it);
+				}
+			}
+
+			shared_ptr<OUTCOME>& slot = outcomes[key];
+			if (slot && slot->request == digest)
+			{
+				outcome = slot;
+				outcomeDone.wait(lock, [&outcome]() { return outcome->done; });
+				message = outcome->message;
+				return outcome->status;
+			}
+			if (!slot)
+			{
+				slot = make_shared<OUTCOME>();
+				slot->request = digest;
+				outcome = slot;
+			}
+		}
+
+		const AUTH_STATUS status = Verify(user, domain, otp, message);
+		if (outcome)
+		{
+			{
+				lock_guard<mutex> lock(outcomeLock);
+				outcome->status = status;
+				outcome->message = message;
+				outcome->at = chrono::steady_clock::now();
+				outcome->done = true;
+			}
+			outcomeDone.notify_all();
+		}
+		return status;
+	}
+
+	// Registers a push, the timer answers it when the phone would
+	void Push(shared_ptr<CONNECTION> connection, uint32_t requestId, unsigned int expiresMs)
+	{
+		thread_local mt19937 random(random_device{}());
+		PUSH push;
+		push.connection = connection;
+		push.requestId = requestId;
+		push.cancelled = make_shared<atomic<bool>>(false);
+		if (options.approveMs > 0 && options.approveMs < expiresMs)
+		{
+			const bool denied = uniform_int_distribution<unsigned int>(0, 99)(random) < options.denyPercent;
+			push.at = chrono::steady_clock::now() + chrono::milliseconds(options.approveMs);
+			push.status = denied ? AUTH_STATUS::REJECTED : AUTH_STATUS::ACCEPTED;
+			push.message = denied ? "denied" : "approved";
+		}
+		else
+		{
+			push.at = chrono::steady_clock::now() + chrono::milliseconds(expiresMs);
+			push.status = AUTH_STATUS::REJECTED;
+			push.message = "expired";
+		}
+
+		{
+			lock_guard<mutex> lock(connection->pendingLock);
+			connection->pending[requestId] = push.cancelled;
+		}
+		lock_guard<mutex> lock(pushLock);
+		const bool first = pushes.empty() || push.at < pushes.top().at;
+		pushes.push(push);
+		if (first)
+		{
+			pushAdded.notify_one();
+		}
+	}
+
+	// Answers the pushes that are due, sleeps until the next one otherwise
+	void PushTimer()
+	{
+		unique_lock<mutex> lock(pushLock);
+		for (;;)
+		{
+			if (pushes.empty())
+			{
+				pushAdded.wait(lock);
+				continue;
+			}
+			if (pushAdded.wait_until(lock, pushes.top().at) == cv_status::no_timeout
+				&& chrono::steady_clock::now() < pushes.top().at)
+			{
+				continue;
+			}
+
+			vector<PUSH> due;
+			const auto now = chrono::steady_clock::now();
+			while (!pushes.empty() && pushes.top().at <= now)
+			{
+				due.push_back(pushes.top());
+				pushes.pop();
+			}
+			lock.unlock();
+
+			for (const PUSH& push : due)
+			{
+				const shared_ptr<CONNECTION> connection = push.connection.lock();
+				if (!connection)
+				{
+					continue;
+				}
+				{
+					lock_guard<mutex> pending(connection->pendingLock);
+					connection->pending.erase(push.requestId);
+				}
+				if (*push.cancelled)
+				{
+					continue;
+				}
+
+				DaemonMessage reply(DAEMON_MESSAGE::PUSH_REPLY, push.requestId);
+				if (options.json)
+				{
+					reply.Add(DAEMON_FIELD::JSON, JsonReply(push.status, push.message, DAEMON_TOKEN::NONE, push.requestId));
+				}
+				else
+				{
+					reply.AddInteger(DAEMON_FIELD::STATUS, uint64_t(push.status)).Add(DAEMON_FIELD::MESSAGE, string(push.message));
+				}
+				if (!WriteFrame(*connection, reply))
+				{
+					shutdown(connection->fd, SHUT_RDWR);
+				}
+			}
+			lock.lock();
+		}
+	}
+
+	void Serve(int fd)
+	{
+		const auto connection = make_shared<CONNECTION>(fd);
+		vector<uint8_t> payload;
+		uint8_t headerBytes[DAEMON_FRAME_HEADER_SIZE];
+		DaemonFields fields;
+		DAEMON_FRAME_HEADER header;
+
+		while (ReadFully(fd, headerBytes, sizeof(headerBytes)) && DaemonProtocol::DecodeHeader(headerBytes, header))
+		{
+			payload.resize(header.length);
+			if (!ReadFully(fd, payload.data(), payload.size()) || !fields.Parse(payload.data(), payload.size()))
+			{
+				break;
+			}
+
+			if (!Inject(static_cast<DAEMON_MESSAGE>(header.type)))
+			{
+				continue;
+			}
+
+			bool written;
+			switch (static_cast<DAEMON_MESSAGE>(header.type))
+			{
+			case DAEMON_MESSAGE::HELLO:
+			{
+				DaemonMessage reply(DAEMON_MESSAGE::HELLO_REPLY, header.requestId);
+				reply.AddInteger(DAEMON_FIELD::VERSION, DAEMON_PROTOCOL_VERSION)
+					.AddInteger(DAEMON_FIELD::CAPABILITIES,
+						DAEMON_CAPABILITY_VERIFY | DAEMON_CAPABILITY_LOOKUP | DAEMON_CAPABILITY_CANCEL | DAEMON_CAPABILITY_PING
+						| DAEMON_CAPABILITY_PUSH);
+				written = WriteFrame(*connection, reply);
+				break;
+			}
+			case DAEMON_MESSAGE::VERIFY:
+			{
+				string user, domain, otp, message;
+				uint64_t key = 0;
+				fields.String(DAEMON_FIELD::USER_NAME, user);
+				fields.String(DAEMON_FIELD::DOMAIN_NAME, domain);
+				fields.String(DAEMON_FIELD::OTP, otp);
+				fields.Integer(DAEMON_FIELD::REQUEST_KEY, key);
+				const AUTH_STATUS status = VerifyOnce(key, user, domain, otp, message);
+				fill(otp.begin(), otp.end(), '\0');
+
+				DaemonMessage reply(DAEMON_MESSAGE::VERIFY_REPLY, header.requestId);
+				if (options.json)
+				{
+					reply.Add(DAEMON_FIELD::JSON, JsonReply(status, message, DAEMON_TOKEN::NONE, header.requestId));
+				}
+				else
+				{
+					reply.AddInteger(DAEMON_FIELD::STATUS, uint64_t(status)).Add(DAEMON_FIELD::MESSAGE, message);
+				}
+				written = WriteFrame(*connection, reply);
+				break;
+			}
+			case DAEMON_MESSAGE::LOOKUP:
+			{
+				string user, domain;
+				fields.String(DAEMON_FIELD::USER_NAME, user);
+				fields.String(DAEMON_FIELD::DOMAIN_NAME, domain);
+				const auto cancelled = make_shared<atomic<bool>>(false);
+				{
+					lock_guard<mutex> lock(connection->pendingLock);
+					connection->pending[header.requestId] = cancelled;
+				}
+				thread(Lookup, connection, header.requestId, user, domain, cancelled).detach();
+				written = true;
+				break;
+			}
+			case DAEMON_MESSAGE::PUSH:
+			{
+				string user, domain;
+				uint64_t expiresMs = 60000;
+				fields.String(DAEMON_FIELD::USER_NAME, user);
+				fields.String(DAEMON_FIELD::DOMAIN_NAME, domain);
+				fields.Integer(DAEMON_FIELD::EXPIRES, expiresMs);
+				ENTRY entry;
+				Resolve(user, domain, nullptr, entry);
+				if (entry.enrolled)
+				{
+					Push(connection, header.requestId, unsigned(expiresMs < 600000 ? expiresMs : 600000));
+					written = true;
+					break;
+				}
+
+				DaemonMessage reply(DAEMON_MESSAGE::PUSH_REPLY, header.requestId);
+				reply.AddInteger(DAEMON_FIELD::STATUS, uint64_t(AUTH_STATUS::NOT_ENROLLED))
+					.Add(DAEMON_FIELD::MESSAGE, string("no device enrolled"));
+				written = WriteFrame(*connection, reply);
+				break;
+			}
+			case DAEMON_MESSAGE::PING:
+			{
+				DaemonMessage reply(DAEMON_MESSAGE::PING_REPLY, header.requestId);
+				written = WriteFrame(*connection, reply);
+				break;
+			}
+			case DAEMON_MESSAGE::CANCEL:
+			{
+				lock_guard<mutex> lock(connection->pendingLock);
+				const auto it = connection->pending.find(header.requestId);
+				if (it != connection->pending.end())
+				{
+					*it->second = true;
+				}
+				written = true;
+				break;
+			}
+			default:
+			{
+				DaemonMessage reply(DAEMON_MESSAGE::ERROR_REPLY, header.requestId);
+				reply.Add(DAEMON_FIELD::MESSAGE, string("unknown message type"));
+				written = WriteFrame(*connection, reply);
+				break;
+			}
+			}
+
+			if (!written)
+			{
+				break;
+			}
+		}
+
+		// Running lookups and pending pushes give up, the last lookup closes the socket
+		shutdown(fd, SHUT_RDWR);
+		lock_guard<mutex> lock(connection->pendingLock);
+		for (auto& request : connection->pending)
+		{
+			*request.second = true;
+		}
+	}
+
+	bool ParseArguments(int argc, char** argv)
+	{
+		for (int i = 1; i < argc; i++)
+		{
+			const string arg = argv[i];
+			if (i + 1 >= argc)
+			{
+				return false;
+			}
+			if (arg == "--socket")
+			{
+				options.socket = argv[++i];
+			}
+			else if (arg == "--store")
+			{
+				options.store = argv[++i];
+			}
+			else if (arg == "--accept")
+			{
+				options.accept = argv[++i];
+			}
+			else if (arg == "--delay")
+			{
+				options.delayMs = unsigned(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--latency")
+			{
+				options.latencyMs = unsigned(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--spike")
+			{
+				const string spike = argv[++i];
+				const size_t colon = spike.find(':');
+				if (colon == string::npos)
+				{
+					return false;
+				}
+				options.spikePercent = strtod(spike.substr(0, colon).c_str(), nullptr);
+				options.spikeMs = unsigned(strtoul(spike.substr(colon + 1).c_str(), nullptr, 10));
+			}
+			else if (arg == "--fail")
+			{
+				options.failPercent = unsigned(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--approve")
+			{
+				options.approveMs = unsigned(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--deny")
+			{
+				options.denyPercent = unsigned(strtoul(argv[++i], nullptr, 10));
+			}
+			else if (arg == "--reply")
+			{
+				const string reply = argv[++i];
+				if (reply != "binary" && reply != "json")
+				{
+					return false;
+				}
+				options.json = reply == "json";
+			}
+			else
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	setlocale(LC_ALL, "C.UTF-8");
+	signal(SIGPIPE, SIG_IGN);
+
+	if (!ParseArguments(argc, argv))
+	{
+		cerr << "Usage: AuthDaemon [--socket path] [--store tokens.db] [--accept code] [--delay ms] [--latency ms] "
+			"[--spike percent:ms] [--fail percent] [--reply binary|json] [--approve ms] [--deny percent]" << endl;
+		return 2;
+	}
+
+	if (!options.store.empty() && !store.Open(Widen(options.store).c_str()))
+	{
+		cerr << "Cannot open token store " << options.store << endl;
+		return 1;
+	}
+	// The whole delta log now, requests read what was appended since
+	if (store.IsOpen() && !store.Refresh())
+	{
+		cerr << "Cannot read the delta log of " << options.store << endl;
+	}
+
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (options.socket.size() >= sizeof(address.sun_path))
+	{
+		cerr << "Socket path too long" << endl;
+		return 1;
+	}
+	memcpy(address.sun_path, options.socket.c_str(), options.socket.size());
+
+	const int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	unlink(options.socket.c_str());
+	if (listener < 0 || ::bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0
+		|| listen(listener, SOMAXCONN) != 0)
+	{
+		cerr << "Cannot listen on " << options.socket << ": " << strerror(errno) << endl;
+		return 1;
+	}
+
+	cout << "Listening on " << options.socket << (store.IsOpen() ? ", token store " + options.store : ", accepting " + options.accept)
+		<< endl;
+
+	thread(PushTimer).detach();
+	for (;;)
+	{
+		const int fd = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+		if (fd < 0)
+		{
+			if (errno == EINTR || errno == ECONNABORTED)
+			{
+				continue;
+			}
+			cerr << "accept: " << strerror(errno) << endl;
+			return 1;
+		}
+		thread(Serve, fd).detach();
+	}
+}
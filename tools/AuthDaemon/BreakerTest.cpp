@@ -0,0 +1,198 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Circuit breaker and negative cache test
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Steps CircuitBreaker and NegativeCache through synthetic time, no clock is
+// read: CLOSED to OPEN after the configured failures, HALF_OPEN once the open
+// time is over, a single trial that closes the breaker on success, opens it
+// again on failure and may be retried once it expired without a verdict.
+// Then the negative cache: expiry after the TTL, Erase() and the capacity,
+// expired entries first, the one that expires first next. Exits with 1 if
+// anything differs. Build it from the repository root with
+//   g++ -std=c++14 -O2 -ICredentialProvider tools/AuthDaemon/BreakerTest.cpp CredentialProvider/daemon/CircuitBreaker.cpp CredentialProvider/daemon/NegativeCache.cpp -o BreakerTest
+
+#include "daemon/CircuitBreaker.h"
+#include "daemon/NegativeCache.h"
+#include <cstdio>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::milliseconds MS;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	// Any fixed point will do, only differences count
+	const CircuitBreaker::TIME T0 = CircuitBreaker::TIME() + chrono::hours(1);
+
+	const unsigned int FAILURES = 3;
+	const MS OPEN_TIME(5000);
+
+	// A breaker that has just opened at T0
+	CircuitBreaker Opened()
+	{
+		CircuitBreaker breaker(FAILURES, OPEN_TIME);
+		for (unsigned int i = 0; i < FAILURES; i++)
+		{
+			breaker.Failure(T0);
+		}
+		return breaker;
+	}
+
+	void CheckClosed()
+	{
+		CircuitBreaker breaker(FAILURES, OPEN_TIME);
+		Expect(breaker.State(T0) == BREAKER_STATE::CLOSED && breaker.Allow(T0), "a new breaker is closed and lets requests through");
+
+		for (unsigned int i = 1; i < FAILURES; i++)
+		{
+			breaker.Failure(T0);
+		}
+		Expect(breaker.State(T0) == BREAKER_STATE::CLOSED, "fewer failures than the threshold keep it closed");
+		breaker.Success(T0);
+		for (unsigned int i = 1; i < FAILURES; i++)
+		{
+			breaker.Failure(T0);
+		}
+		Expect(breaker.State(T0) == BREAKER_STATE::CLOSED, "an answer resets the consecutive failures");
+		breaker.Failure(T0);
+		Expect(breaker.State(T0) == BREAKER_STATE::OPEN && breaker.Trips() == 1, "the threshold-th consecutive failure opens it");
+
+		CircuitBreaker never(0, OPEN_TIME);
+		for (int i = 0; i < 100; i++)
+		{
+			never.Failure(T0);
+		}
+		Expect(never.State(T0) == BREAKER_STATE::CLOSED && never.Trips() == 0, "a threshold of 0 never opens");
+	}
+
+	void CheckOpen()
+	{
+		CircuitBreaker breaker = Opened();
+		const CircuitBreaker::TIME before = T0 + OPEN_TIME - MS(1);
+		Expect(!breaker.Permits(T0) && !breaker.Allow(T0) && !breaker.Allow(before), "an open breaker refuses requests");
+
+		// Verdicts of requests sent before it opened
+		breaker.Success(before);
+		Expect(breaker.State(before) == BREAKER_STATE::OPEN, "a late answer does not close an open breaker");
+		breaker.Failure(before);
+		Expect(breaker.State(T0 + OPEN_TIME) == BREAKER_STATE::HALF_OPEN && breaker.Trips() == 1,
+			"a late failure does not extend the open time");
+	}
+
+	void CheckTrial()
+	{
+		const CircuitBreaker::TIME half = T0 + OPEN_TIME;
+
+		CircuitBreaker breaker = Opened();
+		Expect(breaker.State(half) == BREAKER_STATE::HALF_OPEN && breaker.Permits(half), "half open once the open time is over");
+		Expect(breaker.Allow(half), "the first request is the trial");
+		Expect(!breaker.Allow(half) && !breaker.Allow(half + MS(10)) && !breaker.Permits(half + MS(10)),
+			"only one trial is granted");
+		breaker.Success(half + MS(20));
+		Expect(breaker.State(half + MS(20)) == BREAKER_STATE::CLOSED && breaker.Allow(half + MS(20)) && breaker.Allow(half + MS(20)),
+			"a successful trial closes it");
+		for (unsigned int i = 1; i < FAILURES; i++)
+		{
+			breaker.Failure(half + MS(30));
+		}
+		Expect(breaker.State(half + MS(30)) == BREAKER_STATE::CLOSED, "after closing, failures are counted from 0");
+
+		CircuitBreaker failing = Opened();
+		Expect(failing.Allow(half), "the trial goes out");
+		failing.Failure(half + MS(20));
+		Expect(failing.State(half + MS(20)) == BREAKER_STATE::OPEN && failing.Trips() == 2, "a failed trial opens it again");
+		Expect(!failing.Allow(half + MS(20) + OPEN_TIME - MS(1)), "for another full open time");
+		Expect(failing.State(half + MS(20) + OPEN_TIME) == BREAKER_STATE::HALF_OPEN
+			&& failing.Allow(half + MS(20) + OPEN_TIME), "then the next trial goes");
+
+		// The trial request never comes back
+		CircuitBreaker lost = Opened();
+		Expect(lost.Allow(half), "the trial goes out");
+		Expect(!lost.Allow(half + OPEN_TIME - MS(1)), "no second trial while the first may still answer");
+		Expect(lost.Permits(half + OPEN_TIME) && lost.Allow(half + OPEN_TIME), "an expired trial lets the next one go");
+		Expect(!lost.Allow(half + OPEN_TIME + MS(1)), "and only that one");
+		lost.Success(half + OPEN_TIME + MS(1));
+		Expect(lost.State(half + OPEN_TIME + MS(1)) == BREAKER_STATE::CLOSED && lost.Trips() == 1, "its answer closes the breaker");
+	}
+
+	void CheckNegativeCache()
+	{
+		const NegativeCache::TIME t = T0;
+		const MS ttl(100);
+
+		NegativeCache cache(ttl, 3);
+		cache.Insert("alice", t);
+		Expect(cache.Contains("alice", t) && cache.Contains("alice", t + ttl - MS(1)), "a key is remembered for the TTL");
+		Expect(!cache.Contains("alice", t + ttl), "and forgotten when it is over");
+		Expect(!cache.Contains("bob", t), "other keys are not remembered");
+		cache.Insert("alice", t + ttl);
+		Expect(cache.Contains("alice", t + ttl + MS(50)) && cache.Size() == 1, "inserting again renews the TTL");
+		cache.Erase("alice");
+		Expect(!cache.Contains("alice", t + ttl + MS(50)) && cache.Size() == 0, "Erase() forgets a key at once");
+		cache.Erase("nobody");
+		Expect(cache.Size() == 0, "erasing an unknown key does nothing");
+
+		// Capacity 3: a expires at 100, b at 150, c at 160
+		NegativeCache full(ttl, 3);
+		full.Insert("a", t);
+		full.Insert("b", t + MS(50));
+		full.Insert("c", t + MS(60));
+		full.Insert("d", t + MS(120));
+		Expect(full.Size() == 3 && full.Contains("b", t + MS(120)) && full.Contains("c", t + MS(120))
+			&& full.Contains("d", t + MS(120)), "a full cache drops the expired entries first");
+		full.Insert("e", t + MS(130));
+		Expect(full.Size() == 3 && !full.Contains("b", t + MS(130)) && full.Contains("c", t + MS(130))
+			&& full.Contains("d", t + MS(130)) && full.Contains("e", t + MS(130)), "then the entry that expires first");
+		full.Insert("c", t + MS(140));
+		Expect(full.Size() == 3 && full.Contains("d", t + MS(140)) && full.Contains("e", t + MS(140))
+			&& full.Contains("c", t + MS(200)), "renewing a key of a full cache drops nothing");
+
+		NegativeCache off;
+		off.Insert("alice", t);
+		Expect(!off.Contains("alice", t) && off.Size() == 0, "a TTL of 0 remembers nothing");
+		NegativeCache none(ttl, 0);
+		none.Insert("alice", t);
+		Expect(!none.Contains("alice", t) && none.Size() == 0, "a capacity of 0 remembers nothing");
+	}
+}
+
+int main()
+{
+	CheckClosed();
+	CheckOpen();
+	CheckTrial();
+	CheckNegativeCache();
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n");
+	return 0;
+}
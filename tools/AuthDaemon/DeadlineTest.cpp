@@ -0,0 +1,385 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Deadline and cancellation test of a verification
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Checks AuthDeadline the way Connect uses it, against a daemon that never
+// answers: a mock on a Unix domain socket of its own that completes the
+// handshake, or not, swallows every request and counts the CANCELs it gets.
+// A mock progress stands in for the IQueryContinueWithStatus of LogonUI, it
+// counts the polls, keeps the status texts and cancels when told to.
+//  - the deadline passes: TIMEOUT close to it, the seconds counted down in
+//    the status text, the daemon told to abandon the request
+//  - the user cancels: CANCELLED within a poll, the daemon told as well
+//  - a handshake that never completes, cancelled and expired
+//  - without progress the deadline alone applies, a limit below it wins
+// Exits with 1 on any failure. Linux only.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider -IShared tools/AuthDaemon/DeadlineTest.cpp CredentialProvider/daemon/*.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o DeadlineTest
+//
+// Usage: DeadlineTest [--slack ms]
+
+#include "daemon/AuthDeadline.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	double Millis(CLOCK::time_point start)
+	{
+		return chrono::duration<double, milli>(CLOCK::now() - start).count();
+	}
+
+	bool ReadFully(int fd, uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t read = recv(fd, data, size, 0);
+			if (read <= 0)
+			{
+				return false;
+			}
+			data += read;
+			size -= size_t(read);
+		}
+		return true;
+	}
+
+	// Daemon that answers nothing but HELLO, and that only if handshake is set
+	class MockDaemon
+	{
+	public:
+		explicit MockDaemon(const string& path) : _path(path)
+		{
+			unlink(_path.c_str());
+			sockaddr_un address;
+			memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			memcpy(address.sun_path, _path.c_str(), _path.size());
+			_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (_listener < 0 || bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+				|| listen(_listener, 16) != 0)
+			{
+				return;
+			}
+			_acceptor = thread([this]() { Accept(); });
+		}
+
+		~MockDaemon()
+		{
+			shutdown(_listener, SHUT_RDWR);
+			close(_listener);
+			if (_acceptor.joinable())
+			{
+				_acceptor.join();
+			}
+			{
+				lock_guard<mutex> lock(_lock);
+				for (int fd : _connections)
+				{
+					shutdown(fd, SHUT_RDWR);
+				}
+			}
+			for (thread& t : _servers)
+			{
+				t.join();
+			}
+			for (int fd : _connections)
+			{
+				close(fd);
+			}
+			unlink(_path.c_str());
+		}
+
+		bool IsListening() const { return _acceptor.joinable(); }
+
+		// Waits up to timeoutMs for count CANCELs in all
+		bool WaitCancels(size_t count, unsigned int timeoutMs) const
+		{
+			const auto until = CLOCK::now() + chrono::milliseconds(timeoutMs);
+			while (cancels.load() < count && CLOCK::now() < until)
+			{
+				this_thread::sleep_for(chrono::milliseconds(5));
+			}
+			return cancels.load() >= count;
+		}
+
+		atomic<bool> handshake{ true };
+		atomic<size_t> verifies{ 0 };
+		atomic<size_t> cancels{ 0 };
+
+	private:
+		void Accept()
+		{
+			for (;;)
+			{
+				const int fd = accept(_listener, nullptr, nullptr);
+				if (fd < 0)
+				{
+					return;
+				}
+				lock_guard<mutex> lock(_lock);
+				_connections.push_back(fd);
+				_servers.emplace_back([this, fd]() { Serve(fd); });
+			}
+		}
+
+		void Serve(int fd)
+		{
+			uint8_t headerBytes[DAEMON_FRAME_HEADER_SIZE];
+			vector<uint8_t> payload;
+			DAEMON_FRAME_HEADER header;
+			while (ReadFully(fd, headerBytes, sizeof(headerBytes)) && DaemonProtocol::DecodeHeader(headerBytes, header))
+			{
+				payload.resize(header.length);
+				if (!ReadFully(fd, payload.data(), payload.size()))
+				{
+					return;
+				}
+
+				switch (static_cast<DAEMON_MESSAGE>(header.type))
+				{
+				case DAEMON_MESSAGE::HELLO:
+					if (handshake)
+					{
+						DaemonMessage reply(DAEMON_MESSAGE::HELLO_REPLY, header.requestId);
+						reply.AddInteger(DAEMON_FIELD::VERSION, DAEMON_PROTOCOL_VERSION)
+							.AddInteger(DAEMON_FIELD::CAPABILITIES, DAEMON_CAPABILITY_VERIFY | DAEMON_CAPABILITY_CANCEL);
+						const vector<uint8_t>& frame = reply.Finish();
+						send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+					}
+					break;
+				case DAEMON_MESSAGE::VERIFY:
+					verifies++;
+					break;
+				case DAEMON_MESSAGE::CANCEL:
+					cancels++;
+					break;
+				default:
+					break;
+				}
+			}
+		}
+
+		const string _path;
+		int _listener = -1;
+		thread _acceptor;
+		mutex _lock;
+		vector<int> _connections;
+		vector<thread> _servers;
+	};
+
+	// Stands in for LogonUI, the user cancels once cancelAfterMs have passed
+	class MockProgress : public AuthProgress
+	{
+	public:
+		explicit MockProgress(unsigned int cancelAfterMs = 0) :
+			_cancelAt(cancelAfterMs != 0 ? CLOCK::now() + chrono::milliseconds(cancelAfterMs) : CLOCK::time_point::max())
+		{
+		}
+
+		bool QueryContinue() override
+		{
+			polls++;
+			return CLOCK::now() < _cancelAt;
+		}
+
+		void SetStatusMessage(const std::wstring& message) override
+		{
+			messages.push_back(message);
+		}
+
+		size_t polls = 0;
+		vector<wstring> messages;
+
+	private:
+		const CLOCK::time_point _cancelAt;
+	};
+
+	const wchar_t* STATUS = L"Verifying";
+
+	void CheckTimeout(const string& endpoint, MockDaemon& daemon, unsigned int slackMs)
+	{
+		AuthClient client;
+		Expect(client.Connect(endpoint, 2000), "the client connects to the mock");
+		const size_t cancels = daemon.cancels.load();
+
+		MockProgress progress;
+		const auto start = CLOCK::now();
+		AuthDeadline deadline(2500, &progress, STATUS);
+		AUTH_CALL call = client.Verify("alice", "corp", "123456");
+		const AUTH_RESULT result = deadline.Wait(client, call);
+		const double elapsed = Millis(start);
+
+		Expect(result.status == AUTH_STATUS::TIMEOUT, "a request the daemon never answers times out");
+		Expect(elapsed >= 2500 && elapsed < 2500 + slackMs, "it times out at the deadline");
+		Expect(deadline.Expired() && !deadline.Cancelled(), "the deadline has expired, the user did not cancel");
+		// One poll right away, then one per AUTH_DEADLINE_POLL_MS
+		Expect(progress.polls >= 2500 / AUTH_DEADLINE_POLL_MS / 2, "QueryContinue() is polled throughout");
+
+		const vector<wstring> countdown = { L"Verifying (3 s)", L"Verifying (2 s)", L"Verifying (1 s)" };
+		bool counted = progress.messages.size() >= countdown.size();
+		for (size_t i = 0; counted && i < countdown.size(); i++)
+		{
+			counted = progress.messages[i] == countdown[i];
+		}
+		Expect(counted, "the status text counts the seconds down, once per second");
+		Expect(daemon.WaitCancels(cancels + 1, 1000), "the daemon is told to abandon the request");
+		printf("timeout:          %7.1f ms, %zu polls, %zu status texts, last \"%ls\"\n", elapsed, progress.polls,
+			progress.messages.size(), progress.messages.empty() ? L"" : progress.messages.back().c_str());
+	}
+
+	void CheckCancel(const string& endpoint, MockDaemon& daemon, unsigned int slackMs)
+	{
+		AuthClient client;
+		Expect(client.Connect(endpoint, 2000), "the client connects to the mock");
+		const size_t cancels = daemon.cancels.load();
+
+		MockProgress progress(300);
+		const auto start = CLOCK::now();
+		AuthDeadline deadline(10000, &progress, STATUS);
+		AUTH_CALL call = client.Verify("alice", "corp", "123456");
+		const AUTH_RESULT result = deadline.Wait(client, call);
+		const double elapsed = Millis(start);
+
+		Expect(result.status == AUTH_STATUS::CANCELLED, "a request the user cancels is CANCELLED");
+		Expect(elapsed >= 300 && elapsed < 300 + AUTH_DEADLINE_POLL_MS + slackMs, "it is cancelled within a poll");
+		Expect(deadline.Cancelled() && !deadline.Continue(), "the deadline stays cancelled");
+		Expect(daemon.WaitCancels(cancels + 1, 1000), "the daemon is told to abandon the request");
+		printf("user cancel:      %7.1f ms after the start, cancelled at 300 ms\n", elapsed);
+	}
+
+	void CheckConnect(const string& endpoint, MockDaemon& daemon, unsigned int slackMs)
+	{
+		daemon.handshake = false;
+		{
+			AuthClient client;
+			client.ConnectAsync(endpoint, 1500);
+			MockProgress progress(300);
+			const auto start = CLOCK::now();
+			AuthDeadline deadline(10000, &progress, STATUS);
+			const bool connected = deadline.WaitConnected(client);
+			const double elapsed = Millis(start);
+			Expect(!connected && deadline.Cancelled(), "a stalled handshake is given up when the user cancels");
+			Expect(elapsed < 300 + AUTH_DEADLINE_POLL_MS + slackMs, "the cancel ends the wait within a poll");
+			printf("cancel connect:   %7.1f ms after the start, cancelled at 300 ms\n", elapsed);
+		}
+		{
+			AuthClient client;
+			client.ConnectAsync(endpoint, 1500);
+			MockProgress progress;
+			const auto start = CLOCK::now();
+			AuthDeadline deadline(800, &progress, STATUS);
+			const bool connected = deadline.WaitConnected(client);
+			const double elapsed = Millis(start);
+			Expect(!connected && deadline.Expired() && !deadline.Cancelled(), "a stalled handshake is given up at the deadline");
+			Expect(elapsed >= 800 && elapsed < 800 + slackMs, "the wait ends at the deadline");
+			printf("expire connect:   %7.1f ms, deadline 800 ms\n", elapsed);
+		}
+		daemon.handshake = true;
+	}
+
+	void CheckWithoutProgress(const string& endpoint, unsigned int slackMs)
+	{
+		AuthClient client;
+		Expect(client.Connect(endpoint, 2000), "the client connects to the mock");
+
+		auto start = CLOCK::now();
+		AuthDeadline deadline(600, nullptr, STATUS);
+		Expect(deadline.Continue(), "a deadline without progress continues until it expires");
+		AUTH_CALL call = client.Verify("alice", "corp", "123456");
+		AUTH_RESULT result = deadline.Wait(client, call);
+		double elapsed = Millis(start);
+		Expect(result.status == AUTH_STATUS::TIMEOUT && elapsed >= 600 && elapsed < 600 + slackMs,
+			"without progress the deadline alone applies");
+		Expect(!deadline.Continue() && deadline.RemainingMs() == 0, "an expired deadline does not continue");
+
+		start = CLOCK::now();
+		AuthDeadline longer(5000, nullptr, STATUS);
+		call = client.Verify("alice", "corp", "123456");
+		result = longer.Wait(client, call, 200);
+		elapsed = Millis(start);
+		Expect(result.status == AUTH_STATUS::TIMEOUT && elapsed >= 200 && elapsed < 200 + slackMs && !longer.Expired(),
+			"a limit below the deadline ends the wait first");
+		printf("no progress:      deadline 600 ms, limit 200 ms of 5000 ms after %.1f ms\n", elapsed);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	unsigned int slackMs = 250;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (string(argv[i]) == "--slack")
+		{
+			slackMs = static_cast<unsigned int>(strtoul(argv[i + 1], nullptr, 10));
+		}
+	}
+	if (slackMs == 0)
+	{
+		fprintf(stderr, "Usage: DeadlineTest [--slack ms]\n");
+		return 2;
+	}
+
+	// A socket of its own, an installed daemon is left alone
+	const string endpoint = "/tmp/das-deadline-test-" + to_string(getpid()) + ".sock";
+	{
+		MockDaemon daemon(endpoint);
+		if (!daemon.IsListening())
+		{
+			fprintf(stderr, "FAIL the mock daemon listens on %s\n", endpoint.c_str());
+			return 1;
+		}
+		CheckTimeout(endpoint, daemon, slackMs);
+		CheckCancel(endpoint, daemon, slackMs);
+		CheckConnect(endpoint, daemon, slackMs);
+		CheckWithoutProgress(endpoint, slackMs);
+		Expect(daemon.verifies.load() == 4, "every request reached the daemon");
+	}
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n");
+	return 0;
+}
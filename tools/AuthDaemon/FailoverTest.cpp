@@ -0,0 +1,367 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Failover test of AuthBackends
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Runs AuthBackends against two mock daemons on Unix domain sockets of their
+// own, whose faults are switched while the logons go on: a daemon that stops
+// answering and one that turns slow, below the time limit of an attempt, so
+// it still answers. Checks that
+//  - the faster daemon serves while both are healthy
+//  - once a fault is injected the logons move to the healthy daemon, every
+//    one answered well within its deadline
+//  - the error rate, or the latency average, of the faulty daemon rises
+//    above that of the healthy one
+//  - after the fault is gone the prober's pings alone bring it back to the
+//    top of the ranking, and it serves again
+// Exits with 1 on any failure. Linux only.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider -IShared tools/AuthDaemon/FailoverTest.cpp CredentialProvider/daemon/*.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o FailoverTest
+//
+// Usage: FailoverTest [--logons n]
+
+#include "daemon/AuthBackends.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	double Millis(CLOCK::time_point start)
+	{
+		return chrono::duration<double, milli>(CLOCK::now() - start).count();
+	}
+
+	bool ReadFully(int fd, uint8_t* data, size_t size)
+	{
+		while (size > 0)
+		{
+			const ssize_t read = recv(fd, data, size, 0);
+			if (read <= 0)
+			{
+				return false;
+			}
+			data += read;
+			size -= size_t(read);
+		}
+		return true;
+	}
+
+	// Daemon that accepts every code, after latencyMs, or answers nothing but HELLO while mute
+	class MockDaemon
+	{
+	public:
+		explicit MockDaemon(const string& path) : _path(path)
+		{
+			unlink(_path.c_str());
+			sockaddr_un address;
+			memset(&address, 0, sizeof(address));
+			address.sun_family = AF_UNIX;
+			memcpy(address.sun_path, _path.c_str(), _path.size());
+			_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+			if (_listener < 0 || bind(_listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+				|| listen(_listener, 16) != 0)
+			{
+				return;
+			}
+			_acceptor = thread([this]() { Accept(); });
+		}
+
+		~MockDaemon()
+		{
+			shutdown(_listener, SHUT_RDWR);
+			close(_listener);
+			if (_acceptor.joinable())
+			{
+				_acceptor.join();
+			}
+			{
+				lock_guard<mutex> lock(_lock);
+				for (int fd : _connections)
+				{
+					shutdown(fd, SHUT_RDWR);
+				}
+			}
+			for (thread& t : _servers)
+			{
+				t.join();
+			}
+			for (int fd : _connections)
+			{
+				close(fd);
+			}
+			unlink(_path.c_str());
+		}
+
+		const string& Path() const { return _path; }
+
+		bool IsListening() const { return _acceptor.joinable(); }
+
+		atomic<unsigned int> latencyMs{ 0 };
+		atomic<bool> mute{ false };
+		atomic<size_t> verifies{ 0 };
+		atomic<size_t> pings{ 0 };
+
+	private:
+		void Accept()
+		{
+			for (;;)
+			{
+				const int fd = accept(_listener, nullptr, nullptr);
+				if (fd < 0)
+				{
+					return;
+				}
+				lock_guard<mutex> lock(_lock);
+				_connections.push_back(fd);
+				_servers.emplace_back([this, fd]() { Serve(fd); });
+			}
+		}
+
+		void Serve(int fd)
+		{
+			uint8_t headerBytes[DAEMON_FRAME_HEADER_SIZE];
+			vector<uint8_t> payload;
+			DAEMON_FRAME_HEADER header;
+			while (ReadFully(fd, headerBytes, sizeof(headerBytes)) && DaemonProtocol::DecodeHeader(headerBytes, header))
+			{
+				payload.resize(header.length);
+				if (!ReadFully(fd, payload.data(), payload.size()))
+				{
+					return;
+				}
+
+				const DAEMON_MESSAGE type = static_cast<DAEMON_MESSAGE>(header.type);
+				if (type == DAEMON_MESSAGE::HELLO)
+				{
+					DaemonMessage reply(DAEMON_MESSAGE::HELLO_REPLY, header.requestId);
+					reply.AddInteger(DAEMON_FIELD::VERSION, DAEMON_PROTOCOL_VERSION)
+						.AddInteger(DAEMON_FIELD::CAPABILITIES, DAEMON_CAPABILITY_VERIFY | DAEMON_CAPABILITY_CANCEL | DAEMON_CAPABILITY_PING);
+					Send(fd, reply);
+					continue;
+				}
+				if ((type != DAEMON_MESSAGE::VERIFY && type != DAEMON_MESSAGE::PING) || mute)
+				{
+					continue;
+				}
+
+				// Like the stand-in AuthDaemon, one connection answers in order
+				const unsigned int delay = latencyMs;
+				if (delay > 0)
+				{
+					this_thread::sleep_for(chrono::milliseconds(delay));
+				}
+				if (type == DAEMON_MESSAGE::PING)
+				{
+					pings++;
+					DaemonMessage reply(DAEMON_MESSAGE::PING_REPLY, header.requestId);
+					Send(fd, reply);
+				}
+				else
+				{
+					verifies++;
+					DaemonMessage reply(DAEMON_MESSAGE::VERIFY_REPLY, header.requestId);
+					reply.AddInteger(DAEMON_FIELD::STATUS, uint64_t(AUTH_STATUS::ACCEPTED)).Add(DAEMON_FIELD::MESSAGE, string("accepted"));
+					Send(fd, reply);
+				}
+			}
+		}
+
+		void Send(int fd, DaemonMessage& message)
+		{
+			const vector<uint8_t>& frame = message.Finish();
+			send(fd, frame.data(), frame.size(), MSG_NOSIGNAL);
+		}
+
+		const string _path;
+		int _listener = -1;
+		thread _acceptor;
+		mutex _lock;
+		vector<int> _connections;
+		vector<thread> _servers;
+	};
+
+	const unsigned int TIMEOUT_MS = 1000;
+	const unsigned int DEADLINE_MS = 3000;
+	const unsigned int PROBE_MS = 50;
+
+	struct ROUND
+	{
+		vector<size_t> served;
+		size_t answered = 0;
+		double slowestMs = 0;
+		size_t lastBackend = 0;
+	};
+
+	ROUND Logons(AuthBackends& backends, size_t logons)
+	{
+		ROUND round;
+		round.served.assign(backends.Count(), 0);
+		for (size_t i = 0; i < logons; i++)
+		{
+			AuthDeadline deadline(DEADLINE_MS, nullptr, L"");
+			AUTH_ROUTE route;
+			const auto start = CLOCK::now();
+			const AUTH_RESULT result = backends.Verify("alice", "corp", "123456", deadline, &route);
+			const double elapsed = Millis(start);
+			round.slowestMs = elapsed > round.slowestMs ? elapsed : round.slowestMs;
+			round.answered += result.status == AUTH_STATUS::ACCEPTED;
+			round.served[route.backend]++;
+			round.lastBackend = route.backend;
+		}
+		return round;
+	}
+
+	// Waits up to timeoutMs for backend to head the ranking again
+	bool WaitFirst(AuthBackends& backends, size_t backend, unsigned int timeoutMs)
+	{
+		const auto until = CLOCK::now() + chrono::milliseconds(timeoutMs);
+		while (CLOCK::now() < until)
+		{
+			const vector<size_t> ranking = backends.Ranking();
+			if (!ranking.empty() && ranking[0] == backend)
+			{
+				return true;
+			}
+			this_thread::sleep_for(chrono::milliseconds(10));
+		}
+		return false;
+	}
+
+	void Print(const char* phase, const ROUND& round, AuthBackends& backends)
+	{
+		printf("%-22s served %zu / %zu, slowest logon %7.1f ms", phase, round.served[0], round.served[1], round.slowestMs);
+		for (size_t b = 0; b < backends.Count(); b++)
+		{
+			const AUTH_BACKEND_HEALTH health = backends.Health(b);
+			printf(" | %c: %8.0f us, errors %.2f", char('A' + b), health.latencyUs, health.errorRate);
+		}
+		printf("\n");
+	}
+
+	// primary, backend 0, is faster until fault() breaks it, recover() mends it
+	template <typename FAULT, typename RECOVER>
+	void CheckFailover(const char* name, MockDaemon& primary, MockDaemon& secondary, size_t logons, FAULT fault, RECOVER recover,
+		bool errors)
+	{
+		primary.mute = false;
+		primary.latencyMs = 0;
+		secondary.mute = false;
+		secondary.latencyMs = 20;
+
+		AuthBackends backends({ primary.Path(), secondary.Path() }, TIMEOUT_MS, PROBE_MS);
+		backends.ConnectAsync();
+		this_thread::sleep_for(chrono::milliseconds(200));
+		printf("%s\n", name);
+
+		ROUND round = Logons(backends, logons);
+		Print("  both healthy", round, backends);
+		Expect(round.answered == logons, "every logon is answered while both daemons are healthy");
+		Expect(round.served[0] > round.served[1], "the faster daemon serves most logons");
+
+		fault(primary);
+		round = Logons(backends, logons);
+		Print("  fault injected", round, backends);
+		const AUTH_BACKEND_HEALTH faulty = backends.Health(0);
+		const AUTH_BACKEND_HEALTH healthy = backends.Health(1);
+		Expect(round.answered == logons, "every logon is answered while one daemon is faulty");
+		Expect(round.slowestMs < DEADLINE_MS, "every logon ends before its deadline");
+		Expect(round.served[1] >= logons - 2 && round.lastBackend == 1, "the logons move to the healthy daemon");
+		Expect(faulty.latencyUs > healthy.latencyUs, "the latency average of the faulty daemon rises above the healthy one");
+		if (errors)
+		{
+			Expect(faulty.errorRate > healthy.errorRate, "the error rate of the failing daemon rises above the healthy one");
+		}
+		Expect(backends.Ranking().size() == 2 && backends.Ranking()[0] == 1, "the healthy daemon heads the ranking");
+
+		// No logons meanwhile, only the prober's pings can tell that it is back
+		recover(primary);
+		const size_t pings = primary.pings.load();
+		const auto start = CLOCK::now();
+		const bool restored = WaitFirst(backends, 0, 10000);
+		printf("  recovered after       %7.1f ms, %zu pings\n", Millis(start), primary.pings.load() - pings);
+		Expect(restored, "the prober brings the recovered daemon back to the top of the ranking");
+		round = Logons(backends, logons);
+		Print("  recovered", round, backends);
+		Expect(round.answered == logons && round.served[0] > round.served[1], "the recovered daemon serves again");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t logons = 20;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (string(argv[i]) == "--logons")
+		{
+			logons = strtoul(argv[i + 1], nullptr, 10);
+		}
+	}
+	if (logons < 4)
+	{
+		fprintf(stderr, "Usage: FailoverTest [--logons n], n at least 4\n");
+		return 2;
+	}
+
+	// Sockets of their own, an installed daemon is left alone
+	const string prefix = "/tmp/das-failover-test-" + to_string(getpid());
+	{
+		MockDaemon a(prefix + "-a.sock");
+		MockDaemon b(prefix + "-b.sock");
+		if (!a.IsListening() || !b.IsListening())
+		{
+			fprintf(stderr, "FAIL the mock daemons listen on %s-*.sock\n", prefix.c_str());
+			return 1;
+		}
+
+		CheckFailover("daemon stops answering", a, b, logons,
+			[](MockDaemon& d) { d.mute = true; }, [](MockDaemon& d) { d.mute = false; }, true);
+		CheckFailover("daemon turns slow", a, b, logons,
+			[](MockDaemon& d) { d.latencyMs = 150; }, [](MockDaemon& d) { d.latencyMs = 0; }, false);
+	}
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n");
+	return 0;
+}
@@ -0,0 +1,226 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - JSON reply decoding benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Decodes representative daemon replies with DaemonJson, a SAX pass over the
+// text, and with a full nlohmann::json document that the same fields are then
+// read from, the way it would be done without DaemonJson. Reports the time
+// and the heap allocations per reply. Build it from the repository root with
+//   g++ -std=c++14 -O2 -ICredentialProvider -IShared tools/AuthDaemon/JsonBench.cpp CredentialProvider/daemon/DaemonJson.cpp -o JsonBench
+//
+// Usage: JsonBench [--iterations n]
+
+#include "json.hpp"
+#include "daemon/DaemonJson.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	atomic<size_t> allocations{ 0 };
+}
+
+namespace
+{
+	void* Allocate(size_t size)
+	{
+		allocations++;
+		void* p = malloc(size != 0 ? size : 1);
+		if (p == nullptr)
+		{
+			throw bad_alloc();
+		}
+		return p;
+	}
+}
+
+// Every form the library may pair, so no delete meets a new it does not match
+void* operator new(size_t size)
+{
+	return Allocate(size);
+}
+
+void* operator new[](size_t size)
+{
+	return Allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+	typedef nlohmann::json JSON;
+
+	struct PAYLOAD
+	{
+		const char* name;
+		string text;
+	};
+
+	vector<PAYLOAD> Payloads()
+	{
+		vector<PAYLOAD> payloads;
+		payloads.push_back({ "minimal", "{\"status\":\"accepted\",\"message\":\"ok\"}" });
+
+		payloads.push_back({ "challenge", "{\"id\":4711,\"status\":\"rejected\",\"message\":\"Please enter the code sent by SMS\","
+			"\"token_type\":\"hotp\",\"challenge\":\"Code sent to +41 ** *** 12 34, reference 58213\","
+			"\"detail\":{\"daemon\":\"AuthDaemon\",\"version\":1,\"threadid\":17}}" });
+
+		// Verbose upstream service: several challenges, attributes and an enrollment image nobody reads
+		string verbose = "{\"id\":4712,\"jsonrpc\":\"2.0\",\"version\":\"3.8.1\",\"time\":1791111111.4213,"
+			"\"detail\":{\"transaction_id\":\"05871802765465925744\",\"threadid\":140234,\"multi_challenge\":[";
+		for (int i = 0; i < 5; i++)
+		{
+			verbose += string(i > 0 ? "," : "") + "{\"serial\":\"OATH000" + to_string(i) + "\",\"type\":\"hotp\","
+				"\"transaction_id\":\"05871802765465925744\",\"message\":\"please enter otp\","
+				"\"attributes\":{\"hideResponseInput\":false,\"img\":\"\",\"position\":[" + to_string(i) + ",1.5,null]}}";
+		}
+		verbose += "],\"image\":\"data:image/png;base64," + string(1024, 'A') + "\",\"preferred_client_mode\":\"interactive\"},"
+			"\"status\":\"rejected\",\"message\":\"please enter otp\",\"token_type\":\"hotp\","
+			"\"challenge\":\"Code sent to +41 ** *** 12 34\",\"signature\":\"rsa_sha256_pss:" + string(512, 'f') + "\"}";
+		payloads.push_back({ "verbose", verbose });
+		return payloads;
+	}
+
+	void Widen(const string& in, SecureWString& out)
+	{
+		out.clear();
+		for (const char c : in)
+		{
+			out.push_back(static_cast<wchar_t>(static_cast<unsigned char>(c)));
+		}
+	}
+
+	// The same fields through a document
+	bool DecodeDom(const string& text, DAEMON_JSON_REPLY& reply)
+	{
+		const JSON document = JSON::parse(text, nullptr, false);
+		if (!document.is_object())
+		{
+			return false;
+		}
+
+		const auto status = document.find("status");
+		if (status != document.end() && status->is_string())
+		{
+			const string& value = status->get_ref<const string&>();
+			reply.hasStatus = value == "accepted" || value == "rejected" || value == "not_enrolled";
+			reply.status = value == "accepted" ? AUTH_STATUS::ACCEPTED : value == "rejected" ? AUTH_STATUS::REJECTED
+				: AUTH_STATUS::NOT_ENROLLED;
+		}
+		const auto message = document.find("message");
+		if (message != document.end() && message->is_string())
+		{
+			const string& value = message->get_ref<const string&>();
+			reply.messageLength = min(value.size(), size_t(DAEMON_JSON_MAX_MESSAGE - 1));
+			copy(value.begin(), value.begin() + reply.messageLength, reply.message);
+		}
+		const auto token = document.find("token_type");
+		if (token != document.end() && token->is_string())
+		{
+			reply.token = token->get_ref<const string&>() == "hotp" ? DAEMON_TOKEN::HOTP : DAEMON_TOKEN::TOTP;
+		}
+		const auto challenge = document.find("challenge");
+		if (challenge != document.end() && challenge->is_string())
+		{
+			Widen(challenge->get_ref<const string&>(), reply.challenge);
+		}
+		return true;
+	}
+
+	template <class DECODE>
+	void Measure(const char* name, const PAYLOAD& payload, size_t iterations, DECODE decode)
+	{
+		// Best of five runs, the others only warm up
+		double best = 1e300;
+		size_t allocated = 0;
+		for (int run = 0; run < 5; run++)
+		{
+			const size_t before = allocations;
+			const auto start = CLOCK::now();
+			for (size_t i = 0; i < iterations; i++)
+			{
+				DAEMON_JSON_REPLY reply;
+				if (!decode(payload.text, reply) || !reply.hasStatus)
+				{
+					fprintf(stderr, "%s failed on %s\n", name, payload.name);
+					exit(1);
+				}
+			}
+			best = min(best, chrono::duration<double, nano>(CLOCK::now() - start).count() / double(iterations));
+			allocated = (allocations - before) / iterations;
+		}
+		printf("  %-4s %9.0f ns, %3zu allocations\n", name, best, allocated);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t iterations = 100000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (string(argv[i]) == "--iterations")
+		{
+			iterations = strtoul(argv[i + 1], nullptr, 10);
+		}
+	}
+	if (iterations == 0)
+	{
+		fprintf(stderr, "Usage: JsonBench [--iterations n]\n");
+		return 2;
+	}
+
+	for (const PAYLOAD& payload : Payloads())
+	{
+		printf("%s reply, %zu bytes:\n", payload.name, payload.text.size());
+		Measure("DOM", payload, iterations, DecodeDom);
+		Measure("SAX", payload, iterations, [](const string& text, DAEMON_JSON_REPLY& reply)
+		{
+			return DaemonJson::Decode(text.data(), text.size(), reply);
+		});
+	}
+	return 0;
+}
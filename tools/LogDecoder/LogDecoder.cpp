@@ -0,0 +1,253 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Binary log decoder
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Turns a binary log, log_format "binary", into the lines of the text log.
+// Platform neutral, on Linux build it from the repository root with
+//   g++ -std=c++14 -O2 -IShared tools/LogDecoder/LogDecoder.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o LogDecoder
+//
+// Usage: LogDecoder [--release] input.bin [output.txt]
+//
+// --release keeps the ReleaseDebugPrint lines only, what the text log of a
+// release build shows. Without output the lines go to stdout.
+
+#include "LogFormat.h"
+#include "Utf8.h"
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	struct SESSION
+	{
+		uint64_t ticks = 0;
+		uint64_t ticksPerSecond = 0;
+		int64_t unixMicros = 0;
+		int32_t utcOffset = 0;
+	};
+
+	struct SITE
+	{
+		string file;
+		int line = 0;
+		bool production = false;
+	};
+
+	typedef pair<uint32_t, uint32_t> SITE_KEY;	// session, site
+
+	string Argument(LOG_ARG arg, const uint8_t* data, uint32_t length)
+	{
+		string text;
+		switch (arg)
+		{
+		case LOG_ARG::TEXT:
+			text.assign(reinterpret_cast<const char*>(data), length);
+			break;
+		case LOG_ARG::UTF16:
+		{
+			// Little endian code units, the payload is not aligned for them
+			vector<char16_t> units(length / 2);
+			for (size_t i = 0; i < units.size(); i++)
+			{
+				units[i] = char16_t(data[2 * i] | (data[2 * i + 1] << 8));
+			}
+			text.resize(Utf8::MaxBytes(units.size()));
+			text.resize(Utf8::FromUtf16(units.data(), units.size(), &text[0]));
+			break;
+		}
+		case LOG_ARG::UTF32:
+		{
+			vector<char32_t> units(length / 4);
+			for (size_t i = 0; i < units.size(); i++)
+			{
+				units[i] = char32_t(data[4 * i] | (uint32_t(data[4 * i + 1]) << 8) | (uint32_t(data[4 * i + 2]) << 16) | (uint32_t(data[4 * i + 3]) << 24));
+			}
+			text.resize(4 * units.size());
+			text.resize(Utf8::FromUtf32(units.data(), units.size(), &text[0]));
+			break;
+		}
+		case LOG_ARG::INT:
+			if (length == sizeof(int32_t))
+			{
+				int32_t value = 0;
+				memcpy(&value, data, sizeof(value));
+				text = "(int) " + to_string(value);
+			}
+			break;
+		default:
+			break;
+		}
+		return text;
+	}
+
+	// [Time] of the text log, local time of the machine that wrote the log
+	string Time(const SESSION* session, uint64_t ticks)
+	{
+		if (session == nullptr || session->ticksPerSecond == 0)
+		{
+			return "?";
+		}
+		const double elapsed = (double(int64_t(ticks - session->ticks)) / double(session->ticksPerSecond));
+		const int64_t micros = session->unixMicros + int64_t(elapsed * 1e6);
+		time_t local = time_t(micros / 1000000) + session->utcOffset;
+		const struct tm* parts = gmtime(&local);
+		char buffer[80] = {};
+		if (parts != nullptr)
+		{
+			const size_t length = strftime(buffer, sizeof(buffer), "%d-%m-%Y %H:%M:%S", parts);
+			snprintf(buffer + length, sizeof(buffer) - length, ".%06d", int(micros % 1000000));
+		}
+		return buffer;
+	}
+
+	// Calls visit(header, payload) for every intact record, returns false for a torn or foreign file
+	template <typename VISITOR>
+	bool Scan(const vector<uint8_t>& log, VISITOR&& visit)
+	{
+		size_t offset = 0;
+		while (offset + sizeof(LOG_RECORD_HEADER) <= log.size())
+		{
+			LOG_RECORD_HEADER header;
+			memcpy(&header, log.data() + offset, sizeof(header));
+			if (header.size < sizeof(header) || header.size % 8 != 0 || header.size > log.size() - offset
+				|| header.length > header.size - sizeof(header))
+			{
+				return false;
+			}
+			visit(header, log.data() + offset + sizeof(header));
+			offset += header.size;
+		}
+		return offset == log.size();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	bool releaseOnly = false;
+	int arg = 1;
+	if (arg < argc && strcmp(argv[arg], "--release") == 0)
+	{
+		releaseOnly = true;
+		arg++;
+	}
+	if (argc - arg < 1 || argc - arg > 2)
+	{
+		fprintf(stderr, "Usage: LogDecoder [--release] input.bin [output.txt]\n");
+		return 2;
+	}
+
+	ifstream input(argv[arg], ios::binary);
+	if (!input)
+	{
+		fprintf(stderr, "Cannot open %s\n", argv[arg]);
+		return 1;
+	}
+	const vector<uint8_t> log((istreambuf_iterator<char>(input)), istreambuf_iterator<char>());
+
+	// Sites may be described after their first message, collect them first
+	map<uint32_t, SESSION> sessions;
+	map<SITE_KEY, SITE> sites;
+	const bool intact = Scan(log, [&](const LOG_RECORD_HEADER& header, const uint8_t* payload)
+		{
+			if (header.type == uint16_t(LOG_RECORD::SESSION) && header.length >= sizeof(LOG_SESSION_RECORD))
+			{
+				LOG_SESSION_RECORD record;
+				memcpy(&record, payload, sizeof(record));
+				if (memcmp(record.magic, LOG_BINARY_MAGIC, sizeof(record.magic)) != 0 || record.version != LOG_BINARY_VERSION)
+				{
+					return;
+				}
+				SESSION& session = sessions[header.session];
+				session.ticks = header.ticks;
+				session.ticksPerSecond = record.ticksPerSecond;
+				session.unixMicros = record.unixMicros;
+				session.utcOffset = record.utcOffset;
+			}
+			else if (header.type == uint16_t(LOG_RECORD::SITE) && header.length >= sizeof(LOG_SITE_RECORD))
+			{
+				LOG_SITE_RECORD record;
+				memcpy(&record, payload, sizeof(record));
+				SITE& site = sites[SITE_KEY(header.session, header.site)];
+				site.line = record.line;
+				site.production = (record.flags & LOG_SITE_PRODUCTION) != 0;
+				site.file.assign(reinterpret_cast<const char*>(payload) + sizeof(record), header.length - sizeof(record));
+			}
+		});
+
+	ofstream file;
+	if (argc - arg == 2)
+	{
+		file.open(argv[arg + 1], ios::binary | ios::trunc);
+		if (!file)
+		{
+			fprintf(stderr, "Cannot create %s\n", argv[arg + 1]);
+			return 1;
+		}
+	}
+	ostream& out = file.is_open() ? file : cout;
+
+	size_t lines = 0;
+	Scan(log, [&](const LOG_RECORD_HEADER& header, const uint8_t* payload)
+		{
+			auto session = sessions.find(header.session);
+			const SESSION* clock = session != sessions.end() ? &session->second : nullptr;
+			if (header.type == uint16_t(LOG_RECORD::MESSAGE))
+			{
+				auto site = sites.find(SITE_KEY(header.session, header.site));
+				if (releaseOnly && (site == sites.end() || !site->second.production))
+				{
+					return;
+				}
+				out << "[" << Time(clock, header.ticks) << "] [";
+				if (site != sites.end())
+				{
+					out << site->second.file << ":" << site->second.line;
+				}
+				else
+				{
+					out << "site " << header.site;
+				}
+				out << "] " << Argument(LOG_ARG(header.arg), payload, header.length) << "\n";
+				lines++;
+			}
+			else if (header.type == uint16_t(LOG_RECORD::DROPPED) && header.length == sizeof(uint64_t))
+			{
+				uint64_t dropped = 0;
+				memcpy(&dropped, payload, sizeof(dropped));
+				out << "[Logger] " << dropped << " lines dropped, the log ring was full\n";
+			}
+		});
+
+	if (!intact)
+	{
+		fprintf(stderr, "%s: stopped at a torn or invalid record after %zu lines\n", argv[arg], lines);
+		return 1;
+	}
+	return 0;
+}
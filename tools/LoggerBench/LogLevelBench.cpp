@@ -0,0 +1,106 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Cost of disabled log lines
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Measures what a line costs that a release build does not write: the
+// uncategorized DebugPrint, which builds and converts its message before the
+// logger discards it, a LogInfo whose category is turned down at runtime, and
+// a LogDebug that a release build does not compile in. Build it like a
+// release build, without _DEBUG, from the repository root with
+//   g++ -std=c++14 -O2 -pthread -IShared tools/LoggerBench/LogLevelBench.cpp Shared/Logger.cpp Shared/LogRing.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o LogLevelBench
+//
+// Usage: LogLevelBench [--calls n]
+
+#include "Logger.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	// What Utilities::ReadOTPField logs
+	const wstring otp = L"123456";
+
+	template <typename CALL>
+	void Run(const char* name, size_t calls, CALL&& call)
+	{
+		const auto start = CLOCK::now();
+		for (size_t i = 0; i < calls; i++)
+		{
+			call();
+		}
+		const double ns = chrono::duration<double, nano>(CLOCK::now() - start).count() / double(calls);
+		printf("%-44s %8.2f ns per call\n", name, ns);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t calls = 2000000;
+	if (argc == 3 && string(argv[1]) == "--calls")
+	{
+		calls = strtoul(argv[2], nullptr, 10);
+	}
+	if (calls == 0)
+	{
+		fprintf(stderr, "Usage: LogLevelBench [--calls n]\n");
+		return 2;
+	}
+
+	Logger& logger = Logger::Get();
+	logger.logfilePathProduction = "/dev/null";
+	printf("%zu calls each, compiled in up to level %d\n", calls, LOG_COMPILED_LEVEL);
+
+	logger.releaseLog = true;
+	Run("DebugPrint, discarded by the logger", calls, []
+		{
+			DebugPrint(L"Loading OTP from GUI: '" + otp + L"'");
+		});
+
+	logger.releaseLog = false;
+	Run("LogInfo, release log off", calls, []
+		{
+			LogInfo(UTIL, L"Loading OTP from GUI: '" + otp + L"'");
+		});
+
+	logger.releaseLog = true;
+	logger.setVerbosity(LOG_CATEGORY::UTIL, LOG_LEVEL_WARNING);
+	Run("LogInfo, category turned down to warning", calls, []
+		{
+			LogInfo(UTIL, L"Loading OTP from GUI: '" + otp + L"'");
+		});
+
+	Run("LogDebug, not compiled in", calls, []
+		{
+			LogDebug(UTIL, L"Loading OTP from GUI: '" + otp + L"'");
+		});
+
+	// For scale, a line that is written, to /dev/null
+	logger.setVerbosity(LOG_CATEGORY::UTIL, LOG_LEVEL_INFO);
+	Run("LogInfo, written", calls / 20, []
+		{
+			LogInfo(UTIL, L"Loading OTP from GUI: '" + otp + L"'");
+		});
+	return 0;
+}
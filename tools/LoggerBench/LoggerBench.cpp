@@ -0,0 +1,163 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Logger benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Logs the same lines through the Logger directly, which opens and closes the
+// file per line, and in the asynchronous mode with either overflow policy
+// and in the binary format.
+// Reports the latency of one call as the caller sees it and the lines per
+// second until everything is on disk. Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -IShared tools/LoggerBench/LoggerBench.cpp Shared/Logger.cpp Shared/LogRing.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o LoggerBench
+//
+// Usage: LoggerBench [--lines n] [--threads t] [--capacity slots] [--file path]
+
+#include "Logger.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	double Micros(CLOCK::duration d)
+	{
+		return chrono::duration<double, micro>(d).count();
+	}
+
+	double Percentile(vector<double>& sorted, double p)
+	{
+		const size_t index = min(sorted.size() - 1, size_t(p * double(sorted.size())));
+		return sorted[index];
+	}
+
+	// Lines of the length the provider logs, a short one and a configuration dump
+	const string shortLine = "CCredential::SetSelected";
+	const string longLine = string("Authentication daemon: /run/das/auth.sock, timeout: 5000 ms, deadline: 10000 ms, ")
+		+ "prefetch delay: 250 ms, probe interval: 5000 ms, hedging: off, breaker: 3 failures, 10000 ms";
+
+	void Run(const char* name, size_t lines, size_t threads)
+	{
+		vector<vector<double>> latencies(threads);
+		vector<thread> producers;
+		const auto start = CLOCK::now();
+		for (size_t t = 0; t < threads; t++)
+		{
+			producers.emplace_back([&latencies, t, lines, threads]
+				{
+					vector<double>& own = latencies[t];
+					own.reserve(lines / threads);
+					for (size_t i = t; i < lines; i += threads)
+					{
+						const auto before = CLOCK::now();
+						ReleaseDebugPrint(i % 8 == 0 ? longLine : shortLine);
+						own.push_back(Micros(CLOCK::now() - before));
+					}
+				});
+		}
+		for (thread& producer : producers)
+		{
+			producer.join();
+		}
+		const auto returned = CLOCK::now();
+		Logger::Get().flush();
+		const auto written = CLOCK::now();
+
+		vector<double> all;
+		for (vector<double>& own : latencies)
+		{
+			all.insert(all.end(), own.begin(), own.end());
+		}
+		sort(all.begin(), all.end());
+		printf("%-12s per call p50 %.2f us, p99 %.2f us, p99.9 %.2f us, max %.1f us | "
+			"%.0f lines/s returned, %.0f lines/s on disk\n", name,
+			Percentile(all, 0.5), Percentile(all, 0.99), Percentile(all, 0.999), all.back(),
+			double(lines) / chrono::duration<double>(returned - start).count(),
+			double(lines) / chrono::duration<double>(written - start).count());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t lines = 200000, threads = 1, capacity = 4096;
+	string file = "/tmp/LoggerBench.log";
+
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--lines")
+		{
+			lines = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--threads")
+		{
+			threads = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--capacity")
+		{
+			capacity = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--file")
+		{
+			file = argv[i + 1];
+		}
+	}
+	if (lines == 0 || threads == 0 || capacity == 0)
+	{
+		fprintf(stderr, "Usage: LoggerBench [--lines n] [--threads t] [--capacity slots] [--file path]\n");
+		return 2;
+	}
+
+	Logger& logger = Logger::Get();
+	logger.logfilePathDebug = file;
+	logger.logfilePathProduction = file;
+	logger.logfilePathBinary = file;
+	logger.releaseLog = true;
+	printf("%zu lines, %zu threads, ring of %zu slots, %s\n", lines, threads, capacity, file.c_str());
+
+	unlink(file.c_str());
+	Run("direct", lines, threads);
+
+	unlink(file.c_str());
+	logger.startAsync(LOG_OVERFLOW::BLOCK, LOG_FORMAT::TEXT, capacity);
+	Run("async block", lines, threads);
+	logger.stopAsync();
+
+	unlink(file.c_str());
+	const unsigned long long droppedBefore = logger.dropped();
+	logger.startAsync(LOG_OVERFLOW::DROP, LOG_FORMAT::TEXT, capacity);
+	Run("async drop", lines, threads);
+	logger.stopAsync();
+	printf("async drop lost %llu lines\n", logger.dropped() - droppedBefore);
+
+	unlink(file.c_str());
+	logger.startAsync(LOG_OVERFLOW::BLOCK, LOG_FORMAT::BINARY, capacity);
+	Run("binary", lines, threads);
+	logger.stopAsync();
+
+	unlink(file.c_str());
+	return 0;
+}
@@ -0,0 +1,309 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Latency histogram check and benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// First checks LatencyHistogram: every value lands in a bucket that holds
+// it and is at most 1/32 wide, quantiles of random latencies against the
+// exact ones of the sorted samples, no recording lost while several threads
+// record, and the Prometheus file Metrics writes. Exits with 1 on the first
+// failure. Then measures the cost of a recording, alone and contended.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -IShared tools/MetricsBench/MetricsBench.cpp Shared/Metrics.cpp -o MetricsBench
+//
+// Usage: MetricsBench [--records n] [--threads t] [--file path]
+
+#include "Metrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	void CheckBuckets()
+	{
+		bool holds = true;
+		bool narrow = true;
+		bool ordered = true;
+		mt19937_64 random(4226);
+		vector<uint64_t> values;
+		for (uint64_t v = 0; v < 5000; v++)
+		{
+			values.push_back(v);
+		}
+		for (int bit = 6; bit < 36; bit++)
+		{
+			values.push_back((1ULL << bit) - 1);
+			values.push_back(1ULL << bit);
+			values.push_back((1ULL << bit) + 1);
+		}
+		for (int i = 0; i < 100000; i++)
+		{
+			values.push_back(random() >> (28 + random() % 36));
+		}
+		for (uint64_t v : values)
+		{
+			const size_t index = LatencyHistogram::Index(v);
+			if (index >= HISTOGRAM_BUCKETS)
+			{
+				holds = false;
+				continue;
+			}
+			const uint64_t upper = LatencyHistogram::UpperBound(index);
+			const uint64_t lower = index == 0 ? 0 : LatencyHistogram::UpperBound(index - 1) + 1;
+			const bool clamped = v >= (1ULL << HISTOGRAM_MAX_BITS);
+			holds = holds && (clamped ? index == HISTOGRAM_BUCKETS - 1 : (lower <= v && v <= upper));
+			narrow = narrow && (upper - lower) * 32 <= lower + 32;
+		}
+		for (size_t i = 1; i < HISTOGRAM_BUCKETS; i++)
+		{
+			ordered = ordered && LatencyHistogram::UpperBound(i) > LatencyHistogram::UpperBound(i - 1)
+				&& LatencyHistogram::Index(LatencyHistogram::UpperBound(i)) == i;
+		}
+		Expect(holds, "every value lands in the bucket that holds it");
+		Expect(narrow, "buckets are at most 1/32 of their values wide");
+		Expect(ordered, "buckets are contiguous and ascending");
+		Expect(LatencyHistogram::Index(~0ULL) == HISTOGRAM_BUCKETS - 1, "huge values go to the last bucket");
+	}
+
+	void CheckQuantiles()
+	{
+		// Log-normal around 2 ms with a slow tail, like daemon round trips
+		mt19937 random(7);
+		lognormal_distribution<double> latency(log(2000.0), 0.8);
+		LatencyHistogram histogram;
+		vector<uint64_t> samples;
+		uint64_t sum = 0;
+		for (int i = 0; i < 200000; i++)
+		{
+			const uint64_t v = static_cast<uint64_t>(latency(random));
+			samples.push_back(v);
+			sum += v;
+			histogram.Record(v);
+		}
+		sort(samples.begin(), samples.end());
+		const HISTOGRAM_SNAPSHOT snapshot = histogram.Snapshot();
+		Expect(snapshot.count == samples.size() && snapshot.sum == sum, "count and sum of the recordings");
+		const double quantiles[] = { 0.5, 0.9, 0.99, 0.999, 1.0 };
+		for (double q : quantiles)
+		{
+			const size_t rank = static_cast<size_t>(ceil(q * samples.size()));
+			const uint64_t exact = samples[rank - 1];
+			const uint64_t estimate = snapshot.Quantile(q);
+			printf("q%-6g exact %8llu us, histogram %8llu us\n", q, static_cast<unsigned long long>(exact),
+				static_cast<unsigned long long>(estimate));
+			Expect(estimate >= exact && estimate - exact <= exact / 32 + 1, "a quantile is at most 1/32 above the exact one");
+		}
+		LatencyHistogram empty;
+		Expect(empty.Snapshot().Quantile(0.99) == 0, "an empty histogram has quantile 0");
+	}
+
+	void CheckConcurrent(size_t threads)
+	{
+		LatencyHistogram histogram;
+		vector<thread> writers;
+		for (size_t t = 0; t < threads; t++)
+		{
+			writers.emplace_back([&histogram, t]
+				{
+					for (uint64_t i = 0; i < 500000; i++)
+					{
+						histogram.Record((i * 7919 + t) % 100000);
+					}
+				});
+		}
+		uint64_t reads = 0;
+		bool monotonic = true;
+		uint64_t last = 0;
+		for (size_t t = 0; t < threads; t++)
+		{
+			while (writers[t].joinable())
+			{
+				const uint64_t count = histogram.Snapshot().count;
+				monotonic = monotonic && count >= last;
+				last = count;
+				reads++;
+				writers[t].join();
+			}
+		}
+		const HISTOGRAM_SNAPSHOT snapshot = histogram.Snapshot();
+		uint64_t sum = 0;
+		for (size_t t = 0; t < threads; t++)
+		{
+			for (uint64_t i = 0; i < 500000; i++)
+			{
+				sum += (i * 7919 + t) % 100000;
+			}
+		}
+		printf("concurrent: %zu writers, %llu recordings\n", threads, static_cast<unsigned long long>(snapshot.count));
+		Expect(monotonic, "counts only grow while recording");
+		Expect(snapshot.count == threads * 500000 && snapshot.sum == sum, "no recording lost between threads");
+	}
+
+	string ReadFile(const string& path)
+	{
+		ifstream file(path, ios::binary);
+		stringstream text;
+		text << file.rdbuf();
+		return text.str();
+	}
+
+	void CheckFile(const string& path)
+	{
+		Metrics& metrics = Metrics::Get();
+		LatencyHistogram& a = metrics.Register("das_otp_verify_seconds", "OTP verification", Metrics::Label("endpoint", "\\\\.\\pipe\\das-a"));
+		// Registered in between, like the histograms of Configuration
+		LatencyHistogram& pack = metrics.Register("das_kerberos_pack_seconds", "Kerberos packing", "");
+		LatencyHistogram& b = metrics.Register("das_otp_verify_seconds", "OTP verification", Metrics::Label("endpoint", "offline"));
+		Expect(&a == &metrics.Register("das_otp_verify_seconds", "", Metrics::Label("endpoint", "\\\\.\\pipe\\das-a")),
+			"registering again gives the same histogram");
+		for (uint64_t i = 1; i <= 100; i++)
+		{
+			a.Record(i * 100);
+		}
+		b.Record(250);
+		pack.Record(1500000);
+
+		const string text = metrics.Text();
+		Expect(text.find("# TYPE das_otp_verify_seconds summary\n") != string::npos
+			&& text.find("# TYPE das_otp_verify_seconds summary\n", text.find("# TYPE das_otp_verify_seconds") + 1) == string::npos,
+			"one TYPE line per name");
+		Expect(text.rfind("das_otp_verify_seconds") < text.find("das_kerberos_pack_seconds"),
+			"the samples of a name are written together, after its TYPE line");
+		Expect(text.find("das_otp_verify_seconds{endpoint=\"\\\\\\\\.\\\\pipe\\\\das-a\",quantile=\"0.99\"} 0.009") != string::npos,
+			"p99 per endpoint with the label escaped");
+		Expect(text.find("das_otp_verify_seconds_count{endpoint=\"offline\"} 1\n") != string::npos, "count per endpoint");
+		Expect(text.find("das_kerberos_pack_seconds_sum 1.500000\n") != string::npos, "sum in seconds without labels");
+
+		Expect(metrics.Write(path) && ReadFile(path) == text, "Write() replaces the file with the text");
+		remove(path.c_str());
+		metrics.StartDump(path, 20);
+		metrics.StartDump(path, 20);
+		this_thread::sleep_for(chrono::milliseconds(100));
+		Expect(ReadFile(path).find("das_kerberos_pack_seconds_count 1\n") != string::npos, "the dump thread writes the file");
+		metrics.StopDump();
+		pack.Record(10);
+		metrics.StopDump();
+		Expect(ReadFile(path).find("das_kerberos_pack_seconds_count 2\n") != string::npos, "the last StopDump() writes a last time");
+		Expect(ReadFile(path + ".tmp").empty(), "no temporary file left");
+	}
+
+	double NanosPerRecord(LatencyHistogram& histogram, size_t records)
+	{
+		const auto start = CLOCK::now();
+		for (size_t i = 0; i < records; i++)
+		{
+			histogram.Record((i * 2654435761u) & 0xFFFFF);
+		}
+		return chrono::duration<double, nano>(CLOCK::now() - start).count() / double(records);
+	}
+
+	double NanosPerTimer(LatencyHistogram& histogram, size_t records)
+	{
+		const auto start = CLOCK::now();
+		for (size_t i = 0; i < records; i++)
+		{
+			LatencyTimer timer(histogram);
+		}
+		return chrono::duration<double, nano>(CLOCK::now() - start).count() / double(records);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t records = 20000000;
+	size_t threads = 4;
+	string file = "/tmp/MetricsBench.prom";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--records")
+		{
+			records = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--threads")
+		{
+			threads = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--file")
+		{
+			file = argv[i + 1];
+		}
+	}
+	if (records == 0 || threads == 0)
+	{
+		fprintf(stderr, "Usage: MetricsBench [--records n] [--threads t] [--file path]\n");
+		return 2;
+	}
+
+	CheckBuckets();
+	CheckQuantiles();
+	CheckConcurrent(threads);
+	CheckFile(file);
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n\n");
+
+	LatencyHistogram histogram;
+	printf("record                   %7.1f ns\n", NanosPerRecord(histogram, records));
+	printf("LatencyTimer             %7.1f ns\n", NanosPerTimer(histogram, records / 4));
+
+	vector<double> perThread(threads);
+	vector<thread> workers;
+	for (size_t t = 0; t < threads; t++)
+	{
+		workers.emplace_back([&histogram, &perThread, t, records, threads]
+			{
+				perThread[t] = NanosPerRecord(histogram, records / threads);
+			});
+	}
+	double worst = 0;
+	for (size_t t = 0; t < threads; t++)
+	{
+		workers[t].join();
+		worst = perThread[t] > worst ? perThread[t] : worst;
+	}
+	printf("record, %zu threads       %7.1f ns, slowest thread\n", threads, worst);
+	printf("\nsample metrics file: %s\n", file.c_str());
+	return 0;
+}
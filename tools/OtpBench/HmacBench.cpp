@@ -0,0 +1,225 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - HMAC midstate benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Compares HmacKey::Counter, which resumes from the cached K^ipad and K^opad
+// states, with a textbook HMAC that compresses both pads again for every
+// counter, over TOTP windows of +/- 1, 10 and 100 steps. First checks that
+// both give the same MAC for every algorithm and key length (exits with 1
+// otherwise), then prints the time per window and the speedup.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/OtpBench/HmacBench.cpp CredentialProvider/otp/*.cpp -o HmacBench
+//
+// Usage: HmacBench [--windows n]
+
+#include "otp/Hmac.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	const char* Name(OTP_ALGORITHM algorithm)
+	{
+		return algorithm == OTP_ALGORITHM::SHA1 ? "SHA1" : (algorithm == OTP_ALGORITHM::SHA256 ? "SHA256" : "SHA512");
+	}
+
+	void Pad(uint8_t* block, size_t blockSize, size_t dataLength, uint64_t totalLength)
+	{
+		memset(block + dataLength, 0, blockSize - dataLength);
+		block[dataLength] = 0x80;
+		for (int i = 0; i < 8; i++)
+		{
+			block[blockSize - 1 - i] = uint8_t((totalLength * 8) >> (8 * i));
+		}
+	}
+
+	// RFC 2104 without midstates: four compressions per counter
+	void TextbookHmac(OTP_ALGORITHM algorithm, const uint8_t* key, size_t keyLength, uint64_t counter, uint8_t* out)
+	{
+		const size_t blockSize = Sha::BlockSize(algorithm);
+		const size_t digestSize = Sha::DigestSize(algorithm);
+		uint8_t k[SHA_MAX_BLOCK_SIZE] = {};
+		if (keyLength > blockSize)
+		{
+			Sha::Hash(algorithm, key, keyLength, k);
+		}
+		else
+		{
+			memcpy(k, key, keyLength);
+		}
+
+		uint8_t block[SHA_MAX_BLOCK_SIZE];
+		SHA_STATE state;
+		Sha::Init(algorithm, state);
+		for (size_t i = 0; i < blockSize; i++)
+		{
+			block[i] = k[i] ^ 0x36;
+		}
+		Sha::Compress(algorithm, state, block);
+		for (int i = 0; i < 8; i++)
+		{
+			block[i] = uint8_t(counter >> (56 - 8 * i));
+		}
+		Pad(block, blockSize, 8, blockSize + 8);
+		Sha::Compress(algorithm, state, block);
+		uint8_t inner[SHA_MAX_DIGEST_SIZE];
+		Sha::StoreDigest(algorithm, state, inner);
+
+		Sha::Init(algorithm, state);
+		for (size_t i = 0; i < blockSize; i++)
+		{
+			block[i] = k[i] ^ 0x5c;
+		}
+		Sha::Compress(algorithm, state, block);
+		memcpy(block, inner, digestSize);
+		Pad(block, blockSize, digestSize, blockSize + digestSize);
+		Sha::Compress(algorithm, state, block);
+		Sha::StoreDigest(algorithm, state, out);
+	}
+
+	void CheckEqual()
+	{
+		const OTP_ALGORITHM algorithms[] = { OTP_ALGORITHM::SHA1, OTP_ALGORITHM::SHA256, OTP_ALGORITHM::SHA512 };
+		const size_t lengths[] = { 1, 20, 32, 64, 65, 128, 129, 256 };
+		uint8_t key[256];
+		for (size_t i = 0; i < sizeof(key); i++)
+		{
+			key[i] = uint8_t(i * 131 + 7);
+		}
+		bool equal = true;
+		for (OTP_ALGORITHM algorithm : algorithms)
+		{
+			for (size_t length : lengths)
+			{
+				HmacKey cached;
+				cached.Initialize(algorithm, key, length);
+				for (uint64_t counter = 0; counter < 200; counter++)
+				{
+					const uint64_t c = counter * 0x9E3779B97F4A7C15ULL;
+					uint8_t a[SHA_MAX_DIGEST_SIZE], b[SHA_MAX_DIGEST_SIZE];
+					cached.Counter(c, a);
+					TextbookHmac(algorithm, key, length, c, b);
+					equal = equal && memcmp(a, b, cached.DigestSize()) == 0;
+				}
+			}
+		}
+		Expect(equal, "cached midstates give the textbook HMAC for every algorithm and key length");
+
+		// RFC 4226 appendix D, HMAC-SHA-1 of counter 0
+		static const uint8_t rfc[20] = { 0xcc, 0x93, 0xcf, 0x18, 0x50, 0x8d, 0x94, 0x93, 0x4c, 0x64,
+			0xb6, 0x5d, 0x8b, 0xa7, 0x66, 0x7f, 0xb7, 0xcd, 0xe4, 0xb0 };
+		HmacKey sha1;
+		sha1.Initialize(OTP_ALGORITHM::SHA1, reinterpret_cast<const uint8_t*>("12345678901234567890"), 20);
+		uint8_t mac[SHA_MAX_DIGEST_SIZE];
+		sha1.Counter(0, mac);
+		Expect(memcmp(mac, rfc, sizeof(rfc)) == 0, "HMAC-SHA-1 of RFC 4226 appendix D");
+	}
+
+	volatile uint8_t sink;
+
+	// Nanoseconds per window of 2 * steps + 1 counters
+	template <typename F>
+	double NanosPerWindow(unsigned int steps, size_t windows, F mac)
+	{
+		uint8_t out[SHA_MAX_DIGEST_SIZE];
+		uint8_t fold = 0;
+		const auto start = CLOCK::now();
+		for (size_t w = 0; w < windows; w++)
+		{
+			const uint64_t now = 55000000 + w;
+			for (uint64_t c = now - steps; c <= now + steps; c++)
+			{
+				mac(c, out);
+				fold ^= out[0];
+			}
+		}
+		sink = fold;
+		return chrono::duration<double, nano>(CLOCK::now() - start).count() / double(windows);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t windows = 20000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (string(argv[i]) == "--windows")
+		{
+			windows = strtoul(argv[i + 1], nullptr, 10);
+		}
+	}
+	if (windows == 0)
+	{
+		fprintf(stderr, "Usage: HmacBench [--windows n]\n");
+		return 2;
+	}
+
+	CheckEqual();
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n\n");
+
+	const uint8_t secret[32] = { 0x3d, 0xc6, 0xca, 0xa4, 0x82, 0x4a, 0x6d, 0x28, 0x87, 0x67, 0xb2, 0x33, 0x1e, 0x20, 0xb4, 0x31,
+		0x66, 0xcb, 0x85, 0xd9, 0x3d, 0xc6, 0xca, 0xa4, 0x82, 0x4a, 0x6d, 0x28, 0x87, 0x67, 0xb2, 0x33 };
+	const OTP_ALGORITHM algorithms[] = { OTP_ALGORITHM::SHA1, OTP_ALGORITHM::SHA256, OTP_ALGORITHM::SHA512 };
+	const unsigned int steps[] = { 1, 10, 100 };
+
+	printf("%-7s %7s %14s %14s %8s\n", "", "window", "textbook", "midstates", "speedup");
+	for (OTP_ALGORITHM algorithm : algorithms)
+	{
+		const size_t keyLength = Sha::DigestSize(algorithm) < sizeof(secret) ? Sha::DigestSize(algorithm) : sizeof(secret);
+		HmacKey key;
+		key.Initialize(algorithm, secret, keyLength);
+		for (unsigned int s : steps)
+		{
+			const size_t count = windows / s > 100 ? windows / s : 100;
+			const double textbook = NanosPerWindow(s, count, [&](uint64_t c, uint8_t* out)
+				{
+					TextbookHmac(algorithm, secret, keyLength, c, out);
+				});
+			const double cached = NanosPerWindow(s, count, [&](uint64_t c, uint8_t* out)
+				{
+					key.Counter(c, out);
+				});
+			printf("%-7s %5s%-3u %11.2f us %11.2f us %7.2fx\n", Name(algorithm), "+/-", s,
+				textbook / 1000.0, cached / 1000.0, textbook / cached);
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,192 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - OTP engine test vectors
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Checks OTPVerifier against the HOTP values of RFC 4226 appendix D and the
+// TOTP values of RFC 6238 appendix B for SHA-1, SHA-256 and SHA-512, then
+// Verify() around them: window edges, the matched counter, malformed codes
+// and the base32 decoder. Exits with 1 if anything differs.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/OtpBench/OtpVectors.cpp CredentialProvider/otp/*.cpp -o OtpVectors
+
+#include "otp/OTPVerifier.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace std;
+
+namespace
+{
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	wstring Code(uint32_t value, unsigned int digits)
+	{
+		wchar_t text[16];
+		swprintf(text, 16, L"%0*u", static_cast<int>(digits), value);
+		return text;
+	}
+
+	// RFC 6238 appendix B uses the ASCII digits repeated to the digest size as seed
+	const char* SEED_SHA1 = "12345678901234567890";
+	const char* SEED_SHA256 = "12345678901234567890123456789012";
+	const char* SEED_SHA512 = "1234567890123456789012345678901234567890123456789012345678901234";
+
+	bool Initialize(OTPVerifier& verifier, OTP_TYPE type, OTP_ALGORITHM algorithm, unsigned int digits, const char* seed)
+	{
+		OTP_PARAMETERS parameters;
+		parameters.type = type;
+		parameters.algorithm = algorithm;
+		parameters.digits = digits;
+		parameters.window = 1;
+		return verifier.Initialize(parameters, reinterpret_cast<const uint8_t*>(seed), strlen(seed));
+	}
+
+	void CheckHotp()
+	{
+		static const uint32_t expected[] = { 755224, 287082, 359152, 969429, 338314, 254676, 287922, 162583, 399871, 520489 };
+		OTPVerifier verifier;
+		Expect(Initialize(verifier, OTP_TYPE::HOTP, OTP_ALGORITHM::SHA1, 6, SEED_SHA1), "HOTP initializes");
+		for (uint64_t counter = 0; counter < 10; counter++)
+		{
+			const uint32_t value = verifier.Generate(counter);
+			printf("HOTP   counter %llu  %06u\n", static_cast<unsigned long long>(counter), value);
+			Expect(value == expected[counter], "RFC 4226 appendix D");
+		}
+
+		// Window 1 after the expected counter: counter 4 and 5 verify at 4, 6 does not
+		uint64_t matched = 0;
+		Expect(verifier.Verify(Code(expected[4], 6).c_str(), 0, 4, &matched) == OTP_RESULT::VALID && matched == 4,
+			"HOTP verifies the expected counter");
+		Expect(verifier.Verify(Code(expected[5], 6).c_str(), 0, 4, &matched) == OTP_RESULT::VALID && matched == 5,
+			"HOTP verifies the look-ahead and reports its counter");
+		Expect(verifier.Verify(Code(expected[6], 6).c_str(), 0, 4, &matched) == OTP_RESULT::INVALID,
+			"HOTP rejects a code past the window");
+		Expect(verifier.Verify(Code(expected[3], 6).c_str(), 0, 4, &matched) == OTP_RESULT::INVALID,
+			"HOTP rejects a code before the counter");
+
+		uint64_t resynced = 0;
+		Expect(verifier.Resync(Code(expected[7], 6).c_str(), Code(expected[8], 6).c_str(), 0, &resynced) == OTP_RESULT::VALID
+			&& resynced == 8, "Resync finds the pair and reports the counter of the second code");
+	}
+
+	void CheckTotp()
+	{
+		struct VECTOR
+		{
+			long long time;
+			uint32_t sha1;
+			uint32_t sha256;
+			uint32_t sha512;
+		};
+		static const VECTOR vectors[] =
+		{
+			{ 59LL, 94287082, 46119246, 90693936 },
+			{ 1111111109LL, 7081804, 68084774, 25091201 },
+			{ 1111111111LL, 14050471, 67062674, 99943326 },
+			{ 1234567890LL, 89005924, 91819424, 93441116 },
+			{ 2000000000LL, 69279037, 90698825, 38618901 },
+			{ 20000000000LL, 65353130, 77737706, 47863826 },
+		};
+
+		OTPVerifier sha1, sha256, sha512;
+		Expect(Initialize(sha1, OTP_TYPE::TOTP, OTP_ALGORITHM::SHA1, 8, SEED_SHA1)
+			&& Initialize(sha256, OTP_TYPE::TOTP, OTP_ALGORITHM::SHA256, 8, SEED_SHA256)
+			&& Initialize(sha512, OTP_TYPE::TOTP, OTP_ALGORITHM::SHA512, 8, SEED_SHA512), "TOTP initializes");
+
+		for (const VECTOR& v : vectors)
+		{
+			const uint64_t step = static_cast<uint64_t>(v.time / 30);
+			const uint32_t a = sha1.Generate(step);
+			const uint32_t b = sha256.Generate(step);
+			const uint32_t c = sha512.Generate(step);
+			printf("TOTP   time %11lld  SHA1 %08u  SHA256 %08u  SHA512 %08u\n", v.time, a, b, c);
+			Expect(a == v.sha1 && b == v.sha256 && c == v.sha512, "RFC 6238 appendix B");
+
+			uint64_t matched = 0;
+			Expect(sha1.Verify(Code(v.sha1, 8).c_str(), v.time, 0, &matched) == OTP_RESULT::VALID && matched == step
+				&& sha256.Verify(Code(v.sha256, 8).c_str(), v.time, 0, &matched) == OTP_RESULT::VALID && matched == step
+				&& sha512.Verify(Code(v.sha512, 8).c_str(), v.time, 0, &matched) == OTP_RESULT::VALID && matched == step,
+				"TOTP verifies the vector at its time");
+
+			// Skew of one step either way is inside window 1, two steps are not
+			Expect(sha256.Verify(Code(v.sha256, 8).c_str(), v.time + 30, 0, nullptr) == OTP_RESULT::VALID
+				&& sha256.Verify(Code(v.sha256, 8).c_str(), v.time - 30, 0, nullptr) == OTP_RESULT::VALID,
+				"TOTP accepts one step of skew");
+			Expect(sha256.Verify(Code(v.sha256, 8).c_str(), v.time + 60, 0, nullptr) == OTP_RESULT::INVALID,
+				"TOTP rejects two steps of skew");
+		}
+		Expect(sha1.Verify(L"94287082", 10, 0, nullptr) == OTP_RESULT::VALID, "TOTP verifies at step 0");
+		Expect(sha1.AcceptedUntil(1, 59) == 90, "a TOTP step stays accepted until the window has passed it");
+	}
+
+	void CheckInput()
+	{
+		OTPVerifier verifier;
+		Expect(verifier.Verify(L"123456", 59, 0, nullptr) == OTP_RESULT::NOT_CONFIGURED, "no secret is NOT_CONFIGURED");
+		Expect(Initialize(verifier, OTP_TYPE::TOTP, OTP_ALGORITHM::SHA1, 8, SEED_SHA1), "TOTP initializes");
+		Expect(verifier.Verify(L"9428 7082", 59, 0, nullptr) == OTP_RESULT::VALID, "spaces are ignored");
+		Expect(verifier.Verify(L"9428708", 59, 0, nullptr) == OTP_RESULT::MALFORMED, "too short is MALFORMED");
+		Expect(verifier.Verify(L"942870821", 59, 0, nullptr) == OTP_RESULT::MALFORMED, "too long is MALFORMED");
+		Expect(verifier.Verify(L"9428708a", 59, 0, nullptr) == OTP_RESULT::MALFORMED, "a letter is MALFORMED");
+		Expect(verifier.Verify(L"", 59, 0, nullptr) == OTP_RESULT::MALFORMED, "empty is MALFORMED");
+		Expect(verifier.Verify(nullptr, 59, 0, nullptr) == OTP_RESULT::MALFORMED, "null is MALFORMED");
+
+		OTP_PARAMETERS parameters;
+		const uint8_t secret[1] = { 0 };
+		parameters.digits = 5;
+		Expect(!verifier.Initialize(parameters, secret, 1), "5 digits are refused");
+		parameters.digits = 6;
+		parameters.window = OTP_MAX_WINDOW + 1;
+		Expect(!verifier.Initialize(parameters, secret, 1), "a window above the maximum is refused");
+		parameters.window = 1;
+		Expect(!verifier.Initialize(parameters, secret, 0), "an empty secret is refused");
+
+		// RFC 4648 section 10 and the seed of RFC 6238 as it is usually provisioned
+		uint8_t decoded[64];
+		Expect(OTPVerifier::DecodeBase32("MZXW6YTBOI======", decoded, sizeof(decoded)) == 6
+			&& memcmp(decoded, "foobar", 6) == 0, "base32 of RFC 4648");
+		Expect(OTPVerifier::DecodeBase32("gezdgnbvgy3tqojqgezdgnbvgy3tqojq", decoded, sizeof(decoded)) == 20
+			&& memcmp(decoded, SEED_SHA1, 20) == 0, "lower case base32");
+		Expect(OTPVerifier::DecodeBase32("GEZD1", decoded, sizeof(decoded)) == 0, "a digit outside the alphabet is refused");
+		Expect(OTPVerifier::DecodeBase32("GEZDGNBV", decoded, 4) == 0, "an output buffer too small is refused");
+	}
+}
+
+int main()
+{
+	CheckHotp();
+	CheckTotp();
+	CheckInput();
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n");
+	return 0;
+}
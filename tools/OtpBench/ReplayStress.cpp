@@ -0,0 +1,333 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Replay cache stress test and benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// First checks ReplayCache single-threaded: a code is accepted once, an
+// expired one again, the same code under another spelling of the account is
+// REPLAYED, a probe range of live codes refuses a new one as FULL and keeps
+// the old ones. Then races threads, and forked processes on one shared
+// section like the LogonUI processes of several sessions, over the same
+// keys: every key must be accepted exactly once. Exits with 1 on any
+// failure. Then measures TryAccept for new keys and replays, alone and
+// with several threads. Linux only, the processes are forked.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/OtpBench/ReplayStress.cpp CredentialProvider/otp/*.cpp -o ReplayStress
+//
+// Usage: ReplayStress [--threads t] [--processes p] [--rounds n]
+
+#include "otp/ReplayCache.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	// Keys per round. Linear probing clusters, at half the table a probe
+	// range runs full now and then, at a quarter it does not.
+	const size_t KEYS = OTP_REPLAY_SLOTS / 4;
+	const uint32_t NOW = 1700000000;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	uint64_t RoundKey(size_t round, size_t i)
+	{
+		return ReplayCache::Key(L"user@domain", round, i);
+	}
+
+	// Key whose home slot is home and whose fingerprint is n
+	uint64_t SlotKey(size_t home, uint32_t n)
+	{
+		return (uint64_t(n) << 33) | home;
+	}
+
+	void CheckBasics(const wchar_t* section)
+	{
+		ReplayCache cache;
+		Expect(!cache.IsShared(), "the default cache is local");
+		const uint64_t key = ReplayCache::Key(L"Alice@CORP", 7, 55);
+		Expect(key == ReplayCache::Key(L"alice@corp", 7, 55), "the user is compared case-insensitively");
+		Expect(key != ReplayCache::Key(L"alice@corp", 7, 56) && key != ReplayCache::Key(L"alice@corp", 8, 55),
+			"token and counter are part of the key");
+		Expect(cache.TryAccept(key, NOW + 30, NOW) == REPLAY_RESULT::ACCEPTED, "a new code is accepted");
+		Expect(cache.TryAccept(key, NOW + 30, NOW + 29) == REPLAY_RESULT::REPLAYED, "the same code is refused until it expires");
+		Expect(cache.TryAccept(key, NOW + 60, NOW + 30) == REPLAY_RESULT::ACCEPTED, "an expired code is accepted again");
+		Expect(cache.Count(NOW + 30) == 1, "one live entry");
+
+		// The logon packs user, .\user and HOST\user for one local account, one code must not pass per spelling
+		const uint64_t local = ReplayCache::AccountKey(L"alice", L"", L"HOST", 55);
+		Expect(local == ReplayCache::AccountKey(L"alice", L".", L"HOST", 55)
+			&& local == ReplayCache::AccountKey(L"Alice", L"host", L"HOST", 55), "every spelling of the local account is one key");
+		Expect(local != ReplayCache::AccountKey(L"alice", L"CORP", L"HOST", 55), "a domain account is another account");
+		Expect(cache.TryAccept(ReplayCache::AccountKey(L"alice", L"", L"HOST", 55), NOW + 30, NOW) == REPLAY_RESULT::ACCEPTED
+			&& cache.TryAccept(ReplayCache::AccountKey(L"ALICE", L".", L"HOST", 55), NOW + 30, NOW) == REPLAY_RESULT::REPLAYED
+			&& cache.TryAccept(ReplayCache::AccountKey(L"alice", L"HOST", L"HOST", 55), NOW + 30, NOW) == REPLAY_RESULT::REPLAYED,
+			"the same code under another spelling of the domain is REPLAYED");
+		Expect(ReplayCache::TokenKey(0x1234, 55) != ReplayCache::TokenKey(0x1234, 56)
+			&& ReplayCache::TokenKey(0x1234, 55) != ReplayCache::TokenKey(0x1235, 55), "store token keys are per name hash and counter");
+		Expect(cache.TryAccept(ReplayCache::TokenKey(0x1234, 55), NOW + 30, NOW) == REPLAY_RESULT::ACCEPTED
+			&& cache.TryAccept(ReplayCache::TokenKey(0x1234, 55), NOW + 30, NOW) == REPLAY_RESULT::REPLAYED,
+			"a store token code is refused the second time");
+
+		// A full probe range refuses instead of evicting
+		const size_t home = 100;
+		for (uint32_t n = 1; n <= OTP_REPLAY_PROBES; n++)
+		{
+			Expect(cache.TryAccept(SlotKey(home, n), NOW + 30 + n, NOW) == REPLAY_RESULT::ACCEPTED, "the probe range fills");
+		}
+		Expect(cache.TryAccept(SlotKey(home, 999), NOW + 300, NOW) == REPLAY_RESULT::FULL, "a full probe range is FULL");
+		bool kept = true;
+		for (uint32_t n = 1; n <= OTP_REPLAY_PROBES; n++)
+		{
+			kept = kept && cache.TryAccept(SlotKey(home, n), NOW + 30 + n, NOW) == REPLAY_RESULT::REPLAYED;
+		}
+		Expect(kept, "no live entry was evicted");
+		Expect(cache.TryAccept(SlotKey(home, 999), NOW + 300, NOW + 31) == REPLAY_RESULT::ACCEPTED,
+			"the slot of an expired entry is reused");
+
+		ReplayCache a(section);
+		ReplayCache b(section);
+		Expect(a.IsShared() && b.IsShared(), "the named section opens");
+		a.Clear();
+		Expect(a.TryAccept(key, NOW + 30, NOW) == REPLAY_RESULT::ACCEPTED && b.TryAccept(key, NOW + 30, NOW) == REPLAY_RESULT::REPLAYED,
+			"a code accepted through one mapping is refused through the other");
+		a.Clear();
+	}
+
+	// accepted[i] counts how often key i of the round was accepted
+	void Race(ReplayCache& cache, size_t round, size_t worker, atomic<uint32_t>* accepted, atomic<uint32_t>* full)
+	{
+		// Every worker walks the keys from a different start
+		for (size_t n = 0; n < KEYS; n++)
+		{
+			const size_t i = (n + worker * 7919) % KEYS;
+			const REPLAY_RESULT result = cache.TryAccept(RoundKey(round, i), NOW + 30, NOW);
+			if (result == REPLAY_RESULT::ACCEPTED)
+			{
+				accepted[i].fetch_add(1);
+			}
+			else if (result == REPLAY_RESULT::FULL)
+			{
+				full->fetch_add(1);
+			}
+		}
+	}
+
+	bool ExactlyOnce(const atomic<uint32_t>* accepted)
+	{
+		for (size_t i = 0; i < KEYS; i++)
+		{
+			if (accepted[i].load() != 1)
+			{
+				fprintf(stderr, "key %zu accepted %u times\n", i, accepted[i].load());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void CheckThreads(const wchar_t* section, size_t threads, size_t rounds)
+	{
+		ReplayCache cache(section);
+		vector<atomic<uint32_t>> accepted(KEYS);
+		atomic<uint32_t> full{ 0 };
+		bool once = true;
+		for (size_t round = 0; round < rounds; round++)
+		{
+			cache.Clear();
+			for (atomic<uint32_t>& a : accepted)
+			{
+				a.store(0);
+			}
+			vector<thread> workers;
+			for (size_t t = 0; t < threads; t++)
+			{
+				workers.emplace_back([&, t] { Race(cache, round, t, accepted.data(), &full); });
+			}
+			for (thread& w : workers)
+			{
+				w.join();
+			}
+			once = once && ExactlyOnce(accepted.data());
+		}
+		printf("threads:   %zu x %zu rounds of %zu keys\n", threads, rounds, KEYS);
+		Expect(once, "every key is accepted by exactly one thread");
+		Expect(full.load() == 0, "a quarter full table never refuses as FULL");
+	}
+
+	void CheckProcesses(const wchar_t* section, size_t processes, size_t rounds)
+	{
+		// Counters the children share with the parent
+		void* shared = mmap(nullptr, sizeof(atomic<uint32_t>) * (KEYS + 1), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (shared == MAP_FAILED)
+		{
+			Expect(false, "shared counters are mapped");
+			return;
+		}
+		atomic<uint32_t>* accepted = static_cast<atomic<uint32_t>*>(shared);
+		atomic<uint32_t>* full = accepted + KEYS;
+
+		ReplayCache parent(section);
+		bool once = true;
+		for (size_t round = 0; round < rounds; round++)
+		{
+			parent.Clear();
+			for (size_t i = 0; i <= KEYS; i++)
+			{
+				accepted[i].store(0);
+			}
+			vector<pid_t> children;
+			for (size_t p = 0; p < processes; p++)
+			{
+				const pid_t child = fork();
+				if (child == 0)
+				{
+					// Each session maps the section on its own
+					ReplayCache cache(section);
+					Race(cache, round, p, accepted, full);
+					_exit(cache.IsShared() ? 0 : 3);
+				}
+				children.push_back(child);
+			}
+			for (pid_t child : children)
+			{
+				int status = 0;
+				waitpid(child, &status, 0);
+				Expect(WIFEXITED(status) && WEXITSTATUS(status) == 0, "every process maps the section");
+			}
+			once = once && ExactlyOnce(accepted);
+		}
+		printf("processes: %zu x %zu rounds of %zu keys\n", processes, rounds, KEYS);
+		Expect(once, "every key is accepted by exactly one process");
+		Expect(full->load() == 0, "a quarter full table never refuses as FULL");
+		munmap(shared, sizeof(atomic<uint32_t>) * (KEYS + 1));
+	}
+
+	// Nanoseconds per TryAccept of a new key and of a replay
+	void Measure(ReplayCache& cache, size_t rounds, size_t offset, double* acceptNs, double* replayNs)
+	{
+		double accept = 0, replay = 0;
+		for (size_t round = 0; round < rounds; round++)
+		{
+			auto start = CLOCK::now();
+			for (size_t i = 0; i < KEYS / 4; i++)
+			{
+				cache.TryAccept(RoundKey(offset + round, i), NOW + 30, NOW);
+			}
+			accept += chrono::duration<double, nano>(CLOCK::now() - start).count();
+			start = CLOCK::now();
+			for (size_t i = 0; i < KEYS / 4; i++)
+			{
+				cache.TryAccept(RoundKey(offset + round, i), NOW + 30, NOW);
+			}
+			replay += chrono::duration<double, nano>(CLOCK::now() - start).count();
+		}
+		*acceptNs = accept / double(rounds * (KEYS / 4));
+		*replayNs = replay / double(rounds * (KEYS / 4));
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t threads = 4;
+	size_t processes = 4;
+	size_t rounds = 20;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--threads")
+		{
+			threads = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--processes")
+		{
+			processes = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--rounds")
+		{
+			rounds = strtoul(argv[i + 1], nullptr, 10);
+		}
+	}
+	if (threads == 0 || processes == 0 || rounds == 0)
+	{
+		fprintf(stderr, "Usage: ReplayStress [--threads t] [--processes p] [--rounds n]\n");
+		return 2;
+	}
+
+	// A section of its own, the one of an installed provider is left alone
+	const string name = "/das-replay-stress-" + to_string(getpid());
+	const wstring section(name.begin(), name.end());
+
+	CheckBasics(section.c_str());
+	CheckThreads(section.c_str(), threads, rounds);
+	CheckProcesses(section.c_str(), processes, rounds);
+	if (failed)
+	{
+		shm_unlink(name.c_str());
+		return 1;
+	}
+	printf("checks passed\n\n");
+
+	ReplayCache local;
+	ReplayCache shared(section.c_str());
+	double acceptNs = 0, replayNs = 0;
+	Measure(local, rounds * 10, 0, &acceptNs, &replayNs);
+	printf("local table    accept %6.1f ns  replay %6.1f ns\n", acceptNs, replayNs);
+	shared.Clear();
+	Measure(shared, rounds * 10, 0, &acceptNs, &replayNs);
+	printf("shared section accept %6.1f ns  replay %6.1f ns\n", acceptNs, replayNs);
+
+	shared.Clear();
+	vector<double> accepts(threads), replays(threads);
+	vector<thread> workers;
+	for (size_t t = 0; t < threads; t++)
+	{
+		workers.emplace_back([&, t] { Measure(shared, rounds * 10, (t + 1) * 1000000, &accepts[t], &replays[t]); });
+	}
+	double worstAccept = 0, worstReplay = 0;
+	for (size_t t = 0; t < threads; t++)
+	{
+		workers[t].join();
+		worstAccept = accepts[t] > worstAccept ? accepts[t] : worstAccept;
+		worstReplay = replays[t] > worstReplay ? replays[t] : worstReplay;
+	}
+	printf("%zu threads      accept %6.1f ns  replay %6.1f ns, slowest thread\n", threads, worstAccept, worstReplay);
+
+	shm_unlink(name.c_str());
+	return 0;
+}
@@ -0,0 +1,185 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - HOTP resynchronization benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// First checks OTPVerifier::Resync with every thread count: a pair at the
+// start, in the middle and at the last counter of the window is found with
+// the same counter, a pair one past the window is not. Exits with 1 if not.
+// Then measures the worst case, two codes that match nowhere so the whole
+// window is hashed, against window size and thread count. Thread counts
+// above the cores of the machine are marked, they only show the overhead.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/OtpBench/ResyncBench.cpp CredentialProvider/otp/*.cpp -o ResyncBench
+//
+// Usage: ResyncBench [--runs n] [--algorithm sha1|sha256|sha512]
+
+#include "otp/OTPVerifier.h"
+#include "otp/ShaMultiBuffer.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	const char* SECRET = "12345678901234567890";
+
+	bool Initialize(OTPVerifier& verifier, OTP_ALGORITHM algorithm, unsigned int window, unsigned int threads)
+	{
+		OTP_PARAMETERS parameters;
+		parameters.type = OTP_TYPE::HOTP;
+		parameters.algorithm = algorithm;
+		parameters.resyncWindow = window;
+		parameters.resyncThreads = threads;
+		return verifier.Initialize(parameters, reinterpret_cast<const uint8_t*>(SECRET), 20);
+	}
+
+	wstring Code(const OTPVerifier& verifier, uint64_t counter)
+	{
+		wchar_t text[16];
+		swprintf(text, 16, L"%06u", verifier.Generate(counter));
+		return text;
+	}
+
+	void CheckResync()
+	{
+		const uint64_t counter = 5000;
+		const unsigned int window = 10000;
+		bool found = true;
+		bool outside = true;
+		for (unsigned int threads = 1; threads <= OTP_RESYNC_MAX_THREADS; threads++)
+		{
+			OTPVerifier verifier;
+			Expect(Initialize(verifier, OTP_ALGORITHM::SHA1, window, threads), "resync verifier initializes");
+
+			// Pairs starting at counter + 0, one in the middle, at a chunk edge and the last one of the window
+			const uint64_t starts[] = { 0, 1023, 1024, window / 2, window };
+			for (uint64_t start : starts)
+			{
+				uint64_t matched = 0;
+				const OTP_RESULT result = verifier.Resync(Code(verifier, counter + start).c_str(),
+					Code(verifier, counter + start + 1).c_str(), counter, &matched);
+				found = found && result == OTP_RESULT::VALID && matched == counter + start + 1;
+			}
+
+			uint64_t matched = 0;
+			outside = outside && verifier.Resync(Code(verifier, counter + window + 1).c_str(),
+				Code(verifier, counter + window + 2).c_str(), counter, &matched) == OTP_RESULT::INVALID;
+		}
+		Expect(found, "every thread count finds the pair and reports the counter of the second code");
+		Expect(outside, "a pair past the window is not found");
+
+		OTP_PARAMETERS totp;
+		OTPVerifier verifier;
+		verifier.Initialize(totp, reinterpret_cast<const uint8_t*>(SECRET), 20);
+		Expect(verifier.Resync(L"123456", L"123456", 0, nullptr) == OTP_RESULT::NOT_CONFIGURED, "TOTP tokens do not resync");
+	}
+
+	// Median milliseconds of runs resyncs that match nowhere
+	double WorstCase(OTP_ALGORITHM algorithm, unsigned int window, unsigned int threads, size_t runs)
+	{
+		OTPVerifier verifier;
+		Initialize(verifier, algorithm, window, threads);
+		vector<double> times;
+		for (size_t run = 0; run < runs; run++)
+		{
+			// A pair of equal codes is so rare that none of the windows here holds one
+			const auto start = CLOCK::now();
+			verifier.Resync(L"000000", L"000000", 7000000 + run * 131, nullptr);
+			times.push_back(chrono::duration<double, milli>(CLOCK::now() - start).count());
+		}
+		sort(times.begin(), times.end());
+		return times[times.size() / 2];
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t runs = 9;
+	OTP_ALGORITHM algorithm = OTP_ALGORITHM::SHA1;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		const string value = argv[i + 1];
+		if (arg == "--runs")
+		{
+			runs = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--algorithm")
+		{
+			algorithm = value == "sha512" ? OTP_ALGORITHM::SHA512 : (value == "sha256" ? OTP_ALGORITHM::SHA256 : OTP_ALGORITHM::SHA1);
+		}
+	}
+	if (runs == 0)
+	{
+		fprintf(stderr, "Usage: ResyncBench [--runs n] [--algorithm sha1|sha256|sha512]\n");
+		return 2;
+	}
+
+	CheckResync();
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n\n");
+
+	const unsigned int cores = thread::hardware_concurrency();
+	printf("worst case resync, median of %zu, kernel %s, %u cores\n", runs,
+		ShaMultiBuffer::KernelName(ShaMultiBuffer::ActiveKernel()), cores);
+	printf("%-8s", "window");
+	for (unsigned int threads = 1; threads <= OTP_RESYNC_MAX_THREADS; threads++)
+	{
+		printf("%11u thr ", threads);
+	}
+	printf("\n");
+
+	const unsigned int windows[] = { 1000, 10000, 100000 };
+	for (unsigned int window : windows)
+	{
+		printf("%-8u", window);
+		for (unsigned int threads = 1; threads <= OTP_RESYNC_MAX_THREADS; threads++)
+		{
+			printf("  %9.2f ms%s", WorstCase(algorithm, window, threads, runs), threads > cores ? "*" : " ");
+		}
+		printf("\n");
+	}
+	if (cores < OTP_RESYNC_MAX_THREADS)
+	{
+		printf("* more threads than cores\n");
+	}
+	return 0;
+}
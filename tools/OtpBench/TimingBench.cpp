@@ -0,0 +1,295 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Constant-time verification harness
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Statistical timing test in the style of dudect: every routine is timed
+// with two classes of input, a fixed one that matches at the first position
+// (or selects offset 0) and random ones, picked at random per measurement.
+// The slowest 10 % of the pooled measurements are dropped as interrupts and
+// Welch's t-test compares the two classes. |t| above 10 means the classes
+// take measurably different time and fails the run with exit code 1.
+// An early-exit comparison runs through the same harness as a control and
+// must be caught, otherwise the machine is too noisy for the result to count.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/OtpBench/TimingBench.cpp CredentialProvider/otp/*.cpp -o TimingBench
+//
+// Usage: TimingBench [--measurements n]
+
+#include "otp/ConstantTime.h"
+#include "otp/OTPVerifier.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	// dudect: above 10 the leak is certain, not a fluke of the sample
+	const double T_THRESHOLD = 10.0;
+	// Calls per measurement, so one sample is well above the clock resolution
+	const int CALLS = 8;
+	// Prepared inputs per class, cycled through
+	const size_t INPUTS = 256;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	volatile uint32_t sink;
+
+	// Welch's t of the two classes after dropping the slowest 10 % of all samples
+	double WelchT(const vector<double>& samples, const vector<uint8_t>& classes)
+	{
+		vector<double> sorted(samples);
+		sort(sorted.begin(), sorted.end());
+		const double crop = sorted[sorted.size() * 9 / 10];
+
+		double n[2] = {}, mean[2] = {}, m2[2] = {};
+		for (size_t i = 0; i < samples.size(); i++)
+		{
+			if (samples[i] > crop)
+			{
+				continue;
+			}
+			const int c = classes[i];
+			n[c] += 1;
+			const double delta = samples[i] - mean[c];
+			mean[c] += delta / n[c];
+			m2[c] += delta * (samples[i] - mean[c]);
+		}
+		if (n[0] < 2 || n[1] < 2)
+		{
+			return 0;
+		}
+		const double variance0 = m2[0] / (n[0] - 1);
+		const double variance1 = m2[1] / (n[1] - 1);
+		const double error = sqrt(variance0 / n[0] + variance1 / n[1]);
+		return error > 0 ? (mean[0] - mean[1]) / error : 0;
+	}
+
+	// run(c, input) runs one call on input number input of class c
+	double Measure(size_t measurements, const function<uint32_t(int, size_t)>& run, double* nanos)
+	{
+		mt19937 random(6238);
+		vector<double> samples(measurements);
+		vector<uint8_t> classes(measurements);
+		uint32_t fold = 0;
+		for (size_t m = 0; m < measurements; m++)
+		{
+			const int c = static_cast<int>(random() & 1);
+			const size_t input = m % INPUTS;
+			const auto start = CLOCK::now();
+			for (int k = 0; k < CALLS; k++)
+			{
+				fold += run(c, input);
+			}
+			samples[m] = chrono::duration<double, nano>(CLOCK::now() - start).count();
+			classes[m] = uint8_t(c);
+		}
+		sink = fold;
+		double total = 0;
+		for (double s : samples)
+		{
+			total += s;
+		}
+		*nanos = total / double(measurements) / CALLS;
+		return WelchT(samples, classes);
+	}
+
+	void Report(const char* name, double t, double nanos, bool leaks)
+	{
+		printf("%-34s %9.1f ns  t = %7.2f  %s\n", name, nanos, t, leaks ? "LEAKS" : "constant");
+	}
+
+	// Candidate lists of a window of count codes: class 0 matches at position 0,
+	// class 1 has random codes and almost never matches
+	struct WINDOWS
+	{
+		vector<uint32_t> candidates[2];
+		uint32_t codes[2][INPUTS];
+		uint32_t nexts[2][INPUTS];	// second code for FindPair
+	};
+
+	WINDOWS MakeWindows(size_t count, unsigned int digits)
+	{
+		mt19937 random(4226);
+		uint32_t modulus = 1;
+		for (unsigned int d = 0; d < digits; d++)
+		{
+			modulus *= 10;
+		}
+		WINDOWS windows;
+		for (int c = 0; c < 2; c++)
+		{
+			windows.candidates[c].resize(INPUTS * (count + 1));
+			for (size_t input = 0; input < INPUTS; input++)
+			{
+				uint32_t* candidates = &windows.candidates[c][input * (count + 1)];
+				for (size_t i = 0; i <= count; i++)
+				{
+					candidates[i] = random() % modulus;
+				}
+				windows.codes[c][input] = c == 0 ? candidates[0] : random() % modulus;
+				windows.nexts[c][input] = c == 0 ? candidates[1] : random() % modulus;
+			}
+		}
+		return windows;
+	}
+
+	void CheckFind(size_t measurements)
+	{
+		// +/- 100 steps, the widest window in use
+		const size_t count = 201;
+		const WINDOWS windows = MakeWindows(count, 6);
+		double nanos = 0;
+		const double t = Measure(measurements, [&](int c, size_t input)
+			{
+				size_t index;
+				const uint32_t* candidates = &windows.candidates[c][input * (count + 1)];
+				return ConstantTime::Find(candidates, count, windows.codes[c][input], &index) ? uint32_t(index) : 7u;
+			}, &nanos);
+		Report("ConstantTime::Find, 201 codes", t, nanos, fabs(t) > T_THRESHOLD);
+		Expect(fabs(t) <= T_THRESHOLD, "Find takes the same time with and without a match");
+
+		const double tPair = Measure(measurements, [&](int c, size_t input)
+			{
+				size_t index;
+				const uint32_t* candidates = &windows.candidates[c][input * (count + 1)];
+				return ConstantTime::FindPair(candidates, count + 1, windows.codes[c][input], windows.nexts[c][input], &index)
+					? uint32_t(index) : 7u;
+			}, &nanos);
+		Report("ConstantTime::FindPair, 202 codes", tPair, nanos, fabs(tPair) > T_THRESHOLD);
+		Expect(fabs(tPair) <= T_THRESHOLD, "FindPair takes the same time with and without a match");
+
+		// Control: what the stub and any naive loop do
+		const double tControl = Measure(measurements, [&](int c, size_t input)
+			{
+				const uint32_t* candidates = &windows.candidates[c][input * (count + 1)];
+				for (size_t i = 0; i < count; i++)
+				{
+					if (candidates[i] == windows.codes[c][input])
+					{
+						return uint32_t(i);
+					}
+				}
+				return 7u;
+			}, &nanos);
+		Report("control: early-exit loop", tControl, nanos, fabs(tControl) > T_THRESHOLD);
+		Expect(fabs(tControl) > T_THRESHOLD, "the harness catches an early exit, the machine is too noisy otherwise");
+	}
+
+	void CheckTruncate(size_t measurements)
+	{
+		// Class 0 selects offset 0, class 1 a random one
+		mt19937 random(2104);
+		vector<uint8_t> macs[2];
+		for (int c = 0; c < 2; c++)
+		{
+			macs[c].resize(INPUTS * 20);
+			for (uint8_t& b : macs[c])
+			{
+				b = uint8_t(random());
+			}
+			for (size_t input = 0; input < INPUTS; input++)
+			{
+				uint8_t& last = macs[c][input * 20 + 19];
+				last = c == 0 ? uint8_t(last & 0xf0) : last;
+			}
+		}
+		double nanos = 0;
+		const double t = Measure(measurements, [&](int c, size_t input)
+			{
+				return ConstantTime::Modulo(ConstantTime::Truncate(&macs[c][input * 20], 20), 6);
+			}, &nanos);
+		Report("ConstantTime::Truncate + Modulo", t, nanos, fabs(t) > T_THRESHOLD);
+		Expect(fabs(t) <= T_THRESHOLD, "Truncate and Modulo take the same time for every offset");
+	}
+
+	void CheckVerify(size_t measurements)
+	{
+		OTP_PARAMETERS parameters;
+		parameters.window = 10;
+		OTPVerifier verifier;
+		verifier.Initialize(parameters, reinterpret_cast<const uint8_t*>("12345678901234567890"), 20);
+
+		// Class 0 is the code of the first step of the window, class 1 a random code
+		const long long now = 1700000000;
+		const uint64_t first = uint64_t(now / 30) - parameters.window;
+		mt19937 random(6238);
+		vector<wstring> codes[2];
+		for (size_t input = 0; input < INPUTS; input++)
+		{
+			wchar_t text[16];
+			swprintf(text, 16, L"%06u", verifier.Generate(first));
+			codes[0].push_back(text);
+			swprintf(text, 16, L"%06u", static_cast<unsigned int>(random() % 1000000));
+			codes[1].push_back(text);
+		}
+		double nanos = 0;
+		const double t = Measure(measurements / 8, [&](int c, size_t input)
+			{
+				return static_cast<uint32_t>(verifier.Verify(codes[c][input].c_str(), now, 0, nullptr));
+			}, &nanos);
+		Report("OTPVerifier::Verify, +/- 10 steps", t, nanos, fabs(t) > T_THRESHOLD);
+		Expect(fabs(t) <= T_THRESHOLD, "Verify takes the same time for a valid and an invalid code");
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t measurements = 400000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		if (string(argv[i]) == "--measurements")
+		{
+			measurements = strtoul(argv[i + 1], nullptr, 10);
+		}
+	}
+	if (measurements < 1000)
+	{
+		fprintf(stderr, "Usage: TimingBench [--measurements n], n >= 1000\n");
+		return 2;
+	}
+
+	CheckFind(measurements);
+	CheckTruncate(measurements);
+	CheckVerify(measurements);
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n");
+	return 0;
+}
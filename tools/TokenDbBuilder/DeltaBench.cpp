@@ -0,0 +1,416 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Token database delta log test and benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Opens a token database whose delta log holds 1M COUNTER entries and times
+// Open(), which must not depend on the log, the first Refresh(), which reads
+// all of it, and later ones that read what was appended. Checks that every
+// name has the counter of its last entry, that a reader leaves a torn tail
+// alone and a writer cuts it off, that a Refresh() with a short timeout
+// gives up on a held lock file and that RefreshAsync() reads the log off the
+// calling thread. Then it forks processes that append to one database at
+// once, the store and TokenDeltaWriter side by side, with a compaction
+// threshold low enough that they keep compacting under each other:
+// sequences in the log must be unique and increasing, no counter may be lost
+// and a counter raced for by every process is advanced only once.
+// Exits with 1 on any failure. Linux only, the processes are forked.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/TokenDbBuilder/DeltaBench.cpp CredentialProvider/otp/*.cpp -o DeltaBench
+//
+// Usage: DeltaBench [--entries n] [--processes p] [--appends n] [--directory path]
+
+#include "otp/TokenDelta.h"
+#include "otp/TokenStoreWriter.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	const size_t USERS = 1000;
+	const wchar_t* DOMAIN_NAME = L"corp.example";
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	wstring UserName(size_t i)
+	{
+		wchar_t name[32];
+		swprintf(name, 32, L"user%07zu", i);
+		return name;
+	}
+
+	double Millis(CLOCK::time_point start)
+	{
+		return chrono::duration<double, milli>(CLOCK::now() - start).count();
+	}
+
+	void RemoveAll(const string& path)
+	{
+		const char* suffixes[] = { "", ".delta", ".lock", ".compact", ".old" };
+		for (const char* suffix : suffixes)
+		{
+			remove((path + suffix).c_str());
+		}
+	}
+
+	bool WriteBase(const string& path, size_t users)
+	{
+		TokenStoreWriter writer;
+		OTP_PARAMETERS parameters;
+		parameters.type = OTP_TYPE::HOTP;
+		uint8_t secret[20];
+		for (size_t i = 0; i < users; i++)
+		{
+			for (size_t b = 0; b < sizeof(secret); b++)
+			{
+				secret[b] = uint8_t(i * 31 + b);
+			}
+			writer.Add(UserName(i).c_str(), DOMAIN_NAME, parameters, secret, sizeof(secret), 0);
+		}
+		return TokenStoreWriter::WriteImage(path, writer.Serialize(TOKEN_INDEX::PERFECT_HASH));
+	}
+
+	uint64_t CounterOf(const TokenStore& store, size_t user)
+	{
+		TOKEN_RECORD record;
+		if (!store.Find(UserName(user).c_str(), DOMAIN_NAME, record))
+		{
+			return ~0ULL;
+		}
+		memset(record.secret, 0, sizeof(record.secret));
+		return record.counter;
+	}
+
+	uint64_t FileSize(const wstring& path)
+	{
+		uint64_t size = 0;
+		return TokenFile::Size(path.c_str(), size) ? size : 0;
+	}
+
+	// Entry n moves the counter of user n % USERS to n + 1
+	void CheckLargeLog(const string& directory, size_t entries)
+	{
+		const string path = directory + "/DeltaBench-large.db";
+		const wstring widePath(path.begin(), path.end());
+		const wstring deltaPath = TokenDelta::PathOf(widePath);
+		RemoveAll(path);
+		Expect(WriteBase(path, USERS), "the base file is written");
+
+		vector<uint8_t> log;
+		const TOKEN_DELTA_HEADER header = TokenDelta::Header(0);
+		log.insert(log.end(), reinterpret_cast<const uint8_t*>(&header), reinterpret_cast<const uint8_t*>(&header + 1));
+		vector<vector<uint16_t>> keys(USERS);
+		for (size_t u = 0; u < USERS; u++)
+		{
+			keys[u].resize(TOKEN_STORE_MAX_KEY);
+			keys[u].resize(TokenStore::Normalize(UserName(u).c_str(), DOMAIN_NAME, keys[u].data(), TOKEN_STORE_MAX_KEY));
+		}
+		for (size_t n = 0; n < entries; n++)
+		{
+			const vector<uint16_t>& key = keys[n % USERS];
+			TokenDelta::Encode(TOKEN_DELTA::COUNTER, n + 1, key.data(), key.size(), nullptr, n + 1, log);
+		}
+		Expect(TokenFile::Write(deltaPath.c_str(), log.data(), log.size()), "the delta log is written");
+
+		TokenStore store;
+		store.SetCompactionThreshold(0);
+		auto start = CLOCK::now();
+		const bool opened = store.Open(widePath.c_str());
+		const double open = Millis(start);
+		Expect(opened && store.DeltaCount() == 0, "Open() maps the base file and leaves the log to Refresh()");
+
+		start = CLOCK::now();
+		const bool refreshed = store.Refresh();
+		const double first = Millis(start);
+		Expect(refreshed && store.DeltaCount() == entries, "the first Refresh() applies every entry");
+
+		bool counters = true;
+		for (size_t u = 0; u < USERS && u < entries; u++)
+		{
+			const size_t last = (entries - 1 - u) / USERS * USERS + u;
+			counters = counters && CounterOf(store, u) == last + 1;
+		}
+		Expect(counters, "every name has the counter of its last entry");
+
+		start = CLOCK::now();
+		const bool again = store.Refresh();
+		const double idle = Millis(start);
+		Expect(again && store.DeltaCount() == entries, "a Refresh() with nothing appended reads nothing");
+
+		TokenStore other;
+		other.SetCompactionThreshold(0);
+		Expect(other.Open(widePath.c_str()) && other.Refresh(), "a second store opens the same files");
+		start = CLOCK::now();
+		const bool advanced = other.AppendCounter(UserName(7).c_str(), DOMAIN_NAME, entries + 100) == TOKEN_COUNTER::ADVANCED;
+		const double append = Millis(start);
+		Expect(advanced, "a counter past the log is ADVANCED");
+		Expect(other.AppendCounter(UserName(7).c_str(), DOMAIN_NAME, entries + 100) == TOKEN_COUNTER::USED,
+			"the same counter again is USED");
+		Expect(store.AppendCounter(UserName(7).c_str(), DOMAIN_NAME, entries + 50) == TOKEN_COUNTER::USED,
+			"a store that has not read the append yet still gets USED");
+		Expect(other.AppendCounter(L"nobody", DOMAIN_NAME, 1) == TOKEN_COUNTER::UNKNOWN, "an unknown name is UNKNOWN");
+
+		start = CLOCK::now();
+		const bool tail = store.Refresh();
+		const double appended = Millis(start);
+		Expect(tail && CounterOf(store, 7) == entries + 100, "Refresh() reads the entry another store appended");
+
+		// Half an entry, as a writer that crashed mid-append leaves it
+		const uint64_t intact = FileSize(deltaPath);
+		vector<uint8_t> torn;
+		TokenDelta::Encode(TOKEN_DELTA::COUNTER, entries + 1000, keys[9].data(), keys[9].size(), nullptr, 1, torn);
+		torn.resize(torn.size() / 2);
+		Expect(TokenFile::Append(deltaPath.c_str(), torn.data(), torn.size()), "a torn entry is appended");
+		Expect(store.Refresh() && FileSize(deltaPath) == intact + torn.size(), "a reader leaves the torn tail alone");
+		Expect(store.AppendCounter(UserName(9).c_str(), DOMAIN_NAME, entries + 100) == TOKEN_COUNTER::ADVANCED,
+			"a writer appends behind a torn tail");
+		TokenStore fresh;
+		Expect(fresh.Open(widePath.c_str()) && fresh.Refresh() && CounterOf(fresh, 9) == entries + 100
+			&& fresh.DeltaCount() == entries + 2, "the writer cut the torn tail off, the entry behind it is read");
+
+		// A logon does not wait out a writer of another process, it keeps what was read
+		bool busy;
+		double blocked;
+		{
+			const TokenFileLock writer(TokenDelta::LockPathOf(widePath).c_str(), true, TOKEN_STORE_LOCK_TIMEOUT);
+			start = CLOCK::now();
+			busy = !other.Refresh(TOKEN_STORE_LOGON_LOCK_TIMEOUT);
+			blocked = Millis(start);
+			Expect(writer.IsLocked() && busy && blocked < TOKEN_STORE_LOCK_TIMEOUT / 2 && CounterOf(other, 7) == entries + 100,
+				"Refresh() gives up on a held lock file after its timeout and keeps what it had");
+		}
+
+		TokenStore background;
+		start = CLOCK::now();
+		const bool mapped = background.Open(widePath.c_str());
+		background.RefreshAsync();
+		const double handed = Millis(start);
+		while (background.DeltaCount() < entries + 2 && Millis(start) < 10000)
+		{
+			this_thread::sleep_for(chrono::milliseconds(1));
+		}
+		Expect(mapped && background.DeltaCount() == entries + 2, "RefreshAsync() reads the log off the calling thread");
+		background.RefreshAsync();
+		background.Close();
+		Expect(!background.IsOpen(), "Close() waits for a running RefreshAsync() and unloads");
+
+		printf("%zu delta entries, %.1f MB log\n", entries, double(log.size()) / 1e6);
+		printf("  Open()                     %9.3f ms\n", open);
+		printf("  first Refresh(), all       %9.3f ms\n", first);
+		printf("  Refresh(), nothing new     %9.3f ms\n", idle);
+		printf("  AppendCounter()            %9.3f ms\n", append);
+		printf("  Refresh(), one new entry   %9.3f ms\n", appended);
+		printf("  Refresh(), lock file held  %9.3f ms\n", blocked);
+		printf("  Open(), RefreshAsync()     %9.3f ms\n", handed);
+
+		store.Close();
+		other.Close();
+		fresh.Close();
+		RemoveAll(path);
+	}
+
+	// Child p owns user p and races all others for user processes. advanced[k]
+	// counts the processes that got ADVANCED for counter k of the shared user.
+	int Append(const wstring& path, size_t p, size_t processes, size_t appends, atomic<uint32_t>* advanced)
+	{
+		TokenStore store;
+		// A few dozen entries, every process compacts again and again
+		store.SetCompactionThreshold(4096);
+		TokenDeltaWriter writer;
+		if (!store.Open(path.c_str()) || !writer.Open(path))
+		{
+			return 3;
+		}
+
+		int status = 0;
+		for (size_t k = 1; k <= appends; k++)
+		{
+			// One process writes like the provisioning tools
+			const bool own = p == 0
+				? writer.Counter(UserName(p).c_str(), DOMAIN_NAME, k)
+				: store.AppendCounter(UserName(p).c_str(), DOMAIN_NAME, k) == TOKEN_COUNTER::ADVANCED;
+			status = own ? status : 4;
+			const TOKEN_COUNTER shared = store.AppendCounter(UserName(processes).c_str(), DOMAIN_NAME, k);
+			if (shared == TOKEN_COUNTER::ADVANCED)
+			{
+				advanced[k].fetch_add(1);
+			}
+			status = shared == TOKEN_COUNTER::FAILED ? 5 : status;
+		}
+		store.Compact();
+		store.Close();
+		return status;
+	}
+
+	void CheckProcesses(const string& directory, size_t processes, size_t appends)
+	{
+		const string path = directory + "/DeltaBench-race.db";
+		const wstring widePath(path.begin(), path.end());
+		RemoveAll(path);
+		Expect(WriteBase(path, processes + 1), "the base file is written");
+
+		const size_t bytes = sizeof(atomic<uint32_t>) * (appends + 1);
+		void* mapped = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (mapped == MAP_FAILED)
+		{
+			Expect(false, "shared counters are mapped");
+			return;
+		}
+		atomic<uint32_t>* advanced = static_cast<atomic<uint32_t>*>(mapped);
+		for (size_t k = 0; k <= appends; k++)
+		{
+			advanced[k].store(0);
+		}
+
+		const auto start = CLOCK::now();
+		vector<pid_t> children;
+		for (size_t p = 0; p < processes; p++)
+		{
+			const pid_t child = fork();
+			if (child == 0)
+			{
+				_exit(Append(widePath, p, processes, appends, advanced));
+			}
+			children.push_back(child);
+		}
+		bool exited = true;
+		for (pid_t child : children)
+		{
+			int status = 0;
+			waitpid(child, &status, 0);
+			exited = exited && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+		}
+		const double elapsed = Millis(start);
+		Expect(exited, "every append of a process to its own name succeeds");
+
+		TokenStore store;
+		Expect(store.Open(widePath.c_str()) && store.Refresh(), "the store opens after the race");
+		bool counters = true;
+		for (size_t p = 0; p <= processes; p++)
+		{
+			counters = counters && CounterOf(store, p) == appends;
+		}
+		Expect(counters, "no counter was lost to a compaction");
+
+		bool once = advanced[appends].load() == 1;
+		for (size_t k = 1; k <= appends; k++)
+		{
+			once = once && advanced[k].load() <= 1;
+		}
+		Expect(once, "a counter raced for by every process is advanced once");
+
+		// The compactions must have swapped in bases, and the log left is in order
+		vector<uint8_t> data;
+		uint64_t size = 0;
+		TOKEN_STORE_HEADER base;
+		Expect(TokenFile::Read(widePath.c_str(), 0, sizeof(base), data, size) && data.size() == sizeof(base),
+			"the base header reads");
+		memcpy(&base, data.data(), sizeof(base));
+		Expect(base.sequence > 0, "the processes compacted");
+
+		Expect(TokenFile::Read(TokenDelta::PathOf(widePath).c_str(), 0, ~0ULL, data, size), "the log reads");
+		uint64_t previous = 0;
+		bool ordered = true;
+		const uint64_t intact = TokenDelta::Scan(data.data(), data.size(),
+			[&](const TOKEN_DELTA_ENTRY& entry, const TOKEN_RECORD*, const uint16_t*)
+			{
+				ordered = ordered && entry.sequence > previous;
+				previous = entry.sequence;
+			}, nullptr);
+		Expect(intact == data.size(), "the log is intact");
+		Expect(ordered, "sequences in the log are unique and increasing");
+
+		size_t total = 0;
+		for (size_t k = 1; k <= appends; k++)
+		{
+			total += advanced[k].load();
+		}
+		printf("%zu processes x %zu appends to their own and a shared name, compacting at 4 KB\n", processes, appends);
+		printf("  %.1f ms, %.1f us per append, %zu of %zu shared counters advanced, base sequence %llu\n",
+			elapsed, elapsed * 1000 / double(processes * appends * 2), total, appends,
+			static_cast<unsigned long long>(base.sequence));
+
+		store.Close();
+		munmap(mapped, bytes);
+		RemoveAll(path);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t entries = 1000000;
+	size_t processes = 4;
+	size_t appends = 500;
+	string directory = "/tmp";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--entries")
+		{
+			entries = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--processes")
+		{
+			processes = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--appends")
+		{
+			appends = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--directory")
+		{
+			directory = argv[i + 1];
+		}
+	}
+	if (entries == 0 || processes == 0 || appends == 0)
+	{
+		fprintf(stderr, "Usage: DeltaBench [--entries n] [--processes p] [--appends n] [--directory path]\n");
+		return 2;
+	}
+
+	CheckLargeLog(directory, entries);
+	CheckProcesses(directory, processes, appends);
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n");
+	return 0;
+}
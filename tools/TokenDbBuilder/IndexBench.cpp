@@ -0,0 +1,292 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Token database index benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// Compares the perfect hash index of the token database with the open
+// addressing one and with a sorted array of record numbers searched by
+// binary search over the same keys, at 1k, 100k and 1M users: build time,
+// index size and the latency of TokenStore::Find for present and absent
+// names in random order. First checks that every name is found with its
+// own record through all three and that absent names are not, exits with 1
+// otherwise.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/TokenDbBuilder/IndexBench.cpp CredentialProvider/otp/*.cpp -o IndexBench
+//
+// Usage: IndexBench [--lookups n] [--directory path]
+
+#include "otp/TokenStoreWriter.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	wstring UserName(size_t i)
+	{
+		wchar_t name[32];
+		swprintf(name, 32, L"user%07zu", i);
+		return name;
+	}
+
+	const wchar_t* DOMAIN_NAME = L"corp.example";
+
+	// What the provider would do without a hash index: record numbers sorted
+	// by key, binary search with a key comparison per step
+	class SortedIndex
+	{
+	public:
+		explicit SortedIndex(const vector<uint8_t>& image)
+		{
+			memcpy(&_header, image.data(), sizeof(_header));
+			_records = reinterpret_cast<const TOKEN_RECORD*>(image.data() + _header.recordsOffset);
+			_keys = reinterpret_cast<const uint16_t*>(image.data() + _header.keysOffset);
+			_order.resize(_header.recordCount);
+			for (uint32_t i = 0; i < _header.recordCount; i++)
+			{
+				_order[i] = i;
+			}
+			sort(_order.begin(), _order.end(), [this](uint32_t a, uint32_t b)
+				{
+					return Compare(_records[a], _keys + _records[b].keyOffset, _records[b].keyLength) < 0;
+				});
+		}
+
+		size_t Size() const { return _order.size() * sizeof(uint32_t); }
+
+		bool Find(const wchar_t* user, const wchar_t* domain, TOKEN_RECORD& record) const
+		{
+			uint16_t key[TOKEN_STORE_MAX_KEY];
+			const size_t length = TokenStore::Normalize(user, domain, key, TOKEN_STORE_MAX_KEY);
+			if (length == 0)
+			{
+				return false;
+			}
+			size_t low = 0, high = _order.size();
+			while (low < high)
+			{
+				const size_t middle = (low + high) / 2;
+				const int order = Compare(_records[_order[middle]], key, length);
+				if (order == 0)
+				{
+					record = _records[_order[middle]];
+					return true;
+				}
+				if (order < 0)
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					high = middle;
+				}
+			}
+			return false;
+		}
+
+	private:
+		int Compare(const TOKEN_RECORD& a, const uint16_t* key, size_t length) const
+		{
+			const uint16_t* own = _keys + a.keyOffset;
+			const size_t common = a.keyLength < length ? a.keyLength : length;
+			for (size_t i = 0; i < common; i++)
+			{
+				if (own[i] != key[i])
+				{
+					return own[i] < key[i] ? -1 : 1;
+				}
+			}
+			return a.keyLength == length ? 0 : (a.keyLength < length ? -1 : 1);
+		}
+
+		TOKEN_STORE_HEADER _header;
+		const TOKEN_RECORD* _records;
+		const uint16_t* _keys;
+		vector<uint32_t> _order;
+	};
+
+	volatile size_t sink;
+
+	template <typename F>
+	double NanosPerFind(const vector<wstring>& names, F find)
+	{
+		TOKEN_RECORD record;
+		size_t found = 0;
+		const auto start = CLOCK::now();
+		for (const wstring& name : names)
+		{
+			found += find(name.c_str(), record) ? 1 : 0;
+		}
+		sink = found;
+		return chrono::duration<double, nano>(CLOCK::now() - start).count() / double(names.size());
+	}
+
+	void Run(size_t users, size_t lookups, const string& directory)
+	{
+		TokenStoreWriter writer;
+		OTP_PARAMETERS parameters;
+		uint8_t secret[20];
+		for (size_t i = 0; i < users; i++)
+		{
+			for (size_t b = 0; b < sizeof(secret); b++)
+			{
+				secret[b] = uint8_t(i * 31 + b);
+			}
+			writer.Add(UserName(i).c_str(), DOMAIN_NAME, parameters, secret, sizeof(secret), i);
+		}
+
+		auto start = CLOCK::now();
+		const vector<uint8_t> chd = writer.Serialize(TOKEN_INDEX::PERFECT_HASH);
+		const double chdBuild = chrono::duration<double, milli>(CLOCK::now() - start).count();
+		start = CLOCK::now();
+		const vector<uint8_t> hash = writer.Serialize(TOKEN_INDEX::HASH);
+		const double hashBuild = chrono::duration<double, milli>(CLOCK::now() - start).count();
+		start = CLOCK::now();
+		const SortedIndex sorted(hash);
+		const double sortedBuild = chrono::duration<double, milli>(CLOCK::now() - start).count();
+
+		const string chdPath = directory + "/IndexBench-chd.db";
+		const string hashPath = directory + "/IndexBench-hash.db";
+		TokenStoreWriter::WriteImage(chdPath, chd);
+		TokenStoreWriter::WriteImage(hashPath, hash);
+		const wstring wideChd(chdPath.begin(), chdPath.end());
+		const wstring wideHash(hashPath.begin(), hashPath.end());
+		TokenStore chdStore, hashStore;
+		Expect(chdStore.Open(wideChd.c_str()) && hashStore.Open(wideHash.c_str()), "both stores open");
+
+		// Every record through every index, plus names that are not there
+		bool same = true;
+		for (size_t i = 0; i < users; i++)
+		{
+			TOKEN_RECORD a, b, c;
+			const wstring name = UserName(i);
+			same = same && chdStore.Find(name.c_str(), DOMAIN_NAME, a) && hashStore.Find(name.c_str(), DOMAIN_NAME, b)
+				&& sorted.Find(name.c_str(), DOMAIN_NAME, c) && a.counter == i && b.counter == i && c.counter == i;
+		}
+		Expect(same, "every name finds its own record through every index");
+		bool absent = true;
+		for (size_t i = users; i < users + 1000; i++)
+		{
+			TOKEN_RECORD record;
+			const wstring name = UserName(i);
+			absent = absent && !chdStore.Find(name.c_str(), DOMAIN_NAME, record) && !hashStore.Find(name.c_str(), DOMAIN_NAME, record)
+				&& !sorted.Find(name.c_str(), DOMAIN_NAME, record);
+		}
+		Expect(absent, "absent names are not found");
+
+		// Random names, so the larger tables do not sit in cache
+		mt19937_64 random(users);
+		vector<wstring> hits, misses;
+		for (size_t i = 0; i < lookups; i++)
+		{
+			hits.push_back(UserName(random() % users) + L"@" + DOMAIN_NAME);
+			// Sorts next to a present name, the binary search cannot take a cached path
+			misses.push_back(UserName(random() % users) + L"x@" + DOMAIN_NAME);
+		}
+
+		TOKEN_STORE_HEADER chdHeader, hashHeader;
+		memcpy(&chdHeader, chd.data(), sizeof(chdHeader));
+		memcpy(&hashHeader, hash.data(), sizeof(hashHeader));
+		struct ROW
+		{
+			const char* name;
+			double build;
+			size_t size;
+			double hit;
+			double miss;
+		};
+		const ROW rows[] =
+		{
+			{ "perfect hash", chdBuild, size_t(chdHeader.indexSize),
+				NanosPerFind(hits, [&](const wchar_t* n, TOKEN_RECORD& r) { return chdStore.Find(n, nullptr, r); }),
+				NanosPerFind(misses, [&](const wchar_t* n, TOKEN_RECORD& r) { return chdStore.Find(n, nullptr, r); }) },
+			{ "open addressing", hashBuild, size_t(hashHeader.indexSize),
+				NanosPerFind(hits, [&](const wchar_t* n, TOKEN_RECORD& r) { return hashStore.Find(n, nullptr, r); }),
+				NanosPerFind(misses, [&](const wchar_t* n, TOKEN_RECORD& r) { return hashStore.Find(n, nullptr, r); }) },
+			{ "sorted array", sortedBuild, sorted.Size(),
+				NanosPerFind(hits, [&](const wchar_t* n, TOKEN_RECORD& r) { return sorted.Find(n, nullptr, r); }),
+				NanosPerFind(misses, [&](const wchar_t* n, TOKEN_RECORD& r) { return sorted.Find(n, nullptr, r); }) },
+		};
+		for (const ROW& row : rows)
+		{
+			printf("%8zu  %-16s %10.1f ms %9.2f bytes/user %8.1f ns %8.1f ns\n", users, row.name, row.build,
+				double(row.size) / double(users), row.hit, row.miss);
+		}
+
+		chdStore.Close();
+		hashStore.Close();
+		remove(chdPath.c_str());
+		remove(hashPath.c_str());
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t lookups = 1000000;
+	string directory = "/tmp";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--lookups")
+		{
+			lookups = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--directory")
+		{
+			directory = argv[i + 1];
+		}
+	}
+	if (lookups == 0)
+	{
+		fprintf(stderr, "Usage: IndexBench [--lookups n] [--directory path]\n");
+		return 2;
+	}
+
+	printf("%8s  %-16s %13s %21s %11s %11s\n", "users", "index", "build", "index size", "hit", "miss");
+	const size_t sizes[] = { 1000, 100000, 1000000 };
+	for (size_t users : sizes)
+	{
+		Run(users, lookups, directory);
+		if (failed)
+		{
+			return 1;
+		}
+	}
+	printf("checks passed\n");
+	return 0;
+}
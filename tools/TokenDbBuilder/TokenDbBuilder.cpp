@@ -0,0 +1,297 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Token database builder
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+
+// Provisioning tool, builds the offline token database read by TokenStore.
+// Platform neutral, on Linux build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -ICredentialProvider tools/TokenDbBuilder/TokenDbBuilder.cpp CredentialProvider/otp/*.cpp -o TokenDbBuilder
+//
+// Usage: TokenDbBuilder [--index chd|hash] input.csv output.db
+//
+// One token per line, '#' starts a comment:
+//   name,type,algorithm,digits,period,secret[,counter]
+//   alice@corp.example,totp,sha1,6,30,JBSWY3DPEHPK3PXP
+//   CORP\bob,hotp,sha256,8,0,GEZDGNBVGY3TQOJQGEZDGNBVGY3TQOJQ,42
+// name is normalized like the provider does at logon, secret is base32.
+
+#include "otp/TokenStoreWriter.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	// UTF-8 to UTF-16 code units, names outside the BMP are rejected by TokenStore anyway
+	bool Widen(const string& in, wstring& out)
+	{
+		out.clear();
+		for (size_t i = 0; i < in.size();)
+		{
+			const unsigned char c = static_cast<unsigned char>(in[i]);
+			unsigned long code;
+			size_t extra;
+			if (c < 0x80)
+			{
+				code = c;
+				extra = 0;
+			}
+			else if ((c & 0xe0) == 0xc0)
+			{
+				code = c & 0x1f;
+				extra = 1;
+			}
+			else if ((c & 0xf0) == 0xe0)
+			{
+				code = c & 0x0f;
+				extra = 2;
+			}
+			else
+			{
+				return false;
+			}
+
+			if (i + extra >= in.size() && extra > 0)
+			{
+				return false;
+			}
+			for (size_t k = 1; k <= extra; k++)
+			{
+				const unsigned char next = static_cast<unsigned char>(in[i + k]);
+				if ((next & 0xc0) != 0x80)
+				{
+					return false;
+				}
+				code = (code << 6) | (next & 0x3f);
+			}
+			out.push_back(static_cast<wchar_t>(code));
+			i += extra + 1;
+		}
+		return true;
+	}
+
+	string Trim(const string& s)
+	{
+		const size_t begin = s.find_first_not_of(" \t\r");
+		if (begin == string::npos)
+		{
+			return "";
+		}
+		return s.substr(begin, s.find_last_not_of(" \t\r") - begin + 1);
+	}
+
+	bool ParseUnsigned(const string& s, unsigned long long& value)
+	{
+		if (s.empty())
+		{
+			return false;
+		}
+		char* end = nullptr;
+		value = strtoull(s.c_str(), &end, 10);
+		return *end == '\0';
+	}
+
+	bool ParseLine(const string& line, TokenStoreWriter& writer, string& error)
+	{
+		vector<string> fields;
+		stringstream ss(line);
+		string field;
+		while (getline(ss, field, ','))
+		{
+			fields.push_back(Trim(field));
+		}
+		if (fields.size() < 6 || fields.size() > 7)
+		{
+			error = "expected 6 or 7 fields";
+			return false;
+		}
+
+		OTP_PARAMETERS parameters;
+		if (fields[1] == "totp")
+		{
+			parameters.type = OTP_TYPE::TOTP;
+		}
+		else if (fields[1] == "hotp")
+		{
+			parameters.type = OTP_TYPE::HOTP;
+		}
+		else
+		{
+			error = "type must be totp or hotp";
+			return false;
+		}
+
+		if (fields[2] == "sha1")
+		{
+			parameters.algorithm = OTP_ALGORITHM::SHA1;
+		}
+		else if (fields[2] == "sha256")
+		{
+			parameters.algorithm = OTP_ALGORITHM::SHA256;
+		}
+		else if (fields[2] == "sha512")
+		{
+			parameters.algorithm = OTP_ALGORITHM::SHA512;
+		}
+		else
+		{
+			error = "algorithm must be sha1, sha256 or sha512";
+			return false;
+		}
+
+		unsigned long long digits, period, counter = 0;
+		if (!ParseUnsigned(fields[3], digits) || !ParseUnsigned(fields[4], period)
+			|| (fields.size() == 7 && !ParseUnsigned(fields[6], counter)))
+		{
+			error = "digits, period and counter must be numbers";
+			return false;
+		}
+		parameters.digits = static_cast<unsigned int>(digits);
+		parameters.period = static_cast<unsigned int>(period);
+
+		uint8_t secret[TOKEN_STORE_MAX_SECRET];
+		const size_t secretLength = OTPVerifier::DecodeBase32(fields[5].c_str(), secret, sizeof(secret));
+		if (secretLength == 0)
+		{
+			error = "secret is not base32 or longer than 64 bytes";
+			return false;
+		}
+
+		wstring name;
+		if (!Widen(fields[0], name))
+		{
+			error = "name is not UTF-8";
+			return false;
+		}
+
+		const bool added = writer.Add(name.c_str(), nullptr, parameters, secret, secretLength, counter);
+		memset(secret, 0, sizeof(secret));
+		if (!added)
+		{
+			error = "invalid token or duplicate name";
+			return false;
+		}
+		return true;
+	}
+
+	int Usage()
+	{
+		cerr << "Usage: TokenDbBuilder [--index chd|hash] input.csv output.db" << endl;
+		return 2;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	TOKEN_INDEX index = TOKEN_INDEX::PERFECT_HASH;
+	vector<string> files;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const string arg = argv[i];
+		if (arg == "--index" && i + 1 < argc)
+		{
+			const string kind = argv[++i];
+			if (kind == "chd")
+			{
+				index = TOKEN_INDEX::PERFECT_HASH;
+			}
+			else if (kind == "hash")
+			{
+				index = TOKEN_INDEX::HASH;
+			}
+			else
+			{
+				return Usage();
+			}
+		}
+		else
+		{
+			files.push_back(arg);
+		}
+	}
+	if (files.size() != 2)
+	{
+		return Usage();
+	}
+
+	ifstream input(files[0]);
+	if (!input)
+	{
+		cerr << "Cannot read " << files[0] << endl;
+		return 1;
+	}
+
+	TokenStoreWriter writer;
+	string line;
+	size_t lineNumber = 0;
+	size_t errors = 0;
+	while (getline(input, line))
+	{
+		lineNumber++;
+		line = Trim(line);
+		if (line.empty() || line[0] == '#')
+		{
+			continue;
+		}
+
+		string error;
+		if (!ParseLine(line, writer, error))
+		{
+			cerr << files[0] << ":" << lineNumber << ": " << error << endl;
+			errors++;
+		}
+	}
+	if (errors != 0)
+	{
+		cerr << errors << " invalid lines, nothing written" << endl;
+		return 1;
+	}
+
+	const auto start = chrono::steady_clock::now();
+	const vector<uint8_t> image = writer.Serialize(index);
+	const auto elapsed = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start);
+
+	if (!TokenStoreWriter::WriteImage(files[1], image))
+	{
+		cerr << "Cannot write " << files[1] << endl;
+		return 1;
+	}
+
+	// A full export replaces every earlier change, the old delta log must not be applied on top
+	const string delta = files[1] + ".delta";
+	if (remove(delta.c_str()) == 0)
+	{
+		cout << "Removed " << delta << endl;
+	}
+
+	const TOKEN_STORE_HEADER* header = reinterpret_cast<const TOKEN_STORE_HEADER*>(image.data());
+	cout << writer.Count() << " tokens, " << (index == TOKEN_INDEX::PERFECT_HASH ? "perfect hash" : "hash")
+		<< " index " << header->indexSize << " bytes, file " << image.size() << " bytes, index built in "
+		<< elapsed.count() << " ms" << endl;
+	return 0;
+}
@@ -0,0 +1,263 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - Span tracer check and benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// First checks the Tracer: nothing recorded while off, spans in order, the
+// ring keeping the newest when it wraps, no torn span in snapshots taken
+// while several threads record, and the Chrome JSON. Exits with 1 on the
+// first failure. Then measures the cost of a span, off, on and contended,
+// and writes a sample trace to load in chrome://tracing or Perfetto.
+// Build it from the repository root with
+//   g++ -std=c++14 -O2 -pthread -IShared tools/TraceBench/TraceBench.cpp Shared/Trace.cpp -o TraceBench
+//
+// Usage: TraceBench [--spans n] [--threads t] [--json path]
+
+#include "Trace.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	bool failed = false;
+
+	void Expect(bool condition, const char* what)
+	{
+		if (!condition)
+		{
+			fprintf(stderr, "FAIL %s\n", what);
+			failed = true;
+		}
+	}
+
+	size_t Count(const string& text, const string& part)
+	{
+		size_t count = 0;
+		for (size_t at = text.find(part); at != string::npos; at = text.find(part, at + part.size()))
+		{
+			count++;
+		}
+		return count;
+	}
+
+	void CheckOffAndOrder()
+	{
+		Tracer tracer(64);
+		{
+			TraceSpan span(tracer, "off");
+		}
+		Expect(tracer.Recorded() == 0 && tracer.Snapshot().empty(), "a tracer that is off records nothing");
+
+		tracer.Enable(true);
+		const char* names[] = { "SetUsageScenario", "GetCredentialAt", "Connect" };
+		for (const char* name : names)
+		{
+			TraceSpan span(tracer, name);
+			this_thread::sleep_for(chrono::microseconds(50));
+		}
+		const vector<TRACE_EVENT> events = tracer.Snapshot();
+		Expect(events.size() == 3, "three spans recorded");
+		for (size_t i = 0; i < events.size() && i < 3; i++)
+		{
+			Expect(strcmp(events[i].name, names[i]) == 0, "spans come out in order");
+			Expect(events[i].duration >= 50000, "a span lasts until its scope ends");
+			Expect(i == 0 || events[i].begin >= events[i - 1].begin + events[i - 1].duration, "spans do not overlap");
+		}
+	}
+
+	void CheckWrap()
+	{
+		Tracer tracer(64);
+		tracer.Enable(true);
+		for (uint64_t i = 0; i < 200; i++)
+		{
+			tracer.Record("span", i, i + 1);
+		}
+		const vector<TRACE_EVENT> events = tracer.Snapshot();
+		Expect(events.size() == 64, "a full ring holds its capacity");
+		Expect(!events.empty() && events.front().begin == 136 && events.back().begin == 199, "the ring keeps the newest spans");
+	}
+
+	// Every writer encodes itself in the span, a reader checks that the fields belong together
+	void CheckConcurrent(size_t threads)
+	{
+		Tracer tracer(256);
+		tracer.Enable(true);
+		static const char names[8][8] = { "t0", "t1", "t2", "t3", "t4", "t5", "t6", "t7" };
+		atomic<bool> done(false);
+		atomic<size_t> torn(0);
+		atomic<size_t> seen(0);
+
+		thread reader([&]
+			{
+				while (!done.load())
+				{
+					for (const TRACE_EVENT& event : tracer.Snapshot())
+					{
+						const size_t writer = static_cast<size_t>(event.begin >> 32);
+						const uint64_t i = event.begin & 0xFFFFFFFF;
+						if (writer >= 8 || event.name != names[writer] || event.duration != i)
+						{
+							torn++;
+						}
+						seen++;
+					}
+				}
+			});
+		vector<thread> writers;
+		const size_t count = threads < 8 ? threads : 8;
+		for (size_t t = 0; t < count; t++)
+		{
+			writers.emplace_back([&tracer, t]
+				{
+					for (uint64_t i = 1; i <= 200000; i++)
+					{
+						const uint64_t begin = (uint64_t(t) << 32) | i;
+						tracer.Record(names[t], begin, begin + i);
+						if (i % 1024 == 0)
+						{
+							this_thread::yield();	// lets the reader in on a single core
+						}
+					}
+				});
+		}
+		for (thread& writer : writers)
+		{
+			writer.join();
+		}
+		done = true;
+		reader.join();
+		printf("concurrent: %zu writers, %zu spans read, %zu torn\n", count, seen.load(), torn.load());
+		Expect(seen > 0, "the reader took snapshots while recording");
+		Expect(torn == 0, "no torn span in a snapshot taken while recording");
+		Expect(tracer.Recorded() == count * 200000, "every span is counted");
+		Expect(tracer.Snapshot().size() == 256, "the ring is full after the writers");
+	}
+
+	void CheckJson()
+	{
+		Tracer tracer(16);
+		tracer.Enable(true);
+		tracer.Record("CCredential::Connect", 1000, 2500);
+		tracer.Record("quote\" and \\", 3000, 3001);
+		const string json = tracer.ChromeJson();
+		Expect(json.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[") == 0, "JSON starts with the trace events");
+		Expect(Count(json, "\"ph\":\"X\"") == 2, "one complete event per span");
+		Expect(json.find("\"name\":\"CCredential::Connect\",\"cat\":\"logon\",\"ph\":\"X\",\"ts\":1.000,\"dur\":1.500") != string::npos,
+			"times are microseconds");
+		Expect(json.find("quote\\\" and \\\\") != string::npos, "names are escaped");
+		Expect(Count(json, "{") == Count(json, "}") && Count(json, "[") == Count(json, "]"), "brackets balance");
+	}
+
+	double NanosPerSpan(Tracer& tracer, size_t spans)
+	{
+		const auto start = CLOCK::now();
+		for (size_t i = 0; i < spans; i++)
+		{
+			TraceSpan span(tracer, "CCredential::Connect");
+		}
+		return chrono::duration<double, nano>(CLOCK::now() - start).count() / double(spans);
+	}
+}
+
+int main(int argc, char** argv)
+{
+	size_t spans = 2000000;
+	size_t threads = 4;
+	string json = "/tmp/TraceBench.json";
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--spans")
+		{
+			spans = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--threads")
+		{
+			threads = strtoul(argv[i + 1], nullptr, 10);
+		}
+		else if (arg == "--json")
+		{
+			json = argv[i + 1];
+		}
+	}
+	if (spans == 0 || threads == 0)
+	{
+		fprintf(stderr, "Usage: TraceBench [--spans n] [--threads t] [--json path]\n");
+		return 2;
+	}
+
+	CheckOffAndOrder();
+	CheckWrap();
+	CheckConcurrent(threads);
+	CheckJson();
+	if (failed)
+	{
+		return 1;
+	}
+	printf("checks passed\n\n");
+
+	Tracer& tracer = Tracer::Get();
+	printf("span off                 %7.1f ns\n", NanosPerSpan(tracer, spans));
+	tracer.Enable(true);
+	printf("span on                  %7.1f ns\n", NanosPerSpan(tracer, spans));
+
+	vector<double> perThread(threads);
+	vector<thread> workers;
+	for (size_t t = 0; t < threads; t++)
+	{
+		workers.emplace_back([&tracer, &perThread, t, spans, threads]
+			{
+				perThread[t] = NanosPerSpan(tracer, spans / threads);
+			});
+	}
+	double worst = 0;
+	for (size_t t = 0; t < threads; t++)
+	{
+		workers[t].join();
+		worst = perThread[t] > worst ? perThread[t] : worst;
+	}
+	printf("span on, %zu threads      %7.1f ns, slowest thread\n", threads, worst);
+
+	// A logon as LogonUI calls it, to look at
+	Tracer sample(64);
+	sample.Enable(true);
+	const char* calls[] = { "CProvider::SetUsageScenario", "CProvider::SetSerialization", "CProvider::GetCredentialAt",
+		"CCredential::Initialize", "CCredential::SetSelected", "CCredential::Connect", "CCredential::GetSerialization",
+		"CCredential::ReportResult" };
+	for (const char* call : calls)
+	{
+		TraceSpan span(sample, call);
+		this_thread::sleep_for(chrono::microseconds(strcmp(call, "CCredential::Connect") == 0 ? 2000 : 100));
+	}
+	ofstream file(json, ios::binary | ios::trunc);
+	file << sample.ChromeJson();
+	printf("\nsample logon trace: %s\n", json.c_str());
+	return file ? 0 : 1;
+}
@@ -0,0 +1,311 @@
+/* * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * *
+**
+** DasCredentialProvider - UTF-16 to UTF-8 transcoder check and benchmark
+**
+** Copyright 2026 Adamantic
+**
+**    Licensed under the Apache License, Version 2.0 (the "License");
+**    you may not use this file except in compliance with the License.
+**    You may obtain a copy of the License at
+**
+**        http://www.apache.org/licenses/LICENSE-2.0
+**
+**    Unless required by applicable law or agreed to in writing, software
+**    distributed under the License is distributed on an "AS IS" BASIS,
+**    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+**    See the License for the specific language governing permissions and
+**    limitations under the License.
+**
+** * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * * */
+
+// First checks every Utf8 kernel the CPU supports against a plain reference
+// encoder: surrogate pairs on and across block boundaries, unpaired and
+// reversed surrogates, the boundaries of each sequence length, and random
+// strings. Exits with 1 on the first difference. Then compares the
+// throughput of the kernels with std::wstring_convert, which the logger used
+// before. Build it from the repository root with
+//   g++ -std=c++14 -O2 -IShared tools/Utf8Bench/Utf8Bench.cpp Shared/Utf8.cpp Shared/Utf8Sse4.cpp Shared/Utf8Avx2.cpp -o Utf8Bench
+//
+// Usage: Utf8Bench [--seconds s] [--random n]
+
+#include "Utf8.h"
+#include <chrono>
+#include <codecvt>
+#include <cstdio>
+#include <cstdlib>
+#include <locale>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+	typedef chrono::steady_clock CLOCK;
+
+	const UTF8_KERNEL kernels[] = { UTF8_KERNEL::SCALAR, UTF8_KERNEL::SSE4, UTF8_KERNEL::AVX2 };
+
+	// Independent of Utf8::EncodeScalar, one code point at a time
+	string Reference(const u16string& in)
+	{
+		string out;
+		for (size_t i = 0; i < in.size(); i++)
+		{
+			uint32_t c = in[i];
+			if (c >= 0xD800 && c <= 0xDFFF)
+			{
+				if (c <= 0xDBFF && i + 1 < in.size() && in[i + 1] >= 0xDC00 && in[i + 1] <= 0xDFFF)
+				{
+					c = 0x10000 + ((c - 0xD800) << 10) + (in[i + 1] - 0xDC00u);
+					i++;
+				}
+				else
+				{
+					c = 0xFFFD;
+				}
+			}
+			if (c < 0x80)
+			{
+				out += char(c);
+			}
+			else if (c < 0x800)
+			{
+				out += char(0xC0 | (c >> 6));
+				out += char(0x80 | (c & 0x3F));
+			}
+			else if (c < 0x10000)
+			{
+				out += char(0xE0 | (c >> 12));
+				out += char(0x80 | ((c >> 6) & 0x3F));
+				out += char(0x80 | (c & 0x3F));
+			}
+			else
+			{
+				out += char(0xF0 | (c >> 18));
+				out += char(0x80 | ((c >> 12) & 0x3F));
+				out += char(0x80 | ((c >> 6) & 0x3F));
+				out += char(0x80 | (c & 0x3F));
+			}
+		}
+		return out;
+	}
+
+	string Convert(UTF8_KERNEL kernel, const u16string& in)
+	{
+		// A guard after MaxBytes catches writes beyond it
+		string out(Utf8::MaxBytes(in.size()) + 16, '\x5A');
+		const size_t length = Utf8::FromUtf16(kernel, in.data(), in.size(), &out[0]);
+		for (size_t i = Utf8::MaxBytes(in.size()); i < out.size(); i++)
+		{
+			if (out[i] != '\x5A')
+			{
+				return "<wrote past MaxBytes>";
+			}
+		}
+		out.resize(length);
+		return out;
+	}
+
+	bool Check(const char* name, const u16string& in)
+	{
+		const string expected = Reference(in);
+		for (UTF8_KERNEL kernel : kernels)
+		{
+			if (!Utf8::IsSupported(kernel))
+			{
+				continue;
+			}
+			if (Convert(kernel, in) != expected)
+			{
+				fprintf(stderr, "FAIL %s: %s kernel, %zu units\n", name, Utf8::KernelName(kernel), in.size());
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool CheckFixed()
+	{
+		const u16string smiley = u"\U0001F600";
+		bool ok = Check("empty", u"") && Check("ascii", u"CCredential::Connect user=alice@corp.example")
+			&& Check("latin", u"Jürgen Müller, Björk Guðmundsdóttir, François Lefèvre")
+			&& Check("cjk", u"山田太郎のトークンは登録されていません。もう一度お試しください")
+			&& Check("boundaries", u16string({ 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFFFD, 0xFFFF, 0x00, 0x01, 'a', 0x7FF, 0x800, 0x80, 0x7F, 0xFFFF }));
+
+		// A pair at every position around the block boundaries, padded with each class
+		const char16_t fillers[] = { u'a', u'é', u'€' };
+		for (char16_t filler : fillers)
+		{
+			for (size_t at = 0; ok && at < 40; at++)
+			{
+				u16string text(40, filler);
+				text.replace(at, 0, smiley);
+				ok = Check("pair", text);
+
+				// Unpaired high, unpaired low and a reversed pair at the same place
+				u16string high(40, filler);
+				high[at] = 0xD83D;
+				u16string low(40, filler);
+				low[at] = 0xDE00;
+				u16string reversed(40, filler);
+				reversed.replace(at, 0, u16string({ 0xDE00, 0xD83D }));
+				ok = ok && Check("unpaired high", high) && Check("unpaired low", low) && Check("reversed pair", reversed);
+
+				// High surrogate as the very last unit
+				ok = ok && Check("high at end", text.substr(0, at) + char16_t(0xD83D));
+			}
+		}
+		return ok;
+	}
+
+	bool CheckRandom(size_t count)
+	{
+		mt19937 random(4226);
+		// Weighted classes: ASCII, 2 bytes, 3 bytes, pairs, lone surrogates
+		discrete_distribution<int> kind({ 60, 15, 15, 7, 3 });
+		for (size_t n = 0; n < count; n++)
+		{
+			u16string text;
+			const size_t length = random() % 200;
+			while (text.size() < length)
+			{
+				switch (kind(random))
+				{
+				case 0:
+					text += char16_t(random() % 0x80);
+					break;
+				case 1:
+					text += char16_t(0x80 + random() % 0x780);
+					break;
+				case 2:
+				{
+					char16_t c = char16_t(0x800 + random() % 0xF800);
+					text += (c >= 0xD800 && c <= 0xDFFF) ? char16_t(0xE000) : c;
+					break;
+				}
+				case 3:
+					text += char16_t(0xD800 + random() % 0x400);
+					text += char16_t(0xDC00 + random() % 0x400);
+					break;
+				default:
+					text += char16_t(0xD800 + random() % 0x800);
+					break;
+				}
+			}
+			if (!Check("random", text))
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	u16string Repeat(const u16string& unit, size_t length)
+	{
+		u16string text;
+		while (text.size() < length)
+		{
+			text += unit;
+		}
+		text.resize(length);
+		return text;
+	}
+
+	template <typename CONVERT>
+	double Throughput(const u16string& text, double seconds, CONVERT&& convert)
+	{
+		size_t units = 0;
+		size_t sink = 0;
+		const auto start = CLOCK::now();
+		const auto end = start + chrono::duration_cast<CLOCK::duration>(chrono::duration<double>(seconds));
+		auto now = start;
+		while (now < end)
+		{
+			for (int i = 0; i < 64; i++)
+			{
+				sink += convert(text);
+				units += text.size();
+			}
+			now = CLOCK::now();
+		}
+		if (sink == 0 && !text.empty())
+		{
+			printf(" ");
+		}
+		// Input MB/s, UTF-16 bytes
+		return double(units) * 2 / 1e6 / chrono::duration<double>(now - start).count();
+	}
+}
+
+int main(int argc, char** argv)
+{
+	double seconds = 0.3;
+	size_t randomCount = 100000;
+	for (int i = 1; i + 1 < argc; i += 2)
+	{
+		const string arg = argv[i];
+		if (arg == "--seconds")
+		{
+			seconds = atof(argv[i + 1]);
+		}
+		else if (arg == "--random")
+		{
+			randomCount = strtoul(argv[i + 1], nullptr, 10);
+		}
+	}
+
+	printf("active kernel: %s\n", Utf8::KernelName(Utf8::ActiveKernel()));
+	if (!CheckFixed() || !CheckRandom(randomCount))
+	{
+		return 1;
+	}
+	printf("checks passed: fixed cases and %zu random strings\n\n", randomCount);
+
+	struct SAMPLE
+	{
+		const char* name;
+		u16string unit;
+	};
+	const SAMPLE samples[] = {
+		{ "ascii", u"[CCredential.cpp:745] Daemon /run/das/auth.sock answered in 412 us, " },
+		{ "latin", u"Jürgen Müller François Lefèvre Björk Guðmundsdóttir " },
+		{ "cjk", u"山田太郎のトークンは登録されていません" },
+		{ "mixed", u"user=Jürgen domain=CORP 山田 ok \U0001F600 " },
+	};
+	const size_t lengths[] = { 64, 4096 };
+
+	printf("%-6s %6s %12s %10s %10s %10s   MB/s of UTF-16 input\n", "text", "units", "wstring_conv", "scalar", "sse4", "avx2");
+	string buffer(Utf8::MaxBytes(4096), '\0');
+	for (const SAMPLE& sample : samples)
+	{
+		for (size_t length : lengths)
+		{
+			const u16string text = Repeat(sample.unit, length);
+			printf("%-6s %6zu", sample.name, length);
+
+			const double converter = Throughput(text, seconds, [](const u16string& in)
+				{
+					wstring_convert<codecvt_utf8_utf16<char16_t>, char16_t> convert;
+					return convert.to_bytes(in).size();
+				});
+			printf(" %12.0f", converter);
+
+			for (UTF8_KERNEL kernel : kernels)
+			{
+				if (!Utf8::IsSupported(kernel))
+				{
+					printf(" %10s", "-");
+					continue;
+				}
+				const double rate = Throughput(text, seconds, [&buffer, kernel](const u16string& in)
+					{
+						return Utf8::FromUtf16(kernel, in.data(), in.size(), &buffer[0]);
+					});
+				printf(" %10.0f", rate);
+			}
+			printf("\n");
+		}
+	}
+	return 0;
+}